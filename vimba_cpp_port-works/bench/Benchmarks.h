@@ -0,0 +1,67 @@
+/*=============================================================================
+  Copyright (C) 2013 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        Benchmarks.h
+
+  Description: The options and the benchmarks of the benchmark program.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#ifndef AVT_VMBAPI_EXAMPLES_BENCHMARKS
+#define AVT_VMBAPI_EXAMPLES_BENCHMARKS
+
+#include "VimbaCPP/Include/VimbaCPP.h"
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+//
+// What the command line asked for, every benchmark has its own defaults for the values left at 0
+//
+struct BenchmarkOptions
+{
+    VmbUint64_t     nFrameCount;            // The frames (or images) to measure with
+    VmbUint32_t     nThreadCount;           // The most threads to use
+    VmbUint32_t     nWidth;                 // The size of the images
+    VmbUint32_t     nHeight;
+
+    BenchmarkOptions()
+        : nFrameCount( 0 )
+        , nThreadCount( 0 )
+        , nWidth( 0 )
+        , nHeight( 0 )
+    {
+    }
+};
+
+//
+// The benchmarks, every one prints its results and returns false if a result was wrong
+//
+bool BenchmarkQueues( const BenchmarkOptions &rOptions );
+bool BenchmarkStripes( const BenchmarkOptions &rOptions );
+bool BenchmarkConversion( const BenchmarkOptions &rOptions );
+bool BenchmarkDemosaic( const BenchmarkOptions &rOptions );
+bool BenchmarkSwizzle( const BenchmarkOptions &rOptions );
+
+}}} // namespace AVT::VmbAPI::Examples
+
+#endif
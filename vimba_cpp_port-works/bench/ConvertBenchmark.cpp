@@ -0,0 +1,210 @@
+/*=============================================================================
+  Copyright (C) 2013 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        ConvertBenchmark.cpp
+
+  Description: Compares the bitmap conversion specialized per color code and padding
+               with the generic conversion it replaced
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "Benchmarks.h"
+#include "Bitmap.h"
+#include "SyntheticFrameSource.h"
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+namespace
+{
+
+typedef std::chrono::steady_clock Clock;
+
+enum { DEFAULT_IMAGE_COUNT = 200, };
+enum { DEFAULT_WIDTH = 2048, };
+enum { DEFAULT_HEIGHT = 1536, };
+
+//
+// The conversion AVTCreateBitmap did before it was specialized, as the reference: the format is
+// decided at runtime, RGB is swapped pixel by pixel and the padding is checked per row
+//
+// Parameters:
+//  [in]    pBitmap             Width, height, color code and image size (bufferSize) of the image
+//  [in]    pBuffer             The image
+//
+// Returns:
+//  The bitmap file (free it with free), NULL in case of error
+//
+unsigned char* CreateBitmapGeneric( AVTBitmap const * const pBitmap, const void* pBuffer )
+{
+    AVTBitmapHeader header;
+    if ( 0 == AVTCreateBitmapHeader( pBitmap, &header ))
+    {
+        return NULL;
+    }
+    unsigned char *pBitmapBuffer = static_cast<unsigned char*>( malloc( header.fileSize ));
+    if ( NULL == pBitmapBuffer )
+    {
+        return NULL;
+    }
+    memcpy( pBitmapBuffer, header.data, header.size );
+
+    const unsigned long nNumColors = header.rowSize / pBitmap->width;
+    const unsigned long nPadLength = header.padLength;
+    unsigned char *pCurBitmapBuf = pBitmapBuffer + header.size;
+    const unsigned char *pCurSrc = static_cast<const unsigned char*>( pBuffer );
+    if ( ColorCodeRGB24 == pBitmap->colorCode )
+    {
+        for ( unsigned long y = 0; y < pBitmap->height; ++y, pCurBitmapBuf += nPadLength )
+        {
+            for ( unsigned long x = 0; x < pBitmap->width; ++x, pCurSrc += 3, pCurBitmapBuf += 3 )
+            {
+                // Due to endianess ARGB is stored as BGRA and only the first three bytes are written
+                const unsigned long px = ( pCurSrc[0] << 16 ) | ( pCurSrc[1] << 8 ) | pCurSrc[2];
+                memcpy( pCurBitmapBuf, &px, 3 );
+            }
+            memset( pCurBitmapBuf, 0, nPadLength );
+        }
+    }
+    else if ( 0 == nPadLength )
+    {
+        memcpy( pCurBitmapBuf, pBuffer, pBitmap->bufferSize );
+    }
+    else
+    {
+        for ( unsigned long y = 0; y < pBitmap->height; ++y, pCurSrc += pBitmap->width * nNumColors )
+        {
+            memcpy( pCurBitmapBuf, pCurSrc, pBitmap->width * nNumColors );
+            pCurBitmapBuf += pBitmap->width * nNumColors;
+            memset( pCurBitmapBuf, 0, nPadLength );
+            pCurBitmapBuf += nPadLength;
+        }
+    }
+    return pBitmapBuffer;
+}
+
+//
+// Converts an image with both functions and compares time and result
+//
+// Parameters:
+//  [in]    pName               The name of the format
+//  [in]    ePixelFormat        The pixel format of the rendered image
+//  [in]    eColorCode          The same layout as a color code
+//  [in]    nWidth              The width of the image, decides the padding
+//  [in]    rOptions            The image count and the height
+//
+// Returns:
+//  False if the bitmaps differ
+//
+bool RunConversion( const char *pName, VmbPixelFormatType ePixelFormat, ColorCode eColorCode, VmbUint32_t nWidth, const BenchmarkOptions &rOptions )
+{
+    const VmbUint64_t nImageCount = 0 != rOptions.nFrameCount ? rOptions.nFrameCount : static_cast<VmbUint64_t>( DEFAULT_IMAGE_COUNT );
+    const VmbUint32_t nHeight = 0 != rOptions.nHeight ? rOptions.nHeight : static_cast<VmbUint32_t>( DEFAULT_HEIGHT );
+
+    const SyntheticFrameSource source( nWidth, nHeight, ePixelFormat, 0.0 );
+    std::vector<VmbUchar_t> image( static_cast<size_t>( nWidth ) * nHeight * GetBitsPerPixel( ePixelFormat ) / 8 );
+    source.Render( &image[0], 0 );
+    AVTBitmap bitmap;
+    bitmap.buffer       = NULL;
+    bitmap.bufferSize   = static_cast<unsigned long>( image.size() );
+    bitmap.width        = nWidth;
+    bitmap.height       = nHeight;
+    bitmap.colorCode    = eColorCode;
+
+    bool bIsSame = true;
+    Clock::time_point tStart = Clock::now();
+    for ( VmbUint64_t i = 0; i < nImageCount; ++i )
+    {
+        unsigned char *pGeneric = CreateBitmapGeneric( &bitmap, &image[0] );
+        if ( NULL == pGeneric )
+        {
+            bIsSame = false;
+            break;
+        }
+        free( pGeneric );
+    }
+    const double dGenericSeconds = std::chrono::duration<double>( Clock::now() - tStart ).count() / nImageCount;
+
+    tStart = Clock::now();
+    for ( VmbUint64_t i = 0; i < nImageCount; ++i )
+    {
+        // AVTCreateBitmap turns RGB24 into BGR24
+        AVTBitmap specialized = bitmap;
+        if ( 0 == AVTCreateBitmap( &specialized, &image[0] ))
+        {
+            bIsSame = false;
+            break;
+        }
+        AVTReleaseBitmap( &specialized );
+    }
+    const double dSpecializedSeconds = std::chrono::duration<double>( Clock::now() - tStart ).count() / nImageCount;
+
+    AVTBitmap specialized = bitmap;
+    unsigned char *pGeneric = CreateBitmapGeneric( &bitmap, &image[0] );
+    if (    NULL == pGeneric
+         || 0 == AVTCreateBitmap( &specialized, &image[0] )
+         || 0 != memcmp( pGeneric, specialized.buffer, specialized.bufferSize ))
+    {
+        bIsSame = false;
+    }
+    free( pGeneric );
+    AVTReleaseBitmap( &specialized );
+
+    printf( "  %-8s %6u %6s %12.3f %12.3f %8.2f%s\n",
+            pName,
+            nWidth,
+            0 != ( nWidth * GetBitsPerPixel( ePixelFormat ) / 8 ) % 4 ? "yes" : "no",
+            dGenericSeconds * 1000.0,
+            dSpecializedSeconds * 1000.0,
+            dGenericSeconds / dSpecializedSeconds,
+            bIsSame ? "" : " differs" );
+    return bIsSame;
+}
+
+} // namespace
+
+bool BenchmarkConversion( const BenchmarkOptions &rOptions )
+{
+    // Rows of an odd width need padding
+    const VmbUint32_t nWidth = 0 != rOptions.nWidth ? rOptions.nWidth : static_cast<VmbUint32_t>( DEFAULT_WIDTH );
+    const VmbUint32_t nPaddedWidth = nWidth | 1;
+    // The stripes would blur the comparison
+    AVTSetBitmapParallelFor( NULL, NULL, 0 );
+
+    printf( "  %-8s %6s %6s %12s %12s %8s\n", "format", "width", "padded", "generic ms", "special ms", "speedup" );
+    bool bIsCorrect = true;
+    bIsCorrect = RunConversion( "Mono8", VmbPixelFormatMono8, ColorCodeMono8, nWidth, rOptions ) && bIsCorrect;
+    bIsCorrect = RunConversion( "Mono8", VmbPixelFormatMono8, ColorCodeMono8, nPaddedWidth, rOptions ) && bIsCorrect;
+    bIsCorrect = RunConversion( "BGR8", VmbPixelFormatBgr8, ColorCodeBGR24, nWidth, rOptions ) && bIsCorrect;
+    bIsCorrect = RunConversion( "BGR8", VmbPixelFormatBgr8, ColorCodeBGR24, nPaddedWidth, rOptions ) && bIsCorrect;
+    bIsCorrect = RunConversion( "RGB8", VmbPixelFormatRgb8, ColorCodeRGB24, nWidth, rOptions ) && bIsCorrect;
+    bIsCorrect = RunConversion( "RGB8", VmbPixelFormatRgb8, ColorCodeRGB24, nPaddedWidth, rOptions ) && bIsCorrect;
+    return bIsCorrect;
+}
+
+}}} // namespace AVT::VmbAPI::Examples
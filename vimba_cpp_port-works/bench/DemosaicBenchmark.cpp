@@ -0,0 +1,223 @@
+/*=============================================================================
+  Copyright (C) 2013 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        DemosaicBenchmark.cpp
+
+  Description: Measures the throughput of the demosaic kernels and of the stripes on
+               1 to N cores, and checks the kernels against the scalar reference (PSNR)
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "BayerImage.h"
+#include "Benchmarks.h"
+#include "Demosaic.h"
+#include "SyntheticFrameSource.h"
+#include "WorkerPool.h"
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+namespace
+{
+
+typedef std::chrono::steady_clock Clock;
+
+enum { DEFAULT_IMAGE_COUNT = 20, };
+// A 5 MP sensor
+enum { DEFAULT_WIDTH = 2448, };
+enum { DEFAULT_HEIGHT = 2048, };
+// A kernel may round differently from the reference, but not by more than this
+enum { MIN_PSNR_DB = 50, };
+
+const char* const METHOD_NAMES[DemosaicMethodCount] = { "bilinear", "edge" };
+
+//
+// Gets the peak signal to noise ratio of an 8 bit image against a reference
+//
+// Parameters:
+//  [in]    rImage              The image
+//  [in]    rReference          The reference, as large as the image
+//
+// Returns:
+//  The PSNR in dB, HUGE_VAL if the images are the same
+//
+double GetPsnr( const std::vector<VmbUchar_t> &rImage, const std::vector<VmbUchar_t> &rReference )
+{
+    double dSquaredError = 0.0;
+    for ( size_t i = 0; i < rImage.size(); ++i )
+    {
+        const double dError = static_cast<double>( rImage[i] ) - rReference[i];
+        dSquaredError += dError * dError;
+    }
+    if ( 0.0 == dSquaredError )
+    {
+        return HUGE_VAL;
+    }
+    return 10.0 * log10( 255.0 * 255.0 * rImage.size() / dSquaredError );
+}
+
+//
+// Demosaics the image with every kernel this CPU has and compares each with the scalar reference
+//
+// Returns:
+//  False if a kernel is too far from the reference
+//
+bool RunKernels( const ImageFrame &rFrame, VmbUint64_t nImageCount )
+{
+    BayerPattern ePattern = BayerPatternRG;
+    GetBayerPattern( rFrame.ePixelFormat, ePattern );
+    const size_t nSize = static_cast<size_t>( rFrame.nWidth ) * rFrame.nHeight * 3;
+    bool bIsCorrect = true;
+
+    printf( "  %-8s %-8s %10s %10s\n", "kernel", "method", "MPixel/s", "PSNR dB" );
+    for ( int m = 0; m < DemosaicMethodCount; ++m )
+    {
+        const DemosaicMethod eMethod = static_cast<DemosaicMethod>( m );
+        std::vector<VmbUchar_t> reference( nSize );
+        AVTGetDemosaicKernel( SwizzleKernelScalar )( ePattern, eMethod, rFrame.pImage, rFrame.nWidth, rFrame.nHeight, &reference[0], 0, rFrame.nHeight );
+        for ( int k = 0; k < SwizzleKernelCount; ++k )
+        {
+            const AVTDemosaicFunc pKernel = AVTGetDemosaicKernel( static_cast<SwizzleKernel>( k ));
+            if ( NULL == pKernel )
+            {
+                continue;
+            }
+            std::vector<VmbUchar_t> image( nSize );
+            const Clock::time_point tStart = Clock::now();
+            for ( VmbUint64_t i = 0; i < nImageCount; ++i )
+            {
+                pKernel( ePattern, eMethod, rFrame.pImage, rFrame.nWidth, rFrame.nHeight, &image[0], 0, rFrame.nHeight );
+            }
+            const double dSeconds = std::chrono::duration<double>( Clock::now() - tStart ).count() / nImageCount;
+            const double dPsnr = GetPsnr( image, reference );
+            const bool bIsClose = dPsnr >= MIN_PSNR_DB;
+            bIsCorrect = bIsCorrect && bIsClose;
+            printf( "  %-8s %-8s %10.1f %10.1f%s\n",
+                    AVTGetSwizzleKernelName( static_cast<SwizzleKernel>( k )),
+                    METHOD_NAMES[m],
+                    static_cast<double>( rFrame.nWidth ) * rFrame.nHeight / dSeconds / 1e6,
+                    dPsnr,
+                    bIsClose ? "" : " too far from the reference" );
+        }
+    }
+    return bIsCorrect;
+}
+
+//
+// Demosaics the image in stripes on 1 to N cores with the best kernel, the result must not change
+//
+// Returns:
+//  False if the stripes gave another image than a single core
+//
+bool RunStripes( const ImageFrame &rFrame, VmbUint64_t nImageCount, VmbUint32_t nMaxCores )
+{
+    const size_t nSize = static_cast<size_t>( rFrame.nWidth ) * rFrame.nHeight * 3;
+    bool bIsCorrect = true;
+
+    printf( "  %-8s %-8s %8s %10s %10s\n", "kernel", "method", "cores", "MPixel/s", "speedup" );
+    for ( int m = 0; m < DemosaicMethodCount; ++m )
+    {
+        const DemosaicMethod eMethod = static_cast<DemosaicMethod>( m );
+        std::vector<VmbUchar_t> reference;
+        double dSingleSeconds = 0.0;
+        for ( VmbUint32_t nCores = 1; nCores <= nMaxCores; ++nCores )
+        {
+            // The calling thread demosaics stripes as well, so N cores are a pool of N - 1 threads
+            std::unique_ptr<WorkerPool> pPool;
+            if ( 1 < nCores )
+            {
+                pPool.reset( new WorkerPool( nCores - 1 ));
+            }
+            std::vector<VmbUchar_t> image( nSize );
+            const Clock::time_point tStart = Clock::now();
+            for ( VmbUint64_t i = 0; i < nImageCount; ++i )
+            {
+                if ( VmbErrorSuccess != DemosaicImage( rFrame, eMethod, &image[0], pPool.get() ))
+                {
+                    bIsCorrect = false;
+                }
+            }
+            const double dSeconds = std::chrono::duration<double>( Clock::now() - tStart ).count() / nImageCount;
+
+            bool bIsSame = true;
+            if ( 1 == nCores )
+            {
+                reference.swap( image );
+                dSingleSeconds = dSeconds;
+            }
+            else
+            {
+                bIsSame = image == reference;
+                bIsCorrect = bIsCorrect && bIsSame;
+            }
+            printf( "  %-8s %-8s %8u %10.1f %10.2f%s\n",
+                    AVTGetSwizzleKernelName( AVTGetBestSwizzleKernel() ),
+                    METHOD_NAMES[m],
+                    nCores,
+                    static_cast<double>( rFrame.nWidth ) * rFrame.nHeight / dSeconds / 1e6,
+                    dSingleSeconds / dSeconds,
+                    bIsSame ? "" : " differs" );
+        }
+    }
+    return bIsCorrect;
+}
+
+} // namespace
+
+bool BenchmarkDemosaic( const BenchmarkOptions &rOptions )
+{
+    const VmbUint64_t nImageCount = 0 != rOptions.nFrameCount ? rOptions.nFrameCount : static_cast<VmbUint64_t>( DEFAULT_IMAGE_COUNT );
+    const VmbUint32_t nWidth = 0 != rOptions.nWidth ? rOptions.nWidth : static_cast<VmbUint32_t>( DEFAULT_WIDTH );
+    const VmbUint32_t nHeight = 0 != rOptions.nHeight ? rOptions.nHeight : static_cast<VmbUint32_t>( DEFAULT_HEIGHT );
+    const VmbUint32_t nMaxCores = 0 != rOptions.nThreadCount ? rOptions.nThreadCount : ( std::max )( std::thread::hardware_concurrency(), 1u );
+    if (    nWidth < 2
+         || nHeight < 2 )
+    {
+        printf( "  The image must be at least 2x2\n" );
+        return false;
+    }
+
+    const SyntheticFrameSource source( nWidth, nHeight, VmbPixelFormatBayerRG8, 0.0 );
+    std::vector<VmbUchar_t> bayer( static_cast<size_t>( nWidth ) * nHeight );
+    source.Render( &bayer[0], 0 );
+    ImageFrame frame;
+    frame.pImage        = &bayer[0];
+    frame.nImageSize    = static_cast<VmbUint32_t>( bayer.size() );
+    frame.nWidth        = nWidth;
+    frame.nHeight       = nHeight;
+    frame.ePixelFormat  = VmbPixelFormatBayerRG8;
+
+    bool bIsCorrect = true;
+    bIsCorrect = RunKernels( frame, nImageCount ) && bIsCorrect;
+    bIsCorrect = RunStripes( frame, nImageCount, nMaxCores ) && bIsCorrect;
+    return bIsCorrect;
+}
+
+}}} // namespace AVT::VmbAPI::Examples
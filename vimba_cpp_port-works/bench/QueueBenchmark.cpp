@@ -0,0 +1,217 @@
+/*=============================================================================
+  Copyright (C) 2013 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        QueueBenchmark.cpp
+
+  Description: Throughput and hand-off latency of the lock-free frame queues
+               against a queue guarded by a mutex and a condition variable.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "Benchmarks.h"
+#include "FrameQueue.h"
+#include "LatencyMonitor.h"
+#include "SyntheticFrameSource.h"
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+namespace
+{
+
+enum { DEFAULT_FRAME_COUNT = 1000000, };
+enum { DEFAULT_PRODUCER_COUNT = 4, };
+enum { QUEUE_CAPACITY = 64, };
+// Small images, so the benchmark measures the hand-off and not the rendering
+enum { DEFAULT_WIDTH = 16, };
+enum { DEFAULT_HEIGHT = 4, };
+
+//
+// The way frames were handed over before the lock-free queues, as the reference
+//
+class MutexFrameQueue
+{
+  public:
+    explicit MutexFrameQueue( size_t nCapacity )
+        : m_nCapacity( nCapacity )
+        , m_nOverflows( 0 )
+        , m_bIsClosed( false )
+    {
+    }
+
+    bool Push( ImageFrame item, QueueMode /*eMode*/ )
+    {
+        std::unique_lock<std::mutex> lock( m_mutex );
+        if ( m_frames.size() >= m_nCapacity )
+        {
+            ++m_nOverflows;
+            m_notFull.wait( lock, [this]() { return m_frames.size() < m_nCapacity || m_bIsClosed; } );
+        }
+        if ( m_bIsClosed )
+        {
+            return false;
+        }
+        item.nQueueTime = GetLatencyClock();
+        m_frames.push_back( item );
+        m_notEmpty.notify_one();
+        return true;
+    }
+
+    bool Pop( ImageFrame &rItem )
+    {
+        std::unique_lock<std::mutex> lock( m_mutex );
+        m_notEmpty.wait( lock, [this]() { return !m_frames.empty() || m_bIsClosed; } );
+        if ( m_frames.empty() )
+        {
+            return false;
+        }
+        rItem = m_frames.front();
+        m_frames.pop_front();
+        m_notFull.notify_one();
+        return true;
+    }
+
+    void Close()
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        m_bIsClosed = true;
+        m_notFull.notify_all();
+        m_notEmpty.notify_all();
+    }
+
+    VmbUint64_t GetOverflowCount() const
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        return m_nOverflows;
+    }
+
+  private:
+    const size_t                m_nCapacity;
+    std::deque<ImageFrame>      m_frames;
+    VmbUint64_t                 m_nOverflows;
+    bool                        m_bIsClosed;
+    mutable std::mutex          m_mutex;
+    std::condition_variable     m_notEmpty;
+    std::condition_variable     m_notFull;
+};
+
+//
+// Streams frames of synthetic sources rendering as fast as they can through a queue to the calling thread
+//
+// Parameters:
+//  [in]    pName               The name to print
+//  [in]    nSourceCount        The producer threads
+//  [in]    eMode               How the producers push
+//  [in]    rOptions            The frames to hand over and their size
+//
+// Returns:
+//  False if frames got lost or out of order
+//
+template <typename Queue>
+bool RunQueue( const char *pName, VmbUint32_t nSourceCount, QueueMode eMode, const BenchmarkOptions &rOptions )
+{
+    typedef std::chrono::steady_clock Clock;
+    const VmbUint64_t nFrameCount = 0 != rOptions.nFrameCount ? rOptions.nFrameCount : static_cast<VmbUint64_t>( DEFAULT_FRAME_COUNT );
+    const VmbUint32_t nWidth = 0 != rOptions.nWidth ? rOptions.nWidth : static_cast<VmbUint32_t>( DEFAULT_WIDTH );
+    const VmbUint32_t nHeight = 0 != rOptions.nHeight ? rOptions.nHeight : static_cast<VmbUint32_t>( DEFAULT_HEIGHT );
+
+    Queue queue( QUEUE_CAPACITY );
+    std::vector< std::unique_ptr<SyntheticFrameSource> > sources;
+    for ( VmbUint32_t i = 0; i < nSourceCount; ++i )
+    {
+        // The width tells the sources apart
+        sources.push_back( std::unique_ptr<SyntheticFrameSource>( new SyntheticFrameSource( nWidth + i, nHeight, VmbPixelFormatMono8, 0.0 )));
+    }
+
+    const Clock::time_point tStart = Clock::now();
+    for ( VmbUint32_t i = 0; i < nSourceCount; ++i )
+    {
+        sources[i]->Start( [&queue, eMode]( const ImageFrame &rFrame ) { queue.Push( rFrame, eMode ); }, 4 );
+    }
+
+    LatencyHistogram histogram;
+    std::vector<VmbUint64_t> nextFrameIDs( nSourceCount, 0 );
+    bool bIsInOrder = true;
+    ImageFrame frame;
+    VmbUint64_t nReceivedCount = 0;
+    while (    nReceivedCount < nFrameCount
+            && queue.Pop( frame ))
+    {
+        histogram.Add( GetLatencyClock() - frame.nQueueTime );
+        const VmbUint32_t nSource = frame.nWidth - nWidth;
+        bIsInOrder = bIsInOrder && nSource < nSourceCount && nextFrameIDs[nSource]++ == frame.nFrameID;
+        ++nReceivedCount;
+    }
+    const double dSeconds = std::chrono::duration<double>( Clock::now() - tStart ).count();
+    queue.Close();
+    for ( VmbUint32_t i = 0; i < nSourceCount; ++i )
+    {
+        sources[i]->Stop();
+    }
+
+    printf( "  %-20s %2u %12.0f %8.2f %8.2f %8.2f %10.2f %10llu\n",
+            pName,
+            nSourceCount,
+            nReceivedCount / dSeconds,
+            histogram.GetPercentileNS( 50.0 ) / 1000.0,
+            histogram.GetPercentileNS( 99.0 ) / 1000.0,
+            histogram.GetPercentileNS( 99.9 ) / 1000.0,
+            histogram.GetMaxNS() / 1000.0,
+            static_cast<unsigned long long>( queue.GetOverflowCount() ));
+    return bIsInOrder && nFrameCount == nReceivedCount;
+}
+
+} // namespace
+
+//
+// Hands the frames of one and of several synthetic sources to a consumer thread through every queue
+//
+// Parameters:
+//  [in]    rOptions            -n frames, -j producers for the multi producer runs, -s image size
+//
+// Returns:
+//  False if a queue lost frames or mixed up their order
+//
+bool BenchmarkQueues( const BenchmarkOptions &rOptions )
+{
+    const VmbUint32_t nProducerCount = 0 != rOptions.nThreadCount ? rOptions.nThreadCount : static_cast<VmbUint32_t>( DEFAULT_PRODUCER_COUNT );
+    printf( "  %-20s %2s %12s %8s %8s %8s %10s %10s\n", "queue", "p", "frames/s", "p50 us", "p99 us", "p99.9 us", "max us", "overflows" );
+    bool bIsCorrect = true;
+    bIsCorrect = RunQueue<MutexFrameQueue>( "mutex", 1, QueueModeBlock, rOptions ) && bIsCorrect;
+    bIsCorrect = RunQueue<SpscFrameQueue>( "spsc block", 1, QueueModeBlock, rOptions ) && bIsCorrect;
+    bIsCorrect = RunQueue<SpscFrameQueue>( "spsc spin", 1, QueueModeSpin, rOptions ) && bIsCorrect;
+    bIsCorrect = RunQueue<MutexFrameQueue>( "mutex", nProducerCount, QueueModeBlock, rOptions ) && bIsCorrect;
+    bIsCorrect = RunQueue<MpscFrameQueue>( "mpsc block", nProducerCount, QueueModeBlock, rOptions ) && bIsCorrect;
+    bIsCorrect = RunQueue<MpscFrameQueue>( "mpsc spin", nProducerCount, QueueModeSpin, rOptions ) && bIsCorrect;
+    bIsCorrect = RunQueue< FrameQueue< MpmcRing<ImageFrame> > >( "mpmc block", nProducerCount, QueueModeBlock, rOptions ) && bIsCorrect;
+    return bIsCorrect;
+}
+
+}}} // namespace AVT::VmbAPI::Examples
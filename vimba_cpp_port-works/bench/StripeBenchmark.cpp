@@ -0,0 +1,168 @@
+/*=============================================================================
+  Copyright (C) 2013 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        StripeBenchmark.cpp
+
+  Description: Measures how AVTCreateBitmap scales with the cores that convert the
+               stripes of a large image, and checks the bitmaps stay the same
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "Benchmarks.h"
+#include "Bitmap.h"
+#include "SyntheticFrameSource.h"
+#include "WorkerPool.h"
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+namespace
+{
+
+typedef std::chrono::steady_clock Clock;
+
+enum { DEFAULT_IMAGE_COUNT = 20, };
+// A 20 MP sensor
+enum { DEFAULT_WIDTH = 5472, };
+enum { DEFAULT_HEIGHT = 3648, };
+
+//
+// Converts an image into a bitmap with AVTCreateBitmap
+//
+// Parameters:
+//  [in]    rImage              The image
+//  [in]    nWidth              The width of the image
+//  [in]    nHeight             The height of the image
+//  [in]    eColorCode          The layout of the image
+//  [out]   rBitmap             The bitmap file, header included
+//
+// Returns:
+//  False if AVTCreateBitmap failed
+//
+bool CreateBitmap( const std::vector<VmbUchar_t> &rImage, VmbUint32_t nWidth, VmbUint32_t nHeight, ColorCode eColorCode, std::vector<VmbUchar_t> &rBitmap )
+{
+    AVTBitmap bitmap;
+    bitmap.buffer       = NULL;
+    bitmap.bufferSize   = static_cast<unsigned long>( rImage.size() );
+    bitmap.width        = nWidth;
+    bitmap.height       = nHeight;
+    bitmap.colorCode    = eColorCode;
+    if ( 0 == AVTCreateBitmap( &bitmap, &rImage[0] ))
+    {
+        return false;
+    }
+    const VmbUchar_t *pBitmap = static_cast<const VmbUchar_t*>( bitmap.buffer );
+    rBitmap.assign( pBitmap, pBitmap + bitmap.bufferSize );
+    AVTReleaseBitmap( &bitmap );
+    return true;
+}
+
+//
+// Converts an image on 1 to N cores and compares the bitmaps with the one of a single core
+//
+// Parameters:
+//  [in]    pName               The name of the format
+//  [in]    ePixelFormat        The pixel format of the rendered image
+//  [in]    eColorCode          The same layout as a color code
+//  [in]    rOptions            The image count, the most cores and the image size
+//
+// Returns:
+//  False if a bitmap differed
+//
+bool RunStripes( const char *pName, VmbPixelFormatType ePixelFormat, ColorCode eColorCode, const BenchmarkOptions &rOptions )
+{
+    const VmbUint64_t nImageCount = 0 != rOptions.nFrameCount ? rOptions.nFrameCount : static_cast<VmbUint64_t>( DEFAULT_IMAGE_COUNT );
+    const VmbUint32_t nWidth = 0 != rOptions.nWidth ? rOptions.nWidth : static_cast<VmbUint32_t>( DEFAULT_WIDTH );
+    const VmbUint32_t nHeight = 0 != rOptions.nHeight ? rOptions.nHeight : static_cast<VmbUint32_t>( DEFAULT_HEIGHT );
+    const VmbUint32_t nMaxCores = 0 != rOptions.nThreadCount ? rOptions.nThreadCount : ( std::max )( std::thread::hardware_concurrency(), 1u );
+
+    const SyntheticFrameSource source( nWidth, nHeight, ePixelFormat, 0.0 );
+    std::vector<VmbUchar_t> image( static_cast<size_t>( nWidth ) * nHeight * GetBitsPerPixel( ePixelFormat ) / 8 );
+    source.Render( &image[0], 0 );
+
+    std::vector<VmbUchar_t> reference;
+    double dSingleSeconds = 0.0;
+    bool bIsCorrect = true;
+    for ( VmbUint32_t nCores = 1; nCores <= nMaxCores; ++nCores )
+    {
+        // The calling thread converts stripes as well, so N cores are a pool of N - 1 threads
+        std::unique_ptr<WorkerPool> pPool;
+        if ( 1 < nCores )
+        {
+            pPool.reset( new WorkerPool( nCores - 1 ));
+            pPool->UseForBitmaps();
+        }
+
+        std::vector<VmbUchar_t> bitmap;
+        const Clock::time_point tStart = Clock::now();
+        for ( VmbUint64_t i = 0; i < nImageCount; ++i )
+        {
+            if ( !CreateBitmap( image, nWidth, nHeight, eColorCode, bitmap ))
+            {
+                bIsCorrect = false;
+            }
+        }
+        const double dSeconds = std::chrono::duration<double>( Clock::now() - tStart ).count() / nImageCount;
+        // The pool must not be used once it is gone
+        AVTSetBitmapParallelFor( NULL, NULL, 0 );
+
+        bool bIsSame = true;
+        if ( 1 == nCores )
+        {
+            reference.swap( bitmap );
+            dSingleSeconds = dSeconds;
+        }
+        else
+        {
+            bIsSame = bitmap == reference;
+            bIsCorrect = bIsCorrect && bIsSame;
+        }
+        printf( "  %-8s %5u %10.2f %10.1f %8.2f%s\n",
+                pName,
+                nCores,
+                dSeconds * 1000.0,
+                image.size() / dSeconds / ( 1024.0 * 1024.0 ),
+                dSingleSeconds / dSeconds,
+                bIsSame ? "" : " differs" );
+    }
+    return bIsCorrect;
+}
+
+} // namespace
+
+bool BenchmarkStripes( const BenchmarkOptions &rOptions )
+{
+    printf( "  %-8s %5s %10s %10s %8s\n", "format", "cores", "ms/image", "MB/s", "speedup" );
+    bool bIsCorrect = true;
+    bIsCorrect = RunStripes( "Mono8", VmbPixelFormatMono8, ColorCodeMono8, rOptions ) && bIsCorrect;
+    bIsCorrect = RunStripes( "RGB8", VmbPixelFormatRgb8, ColorCodeRGB24, rOptions ) && bIsCorrect;
+    return bIsCorrect;
+}
+
+}}} // namespace AVT::VmbAPI::Examples
@@ -0,0 +1,95 @@
+/*=============================================================================
+  Copyright (C) 2013 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        SwizzleBenchmark.cpp
+
+  Description: Measures the throughput of every available RGB swap kernel
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "Benchmarks.h"
+#include "PixelSwizzle.h"
+#include "SyntheticFrameSource.h"
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+namespace
+{
+
+typedef std::chrono::steady_clock Clock;
+
+enum { DEFAULT_IMAGE_COUNT = 100, };
+enum { DEFAULT_WIDTH = 2048, };
+enum { DEFAULT_HEIGHT = 1536, };
+
+} // namespace
+
+bool BenchmarkSwizzle( const BenchmarkOptions &rOptions )
+{
+    const VmbUint64_t nImageCount = 0 != rOptions.nFrameCount ? rOptions.nFrameCount : static_cast<VmbUint64_t>( DEFAULT_IMAGE_COUNT );
+    const VmbUint32_t nWidth = 0 != rOptions.nWidth ? rOptions.nWidth : static_cast<VmbUint32_t>( DEFAULT_WIDTH );
+    const VmbUint32_t nHeight = 0 != rOptions.nHeight ? rOptions.nHeight : static_cast<VmbUint32_t>( DEFAULT_HEIGHT );
+    const unsigned long nPixels = static_cast<unsigned long>( nWidth ) * nHeight;
+
+    const SyntheticFrameSource source( nWidth, nHeight, VmbPixelFormatRgb8, 0.0 );
+    std::vector<VmbUchar_t> image( static_cast<size_t>( nPixels ) * 3 );
+    source.Render( &image[0], 0 );
+    std::vector<VmbUchar_t> reference( image.size() );
+    std::vector<VmbUchar_t> swapped( image.size() );
+    AVTGetSwapRGBKernel( SwizzleKernelScalar )( &image[0], &reference[0], nPixels );
+
+    printf( "  %-8s %10s %10s\n", "kernel", "ms", "GB/s" );
+    bool bIsCorrect = true;
+    for ( int i = 0; i < SwizzleKernelCount; ++i )
+    {
+        const SwizzleKernel eKernel = static_cast<SwizzleKernel>( i );
+        AVTSwapRGBFunc pKernel = AVTGetSwapRGBKernel( eKernel );
+        if ( NULL == pKernel )
+        {
+            continue;
+        }
+        const Clock::time_point tStart = Clock::now();
+        for ( VmbUint64_t j = 0; j < nImageCount; ++j )
+        {
+            pKernel( &image[0], &swapped[0], nPixels );
+        }
+        const double dSeconds = std::chrono::duration<double>( Clock::now() - tStart ).count() / nImageCount;
+        const bool bIsSame = 0 == memcmp( &reference[0], &swapped[0], swapped.size() );
+        bIsCorrect = bIsCorrect && bIsSame;
+        // The bytes read, as memcpy benchmarks count them
+        printf( "  %-8s %10.3f %10.2f%s\n",
+                AVTGetSwizzleKernelName( eKernel ),
+                dSeconds * 1000.0,
+                image.size() / dSeconds / 1e9,
+                bIsSame ? "" : " differs" );
+        memset( &swapped[0], 0, swapped.size() );
+    }
+    return bIsCorrect;
+}
+
+}}} // namespace AVT::VmbAPI::Examples
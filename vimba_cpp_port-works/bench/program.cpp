@@ -0,0 +1,167 @@
+/*=============================================================================
+  Copyright (C) 2013 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        program.cpp
+
+  Description: Measures the throughput of the queues and image conversions of the
+               shared sources on synthetic frames and images.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include "Benchmarks.h"
+
+using namespace AVT::VmbAPI::Examples;
+
+namespace
+{
+
+struct Benchmark
+{
+    const char*         pName;
+    bool                (*pRun)( const BenchmarkOptions &rOptions );
+    const char*         pDescription;
+};
+
+// Ends with an empty entry
+const Benchmark BENCHMARKS[] =
+{
+    { "queue",      BenchmarkQueues,        "Hands frames of synthetic sources to a consumer through the frame queues and a mutex queue" },
+    { "stripes",    BenchmarkStripes,       "Converts a large image into a bitmap on 1 to N cores" },
+    { "convert",    BenchmarkConversion,    "Converts images into bitmaps with the specialized and the generic conversion" },
+    { "demosaic",   BenchmarkDemosaic,      "Demosaics a Bayer image with every kernel and in stripes on 1 to N cores" },
+    { "swizzle",    BenchmarkSwizzle,       "Swaps the channels of RGB images with every available kernel" },
+    { NULL,         NULL,                   NULL },
+};
+
+void PrintUsage()
+{
+    printf( "Usage: vimbacppbench <benchmark> [options]\n\n" );
+    for ( size_t i = 0; NULL != BENCHMARKS[i].pName; ++i )
+    {
+        printf( "  %-12s %s\n", BENCHMARKS[i].pName, BENCHMARKS[i].pDescription );
+    }
+    printf( "  all          Runs all of them\n\n" );
+    printf( "Options:\n" );
+    printf( "  -n, --count <N>             The frames or images to measure with\n" );
+    printf( "  -j, --threads <N>           The most threads to use\n" );
+    printf( "  -s, --size <W>x<H>          The size of the images\n" );
+}
+
+//
+// Parses a whole number, rejecting anything but digits
+//
+bool ParseNumber( const char *pText, VmbUint64_t &rnValue )
+{
+    char *pEnd = NULL;
+    if (    NULL == pText
+         || '\0' == *pText
+         || '-' == *pText )
+    {
+        return false;
+    }
+    rnValue = strtoull( pText, &pEnd, 10 );
+    return '\0' == *pEnd && 0 != rnValue;
+}
+
+//
+// Reads the options after the benchmark name
+//
+bool ParseOptions( int nArgCount, char *ppArgs[], BenchmarkOptions &rOptions )
+{
+    for ( int i = 2; i < nArgCount; ++i )
+    {
+        const std::string strOption( ppArgs[i] );
+        const char *pValue = i + 1 < nArgCount ? ppArgs[++i] : NULL;
+        VmbUint64_t nValue = 0;
+        bool bIsValid = false;
+        if (    "-n" == strOption
+             || "--count" == strOption )
+        {
+            bIsValid = ParseNumber( pValue, rOptions.nFrameCount );
+        }
+        else if (    "-j" == strOption
+                  || "--threads" == strOption )
+        {
+            bIsValid = ParseNumber( pValue, nValue ) && nValue <= 1024;
+            rOptions.nThreadCount = static_cast<VmbUint32_t>( nValue );
+        }
+        else if (    "-s" == strOption
+                  || "--size" == strOption )
+        {
+            unsigned int nWidth = 0;
+            unsigned int nHeight = 0;
+            char cEnd = '\0';
+            bIsValid =     NULL != pValue
+                        && 2 == sscanf( pValue, "%ux%u%c", &nWidth, &nHeight, &cEnd )
+                        && 0 != nWidth
+                        && 0 != nHeight;
+            rOptions.nWidth = nWidth;
+            rOptions.nHeight = nHeight;
+        }
+        if ( !bIsValid )
+        {
+            fprintf( stderr, "Unknown option or invalid value: %s\n", strOption.c_str() );
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int main( int argc, char* argv[] )
+{
+    BenchmarkOptions options;
+    if (    argc < 2
+         || !ParseOptions( argc, argv, options ))
+    {
+        PrintUsage();
+        return 1;
+    }
+
+    const std::string strName( argv[1] );
+    bool bIsKnown = "all" == strName;
+    bool bIsCorrect = true;
+    for ( size_t i = 0; NULL != BENCHMARKS[i].pName; ++i )
+    {
+        if (    "all" == strName
+             || strName == BENCHMARKS[i].pName )
+        {
+            bIsKnown = true;
+            printf( "%s\n", BENCHMARKS[i].pName );
+            if ( !BENCHMARKS[i].pRun( options ))
+            {
+                printf( "%s gave a wrong result\n", BENCHMARKS[i].pName );
+                bIsCorrect = false;
+            }
+        }
+    }
+    if ( !bIsKnown )
+    {
+        PrintUsage();
+        return 1;
+    }
+    return bIsCorrect ? 0 : 2;
+}
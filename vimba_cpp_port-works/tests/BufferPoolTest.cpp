@@ -0,0 +1,140 @@
+/*=============================================================================
+  Copyright (C) 2013 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        BufferPoolTest.cpp
+
+  Description: Checks that saving a stream allocates no memory once the buffer pool is warm
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ApiController.h"
+#include "BufferPool.h"
+#include "ImageWriter.h"
+#include "SimulatedCameraBackend.h"
+#include "Tests.h"
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+namespace
+{
+
+// Every buffer the save path needs has been allocated once after these frames
+enum { WARMUP_FRAME_COUNT = 4, };
+enum { FRAME_COUNT = 40, };
+// Rows of RGB bitmaps of this width need padding
+enum { WIDTH = 62, };
+enum { HEIGHT = 48, };
+enum { RING_FRAME_COUNT = 4, };
+
+//
+// Streams from a synthetic camera, saves and converts every frame and checks that
+// the default pool stops allocating from the system after the warm-up frames
+//
+// Parameters:
+//  [in]    pName               The name of the pixel format, part of the camera ID and the file name
+//  [in]    ePixelFormat        The pixel format of the camera
+//  [in]    nBuffersPerFrame    The pool buffers saving a frame takes: the copy and a converted image or the staging rows
+//
+void TestSteadyState( const char *pName, VmbPixelFormatType ePixelFormat, VmbUint64_t nBuffersPerFrame )
+{
+    SyntheticCameraConfig config;
+    config.strID        = std::string( "BufferPoolTest" ) + pName;
+    config.nWidth       = WIDTH;
+    config.nHeight      = HEIGHT;
+    config.ePixelFormat = ePixelFormat;
+    config.dFrameRate   = 0.0;
+    std::shared_ptr<SimulatedCameraBackend> pBackend( new SimulatedCameraBackend() );
+    pBackend->AddSyntheticCamera( config );
+    ApiController controller( pBackend );
+    controller.SetPixelFormats( std::vector<VmbPixelFormatType>( 1, ePixelFormat ));
+    TEST_CHECK( VmbErrorSuccess == controller.StartUp() );
+
+    // Every frame is written before the next one comes, so the writer never holds more than one
+    const std::string strFileName = GetTestFileName( ( config.strID + ".bmp" ).c_str(), true );
+    BufferPool &rPool = BufferPool::GetDefault();
+    ImageWriter writer;
+    BufferPoolStatistics warm;
+    std::atomic<VmbUint64_t> nDeliveredCount( 0 );
+    std::atomic<VmbUint64_t> nFailedCount( 0 );
+    const VmbErrorType res = controller.StartContinuousAcquisition( config.strID,
+                                                                    [&]( const ImageFrame &rFrame )
+                                                                    {
+                                                                        const VmbUint64_t nIndex = nDeliveredCount.fetch_add( 1 );
+                                                                        if ( FRAME_COUNT <= nIndex )
+                                                                        {
+                                                                            return;
+                                                                        }
+                                                                        if ( VmbErrorSuccess != writer.SubmitCopy( rFrame, strFileName ))
+                                                                        {
+                                                                            ++nFailedCount;
+                                                                        }
+                                                                        writer.Flush();
+                                                                        if ( WARMUP_FRAME_COUNT - 1 == nIndex )
+                                                                        {
+                                                                            warm = rPool.GetStatistics();
+                                                                        }
+                                                                    },
+                                                                    RING_FRAME_COUNT );
+    TEST_CHECK( VmbErrorSuccess == res );
+    while (    VmbErrorSuccess == res
+            && nDeliveredCount < FRAME_COUNT )
+    {
+        std::this_thread::yield();
+    }
+    TEST_CHECK( VmbErrorSuccess == controller.StopContinuousAcquisition() );
+    writer.Flush();
+    const BufferPoolStatistics steady = rPool.GetStatistics();
+    controller.ShutDown();
+    remove( strFileName.c_str() );
+
+    TEST_CHECK( 0 == nFailedCount );
+    TEST_CHECK( FRAME_COUNT == writer.GetStatistics().nWrittenCount );
+    TEST_CHECK( warm.nSystemAllocations == steady.nSystemAllocations );
+    TEST_CHECK( ( FRAME_COUNT - WARMUP_FRAME_COUNT ) * nBuffersPerFrame == steady.nRecycled - warm.nRecycled );
+    printf( "  %-8s %llu allocations after %u frames, %llu after %u\n",
+            pName,
+            static_cast<unsigned long long>( warm.nSystemAllocations ),
+            static_cast<unsigned int>( WARMUP_FRAME_COUNT ),
+            static_cast<unsigned long long>( steady.nSystemAllocations ),
+            static_cast<unsigned int>( FRAME_COUNT ));
+}
+
+} // namespace
+
+void TestBufferPool()
+{
+    // RGB8 rows are swapped in the staging buffer, Mono12 and Bayer images are converted into pool buffers
+    TestSteadyState( "Mono8",       VmbPixelFormatMono8,    1 );
+    TestSteadyState( "RGB8",        VmbPixelFormatRgb8,     2 );
+    TestSteadyState( "Mono12",      VmbPixelFormatMono12,   2 );
+    TestSteadyState( "BayerRG8",    VmbPixelFormatBayerRG8, 2 );
+}
+
+}}} // namespace AVT::VmbAPI::Examples
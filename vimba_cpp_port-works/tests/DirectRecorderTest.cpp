@@ -0,0 +1,151 @@
+/*=============================================================================
+  Copyright (C) 2013 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        DirectRecorderTest.cpp
+
+  Description: Records frames of a synthetic source with DirectRecorder while the
+               statistics are read from another thread and reads them back
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "DirectRecorder.h"
+#include "RecordingFile.h"
+#include "SyntheticFrameSource.h"
+#include "Tests.h"
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+namespace
+{
+
+enum { RECORD_FRAME_COUNT = 2000, };
+enum { RECORD_WIDTH = 64, };
+enum { RECORD_HEIGHT = 48, };
+// Small chunks, so the recording takes many writes and Append has to wait for the disk now and then
+enum { RECORD_CHUNK_SIZE = 4 * DIRECT_IO_ALIGNMENT, };
+
+//
+// Records RECORD_FRAME_COUNT frames of a synthetic source, polls the statistics on the way and
+// checks that the recording holds every frame in order and unchanged
+//
+// Parameters:
+//  [in]    rRecorder           The recorder, closed
+//  [in]    rFileName           The recording to create
+//
+void TestRecord( DirectRecorder &rRecorder, const std::string &rFileName )
+{
+    TEST_CHECK( VmbErrorSuccess == rRecorder.Open( rFileName ));
+
+    SyntheticFrameSource source( RECORD_WIDTH, RECORD_HEIGHT, VmbPixelFormatMono8, 0.0 );
+    std::atomic<VmbUint64_t> nAppendedCount( 0 );
+    std::atomic<VmbUint64_t> nFailedCount( 0 );
+    std::atomic<bool> bIsDone( false );
+    // Reads the counters while frames are appended, they must never go back
+    std::thread poller( [&rRecorder, &bIsDone]()
+                        {
+                            VmbUint64_t nLastCount = 0;
+                            while ( !bIsDone )
+                            {
+                                const DirectRecorderStatistics statistics = rRecorder.GetStatistics();
+                                TEST_CHECK( statistics.nFrameCount >= nLastCount );
+                                nLastCount = statistics.nFrameCount;
+                                std::this_thread::yield();
+                            }
+                        } );
+    const VmbErrorType res = source.Start( [&rRecorder, &nAppendedCount, &nFailedCount]( const ImageFrame &rFrame )
+                                           {
+                                               if (    RECORD_FRAME_COUNT > rFrame.nFrameID
+                                                    && VmbErrorSuccess != rRecorder.Append( rFrame ))
+                                               {
+                                                   ++nFailedCount;
+                                               }
+                                               ++nAppendedCount;
+                                           }, 4 );
+    TEST_CHECK( VmbErrorSuccess == res );
+    while (    VmbErrorSuccess == res
+            && nAppendedCount < RECORD_FRAME_COUNT )
+    {
+        std::this_thread::yield();
+    }
+    source.Stop();
+    TEST_CHECK( VmbErrorSuccess == rRecorder.Close() );
+    bIsDone = true;
+    poller.join();
+
+    const DirectRecorderStatistics statistics = rRecorder.GetStatistics();
+    TEST_CHECK( 0 == nFailedCount );
+    TEST_CHECK( RECORD_FRAME_COUNT == statistics.nFrameCount );
+    TEST_CHECK( statistics.nBytesWritten >= RECORD_FRAME_COUNT * GetRecordingRecordSize( RECORD_WIDTH * RECORD_HEIGHT ));
+    printf( "  %s: %llu frames, %llu stalls, %s\n",
+            rFileName.c_str(),
+            static_cast<unsigned long long>( statistics.nFrameCount ),
+            static_cast<unsigned long long>( statistics.nStallCount ),
+            statistics.bIsDirect ? "unbuffered" : "buffered" );
+
+    RecordingReader reader;
+    TEST_CHECK( VmbErrorSuccess == reader.Open( rFileName ));
+    TEST_CHECK( RECORD_FRAME_COUNT == reader.GetFrameCount() );
+    std::vector<VmbUchar_t> expected( RECORD_WIDTH * RECORD_HEIGHT );
+    VmbUint64_t nWrongCount = 0;
+    for ( VmbUint64_t i = 0; i < reader.GetFrameCount(); ++i )
+    {
+        ImageFrame frame;
+        source.Render( &expected[0], i );
+        if (    VmbErrorSuccess != reader.GetFrame( i, frame )
+             || i != frame.nFrameID
+             || RECORD_WIDTH != frame.nWidth
+             || RECORD_HEIGHT != frame.nHeight
+             || expected.size() != frame.nImageSize
+             || 0 != memcmp( &expected[0], frame.pImage, expected.size() ))
+        {
+            ++nWrongCount;
+        }
+    }
+    TEST_CHECK( 0 == nWrongCount );
+    reader.Close();
+    remove( rFileName.c_str() );
+}
+
+} // namespace
+
+void TestDirectRecorder()
+{
+    DirectRecorder recorder( RECORD_CHUNK_SIZE );
+    const VmbUchar_t image[RECORD_WIDTH] = { 0 };
+    ImageFrame frame;
+    frame.pImage        = image;
+    frame.nImageSize    = sizeof( image );
+    TEST_CHECK( VmbErrorInvalidCall == recorder.Append( frame ));
+
+    // Once in memory (tmpfs) and once on the disk of the temporary directory
+    TestRecord( recorder, GetTestFileName( "DirectRecorderTest.rec", true ));
+    TestRecord( recorder, GetTestFileName( "DirectRecorderTest.rec", false ));
+}
+
+}}} // namespace AVT::VmbAPI::Examples
@@ -0,0 +1,317 @@
+/*=============================================================================
+  Copyright (C) 2013 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        FlightRecorderTest.cpp
+
+  Description: Triggers the flight recorder on synthetic frames and reads back what it wrote
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "FlightRecorder.h"
+#include "RecordingFile.h"
+#include "SyntheticFrameSource.h"
+#include "Tests.h"
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+namespace
+{
+
+enum { WIDTH = 32, };
+enum { HEIGHT = 8, };
+enum { RING_FRAME_COUNT = 8, };
+// Long enough that a frame pushed right before the trigger is still inside the window on a busy machine
+enum { PRE_TRIGGER_MS = 200, };
+enum { POST_TRIGGER_MS = 100, };
+// Frames older than this are outside both windows
+enum { AGING_MS = 400, };
+// The streaming case
+enum { STREAM_RING_FRAME_COUNT = 32, };
+enum { STREAM_TRIGGER_FRAME_ID = 100, };
+enum { STREAM_FRAME_COUNT = 300, };
+
+//
+// Renders frames with consecutive IDs and pushes them into the recorder
+//
+// Parameters:
+//  [in]    rRecorder           The recorder
+//  [in]    rSource             Renders the images
+//  [in]    nFirstID            The ID of the first frame
+//  [in]    nCount              The number of frames
+//
+// Returns:
+//  The number of frames the recorder dropped
+//
+VmbUint32_t PushFrames( FlightRecorder &rRecorder, const SyntheticFrameSource &rSource, VmbUint64_t nFirstID, VmbUint32_t nCount )
+{
+    std::vector<VmbUchar_t> image( GetImageSize( WIDTH, HEIGHT, VmbPixelFormatMono8 ));
+    ImageFrame frame;
+    frame.pImage            = &image[0];
+    frame.nImageSize        = static_cast<VmbUint32_t>( image.size() );
+    frame.nWidth            = WIDTH;
+    frame.nHeight           = HEIGHT;
+    frame.ePixelFormat      = VmbPixelFormatMono8;
+    frame.eReceiveStatus    = VmbFrameStatusComplete;
+    VmbUint32_t nDroppedCount = 0;
+    for ( VmbUint64_t nFrameID = nFirstID; nFrameID < nFirstID + nCount; ++nFrameID )
+    {
+        rSource.Render( &image[0], nFrameID );
+        frame.nFrameID      = nFrameID;
+        frame.nTimestamp    = nFrameID;
+        const VmbErrorType res = rRecorder.Push( frame );
+        TEST_CHECK(    VmbErrorSuccess == res
+                    || VmbErrorResources == res );
+        if ( VmbErrorSuccess != res )
+        {
+            ++nDroppedCount;
+        }
+    }
+    return nDroppedCount;
+}
+
+//
+// Checks that a recording holds the frames with the given consecutive IDs and their images, then deletes it
+//
+// Parameters:
+//  [in]    rFileName           The path of the recording
+//  [in]    rSource             Renders the images the frames must have
+//  [in]    nFirstID            The ID of the first frame
+//  [in]    nCount              The number of frames
+//
+void CheckRecording( const std::string &rFileName, const SyntheticFrameSource &rSource, VmbUint64_t nFirstID, VmbUint64_t nCount )
+{
+    {
+        RecordingReader reader;
+        TEST_CHECK( VmbErrorSuccess == reader.Open( rFileName ));
+        TEST_CHECK( nCount == reader.GetFrameCount() );
+        std::vector<VmbUchar_t> expected( GetImageSize( WIDTH, HEIGHT, VmbPixelFormatMono8 ));
+        for ( VmbUint64_t i = 0; i < reader.GetFrameCount(); ++i )
+        {
+            ImageFrame frame;
+            if ( VmbErrorSuccess != reader.GetFrame( i, frame ))
+            {
+                TEST_CHECK( !"GetFrame failed" );
+                continue;
+            }
+            rSource.Render( &expected[0], nFirstID + i );
+            TEST_CHECK( nFirstID + i == frame.nFrameID );
+            TEST_CHECK(    expected.size() == frame.nImageSize
+                        && 0 == memcmp( &expected[0], frame.pImage, expected.size() ));
+        }
+    }
+    remove( rFileName.c_str() );
+}
+
+//
+// Frames after the trigger are added until the frame limit, frames too large for a slot are dropped
+//
+void TestPostTriggerFrames( const SyntheticFrameSource &rSource )
+{
+    FlightRecorderConfig config;
+    config.nFrameCount          = RING_FRAME_COUNT;
+    config.nMaxImageSize        = GetImageSize( WIDTH, HEIGHT, VmbPixelFormatMono8 );
+    config.nPostTriggerFrames   = 2;
+    FlightRecorder recorder;
+    TEST_CHECK( VmbErrorSuccess == recorder.Allocate( config ));
+    TEST_CHECK( static_cast<VmbUint64_t>( RING_FRAME_COUNT ) * config.nMaxImageSize == recorder.GetStatistics().nMemorySize );
+
+    std::vector<VmbUchar_t> large( config.nMaxImageSize + 1 );
+    ImageFrame frame;
+    frame.pImage        = &large[0];
+    frame.nImageSize    = static_cast<VmbUint32_t>( large.size() );
+    TEST_CHECK( VmbErrorResources == recorder.Push( frame ));
+
+    const std::string strFileName = GetTestFileName( "FlightRecorderTestFrames.rec", true );
+    VmbUint32_t nCallbackFrameCount = 0;
+    VmbErrorType eCallbackResult = VmbErrorOther;
+    TEST_CHECK( 0 == PushFrames( recorder, rSource, 0, 3 ));
+    TEST_CHECK( VmbErrorSuccess == recorder.Trigger( strFileName,
+                                                     [&nCallbackFrameCount, &eCallbackResult]( const std::string &/*rFileName*/, VmbUint32_t nFrameCount, VmbErrorType eResult )
+                                                     {
+                                                         nCallbackFrameCount = nFrameCount;
+                                                         eCallbackResult = eResult;
+                                                     } ));
+    TEST_CHECK( VmbErrorInvalidCall == recorder.Trigger( strFileName ));
+    // The two frames after the trigger end the window, the rest go into the ring as usual
+    TEST_CHECK( 0 == PushFrames( recorder, rSource, 3, 3 ));
+    recorder.Flush();
+
+    const FlightRecorderStatistics statistics = recorder.GetStatistics();
+    TEST_CHECK( 6 == statistics.nFrameCount );
+    TEST_CHECK( 1 == statistics.nDroppedCount );
+    TEST_CHECK( 1 == statistics.nEventCount );
+    TEST_CHECK( 0 == statistics.nFailedEventCount );
+    TEST_CHECK( 5 == nCallbackFrameCount );
+    TEST_CHECK( VmbErrorSuccess == eCallbackResult );
+    CheckRecording( strFileName, rSource, 0, 5 );
+}
+
+//
+// Only frames younger than the pre-trigger window are kept, and the event wraps around the end of the ring
+//
+void TestPreTriggerWindow( const SyntheticFrameSource &rSource )
+{
+    FlightRecorderConfig config;
+    config.nFrameCount          = RING_FRAME_COUNT;
+    config.nMaxImageSize        = GetImageSize( WIDTH, HEIGHT, VmbPixelFormatMono8 );
+    config.nPreTriggerMS        = PRE_TRIGGER_MS;
+    config.nPostTriggerFrames   = 2;
+    FlightRecorder recorder;
+    TEST_CHECK( VmbErrorSuccess == recorder.Allocate( config ));
+
+    // Frames 0 to 13 fill the ring and age, 14 and 15 go into the last two slots,
+    // 16 and 17 after the trigger into the first two
+    const std::string strFileName = GetTestFileName( "FlightRecorderTestPre.rec", true );
+    TEST_CHECK( 0 == PushFrames( recorder, rSource, 0, 14 ));
+    std::this_thread::sleep_for( std::chrono::milliseconds( AGING_MS ));
+    TEST_CHECK( 0 == PushFrames( recorder, rSource, 14, 2 ));
+    TEST_CHECK( VmbErrorSuccess == recorder.Trigger( strFileName ));
+    TEST_CHECK( 0 == PushFrames( recorder, rSource, 16, 2 ));
+    recorder.Flush();
+
+    TEST_CHECK( 0 == recorder.GetStatistics().nDroppedCount );
+    CheckRecording( strFileName, rSource, 14, 4 );
+}
+
+//
+// Frames after the trigger are added until the time limit
+//
+void TestPostTriggerTime( const SyntheticFrameSource &rSource )
+{
+    FlightRecorderConfig config;
+    config.nFrameCount          = RING_FRAME_COUNT;
+    config.nMaxImageSize        = GetImageSize( WIDTH, HEIGHT, VmbPixelFormatMono8 );
+    config.nPostTriggerMS       = POST_TRIGGER_MS;
+    FlightRecorder recorder;
+    TEST_CHECK( VmbErrorSuccess == recorder.Allocate( config ));
+
+    const std::string strFileName = GetTestFileName( "FlightRecorderTestTime.rec", true );
+    TEST_CHECK( 0 == PushFrames( recorder, rSource, 0, 2 ));
+    TEST_CHECK( VmbErrorSuccess == recorder.Trigger( strFileName ));
+    TEST_CHECK( 0 == PushFrames( recorder, rSource, 2, 2 ));
+    std::this_thread::sleep_for( std::chrono::milliseconds( AGING_MS ));
+    // Closes the window, the frame itself is not part of the event
+    TEST_CHECK( 0 == PushFrames( recorder, rSource, 4, 1 ));
+    recorder.Flush();
+
+    TEST_CHECK( 0 == recorder.GetStatistics().nDroppedCount );
+    CheckRecording( strFileName, rSource, 0, 4 );
+}
+
+//
+// An event that takes the whole ring pins every slot: frames are dropped and end the window
+// until the event is written, then the ring runs again
+//
+void TestPinnedSlots( const SyntheticFrameSource &rSource )
+{
+    FlightRecorderConfig config;
+    config.nFrameCount          = RING_FRAME_COUNT;
+    config.nMaxImageSize        = GetImageSize( WIDTH, HEIGHT, VmbPixelFormatMono8 );
+    config.nPostTriggerFrames   = 4;
+    FlightRecorder recorder;
+    TEST_CHECK( VmbErrorSuccess == recorder.Allocate( config ));
+
+    const std::string strFileName = GetTestFileName( "FlightRecorderTestPinned.rec", true );
+    TEST_CHECK( 0 == PushFrames( recorder, rSource, 0, 20 ));
+    TEST_CHECK( VmbErrorSuccess == recorder.Trigger( strFileName ));
+    TEST_CHECK( 1 == PushFrames( recorder, rSource, 20, 1 ));
+    recorder.Flush();
+    TEST_CHECK( 0 == PushFrames( recorder, rSource, 21, RING_FRAME_COUNT ));
+
+    const FlightRecorderStatistics statistics = recorder.GetStatistics();
+    TEST_CHECK( 20 + RING_FRAME_COUNT == statistics.nFrameCount );
+    TEST_CHECK( 1 == statistics.nDroppedCount );
+    CheckRecording( strFileName, rSource, 20 - RING_FRAME_COUNT, RING_FRAME_COUNT );
+}
+
+//
+// Pushes the frames of a running synthetic source and triggers from its callback mid-stream
+//
+void TestStream()
+{
+    SyntheticFrameSource source( WIDTH, HEIGHT, VmbPixelFormatMono8, 0.0 );
+    FlightRecorderConfig config;
+    config.nFrameCount          = STREAM_RING_FRAME_COUNT;
+    config.nMaxImageSize        = GetImageSize( WIDTH, HEIGHT, VmbPixelFormatMono8 );
+    config.nPostTriggerFrames   = 10;
+    FlightRecorder recorder;
+    TEST_CHECK( VmbErrorSuccess == recorder.Allocate( config ));
+
+    const std::string strFileName = GetTestFileName( "FlightRecorderTestStream.rec", true );
+    std::atomic<VmbUint64_t> nPushedCount( 0 );
+    std::atomic<VmbUint64_t> nFailedCount( 0 );
+    TEST_CHECK( VmbErrorSuccess == source.Start( [&]( const ImageFrame &rFrame )
+                                                 {
+                                                     if ( STREAM_FRAME_COUNT <= nPushedCount )
+                                                     {
+                                                         return;
+                                                     }
+                                                     recorder.Push( rFrame );
+                                                     ++nPushedCount;
+                                                     if (    STREAM_TRIGGER_FRAME_ID == rFrame.nFrameID
+                                                          && VmbErrorSuccess != recorder.Trigger( strFileName ))
+                                                     {
+                                                         ++nFailedCount;
+                                                     }
+                                                 },
+                                                 4 ));
+    while ( nPushedCount < STREAM_FRAME_COUNT )
+    {
+        std::this_thread::yield();
+    }
+    source.Stop();
+    recorder.Flush();
+
+    // The ring was full at the trigger, so the first frame after it found a pinned slot
+    const FlightRecorderStatistics statistics = recorder.GetStatistics();
+    TEST_CHECK( 0 == nFailedCount );
+    TEST_CHECK( STREAM_FRAME_COUNT == statistics.nFrameCount + statistics.nDroppedCount );
+    TEST_CHECK( 1 <= statistics.nDroppedCount );
+    TEST_CHECK( 1 == statistics.nEventCount );
+    CheckRecording( strFileName, source, STREAM_TRIGGER_FRAME_ID + 1 - STREAM_RING_FRAME_COUNT, STREAM_RING_FRAME_COUNT );
+    printf( "  %llu frames pushed, %llu dropped while the event was written\n",
+            static_cast<unsigned long long>( statistics.nFrameCount ),
+            static_cast<unsigned long long>( statistics.nDroppedCount ));
+}
+
+} // namespace
+
+void TestFlightRecorder()
+{
+    const SyntheticFrameSource source( WIDTH, HEIGHT, VmbPixelFormatMono8, 0.0 );
+    TestPostTriggerFrames( source );
+    TestPreTriggerWindow( source );
+    TestPostTriggerTime( source );
+    TestPinnedSlots( source );
+    TestStream();
+}
+
+}}} // namespace AVT::VmbAPI::Examples
@@ -0,0 +1,258 @@
+/*=============================================================================
+  Copyright (C) 2013 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        FrameQueueTest.cpp
+
+  Description: Stress test of the lock-free frame queues, fed by synthetic frame
+               sources on one or several threads.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "FrameQueue.h"
+#include "SyntheticFrameSource.h"
+#include "Tests.h"
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+namespace
+{
+
+enum { STRESS_FRAME_COUNT = 200000, };
+enum { STRESS_SOURCE_COUNT = 4, };
+enum { STRESS_QUEUE_CAPACITY = 64, };
+// Every source renders images of its own width, which tells their frames apart
+enum { SOURCE_BASE_WIDTH = 16, };
+
+//
+// Checks the behavior of a queue on a single thread: full, empty, order and closing
+//
+template <typename Queue>
+void TestSingleThread()
+{
+    Queue queue( 3 );
+    TEST_CHECK( 4 == queue.GetCapacity() );
+
+    ImageFrame frame;
+    for ( VmbUint64_t i = 0; i < 4; ++i )
+    {
+        frame.nFrameID = i;
+        TEST_CHECK( queue.Push( frame, QueueModeTry ));
+    }
+    TEST_CHECK( 4 == queue.GetSize() );
+    TEST_CHECK( !queue.Push( frame, QueueModeTry ));
+    TEST_CHECK( !queue.Push( frame, QueueModeSpin, 1 ));
+    TEST_CHECK( 2 == queue.GetOverflowCount() );
+
+    for ( VmbUint64_t i = 0; i < 2; ++i )
+    {
+        TEST_CHECK( queue.Pop( frame, QueueModeTry ));
+        TEST_CHECK( i == frame.nFrameID );
+    }
+
+    // A closed queue takes nothing, but hands out what it holds
+    queue.Close();
+    TEST_CHECK( !queue.Push( frame, QueueModeTry ));
+    TEST_CHECK( queue.Pop( frame ));
+    TEST_CHECK( 2 == frame.nFrameID );
+    TEST_CHECK( queue.Pop( frame ));
+    TEST_CHECK( 3 == frame.nFrameID );
+    TEST_CHECK( !queue.Pop( frame ));
+}
+
+//
+// Checks that a blocking pop on an empty queue gives up after its timeout, and that closing wakes it
+//
+void TestBlockingPop()
+{
+    typedef std::chrono::steady_clock Clock;
+    SpscFrameQueue queue( 4 );
+    ImageFrame frame;
+
+    const Clock::time_point tStart = Clock::now();
+    TEST_CHECK( !queue.Pop( frame, QueueModeBlock, 20 ));
+    TEST_CHECK( Clock::now() - tStart >= std::chrono::milliseconds( 20 ));
+
+    std::thread closer( [&queue]()
+                        {
+                            std::this_thread::sleep_for( std::chrono::milliseconds( 20 ));
+                            queue.Close();
+                        } );
+    TEST_CHECK( !queue.Pop( frame ));
+    closer.join();
+}
+
+//
+// Streams frames from synthetic sources through a queue to one consumer, which checks that every
+// frame of every source arrives exactly once and in order
+//
+// Parameters:
+//  [in]    nSourceCount        The producer threads
+//  [in]    eMode               How the producers push
+//
+template <typename Queue>
+void TestStress( VmbUint32_t nSourceCount, QueueMode eMode )
+{
+    Queue queue( STRESS_QUEUE_CAPACITY );
+    std::atomic<VmbUint64_t> nRejectedCount( 0 );
+    std::vector< std::unique_ptr<SyntheticFrameSource> > sources;
+    for ( VmbUint32_t i = 0; i < nSourceCount; ++i )
+    {
+        sources.push_back( std::unique_ptr<SyntheticFrameSource>( new SyntheticFrameSource( SOURCE_BASE_WIDTH + i, 4, VmbPixelFormatMono8, 0.0 )));
+    }
+    for ( VmbUint32_t i = 0; i < nSourceCount; ++i )
+    {
+        const VmbErrorType res = sources[i]->Start( [&queue, &nRejectedCount, eMode]( const ImageFrame &rFrame )
+                                                    {
+                                                        // Only refused once the consumer has all it wants
+                                                        if ( !queue.Push( rFrame, eMode ))
+                                                        {
+                                                            ++nRejectedCount;
+                                                        }
+                                                    }, 4 );
+        TEST_CHECK( VmbErrorSuccess == res );
+    }
+
+    std::vector<VmbUint64_t> nextFrameIDs( nSourceCount, 0 );
+    VmbUint64_t nOutOfOrderCount = 0;
+    ImageFrame frame;
+    for ( VmbUint64_t i = 0; i < STRESS_FRAME_COUNT; ++i )
+    {
+        if ( !queue.Pop( frame, QueueModeBlock, 5000 ))
+        {
+            TEST_CHECK( !"The queue stayed empty" );
+            break;
+        }
+        const VmbUint32_t nSource = frame.nWidth - SOURCE_BASE_WIDTH;
+        if (    nSource >= nSourceCount
+             || frame.nFrameID != nextFrameIDs[nSource] )
+        {
+            ++nOutOfOrderCount;
+            continue;
+        }
+        ++nextFrameIDs[nSource];
+    }
+    queue.Close();
+    for ( VmbUint32_t i = 0; i < nSourceCount; ++i )
+    {
+        sources[i]->Stop();
+    }
+
+    TEST_CHECK( 0 == nOutOfOrderCount );
+    VmbUint64_t nReceivedCount = 0;
+    for ( VmbUint32_t i = 0; i < nSourceCount; ++i )
+    {
+        nReceivedCount += nextFrameIDs[i];
+    }
+    TEST_CHECK( STRESS_FRAME_COUNT == nReceivedCount );
+    printf( "  %u source(s): %llu frames, %llu overflows, %llu refused after the close\n",
+            nSourceCount,
+            static_cast<unsigned long long>( nReceivedCount ),
+            static_cast<unsigned long long>( queue.GetOverflowCount() ),
+            static_cast<unsigned long long>( nRejectedCount.load() ));
+}
+
+//
+// Several producers and consumers on a MpmcRing, every frame ID must be taken exactly once
+//
+void TestManyConsumers()
+{
+    enum { PRODUCER_COUNT = 4, };
+    enum { CONSUMER_COUNT = 4, };
+    enum { FRAMES_PER_PRODUCER = 50000, };
+
+    FrameQueue< MpmcRing<ImageFrame> > queue( STRESS_QUEUE_CAPACITY );
+    std::unique_ptr< std::atomic<VmbUint32_t>[] > pTakenCounts( new std::atomic<VmbUint32_t>[PRODUCER_COUNT * FRAMES_PER_PRODUCER] );
+    for ( VmbUint32_t i = 0; i < PRODUCER_COUNT * FRAMES_PER_PRODUCER; ++i )
+    {
+        pTakenCounts[i] = 0;
+    }
+
+    std::vector<std::thread> consumers;
+    for ( int i = 0; i < CONSUMER_COUNT; ++i )
+    {
+        consumers.push_back( std::thread(   [&queue, &pTakenCounts]()
+                                            {
+                                                ImageFrame frame;
+                                                while ( queue.Pop( frame ))
+                                                {
+                                                    ++pTakenCounts[frame.nFrameID];
+                                                }
+                                            } ));
+    }
+    std::vector<std::thread> producers;
+    for ( VmbUint32_t i = 0; i < PRODUCER_COUNT; ++i )
+    {
+        producers.push_back( std::thread(   [&queue, i]()
+                                            {
+                                                ImageFrame frame;
+                                                for ( VmbUint32_t j = 0; j < FRAMES_PER_PRODUCER; ++j )
+                                                {
+                                                    frame.nFrameID = i * FRAMES_PER_PRODUCER + j;
+                                                    queue.Push( frame );
+                                                }
+                                            } ));
+    }
+    for ( size_t i = 0; i < producers.size(); ++i )
+    {
+        producers[i].join();
+    }
+    // The consumers drain the queue before they see the close
+    queue.Close();
+    for ( size_t i = 0; i < consumers.size(); ++i )
+    {
+        consumers[i].join();
+    }
+
+    VmbUint32_t nWrongCount = 0;
+    for ( VmbUint32_t i = 0; i < PRODUCER_COUNT * FRAMES_PER_PRODUCER; ++i )
+    {
+        if ( 1 != pTakenCounts[i] )
+        {
+            ++nWrongCount;
+        }
+    }
+    TEST_CHECK( 0 == nWrongCount );
+}
+
+} // namespace
+
+void TestFrameQueue()
+{
+    TestSingleThread<SpscFrameQueue>();
+    TestSingleThread<MpscFrameQueue>();
+    TestSingleThread< FrameQueue< MpmcRing<ImageFrame> > >();
+    TestBlockingPop();
+    TestStress<SpscFrameQueue>( 1, QueueModeBlock );
+    TestStress<SpscFrameQueue>( 1, QueueModeSpin );
+    TestStress<MpscFrameQueue>( STRESS_SOURCE_COUNT, QueueModeBlock );
+    TestStress<MpscFrameQueue>( STRESS_SOURCE_COUNT, QueueModeSpin );
+    TestManyConsumers();
+}
+
+}}} // namespace AVT::VmbAPI::Examples
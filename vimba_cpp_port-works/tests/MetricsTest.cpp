@@ -0,0 +1,174 @@
+/*=============================================================================
+  Copyright (C) 2013 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        MetricsTest.cpp
+
+  Description: Saves the frames of synthetic cameras in several pixel formats and checks
+               the frame, conversion and write counters of the default metrics registry
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ApiController.h"
+#include "ImageWriter.h"
+#include "MetricsRegistry.h"
+#include "SimulatedCameraBackend.h"
+#include "Tests.h"
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+namespace
+{
+
+enum { SAVE_FRAME_COUNT = 20, };
+// Rows of RGB bitmaps of this width need padding, which must not count as converted
+enum { SAVE_WIDTH = 62, };
+enum { SAVE_HEIGHT = 48, };
+enum { RING_FRAME_COUNT = 4, };
+
+//
+// Gets the size of a file, 0 if it cannot be read
+//
+VmbUint64_t GetFileSize( const std::string &rFileName )
+{
+    FILE *file = fopen( rFileName.c_str(), "rb" );
+    if ( NULL == file )
+    {
+        return 0;
+    }
+    long nSize = -1;
+    if ( 0 == fseek( file, 0, SEEK_END ))
+    {
+        nSize = ftell( file );
+    }
+    fclose( file );
+    return 0 < nSize ? static_cast<VmbUint64_t>( nSize ) : 0;
+}
+
+//
+// Streams from a synthetic camera, saves SAVE_FRAME_COUNT frames as bitmaps and checks what the metrics counted
+//
+// Parameters:
+//  [in]    pName               The name of the pixel format, part of the camera ID and the file names
+//  [in]    ePixelFormat        The pixel format of the camera
+//  [in]    nConvertedSize      The image bytes the conversion for the bitmap makes of one frame, 0 for none
+//
+void TestSave( const char *pName, VmbPixelFormatType ePixelFormat, VmbUint64_t nConvertedSize )
+{
+    SyntheticCameraConfig config;
+    config.strID        = std::string( "MetricsTest" ) + pName;
+    config.nWidth       = SAVE_WIDTH;
+    config.nHeight      = SAVE_HEIGHT;
+    config.ePixelFormat = ePixelFormat;
+    config.dFrameRate   = 0.0;
+    std::shared_ptr<SimulatedCameraBackend> pBackend( new SimulatedCameraBackend() );
+    pBackend->AddSyntheticCamera( config );
+    ApiController controller( pBackend );
+    controller.SetPixelFormats( std::vector<VmbPixelFormatType>( 1, ePixelFormat ));
+    TEST_CHECK( VmbErrorSuccess == controller.StartUp() );
+
+    MetricsRegistry &rRegistry = MetricsRegistry::GetDefault();
+    const std::string strCamera = MakeMetricLabel( "camera", config.strID );
+    const MetricCounter &rFramesAcquired = rRegistry.GetCounter( "vimba_frames_acquired_total", "", strCamera );
+    const MetricCounter &rBytesAcquired = rRegistry.GetCounter( "vimba_bytes_acquired_total", "", strCamera );
+    const WriteMetrics &rMetrics = WriteMetrics::GetDefault();
+    const VmbUint64_t nConvertedBefore = rMetrics.pBytesConverted->GetValue();
+    const VmbUint64_t nWrittenBefore = rMetrics.pBytesWritten->GetValue();
+
+    std::vector<std::string> fileNames;
+    for ( VmbUint32_t i = 0; i < SAVE_FRAME_COUNT; ++i )
+    {
+        fileNames.push_back( GetTestFileName( ( config.strID + "_" + std::to_string( i ) + ".bmp" ).c_str(), true ));
+    }
+
+    // Frames keep coming until the acquisition stops, only the first ones are saved
+    ImageWriter writer;
+    std::atomic<VmbUint64_t> nDeliveredCount( 0 );
+    std::atomic<VmbUint64_t> nFailedCount( 0 );
+    const VmbErrorType res = controller.StartContinuousAcquisition( config.strID,
+                                                                    [&writer, &fileNames, &nDeliveredCount, &nFailedCount]( const ImageFrame &rFrame )
+                                                                    {
+                                                                        const VmbUint64_t nIndex = nDeliveredCount.fetch_add( 1 );
+                                                                        if (    SAVE_FRAME_COUNT > nIndex
+                                                                             && VmbErrorSuccess != writer.SubmitCopy( rFrame, fileNames[static_cast<size_t>( nIndex )] ))
+                                                                        {
+                                                                            ++nFailedCount;
+                                                                        }
+                                                                    },
+                                                                    RING_FRAME_COUNT );
+    TEST_CHECK( VmbErrorSuccess == res );
+    while (    VmbErrorSuccess == res
+            && nDeliveredCount < SAVE_FRAME_COUNT )
+    {
+        std::this_thread::yield();
+    }
+    TEST_CHECK( VmbErrorSuccess == controller.StopContinuousAcquisition() );
+    writer.Flush();
+    controller.ShutDown();
+
+    const ImageWriterStatistics statistics = writer.GetStatistics();
+    TEST_CHECK( 0 == nFailedCount );
+    TEST_CHECK( SAVE_FRAME_COUNT == statistics.nWrittenCount );
+    TEST_CHECK( nDeliveredCount == rFramesAcquired.GetValue() );
+    TEST_CHECK( nDeliveredCount * GetImageSize( SAVE_WIDTH, SAVE_HEIGHT, ePixelFormat ) == rBytesAcquired.GetValue() );
+
+    // Headers and row padding are written, but not converted
+    VmbUint64_t nFileBytes = 0;
+    for (   std::vector<std::string>::const_iterator iter = fileNames.begin();
+            fileNames.end() != iter;
+            ++iter )
+    {
+        nFileBytes += GetFileSize( *iter );
+        remove( iter->c_str() );
+    }
+    const VmbUint64_t nConvertedBytes = rMetrics.pBytesConverted->GetValue() - nConvertedBefore;
+    const VmbUint64_t nWrittenBytes = rMetrics.pBytesWritten->GetValue() - nWrittenBefore;
+    TEST_CHECK( SAVE_FRAME_COUNT * nConvertedSize == nConvertedBytes );
+    TEST_CHECK( nFileBytes == nWrittenBytes );
+    printf( "  %-8s %llu frames, %llu bytes converted, %llu bytes written\n",
+            pName,
+            static_cast<unsigned long long>( nDeliveredCount ),
+            static_cast<unsigned long long>( nConvertedBytes ),
+            static_cast<unsigned long long>( nWrittenBytes ));
+}
+
+} // namespace
+
+void TestMetrics()
+{
+    // Mono8 and BGR8 go to the file as they are, RGB8 rows are swapped to BGR,
+    // deeper mono images are mapped to 8 bit and Bayer images demosaiced to BGR8
+    TestSave( "Mono8",      VmbPixelFormatMono8,    0 );
+    TestSave( "BGR8",       VmbPixelFormatBgr8,     0 );
+    TestSave( "RGB8",       VmbPixelFormatRgb8,     SAVE_WIDTH * SAVE_HEIGHT * 3 );
+    TestSave( "Mono12",     VmbPixelFormatMono12,   SAVE_WIDTH * SAVE_HEIGHT );
+    TestSave( "BayerRG8",   VmbPixelFormatBayerRG8, SAVE_WIDTH * SAVE_HEIGHT * 3 );
+}
+
+}}} // namespace AVT::VmbAPI::Examples
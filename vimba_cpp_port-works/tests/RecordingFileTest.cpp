@@ -0,0 +1,183 @@
+/*=============================================================================
+  Copyright (C) 2013 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        RecordingFileTest.cpp
+
+  Description: Opens recordings with a corrupt index and checks the reader falls back to
+               scanning the frames or fails cleanly
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "RecordingFile.h"
+#include "Tests.h"
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+namespace
+{
+
+enum { WIDTH = 16, };
+enum { HEIGHT = 4, };
+enum { FRAME_COUNT = 3, };
+
+//
+// Reads a whole file
+//
+bool ReadFile( const std::string &rFileName, std::vector<VmbUchar_t> &rData )
+{
+    rData.clear();
+    FILE *file = fopen( rFileName.c_str(), "rb" );
+    if ( NULL == file )
+    {
+        return false;
+    }
+    VmbUchar_t buffer[4096];
+    size_t nRead;
+    while ( 0 < ( nRead = fread( buffer, 1, sizeof( buffer ), file )))
+    {
+        rData.insert( rData.end(), buffer, buffer + nRead );
+    }
+    fclose( file );
+    return true;
+}
+
+//
+// Writes a whole file
+//
+bool WriteFile( const std::string &rFileName, const std::vector<VmbUchar_t> &rData )
+{
+    FILE *file = fopen( rFileName.c_str(), "wb" );
+    if ( NULL == file )
+    {
+        return false;
+    }
+    const bool bIsWritten = rData.size() == fwrite( &rData[0], 1, rData.size(), file );
+    return 0 == fclose( file ) && bIsWritten;
+}
+
+//
+// Replaces a 64 bit value of the file
+//
+void Patch( std::vector<VmbUchar_t> &rData, VmbUint64_t nOffset, VmbUint64_t nValue )
+{
+    memcpy( &rData[static_cast<size_t>( nOffset )], &nValue, sizeof( nValue ));
+}
+
+//
+// Opens a corrupt copy of a recording
+//
+// Parameters:
+//  [in]    pName               What was corrupted, for the report
+//  [in]    rData               The corrupt file
+//  [in]    eExpected           What Open has to return
+//  [in]    nExpectedCount      The frames the reader has to find if it opens the file
+//
+void CheckCorruptFile( const char *pName, const std::vector<VmbUchar_t> &rData, VmbErrorType eExpected, VmbUint64_t nExpectedCount )
+{
+    const std::string strFileName = GetTestFileName( "RecordingFileTestCorrupt.rec", true );
+    TEST_CHECK( WriteFile( strFileName, rData ));
+    {
+        RecordingReader reader;
+        const VmbErrorType res = reader.Open( strFileName );
+        TEST_CHECK( eExpected == res );
+        if ( VmbErrorSuccess == res )
+        {
+            TEST_CHECK( nExpectedCount == reader.GetFrameCount() );
+            for ( VmbUint64_t i = 0; i < reader.GetFrameCount(); ++i )
+            {
+                ImageFrame frame;
+                TEST_CHECK( VmbErrorSuccess == reader.GetFrame( i, frame ));
+                TEST_CHECK( i == frame.nFrameID );
+            }
+        }
+        printf( "  %-28s %s, %llu frames\n", pName, VmbErrorSuccess == res ? "opened" : "refused",
+                static_cast<unsigned long long>( reader.GetFrameCount() ));
+    }
+    remove( strFileName.c_str() );
+}
+
+} // namespace
+
+void TestRecordingFile()
+{
+    const std::string strFileName = GetTestFileName( "RecordingFileTest.rec", true );
+    std::vector<VmbUchar_t> image( GetImageSize( WIDTH, HEIGHT, VmbPixelFormatMono8 ), 0x5A );
+    {
+        RecordingWriter writer;
+        TEST_CHECK( VmbErrorSuccess == writer.Open( strFileName ));
+        ImageFrame frame;
+        frame.pImage            = &image[0];
+        frame.nImageSize        = static_cast<VmbUint32_t>( image.size() );
+        frame.nWidth            = WIDTH;
+        frame.nHeight           = HEIGHT;
+        frame.ePixelFormat      = VmbPixelFormatMono8;
+        frame.eReceiveStatus    = VmbFrameStatusComplete;
+        for ( VmbUint64_t i = 0; i < FRAME_COUNT; ++i )
+        {
+            frame.nFrameID = i;
+            TEST_CHECK( VmbErrorSuccess == writer.Append( frame ));
+        }
+        TEST_CHECK( VmbErrorSuccess == writer.Close() );
+    }
+    std::vector<VmbUchar_t> data;
+    TEST_CHECK( ReadFile( strFileName, data ));
+    remove( strFileName.c_str() );
+    const VmbUint64_t nTrailerOffset = data.size() - sizeof( RecordingTrailer );
+    const VmbUint64_t nIndexOffset = nTrailerOffset - FRAME_COUNT * sizeof( VmbUint64_t );
+    if ( data.size() < sizeof( RecordingFileHeader ) + FRAME_COUNT * GetRecordingRecordSize( image.size() ) + FRAME_COUNT * sizeof( VmbUint64_t ) + sizeof( RecordingTrailer ))
+    {
+        TEST_CHECK( !"The recording is too small" );
+        return;
+    }
+    CheckCorruptFile( "intact", data, VmbErrorSuccess, FRAME_COUNT );
+
+    // Trailers that are consistent with the file size, but put the index into the file header: the frames are scanned
+    std::vector<VmbUchar_t> corrupt( data );
+    const VmbUint64_t nInHeaderOffset = sizeof( VmbUint64_t );
+    Patch( corrupt, nTrailerOffset, nInHeaderOffset );
+    Patch( corrupt, nTrailerOffset + sizeof( VmbUint64_t ), ( nTrailerOffset - nInHeaderOffset ) / sizeof( VmbUint64_t ));
+    CheckCorruptFile( "index in the file header", corrupt, VmbErrorSuccess, FRAME_COUNT );
+
+    corrupt = data;
+    const VmbUint64_t nAfterHeaderOffset = sizeof( RecordingFileHeader );
+    Patch( corrupt, nTrailerOffset, nAfterHeaderOffset );
+    Patch( corrupt, nTrailerOffset + sizeof( VmbUint64_t ), ( nTrailerOffset - nAfterHeaderOffset ) / sizeof( VmbUint64_t ));
+    CheckCorruptFile( "index before the frames", corrupt, VmbErrorSuccess, FRAME_COUNT );
+
+    // Index entries that would wrap around when the frame header size is added to them
+    corrupt = data;
+    Patch( corrupt, nIndexOffset + sizeof( VmbUint64_t ), ( std::numeric_limits<VmbUint64_t>::max )() - sizeof( RecordingFrameHeader ) + 1 );
+    CheckCorruptFile( "index entry wraps around", corrupt, VmbErrorInvalidValue, 0 );
+
+    corrupt = data;
+    Patch( corrupt, nIndexOffset, nIndexOffset );
+    CheckCorruptFile( "index entry past the frames", corrupt, VmbErrorInvalidValue, 0 );
+}
+
+}}} // namespace AVT::VmbAPI::Examples
@@ -0,0 +1,174 @@
+/*=============================================================================
+  Copyright (C) 2013 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        SwizzleTest.cpp
+
+  Description: Checks every available RGB swap kernel against the scalar one
+               for all widths up to a few vectors, misaligned buffers and row padding
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "Tests.h"
+#include "Bitmap.h"
+#include "PixelSwizzle.h"
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+namespace
+{
+
+// Covers the vector loops of every kernel a few times over plus every tail length
+enum { MAX_PIXEL_COUNT = 200, };
+// Source and destination are shifted by up to this many bytes against the allocation
+enum { MAX_OFFSET = 35, };
+// Bytes behind the destination that no kernel may touch
+enum { GUARD_SIZE = 64, };
+const unsigned char GUARD_BYTE = 0xA5;
+
+//
+// Swaps a row with a kernel into a misaligned destination and compares it with the scalar kernel
+//
+// Parameters:
+//  [in]    pKernel             The kernel under test
+//  [in]    pScalar             The scalar kernel
+//  [in]    rSource             The source pixels, longer than needed
+//  [in]    nSourceOffset       Where the row starts in the source
+//  [in]    nDestinationOffset  Where the row starts in the destination
+//  [in]    nPixels             The number of pixels of the row
+//
+// Returns:
+//  False if the result or the guard bytes differ
+//
+bool CheckRow( AVTSwapRGBFunc pKernel, AVTSwapRGBFunc pScalar, const std::vector<unsigned char> &rSource,
+               size_t nSourceOffset, size_t nDestinationOffset, unsigned long nPixels )
+{
+    const size_t nSize = nDestinationOffset + nPixels * 3 + GUARD_SIZE;
+    std::vector<unsigned char> expected( nSize, GUARD_BYTE );
+    std::vector<unsigned char> actual( nSize, GUARD_BYTE );
+    pScalar( &rSource[nSourceOffset], &expected[nDestinationOffset], nPixels );
+    pKernel( &rSource[nSourceOffset], &actual[nDestinationOffset], nPixels );
+    return 0 == memcmp( &expected[0], &actual[0], nSize );
+}
+
+//
+// Converts RGB images of every row padding into bitmaps and compares them with a bitmap
+// of the same image swapped row by row with the scalar kernel
+//
+void TestBitmapPadding()
+{
+    AVTSwapRGBFunc pScalar = AVTGetSwapRGBKernel( SwizzleKernelScalar );
+    // Four widths in a row give every padding from 0 to 3 bytes
+    for ( unsigned long nWidth = 1; nWidth <= 68; ++nWidth )
+    {
+        const unsigned long nHeight = 3;
+        std::vector<unsigned char> image( nWidth * nHeight * 3 );
+        for ( size_t i = 0; i < image.size(); ++i )
+        {
+            image[i] = static_cast<unsigned char>( i * 7 + nWidth );
+        }
+
+        AVTBitmap bitmap;
+        bitmap.buffer       = NULL;
+        bitmap.bufferSize   = static_cast<unsigned long>( image.size() );
+        bitmap.width        = nWidth;
+        bitmap.height       = nHeight;
+        bitmap.colorCode    = ColorCodeRGB24;
+        AVTBitmapHeader header;
+        TEST_CHECK( 0 != AVTCreateBitmapHeader( &bitmap, &header ));
+        if ( 0 == AVTCreateBitmap( &bitmap, &image[0] ))
+        {
+            TEST_CHECK( !"AVTCreateBitmap failed" );
+            continue;
+        }
+
+        std::vector<unsigned char> expected( header.data, header.data + header.size );
+        for ( unsigned long y = 0; y < nHeight; ++y )
+        {
+            std::vector<unsigned char> row( header.rowSize + header.padLength, 0 );
+            pScalar( &image[y * nWidth * 3], &row[0], nWidth );
+            expected.insert( expected.end(), row.begin(), row.end() );
+        }
+        TEST_CHECK(    expected.size() == bitmap.bufferSize
+                    && 0 == memcmp( &expected[0], bitmap.buffer, expected.size() ));
+        AVTReleaseBitmap( &bitmap );
+    }
+}
+
+} // namespace
+
+void TestSwizzle()
+{
+    AVTSwapRGBFunc pScalar = AVTGetSwapRGBKernel( SwizzleKernelScalar );
+    TEST_CHECK( NULL != pScalar );
+    if ( NULL == pScalar )
+    {
+        return;
+    }
+    TEST_CHECK( NULL != AVTGetSwapRGBKernel( AVTGetBestSwizzleKernel() ));
+
+    std::vector<unsigned char> source( MAX_OFFSET + MAX_PIXEL_COUNT * 3 );
+    for ( size_t i = 0; i < source.size(); ++i )
+    {
+        source[i] = static_cast<unsigned char>( i * 31 + 17 );
+    }
+
+    for ( int i = 0; i < SwizzleKernelCount; ++i )
+    {
+        const SwizzleKernel eKernel = static_cast<SwizzleKernel>( i );
+        AVTSwapRGBFunc pKernel = AVTGetSwapRGBKernel( eKernel );
+        if ( NULL == pKernel )
+        {
+            printf( "  %s not available\n", AVTGetSwizzleKernelName( eKernel ));
+            continue;
+        }
+        printf( "  %s\n", AVTGetSwizzleKernelName( eKernel ));
+        unsigned int nMismatchCount = 0;
+        for ( unsigned long nPixels = 0; nPixels <= MAX_PIXEL_COUNT; ++nPixels )
+        {
+            for ( size_t nSourceOffset = 0; nSourceOffset <= MAX_OFFSET; nSourceOffset += 5 )
+            {
+                for ( size_t nDestinationOffset = 0; nDestinationOffset <= MAX_OFFSET; nDestinationOffset += 7 )
+                {
+                    if ( !CheckRow( pKernel, pScalar, source, nSourceOffset, nDestinationOffset, nPixels ))
+                    {
+                        // One report per kernel is enough to find it
+                        if ( 0 == nMismatchCount++ )
+                        {
+                            printf( "  %s differs at %lu pixels, offsets %u/%u\n", AVTGetSwizzleKernelName( eKernel ), nPixels,
+                                    static_cast<unsigned int>( nSourceOffset ), static_cast<unsigned int>( nDestinationOffset ));
+                        }
+                    }
+                }
+            }
+        }
+        TEST_CHECK( 0 == nMismatchCount );
+    }
+
+    TestBitmapPadding();
+}
+
+}}} // namespace AVT::VmbAPI::Examples
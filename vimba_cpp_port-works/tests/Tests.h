@@ -0,0 +1,84 @@
+/*=============================================================================
+  Copyright (C) 2013 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        Tests.h
+
+  Description: Checks and the test cases of the test program.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#ifndef AVT_VMBAPI_EXAMPLES_TESTS
+#define AVT_VMBAPI_EXAMPLES_TESTS
+
+#include <string>
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+//
+// Counts a failed check of the running test and prints where it happened
+//
+// Parameters:
+//  [in]    pFile               The source file of the check
+//  [in]    nLine               The line of the check
+//  [in]    pCondition          The condition that did not hold
+//
+void ReportFailure( const char *pFile, int nLine, const char *pCondition );
+
+//
+// Gets a path for a scratch file of a test
+//
+// Parameters:
+//  [in]    pName               The name of the file
+//  [in]    bOnTmpfs            Prefers a file system in memory (/dev/shm) where there is one
+//
+// Returns:
+//  The path in the temporary directory
+//
+std::string GetTestFileName( const char *pName, bool bOnTmpfs );
+
+//
+// Fails the running test if the condition does not hold, the test goes on
+//
+#define TEST_CHECK( condition ) \
+    do \
+    { \
+        if ( !( condition )) \
+        { \
+            ::AVT::VmbAPI::Examples::ReportFailure( __FILE__, __LINE__, #condition ); \
+        } \
+    } while ( 0 )
+
+//
+// The test cases, every one runs on its own and reports failures through TEST_CHECK
+//
+void TestFrameQueue();
+void TestDirectRecorder();
+void TestFlightRecorder();
+void TestRecordingFile();
+void TestMetrics();
+void TestBufferPool();
+void TestSwizzle();
+
+}}} // namespace AVT::VmbAPI::Examples
+
+#endif
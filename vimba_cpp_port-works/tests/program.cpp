@@ -0,0 +1,153 @@
+/*=============================================================================
+  Copyright (C) 2013 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        program.cpp
+
+  Description: Runs the tests of the shared sources against synthetic cameras
+               and frame sources, all of them or the ones named on the command line.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+#include "Tests.h"
+
+using namespace AVT::VmbAPI::Examples;
+
+namespace
+{
+
+struct TestCase
+{
+    const char*         pName;
+    void                (*pRun)();
+};
+
+// Ends with an empty entry
+const TestCase TEST_CASES[] =
+{
+    { "FrameQueue",         TestFrameQueue },
+    { "DirectRecorder",     TestDirectRecorder },
+    { "FlightRecorder",     TestFlightRecorder },
+    { "RecordingFile",      TestRecordingFile },
+    { "Metrics",            TestMetrics },
+    { "BufferPool",         TestBufferPool },
+    { "Swizzle",            TestSwizzle },
+    { NULL,                 NULL },
+};
+
+#ifdef _WIN32
+const char TEMP_DIRECTORY_VARIABLE[]    = "TEMP";
+const char DEFAULT_TEMP_DIRECTORY[]     = ".";
+#else
+const char TEMP_DIRECTORY_VARIABLE[]    = "TMPDIR";
+const char DEFAULT_TEMP_DIRECTORY[]     = "/tmp";
+#endif
+
+// The failed checks of the running test, some tests check on several threads
+std::atomic<unsigned int> g_nFailureCount( 0 );
+
+//
+// Tells whether the test was asked for, no names ask for all of them
+//
+bool IsSelected( const char *pName, int nArgCount, char *ppArgs[] )
+{
+    if ( nArgCount < 2 )
+    {
+        return true;
+    }
+    for ( int i = 1; i < nArgCount; ++i )
+    {
+        if ( 0 == strcmp( pName, ppArgs[i] ))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+void ReportFailure( const char *pFile, int nLine, const char *pCondition )
+{
+    ++g_nFailureCount;
+    printf( "  %s(%d): %s\n", pFile, nLine, pCondition );
+}
+
+std::string GetTestFileName( const char *pName, bool bOnTmpfs )
+{
+    const char *pDirectory = NULL;
+#ifndef _WIN32
+    if (    bOnTmpfs
+         && 0 == access( "/dev/shm", W_OK ))
+    {
+        pDirectory = "/dev/shm";
+    }
+#endif
+    if ( NULL == pDirectory )
+    {
+        pDirectory = getenv( TEMP_DIRECTORY_VARIABLE );
+    }
+    return std::string( NULL != pDirectory ? pDirectory : DEFAULT_TEMP_DIRECTORY ) + "/" + pName;
+}
+
+}}} // namespace AVT::VmbAPI::Examples
+
+int main( int argc, char* argv[] )
+{
+    unsigned int nFailedCount = 0;
+    unsigned int nRunCount = 0;
+    for ( size_t i = 0; NULL != TEST_CASES[i].pName; ++i )
+    {
+        if ( !IsSelected( TEST_CASES[i].pName, argc, argv ))
+        {
+            continue;
+        }
+        printf( "%s\n", TEST_CASES[i].pName );
+        fflush( stdout );
+        g_nFailureCount = 0;
+        TEST_CASES[i].pRun();
+        printf( "%s %s\n", 0 == g_nFailureCount ? "  passed" : "  FAILED", TEST_CASES[i].pName );
+        ++nRunCount;
+        if ( 0 != g_nFailureCount )
+        {
+            ++nFailedCount;
+        }
+    }
+    if (    0 == nRunCount
+         && argc > 1 )
+    {
+        printf( "No such test\n" );
+        return 1;
+    }
+    printf( "%u of %u tests passed\n", nRunCount - nFailedCount, nRunCount );
+    return 0 == nFailedCount ? 0 : 1;
+}
@@ -0,0 +1,1176 @@
+/*=============================================================================
+  Copyright (C) 2013 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        program.cpp
+
+  Description: A command line front end for ApiController: lists cameras, acquires
+               a number of frames or streams for a while, saves or records them and
+               reports throughput, dropped frames and latency percentiles.
+               Runs against synthetic cameras where no camera (or Windows) is at hand.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "VimbaCPP/Include/VimbaCPP.h"
+#include "Common/ErrorCodeToMessage.h"
+
+#include "AcquisitionStatistics.h"
+#include "ApiController.h"
+#include "Bitmap.h"
+#include "DirectRecorder.h"
+#include "FlightRecorder.h"
+#include "ImageWriter.h"
+#include "LatencyMonitor.h"
+#include "MetricsExporter.h"
+#include "RecordingFile.h"
+#include "SimulatedCameraBackend.h"
+#include "VimbaCameraBackend.h"
+#include "WorkerPool.h"
+
+using namespace AVT::VmbAPI::Examples;
+
+namespace
+{
+
+typedef std::chrono::steady_clock Clock;
+
+enum { DEFAULT_RING_SIZE = 8, };
+enum { PROGRESS_INTERVAL_MS = 1000, };
+enum { WAIT_INTERVAL_MS = 20, };
+const char DEFAULT_FLIGHT_PREFIX[] = "flight_";
+
+#ifdef _WIN32
+// Ctrl+Break, Windows has no user signals
+const int FLIGHT_TRIGGER_SIGNAL = SIGBREAK;
+const char FLIGHT_TRIGGER_NAME[] = "Ctrl+Break";
+#else
+const int FLIGHT_TRIGGER_SIGNAL = SIGUSR1;
+const char FLIGHT_TRIGGER_NAME[] = "SIGUSR1";
+#endif
+
+enum ExitCode
+{
+    ExitSuccess     = 0,
+    ExitUsage       = 1,                // The command line was wrong
+    ExitApiError    = 2,                // The API reported an error
+    ExitDropped     = 3,                // The acquisition worked, but frames were lost (--strict)
+};
+
+//
+// The pixel formats that can be given by name
+//
+struct PixelFormatName
+{
+    const char*         pName;
+    VmbPixelFormatType  ePixelFormat;
+};
+const PixelFormatName PIXEL_FORMAT_NAMES[] =
+{
+    { "Mono8",          VmbPixelFormatMono8 },
+    { "Mono10",         VmbPixelFormatMono10 },
+    { "Mono10p",        VmbPixelFormatMono10p },
+    { "Mono12",         VmbPixelFormatMono12 },
+    { "Mono12p",        VmbPixelFormatMono12p },
+    { "Mono12Packed",   VmbPixelFormatMono12Packed },
+    { "Mono14",         VmbPixelFormatMono14 },
+    { "Mono16",         VmbPixelFormatMono16 },
+    { "BayerRG8",       VmbPixelFormatBayerRG8 },
+    { "BayerGR8",       VmbPixelFormatBayerGR8 },
+    { "BayerGB8",       VmbPixelFormatBayerGB8 },
+    { "BayerBG8",       VmbPixelFormatBayerBG8 },
+    { "RGB8",           VmbPixelFormatRgb8 },
+    { "BGR8",           VmbPixelFormatBgr8 },
+};
+
+//
+// What the command line asked for
+//
+struct ProgramOptions
+{
+    std::string             strCommand;         // list, acquire, export or version
+    std::string             strCameraID;        // The camera to acquire from, empty for the first one
+    VmbUint64_t             nFrameCount;        // The frames to acquire or export, 0 for no limit
+    double                  dDurationS;         // How long to stream in seconds, 0 for no limit
+    std::string             strSaveDirectory;   // Where to save frames to, empty to not save them
+    VmbUint32_t             nSaveEvery;         // Saves every n-th frame
+    bool                    bSavePgm;           // Saves portable graymaps instead of bitmaps
+    std::string             strRecordFile;      // The recording to append all frames to (or to export from), empty for none
+    std::string             strExportPrefix;    // The path and start of the exported file names
+    VmbUint64_t             nExportFirst;       // The index of the first frame to export
+    VmbUint64_t             nExportStep;        // Exports every n-th frame
+    std::string             strTraceFile;       // The Chrome trace of the pipeline to write, empty for none
+    FlightRecorderConfig    flight;             // The ring of the flight recorder, no frames for none
+    std::string             strFlightPrefix;    // The path and start of the recordings the flight recorder writes
+    MetricsExporterConfig   metrics;            // Where to publish the metrics while acquiring
+    VmbUint32_t             nRingSize;          // The frames announced to the camera
+    VmbUint32_t             nWriterThreads;     // The I/O threads of the image writer
+    VmbUint32_t             nConvertThreads;    // The threads that convert stripes of large images, 0 for none
+    VmbUint32_t             nMinStripeSize;     // The least bytes of converted image per stripe, 0 for the default
+    std::vector<VmbPixelFormatType> pixelFormats; // The pixel formats to ask for, empty for the default
+    bool                    bIsSynthetic;       // Acquires from synthetic cameras instead of Vimba
+    SyntheticCameraConfig   synthetic;          // The settings of the synthetic cameras
+    VmbUint32_t             nSyntheticCount;    // The number of synthetic cameras
+    std::vector<std::string> transportLayers;   // The transport layers to load, empty for all
+    bool                    bIsQuiet;           // No progress while acquiring
+    bool                    bIsStrict;          // Fails if frames were dropped
+    bool                    bPrintStartupTiming; // Prints where the startup time went
+
+    ProgramOptions()
+        : strCommand( "acquire" )
+        , nFrameCount( 0 )
+        , dDurationS( 0.0 )
+        , nSaveEvery( 1 )
+        , bSavePgm( false )
+        , nExportFirst( 0 )
+        , nExportStep( 1 )
+        , strFlightPrefix( DEFAULT_FLIGHT_PREFIX )
+        , nRingSize( DEFAULT_RING_SIZE )
+        , nWriterThreads( DEFAULT_WRITER_THREAD_COUNT )
+        , nConvertThreads( 0 )
+        , nMinStripeSize( 0 )
+        , bIsSynthetic( false )
+        , nSyntheticCount( 1 )
+        , bIsQuiet( false )
+        , bIsStrict( false )
+        , bPrintStartupTiming( false )
+    {
+    }
+};
+
+// Set by Ctrl+C, ends the acquisition early
+volatile std::sig_atomic_t g_bIsInterrupted = 0;
+
+void OnInterrupt( int )
+{
+    g_bIsInterrupted = 1;
+}
+
+// Set by FLIGHT_TRIGGER_SIGNAL, the acquisition loop triggers the flight recorder
+volatile std::sig_atomic_t g_bIsFlightTriggered = 0;
+
+void OnFlightTrigger( int nSignal )
+{
+    g_bIsFlightTriggered = 1;
+    // Windows resets the handler with every signal
+    signal( nSignal, OnFlightTrigger );
+}
+
+//
+// Hooks a worker pool up to AVTCreateBitmap for as long as it lives,
+// so no bitmap is converted on a pool that is gone
+//
+class BitmapPoolScope
+{
+  public:
+    BitmapPoolScope( const WorkerPoolPtr &pPool, VmbUint32_t nMinStripeSize )
+        : m_pPool( pPool )
+    {
+        if ( m_pPool )
+        {
+            m_pPool->UseForBitmaps( nMinStripeSize );
+        }
+    }
+
+    ~BitmapPoolScope()
+    {
+        if ( m_pPool )
+        {
+            AVTSetBitmapParallelFor( NULL, NULL, 0 );
+        }
+    }
+
+  private:
+    const WorkerPoolPtr m_pPool;
+
+    // No copies
+    BitmapPoolScope( const BitmapPoolScope& );
+    BitmapPoolScope& operator=( const BitmapPoolScope& );
+};
+
+void PrintUsage()
+{
+    printf( "Usage: vimbacppcli [list | acquire | version] [options]\n" );
+    printf( "       vimbacppcli export <recording> [options] <prefix>\n\n" );
+    printf( "  list                        Lists the cameras\n" );
+    printf( "  acquire                     Streams from a camera (the default command)\n" );
+    printf( "  export                      Writes frames of a recording to bitmaps named <prefix><index>.bmp\n" );
+    printf( "  version                     Prints the version of the API\n\n" );
+    printf( "Options of acquire:\n" );
+    printf( "  -c, --camera <ID>           The camera to acquire from (default: the first one)\n" );
+    printf( "  -n, --count <N>             Stops after N frames\n" );
+    printf( "  -t, --duration <seconds>    Stops after the given time\n" );
+    printf( "                              Without -n and -t the acquisition runs until Ctrl+C\n" );
+    printf( "  -s, --save <directory>      Saves the frames as bitmaps into the directory\n" );
+    printf( "      --save-every <N>        Saves only every N-th frame (default 1)\n" );
+    printf( "      --pgm                   Saves portable graymaps, keeps all bits of mono images\n" );
+    printf( "  -r, --record <file>         Appends all frames to a recording file\n" );
+    printf( "      --trace <file>          Writes where every frame spent its time as a Chrome trace (open it in Perfetto)\n" );
+    printf( "      --flight <N>,<bytes>    Keeps the last N frames in memory, <bytes> per frame (at least the image size),\n" );
+    printf( "                              %s writes them to <prefix><index>.rec in the background\n", FLIGHT_TRIGGER_NAME );
+    printf( "      --flight-window <ms>[,<N>[,<ms>]]  Keeps only frames younger than <ms> at the trigger and adds\n" );
+    printf( "                              up to N frames or <ms> after it (default: the whole ring, nothing after)\n" );
+    printf( "      --flight-prefix <prefix> The path and start of the flight recordings (default %s)\n", DEFAULT_FLIGHT_PREFIX );
+    printf( "      --metrics <file>        Keeps the counters in a Prometheus text file while acquiring (every second)\n" );
+    printf( "      --metrics-shm <name>    Keeps the counters in a shared memory block while acquiring (every second)\n" );
+    printf( "  -f, --format <name>[,...]   The pixel formats to ask for, the first one the camera takes is used\n" );
+    printf( "                              (Mono8, Mono10, Mono10p, Mono12, Mono12p, Mono12Packed, Mono14, Mono16,\n" );
+    printf( "                              BayerRG8, BayerGR8, BayerGB8, BayerBG8, RGB8, BGR8)\n" );
+    printf( "      --ring <N>              The number of frames announced to the camera (default %d)\n", DEFAULT_RING_SIZE );
+    printf( "      --writer-threads <N>    The I/O threads that save frames (default %d)\n", DEFAULT_WRITER_THREAD_COUNT );
+    printf( "      --convert-threads <N>   Converts large Bayer images for bitmaps in stripes on N more threads (default: none)\n" );
+    printf( "      --min-stripe <bytes>    The least bytes of converted image per stripe (default %d)\n", AVT_BITMAP_DEFAULT_MIN_STRIPE_SIZE );
+    printf( "  -q, --quiet                 No progress while acquiring\n" );
+    printf( "      --strict                Exits with %d if frames were dropped\n\n", ExitDropped );
+    printf( "Options of export:\n" );
+    printf( "      --first <N>             The index of the first frame to export (default 0)\n" );
+    printf( "      --count <N>             Exports N frames at most (default all)\n" );
+    printf( "      --step <N>              Exports every N-th frame (default 1)\n\n" );
+    printf( "Synthetic cameras (for all commands):\n" );
+    printf( "      --synthetic [<W>x<H>[@<fps>]]  Uses synthetic cameras instead of Vimba (default 640x480@30,\n" );
+    printf( "                              fps 0 streams as fast as possible)\n" );
+    printf( "      --synthetic-count <N>   The number of synthetic cameras (default 1)\n" );
+    printf( "      --jitter <us>           The maximum deviation of a synthetic frame from its nominal time\n\n" );
+    printf( "Startup (for list and acquire):\n" );
+    printf( "      --tl <name>[,...]       Loads only the transport layers whose path contains one of the names\n" );
+    printf( "                              (e.g. VimbaGigETL, VimbaUSBTL), skipping the discovery of the others\n" );
+    printf( "      --startup-timing        Prints how long starting the API, listing and opening the cameras took\n" );
+}
+
+//
+// Parses a whole number, rejecting anything but digits
+//
+// Parameters:
+//  [in]    pText               The text
+//  [out]   rnValue             The number
+//
+// Returns:
+//  False if the text is not a number
+//
+bool ParseNumber( const char *pText, VmbUint64_t &rnValue )
+{
+    char *pEnd = NULL;
+    if (    NULL == pText
+         || '\0' == *pText
+         || '-' == *pText )
+    {
+        return false;
+    }
+    rnValue = strtoull( pText, &pEnd, 10 );
+    return '\0' == *pEnd;
+}
+
+bool ParseNumber( const char *pText, VmbUint32_t &rnValue )
+{
+    VmbUint64_t nValue = 0;
+    if (    !ParseNumber( pText, nValue )
+         || nValue > 0xFFFFFFFFull )
+    {
+        return false;
+    }
+    rnValue = static_cast<VmbUint32_t>( nValue );
+    return true;
+}
+
+bool ParseNumber( const char *pText, double &rdValue )
+{
+    char *pEnd = NULL;
+    if (    NULL == pText
+         || '\0' == *pText )
+    {
+        return false;
+    }
+    rdValue = strtod( pText, &pEnd );
+    return '\0' == *pEnd && rdValue >= 0.0;
+}
+
+//
+// Parses a comma separated list of pixel format names
+//
+bool ParsePixelFormats( const char *pText, std::vector<VmbPixelFormatType> &rPixelFormats )
+{
+    if ( NULL == pText )
+    {
+        return false;
+    }
+    rPixelFormats.clear();
+    std::string strList( pText );
+    size_t nStart = 0;
+    while ( nStart <= strList.size() )
+    {
+        const size_t nEnd = ( std::min )( strList.find( ',', nStart ), strList.size() );
+        const std::string strName = strList.substr( nStart, nEnd - nStart );
+        bool bIsKnown = false;
+        for ( size_t i = 0; i < sizeof( PIXEL_FORMAT_NAMES ) / sizeof( PIXEL_FORMAT_NAMES[0] ); ++i )
+        {
+            if ( strName == PIXEL_FORMAT_NAMES[i].pName )
+            {
+                rPixelFormats.push_back( PIXEL_FORMAT_NAMES[i].ePixelFormat );
+                bIsKnown = true;
+                break;
+            }
+        }
+        if ( !bIsKnown )
+        {
+            fprintf( stderr, "Unknown pixel format: %s\n", strName.c_str() );
+            return false;
+        }
+        nStart = nEnd + 1;
+    }
+    return true;
+}
+
+//
+// Parses a comma separated list of names
+//
+bool ParseNames( const char *pText, std::vector<std::string> &rNames )
+{
+    if (    NULL == pText
+         || '\0' == pText[0] )
+    {
+        return false;
+    }
+    rNames.clear();
+    std::string strList( pText );
+    size_t nStart = 0;
+    while ( nStart <= strList.size() )
+    {
+        const size_t nEnd = ( std::min )( strList.find( ',', nStart ), strList.size() );
+        if ( nEnd == nStart )
+        {
+            return false;
+        }
+        rNames.push_back( strList.substr( nStart, nEnd - nStart ));
+        nStart = nEnd + 1;
+    }
+    return true;
+}
+
+//
+// Parses a comma separated list of whole numbers
+//
+// Parameters:
+//  [in]    pText               The text
+//  [in]    nMinCount           The numbers that have to be there
+//  [in]    nMaxCount           The numbers that may be there
+//  [out]   rNumbers            The numbers
+//
+// Returns:
+//  False if the text is not such a list
+//
+bool ParseNumbers( const char *pText, size_t nMinCount, size_t nMaxCount, std::vector<VmbUint32_t> &rNumbers )
+{
+    std::vector<std::string> names;
+    if (    !ParseNames( pText, names )
+         || names.size() < nMinCount
+         || names.size() > nMaxCount )
+    {
+        return false;
+    }
+    rNumbers.assign( names.size(), 0 );
+    for ( size_t i = 0; i < names.size(); ++i )
+    {
+        if ( !ParseNumber( names[i].c_str(), rNumbers[i] ))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+//
+// Parses <W>x<H>[@<fps>]
+//
+bool ParseGeometry( const char *pText, SyntheticCameraConfig &rConfig )
+{
+    unsigned int nWidth = 0;
+    unsigned int nHeight = 0;
+    int nLength = 0;
+    double dFrameRate = rConfig.dFrameRate;
+    if (    2 != sscanf( pText, "%ux%u%n", &nWidth, &nHeight, &nLength )
+         || 0 == nWidth
+         || 0 == nHeight )
+    {
+        return false;
+    }
+    if (    '\0' != pText[nLength]
+         && (    '@' != pText[nLength]
+              || !ParseNumber( pText + nLength + 1, dFrameRate )))
+    {
+        return false;
+    }
+    rConfig.nWidth      = nWidth;
+    rConfig.nHeight     = nHeight;
+    rConfig.dFrameRate  = dFrameRate;
+    return true;
+}
+
+//
+// Reads the command line
+//
+// Parameters:
+//  [in]    nArgCount           The number of arguments
+//  [in]    ppArgs              The arguments
+//  [out]   rOptions            The options
+//
+// Returns:
+//  False if the command line is wrong (the reason was printed)
+//
+bool ParseCommandLine( int nArgCount, char *ppArgs[], ProgramOptions &rOptions )
+{
+    int i = 1;
+    if (    i < nArgCount
+         && '-' != ppArgs[i][0] )
+    {
+        rOptions.strCommand = ppArgs[i++];
+        if (    "list" != rOptions.strCommand
+             && "acquire" != rOptions.strCommand
+             && "export" != rOptions.strCommand
+             && "version" != rOptions.strCommand )
+        {
+            fprintf( stderr, "Unknown command: %s\n", rOptions.strCommand.c_str() );
+            return false;
+        }
+    }
+
+    for ( ; i < nArgCount; ++i )
+    {
+        const std::string strOption( ppArgs[i] );
+        // The argument of the option, if there is one
+        const char *pValue = i + 1 < nArgCount ? ppArgs[i + 1] : NULL;
+        bool bIsValid = true;
+        bool bTakesValue = true;
+
+        if (    "export" == rOptions.strCommand
+             && '-' != strOption[0] )
+        {
+            // The recording, then the prefix
+            bTakesValue = false;
+            if ( rOptions.strRecordFile.empty() )
+            {
+                rOptions.strRecordFile = strOption;
+            }
+            else if ( rOptions.strExportPrefix.empty() )
+            {
+                rOptions.strExportPrefix = strOption;
+            }
+            else
+            {
+                fprintf( stderr, "Unexpected argument: %s\n", strOption.c_str() );
+                return false;
+            }
+        }
+        else if (    "-c" == strOption
+             || "--camera" == strOption )
+        {
+            bIsValid = NULL != pValue;
+            if ( bIsValid )
+            {
+                rOptions.strCameraID = pValue;
+            }
+        }
+        else if (    "-n" == strOption
+                  || "--count" == strOption )
+        {
+            bIsValid = ParseNumber( pValue, rOptions.nFrameCount ) && 0 != rOptions.nFrameCount;
+        }
+        else if (    "-t" == strOption
+                  || "--duration" == strOption )
+        {
+            bIsValid = ParseNumber( pValue, rOptions.dDurationS ) && rOptions.dDurationS > 0.0;
+        }
+        else if (    "-s" == strOption
+                  || "--save" == strOption )
+        {
+            bIsValid = NULL != pValue;
+            if ( bIsValid )
+            {
+                rOptions.strSaveDirectory = pValue;
+            }
+        }
+        else if ( "--first" == strOption )
+        {
+            bIsValid = ParseNumber( pValue, rOptions.nExportFirst );
+        }
+        else if ( "--step" == strOption )
+        {
+            bIsValid = ParseNumber( pValue, rOptions.nExportStep ) && 0 != rOptions.nExportStep;
+        }
+        else if ( "--save-every" == strOption )
+        {
+            bIsValid = ParseNumber( pValue, rOptions.nSaveEvery ) && 0 != rOptions.nSaveEvery;
+        }
+        else if (    "-r" == strOption
+                  || "--record" == strOption )
+        {
+            bIsValid = NULL != pValue;
+            if ( bIsValid )
+            {
+                rOptions.strRecordFile = pValue;
+            }
+        }
+        else if ( "--trace" == strOption )
+        {
+            bIsValid = NULL != pValue;
+            if ( bIsValid )
+            {
+                rOptions.strTraceFile = pValue;
+            }
+        }
+        else if ( "--flight" == strOption )
+        {
+            std::vector<VmbUint32_t> numbers;
+            bIsValid =    ParseNumbers( pValue, 2, 2, numbers )
+                       && 0 != numbers[0]
+                       && 0 != numbers[1];
+            if ( bIsValid )
+            {
+                rOptions.flight.nFrameCount     = numbers[0];
+                rOptions.flight.nMaxImageSize   = numbers[1];
+            }
+        }
+        else if ( "--flight-window" == strOption )
+        {
+            std::vector<VmbUint32_t> numbers;
+            bIsValid = ParseNumbers( pValue, 1, 3, numbers );
+            if ( bIsValid )
+            {
+                numbers.resize( 3, 0 );
+                rOptions.flight.nPreTriggerMS       = numbers[0];
+                rOptions.flight.nPostTriggerFrames  = numbers[1];
+                rOptions.flight.nPostTriggerMS      = numbers[2];
+            }
+        }
+        else if ( "--flight-prefix" == strOption )
+        {
+            bIsValid = NULL != pValue;
+            if ( bIsValid )
+            {
+                rOptions.strFlightPrefix = pValue;
+            }
+        }
+        else if ( "--metrics" == strOption )
+        {
+            bIsValid = NULL != pValue;
+            if ( bIsValid )
+            {
+                rOptions.metrics.strTextFile = pValue;
+            }
+        }
+        else if ( "--metrics-shm" == strOption )
+        {
+            bIsValid = NULL != pValue;
+            if ( bIsValid )
+            {
+                rOptions.metrics.strSharedMemoryName = pValue;
+            }
+        }
+        else if (    "-f" == strOption
+                  || "--format" == strOption )
+        {
+            bIsValid = ParsePixelFormats( pValue, rOptions.pixelFormats );
+        }
+        else if ( "--ring" == strOption )
+        {
+            bIsValid = ParseNumber( pValue, rOptions.nRingSize ) && 0 != rOptions.nRingSize;
+        }
+        else if ( "--writer-threads" == strOption )
+        {
+            bIsValid = ParseNumber( pValue, rOptions.nWriterThreads ) && 0 != rOptions.nWriterThreads;
+        }
+        else if ( "--convert-threads" == strOption )
+        {
+            bIsValid = ParseNumber( pValue, rOptions.nConvertThreads ) && 0 != rOptions.nConvertThreads;
+        }
+        else if ( "--min-stripe" == strOption )
+        {
+            bIsValid = ParseNumber( pValue, rOptions.nMinStripeSize ) && 0 != rOptions.nMinStripeSize;
+        }
+        else if ( "--synthetic" == strOption )
+        {
+            rOptions.bIsSynthetic = true;
+            // The geometry is optional
+            bTakesValue = NULL != pValue && '-' != pValue[0];
+            if ( bTakesValue )
+            {
+                bIsValid = ParseGeometry( pValue, rOptions.synthetic );
+            }
+        }
+        else if ( "--synthetic-count" == strOption )
+        {
+            bIsValid = ParseNumber( pValue, rOptions.nSyntheticCount ) && 0 != rOptions.nSyntheticCount;
+        }
+        else if ( "--jitter" == strOption )
+        {
+            bIsValid = ParseNumber( pValue, rOptions.synthetic.nJitterUS );
+        }
+        else if ( "--tl" == strOption )
+        {
+            bIsValid = ParseNames( pValue, rOptions.transportLayers );
+        }
+        else
+        {
+            bTakesValue = false;
+            if ( "--pgm" == strOption )
+            {
+                rOptions.bSavePgm = true;
+            }
+            else if (    "-q" == strOption
+                      || "--quiet" == strOption )
+            {
+                rOptions.bIsQuiet = true;
+            }
+            else if ( "--strict" == strOption )
+            {
+                rOptions.bIsStrict = true;
+            }
+            else if ( "--startup-timing" == strOption )
+            {
+                rOptions.bPrintStartupTiming = true;
+            }
+            else if (    "-h" == strOption
+                      || "--help" == strOption )
+            {
+                return false;
+            }
+            else
+            {
+                fprintf( stderr, "Unknown option: %s\n", strOption.c_str() );
+                return false;
+            }
+        }
+
+        if ( !bIsValid )
+        {
+            fprintf( stderr, "Missing or invalid value of %s\n", strOption.c_str() );
+            return false;
+        }
+        if ( bTakesValue )
+        {
+            ++i;
+        }
+    }
+    if (    "export" == rOptions.strCommand
+         && rOptions.strExportPrefix.empty() )
+    {
+        fprintf( stderr, "export needs a recording and a prefix\n" );
+        return false;
+    }
+    return true;
+}
+
+//
+// Creates the controller for Vimba or for the synthetic cameras
+//
+std::unique_ptr<ApiController> CreateController( const ProgramOptions &rOptions )
+{
+    if ( !rOptions.bIsSynthetic )
+    {
+        std::shared_ptr<VimbaCameraBackend> pBackend( new VimbaCameraBackend() );
+        pBackend->SetTransportLayers( rOptions.transportLayers );
+        return std::unique_ptr<ApiController>( new ApiController( pBackend ));
+    }
+    std::shared_ptr<SimulatedCameraBackend> pBackend( new SimulatedCameraBackend() );
+    for ( VmbUint32_t i = 0; i < rOptions.nSyntheticCount; ++i )
+    {
+        SyntheticCameraConfig config = rOptions.synthetic;
+        config.strID = "Synthetic" + std::to_string( i );
+        config.nSeed = i;
+        pBackend->AddSyntheticCamera( config );
+    }
+    return std::unique_ptr<ApiController>( new ApiController( pBackend ));
+}
+
+//
+// Prints the steps of the startup to stderr
+//
+void PrintStartupPhases( const ApiController &rController )
+{
+    const StartupPhaseVector phases = rController.GetStartupPhases();
+    VmbUint64_t nTotalUS = 0;
+    for (   StartupPhaseVector::const_iterator iter = phases.begin();
+            phases.end() != iter;
+            ++iter )
+    {
+        fprintf( stderr, "%-40s %10.3f ms\n", iter->strName.c_str(), iter->nDurationUS / 1000.0 );
+        nTotalUS += iter->nDurationUS;
+    }
+    fprintf( stderr, "%-40s %10.3f ms\n", "Total", nTotalUS / 1000.0 );
+}
+
+int ListCameras( ApiController &rController )
+{
+    const CameraInfoVector cameras = rController.GetCameraList();
+    if ( cameras.empty() )
+    {
+        printf( "No cameras found\n" );
+        return ExitSuccess;
+    }
+    printf( "%-24s %-24s %-24s %s\n", "ID", "Name", "Model", "Serial number" );
+    for (   CameraInfoVector::const_iterator iter = cameras.begin();
+            cameras.end() != iter;
+            ++iter )
+    {
+        printf( "%-24s %-24s %-24s %s\n", iter->strID.c_str(), iter->strName.c_str(), iter->strModel.c_str(), iter->strSerialNumber.c_str() );
+    }
+    return ExitSuccess;
+}
+
+//
+// Prints the latencies the pipeline stages recorded into the default latency monitor
+//
+void PrintLatencies()
+{
+    for ( int i = 0; i < LatencyStageCount; ++i )
+    {
+        LatencyHistogram histogram;
+        LatencyMonitor::GetDefault().GetHistogram( static_cast<LatencyStage>( i ), histogram );
+        if ( 0 == histogram.GetCount() )
+        {
+            continue;
+        }
+        printf( "  %-12s %10llu %10llu %10llu %10llu %10llu\n",
+                GetLatencyStageName( static_cast<LatencyStage>( i )),
+                static_cast<unsigned long long>( histogram.GetPercentileNS( 50.0 ) / 1000 ),
+                static_cast<unsigned long long>( histogram.GetPercentileNS( 90.0 ) / 1000 ),
+                static_cast<unsigned long long>( histogram.GetPercentileNS( 99.0 ) / 1000 ),
+                static_cast<unsigned long long>( histogram.GetMaxNS() / 1000 ),
+                static_cast<unsigned long long>( histogram.GetCount() ));
+    }
+}
+
+//
+// Writes frames of a recording to bitmap files
+//
+// Parameters:
+//  [in]    rOptions            The recording, the prefix and which frames to export
+//
+// Returns:
+//  An ExitCode
+//
+int ExportRecording( const ProgramOptions &rOptions )
+{
+    RecordingReader reader;
+    VmbErrorType err = reader.Open( rOptions.strRecordFile );
+    if ( VmbErrorSuccess != err )
+    {
+        fprintf( stderr, "Could not open %s: %s\n", rOptions.strRecordFile.c_str(), ErrorCodeToMessage( err ).c_str() );
+        return ExitApiError;
+    }
+    const VmbUint64_t nCount = 0 != rOptions.nFrameCount ? rOptions.nFrameCount : reader.GetFrameCount();
+    VmbUint64_t nExported = 0;
+    err = ExportRecordingToBitmaps( reader, rOptions.nExportFirst, nCount, rOptions.nExportStep, rOptions.strExportPrefix, nExported );
+    printf( "Exported:    %llu of %llu frames\n",
+            static_cast<unsigned long long>( nExported ),
+            static_cast<unsigned long long>( reader.GetFrameCount() ));
+    if ( VmbErrorSuccess != err )
+    {
+        fprintf( stderr, "Could not export frame %llu: %s\n",
+                 static_cast<unsigned long long>( rOptions.nExportFirst + nExported * rOptions.nExportStep ),
+                 ErrorCodeToMessage( err ).c_str() );
+        return ExitApiError;
+    }
+    return ExitSuccess;
+}
+
+//
+// Prints what the acquisition achieved
+//
+// Parameters:
+//  [in]    rSummary            The counters of the acquisition
+//  [in]    pWriterStatistics   The counters of the image writer, NULL if nothing was saved
+//  [in]    pRecorderStatistics The counters of the recording, NULL if nothing was recorded
+//  [in]    pFlightStatistics   The counters of the flight recorder, NULL if it did not run
+//
+void PrintSummary( const AcquisitionSummary &rSummary, const ImageWriterStatistics *pWriterStatistics, const DirectRecorderStatistics *pRecorderStatistics,
+                   const FlightRecorderStatistics *pFlightStatistics )
+{
+    const VmbUint64_t nWriterDropped = NULL != pWriterStatistics ? pWriterStatistics->nDroppedCount : 0;
+    printf( "Frames:      %llu in %.2f s, %.1f fps, %.1f MB/s\n",
+            static_cast<unsigned long long>( rSummary.nFrameCount ),
+            rSummary.dSeconds,
+            rSummary.dFramesPerSecond,
+            rSummary.dBytesPerSecond / ( 1024.0 * 1024.0 ));
+    printf( "Dropped:     %llu (missing %llu, incomplete %llu, not saved %llu)\n",
+            static_cast<unsigned long long>( rSummary.nMissingCount + rSummary.nIncompleteCount + rSummary.nOverflowCount ),
+            static_cast<unsigned long long>( rSummary.nMissingCount ),
+            static_cast<unsigned long long>( rSummary.nIncompleteCount ),
+            static_cast<unsigned long long>( rSummary.nOverflowCount ));
+    if ( NULL != pWriterStatistics )
+    {
+        printf( "Saved:       %llu files, %.1f MB/s, %llu failed, %llu dropped, queue up to %u\n",
+                static_cast<unsigned long long>( pWriterStatistics->nWrittenCount ),
+                pWriterStatistics->dBytesPerSecond / ( 1024.0 * 1024.0 ),
+                static_cast<unsigned long long>( pWriterStatistics->nFailedCount ),
+                static_cast<unsigned long long>( nWriterDropped ),
+                pWriterStatistics->nMaxQueueDepth );
+    }
+    if ( NULL != pRecorderStatistics )
+    {
+        printf( "Recorded:    %llu frames, %.1f MB/s, %llu stalls (%.1f ms)%s\n",
+                static_cast<unsigned long long>( pRecorderStatistics->nFrameCount ),
+                pRecorderStatistics->dBytesPerSecond / ( 1024.0 * 1024.0 ),
+                static_cast<unsigned long long>( pRecorderStatistics->nStallCount ),
+                pRecorderStatistics->nStallTimeUS / 1000.0,
+                pRecorderStatistics->bIsDirect ? ", unbuffered" : "" );
+    }
+    if ( NULL != pFlightStatistics )
+    {
+        printf( "Flight:      %llu events, %llu failed, %llu frames in a ring of %.1f MB, %llu dropped\n",
+                static_cast<unsigned long long>( pFlightStatistics->nEventCount ),
+                static_cast<unsigned long long>( pFlightStatistics->nFailedEventCount ),
+                static_cast<unsigned long long>( pFlightStatistics->nFrameCount ),
+                pFlightStatistics->nMemorySize / ( 1024.0 * 1024.0 ),
+                static_cast<unsigned long long>( pFlightStatistics->nDroppedCount ));
+    }
+    printf( "Latency (us) %10s %10s %10s %10s %10s\n", "p50", "p90", "p99", "max", "samples" );
+    PrintLatencies();
+}
+
+//
+// Streams from a camera until the frame count or the duration is reached (or Ctrl+C),
+// saves or records the frames on the way and prints the statistics
+//
+// Parameters:
+//  [in]    rController         The started controller
+//  [in]    rOptions            What to do
+//
+// Returns:
+//  An ExitCode
+//
+int Acquire( ApiController &rController, const ProgramOptions &rOptions )
+{
+    std::string strCameraID = rOptions.strCameraID;
+    if ( strCameraID.empty() )
+    {
+        const CameraInfoVector cameras = rController.GetCameraList();
+        if ( cameras.empty() )
+        {
+            fprintf( stderr, "No cameras found\n" );
+            return ExitApiError;
+        }
+        strCameraID = cameras.front().strID;
+    }
+    if ( !rOptions.pixelFormats.empty() )
+    {
+        rController.SetPixelFormats( rOptions.pixelFormats );
+    }
+
+    WorkerPoolPtr pConversionPool;
+    if ( 0 != rOptions.nConvertThreads )
+    {
+        pConversionPool.reset( new WorkerPool( rOptions.nConvertThreads ));
+    }
+    // Outlives the writer, whose I/O threads may still convert on the pool
+    const BitmapPoolScope bitmapPool( pConversionPool, rOptions.nMinStripeSize );
+    std::unique_ptr<ImageWriter> pWriter;
+    if ( !rOptions.strSaveDirectory.empty() )
+    {
+        // Saving must never hold up the frame callback, frames the disk cannot take are counted instead
+        pWriter.reset( new ImageWriter( rOptions.nWriterThreads, DEFAULT_WRITER_QUEUE_CAPACITY, WriterPolicyDropNewest ));
+        if ( pConversionPool )
+        {
+            pWriter->SetConversionPool( pConversionPool, rOptions.nMinStripeSize );
+        }
+    }
+    std::unique_ptr<DirectRecorder> pRecorder;
+    if ( !rOptions.strRecordFile.empty() )
+    {
+        pRecorder.reset( new DirectRecorder() );
+        const VmbErrorType err = pRecorder->Open( rOptions.strRecordFile );
+        if ( VmbErrorSuccess != err )
+        {
+            fprintf( stderr, "Could not create %s: %s\n", rOptions.strRecordFile.c_str(), rController.ErrorCodeToMessage( err ).c_str() );
+            return ExitApiError;
+        }
+    }
+
+    AcquisitionStatistics statistics;
+    std::atomic<VmbUint64_t> nAccepted( 0 );
+    std::atomic<bool> bIsRecordingFailed( false );
+    const char *pExtension = rOptions.bSavePgm ? ".pgm" : ".bmp";
+
+    // Runs on the API's thread, everything slow is handed to the writer
+    const auto onFrame = [&]( const ImageFrame &rFrame )
+    {
+        const VmbUint64_t nIndex = nAccepted.fetch_add( 1 );
+        // Frames that arrive while the acquisition stops do not count
+        if (    0 != rOptions.nFrameCount
+             && nIndex >= rOptions.nFrameCount )
+        {
+            return;
+        }
+        statistics.RecordFrame( rFrame );
+        if (    pRecorder
+             && VmbErrorSuccess != pRecorder->Append( rFrame ))
+        {
+            bIsRecordingFailed = true;
+        }
+        if (    pWriter
+             && 0 == nIndex % rOptions.nSaveEvery )
+        {
+            const std::string strFileName = rOptions.strSaveDirectory + "/" + strCameraID + "_" + std::to_string( rFrame.nFrameID ) + pExtension;
+            const VmbErrorType err = pWriter->SubmitCopy( rFrame, strFileName );
+            if ( VmbErrorSuccess != err )
+            {
+                statistics.RecordOverflow();
+            }
+        }
+    };
+
+    MetricsExporter metricsExporter;
+    if (    !rOptions.metrics.strTextFile.empty()
+         || !rOptions.metrics.strSharedMemoryName.empty() )
+    {
+        const VmbErrorType err = metricsExporter.Start( rOptions.metrics );
+        if ( VmbErrorSuccess != err )
+        {
+            fprintf( stderr, "Could not publish the metrics: %s\n", rController.ErrorCodeToMessage( err ).c_str() );
+            return ExitApiError;
+        }
+    }
+    if ( !rOptions.strTraceFile.empty() )
+    {
+        rController.SetTracing( true );
+    }
+    const bool bIsFlightRecording = 0 != rOptions.flight.nFrameCount;
+    VmbUint64_t nFlightEventIndex = 0;
+    // Counted by the writer thread of the flight recorder, the recorder only counts what it wrote before it stops
+    std::atomic<VmbUint64_t> nFlightEventCount( 0 );
+    std::atomic<VmbUint64_t> nFailedFlightEventCount( 0 );
+    const FlightRecorder::EventCallback onFlightEvent = [&]( const std::string &rFileName, VmbUint32_t nFrameCount, VmbErrorType eResult )
+    {
+        if ( VmbErrorSuccess == eResult )
+        {
+            ++nFlightEventCount;
+            fprintf( stderr, "\nWrote %u frames to %s\n", nFrameCount, rFileName.c_str() );
+        }
+        else
+        {
+            ++nFailedFlightEventCount;
+            fprintf( stderr, "\nCould not write %s: %s\n", rFileName.c_str(), rController.ErrorCodeToMessage( eResult ).c_str() );
+        }
+    };
+    if ( bIsFlightRecording )
+    {
+        const VmbErrorType err = rController.StartFlightRecorder( rOptions.flight );
+        if ( VmbErrorSuccess != err )
+        {
+            fprintf( stderr, "Could not start the flight recorder: %s\n", rController.ErrorCodeToMessage( err ).c_str() );
+            return ExitApiError;
+        }
+    }
+    statistics.Start();
+    VmbErrorType err = rController.StartContinuousAcquisition( strCameraID, onFrame, rOptions.nRingSize );
+    if ( VmbErrorSuccess != err )
+    {
+        fprintf( stderr, "Could not start the acquisition of %s: %s\n", strCameraID.c_str(), rController.ErrorCodeToMessage( err ).c_str() );
+        return ExitApiError;
+    }
+    if ( !rOptions.bIsQuiet )
+    {
+        fprintf( stderr, "Acquiring from %s, Ctrl+C stops\n", strCameraID.c_str() );
+        if ( bIsFlightRecording )
+        {
+            fprintf( stderr, "%s writes the flight recorder\n", FLIGHT_TRIGGER_NAME );
+        }
+    }
+
+    const Clock::time_point tStart = Clock::now();
+    Clock::time_point tProgress = tStart;
+    for ( ;; )
+    {
+        const Clock::time_point tNow = Clock::now();
+        if (    g_bIsInterrupted
+             || ( 0 != rOptions.nFrameCount && nAccepted.load() >= rOptions.nFrameCount )
+             || ( rOptions.dDurationS > 0.0 && std::chrono::duration<double>( tNow - tStart ).count() >= rOptions.dDurationS ))
+        {
+            break;
+        }
+        if (    bIsFlightRecording
+             && g_bIsFlightTriggered )
+        {
+            g_bIsFlightTriggered = 0;
+            const std::string strFileName = rOptions.strFlightPrefix + std::to_string( nFlightEventIndex ) + ".rec";
+            const VmbErrorType err = rController.TriggerFlightRecorder( strFileName, onFlightEvent );
+            if ( VmbErrorSuccess == err )
+            {
+                ++nFlightEventIndex;
+            }
+            else
+            {
+                // The window of the previous event is still open
+                fprintf( stderr, "\nCould not trigger the flight recorder: %s\n", rController.ErrorCodeToMessage( err ).c_str() );
+            }
+        }
+        if (    !rOptions.bIsQuiet
+             && tNow - tProgress >= std::chrono::milliseconds( PROGRESS_INTERVAL_MS ))
+        {
+            const AcquisitionSummary summary = statistics.GetSummary();
+            fprintf( stderr, "\r%llu frames, %.1f fps, %.1f MB/s   ",
+                     static_cast<unsigned long long>( summary.nFrameCount ),
+                     summary.dFramesPerSecond,
+                     summary.dBytesPerSecond / ( 1024.0 * 1024.0 ));
+            tProgress = tNow;
+        }
+        std::this_thread::sleep_for( std::chrono::milliseconds( WAIT_INTERVAL_MS ));
+    }
+    err = rController.StopContinuousAcquisition();
+    // The rates are those of the acquisition, not of the files written afterwards
+    const AcquisitionSummary summary = statistics.GetSummary();
+    if (    !rOptions.bIsQuiet
+         && tProgress != tStart )
+    {
+        fprintf( stderr, "\n" );
+    }
+
+    std::unique_ptr<ImageWriterStatistics> pWriterStatistics;
+    if ( pWriter )
+    {
+        pWriter->Flush();
+        pWriterStatistics.reset( new ImageWriterStatistics( pWriter->GetStatistics() ));
+    }
+    std::unique_ptr<DirectRecorderStatistics> pRecorderStatistics;
+    if ( pRecorder )
+    {
+        if ( VmbErrorSuccess != pRecorder->Close() )
+        {
+            bIsRecordingFailed = true;
+        }
+        pRecorderStatistics.reset( new DirectRecorderStatistics( pRecorder->GetStatistics() ));
+    }
+    std::unique_ptr<FlightRecorderStatistics> pFlightStatistics;
+    if ( bIsFlightRecording )
+    {
+        // No frames come in anymore, only events may still be written
+        pFlightStatistics.reset( new FlightRecorderStatistics() );
+        rController.GetFlightRecorderStatistics( *pFlightStatistics );
+        rController.StopFlightRecorder();
+        pFlightStatistics->nEventCount          = nFlightEventCount;
+        pFlightStatistics->nFailedEventCount    = nFailedFlightEventCount;
+    }
+
+    // The last publication has the counters of all written files
+    const bool bIsMetricsFailed = VmbErrorSuccess != metricsExporter.Stop();
+    bool bIsTraceFailed = false;
+    if ( !rOptions.strTraceFile.empty() )
+    {
+        rController.SetTracing( false );
+        bIsTraceFailed = VmbErrorSuccess != rController.WriteTrace( rOptions.strTraceFile );
+    }
+
+    // The latencies of the save stage come in until the writer is flushed
+    PrintSummary( summary, pWriterStatistics.get(), pRecorderStatistics.get(), pFlightStatistics.get() );
+
+    if ( VmbErrorSuccess != err )
+    {
+        fprintf( stderr, "Could not stop the acquisition: %s\n", rController.ErrorCodeToMessage( err ).c_str() );
+        return ExitApiError;
+    }
+    if (    pWriterStatistics
+         && 0 != pWriterStatistics->nFailedCount )
+    {
+        fprintf( stderr, "Could not write %llu files to %s\n",
+                 static_cast<unsigned long long>( pWriterStatistics->nFailedCount ),
+                 rOptions.strSaveDirectory.c_str() );
+        return ExitApiError;
+    }
+    if ( bIsRecordingFailed )
+    {
+        fprintf( stderr, "Could not write %s\n", rOptions.strRecordFile.c_str() );
+        return ExitApiError;
+    }
+    if (    pFlightStatistics
+         && 0 != pFlightStatistics->nFailedEventCount )
+    {
+        fprintf( stderr, "Could not write %llu flight recordings\n", static_cast<unsigned long long>( pFlightStatistics->nFailedEventCount ));
+        return ExitApiError;
+    }
+    if ( bIsTraceFailed )
+    {
+        fprintf( stderr, "Could not write %s\n", rOptions.strTraceFile.c_str() );
+        return ExitApiError;
+    }
+    if ( bIsMetricsFailed )
+    {
+        fprintf( stderr, "Could not write %s\n", rOptions.metrics.strTextFile.c_str() );
+        return ExitApiError;
+    }
+    if (    rOptions.bIsStrict
+         && 0 != summary.nMissingCount + summary.nIncompleteCount + summary.nOverflowCount )
+    {
+        return ExitDropped;
+    }
+    return ExitSuccess;
+}
+
+} // namespace
+
+int main( int argc, char* argv[] )
+{
+    ProgramOptions options;
+    if ( !ParseCommandLine( argc, argv, options ))
+    {
+        PrintUsage();
+        return ExitUsage;
+    }
+    signal( SIGINT, OnInterrupt );
+    signal( FLIGHT_TRIGGER_SIGNAL, OnFlightTrigger );
+
+    // Needs no API
+    if ( "export" == options.strCommand )
+    {
+        return ExportRecording( options );
+    }
+
+    std::unique_ptr<ApiController> pController = CreateController( options );
+    if ( "version" == options.strCommand )
+    {
+        printf( "%s\n", pController->GetVersion().c_str() );
+        return ExitSuccess;
+    }
+
+    const VmbErrorType err = pController->StartUp();
+    if ( VmbErrorSuccess != err )
+    {
+        fprintf( stderr, "Could not start the API: %s\n", pController->ErrorCodeToMessage( err ).c_str() );
+        return ExitApiError;
+    }
+    const int nResult = "list" == options.strCommand
+        ? ListCameras( *pController )
+        : Acquire( *pController, options );
+    if ( options.bPrintStartupTiming )
+    {
+        PrintStartupPhases( *pController );
+    }
+    pController->ShutDown();
+    return nResult;
+}
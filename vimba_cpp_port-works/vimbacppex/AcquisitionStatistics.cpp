@@ -0,0 +1,108 @@
+/*=============================================================================
+  Copyright (C) 2013 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        AcquisitionStatistics.cpp
+
+  Description: Counts the frames of a continuous acquisition for throughput
+               reports (the latencies are kept by LatencyMonitor).
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#include "AcquisitionStatistics.h"
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+AcquisitionStatistics::AcquisitionStatistics()
+{
+    Start();
+}
+
+//
+// Sets all counters to zero and starts measuring
+//
+void AcquisitionStatistics::Start()
+{
+    std::lock_guard<std::mutex> lock( m_mutex );
+    m_tStart            = Clock::now();
+    m_nFrameCount       = 0;
+    m_nByteCount        = 0;
+    m_nIncompleteCount  = 0;
+    m_nMissingCount     = 0;
+    m_nOverflowCount    = 0;
+    m_nNextFrameID      = 0;
+}
+
+//
+// Counts a frame of the frame callback
+//
+// Parameters:
+//  [in]    rFrame              The frame
+//
+void AcquisitionStatistics::RecordFrame( const ImageFrame &rFrame )
+{
+    std::lock_guard<std::mutex> lock( m_mutex );
+    // A frame ID below the expected one means the camera restarted counting, that is no loss
+    if (    0 != m_nFrameCount
+         && rFrame.nFrameID > m_nNextFrameID )
+    {
+        m_nMissingCount += rFrame.nFrameID - m_nNextFrameID;
+    }
+    m_nNextFrameID = rFrame.nFrameID + 1;
+    if ( VmbFrameStatusComplete != rFrame.eReceiveStatus )
+    {
+        ++m_nIncompleteCount;
+    }
+    ++m_nFrameCount;
+    m_nByteCount += rFrame.nImageSize;
+}
+
+//
+// Counts a frame the host had to throw away
+//
+void AcquisitionStatistics::RecordOverflow()
+{
+    std::lock_guard<std::mutex> lock( m_mutex );
+    ++m_nOverflowCount;
+}
+
+//
+// Gets the counters and the rates
+//
+AcquisitionSummary AcquisitionStatistics::GetSummary() const
+{
+    AcquisitionSummary summary;
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        summary.dSeconds            = std::chrono::duration<double>( Clock::now() - m_tStart ).count();
+        summary.nFrameCount         = m_nFrameCount;
+        summary.nByteCount          = m_nByteCount;
+        summary.nIncompleteCount    = m_nIncompleteCount;
+        summary.nMissingCount       = m_nMissingCount;
+        summary.nOverflowCount      = m_nOverflowCount;
+    }
+    summary.dFramesPerSecond    = summary.dSeconds > 0.0 ? summary.nFrameCount / summary.dSeconds : 0.0;
+    summary.dBytesPerSecond     = summary.dSeconds > 0.0 ? summary.nByteCount / summary.dSeconds : 0.0;
+    return summary;
+}
+
+}}} // namespace AVT::VmbAPI::Examples
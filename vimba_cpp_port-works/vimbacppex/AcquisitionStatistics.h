@@ -0,0 +1,105 @@
+/*=============================================================================
+  Copyright (C) 2013 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        AcquisitionStatistics.h
+
+  Description: Counts the frames of a continuous acquisition for throughput
+               reports (the latencies are kept by LatencyMonitor).
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#ifndef AVT_VMBAPI_EXAMPLES_ACQUISITIONSTATISTICS
+#define AVT_VMBAPI_EXAMPLES_ACQUISITIONSTATISTICS
+
+#include <chrono>
+#include <mutex>
+
+#include "VimbaCPP/Include/VimbaCPP.h"
+
+#include "ImageFrame.h"
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+//
+// What AcquisitionStatistics measured since its start
+//
+struct AcquisitionSummary
+{
+    double          dSeconds;               // The time since the start
+    VmbUint64_t     nFrameCount;            // Frames that reached the frame callback
+    VmbUint64_t     nByteCount;             // Image bytes of these frames
+    VmbUint64_t     nIncompleteCount;       // Frames that arrived, but not completely
+    VmbUint64_t     nMissingCount;          // Frames that never arrived (gaps in the frame IDs)
+    VmbUint64_t     nOverflowCount;         // Frames thrown away because the host could not keep up
+    double          dFramesPerSecond;
+    double          dBytesPerSecond;
+};
+
+class AcquisitionStatistics
+{
+  public:
+    AcquisitionStatistics();
+
+    //
+    // Sets all counters to zero and starts measuring
+    //
+    void            Start();
+
+    //
+    // Counts a frame of the frame callback
+    //
+    // Parameters:
+    //  [in]    rFrame              The frame
+    //
+    void            RecordFrame( const ImageFrame &rFrame );
+
+    //
+    // Counts a frame the host had to throw away
+    //
+    void            RecordOverflow();
+
+    //
+    // Gets the counters and the rates
+    //
+    AcquisitionSummary GetSummary() const;
+
+  private:
+    typedef std::chrono::steady_clock Clock;
+
+    mutable std::mutex          m_mutex;
+    Clock::time_point           m_tStart;
+    VmbUint64_t                 m_nFrameCount;
+    VmbUint64_t                 m_nByteCount;
+    VmbUint64_t                 m_nIncompleteCount;
+    VmbUint64_t                 m_nMissingCount;
+    VmbUint64_t                 m_nOverflowCount;
+    VmbUint64_t                 m_nNextFrameID;
+
+    // No copies
+    AcquisitionStatistics( const AcquisitionStatistics& );
+    AcquisitionStatistics& operator=( const AcquisitionStatistics& );
+};
+
+}}} // namespace AVT::VmbAPI::Examples
+
+#endif
@@ -28,13 +28,18 @@
 =============================================================================*/
 
 
-#include "stdafx.h"
-
+#include <algorithm>
+#include <atomic>
+#include <climits>
 #include <sstream>
 #include <iostream>
 
 #include "ApiController.h"
-#include "Common/StreamSystemInfo.h"
+#include "BufferPool.h"
+#include "FrameTracer.h"
+#include "LatencyMonitor.h"
+#include "MetricsRegistry.h"
+#include "VimbaCameraBackend.h"
 #include "Common/ErrorCodeToMessage.h"
 
 namespace AVT {
@@ -42,116 +47,1231 @@ namespace VmbAPI {
 namespace Examples {
 
 enum { NUM_FRAMES = 3, };
+enum { DEFAULT_IDLE_TIMEOUT_MS = 10000, };
+// How often the reaper looks for idle sessions at most
+enum { MAX_REAP_INTERVAL_MS = 1000, };
+// How long the packet size negotiation may take and how long we sleep between polls at most
+enum { PACKET_SIZE_TIMEOUT_MS = 5000, };
+enum { MAX_PACKET_SIZE_BACKOFF_MS = 50, };
+// How often the cameras are listed again for backends without hot-plug events
+enum { CAMERA_REFRESH_INTERVAL_MS = 5000, };
+// The pixel formats cameras are asked for unless SetPixelFormats says otherwise
+static const VmbPixelFormatType DEFAULT_PIXEL_FORMATS[] = { VmbPixelFormatRgb8, VmbPixelFormatMono8 };
+// The camera timestamp ticks per second of cameras without GevTimestampTickFrequency (USB cameras count nanoseconds)
+static const VmbInt64_t DEFAULT_TIMESTAMP_TICK_FREQUENCY = 1000000000;
+
+//
+// The timing state of one stream, only used by its frame callback
+//
+struct StreamTiming
+{
+    explicit StreamTiming( VmbUint64_t nFrequency )
+        : nTickFrequency( nFrequency )
+        , nMinTransportOffsetNS( LLONG_MAX )
+        , nLastCallbackStart( 0 )
+    {
+    }
+
+    //
+    // Converts a camera timestamp to nanoseconds
+    //
+    VmbUint64_t ToNanoseconds( VmbUint64_t nTicks ) const
+    {
+        // Split up so that ticks * 10^9 cannot overflow
+        return nTicks / nTickFrequency * 1000000000ULL + nTicks % nTickFrequency * 1000000000ULL / nTickFrequency;
+    }
+
+    // The camera timestamp ticks per second
+    const VmbUint64_t   nTickFrequency;
+    // The smallest difference between host and camera time of the stream
+    VmbInt64_t          nMinTransportOffsetNS;
+    // When the previous frame callback started, 0 before the first frame
+    VmbUint64_t         nLastCallbackStart;
+};
 
 ApiController::ApiController()
-    // Get a reference to the Vimba singleton
-    : m_system ( VimbaSystem::GetInstance() )
+    // Work on the Vimba singleton
+    : m_pBackend( new VimbaCameraBackend() )
+    , m_nStartCount( 0 )
+    , m_nCallCount( 0 )
+    , m_bIsBackendStarted( false )
+    , m_bIsLazyStartup( false )
+    , m_bHasListedCameras( false )
+    , m_bStopReaper( false )
+    , m_nIdleTimeoutMS( DEFAULT_IDLE_TIMEOUT_MS )
+    , m_pixelFormats( DEFAULT_PIXEL_FORMATS, DEFAULT_PIXEL_FORMATS + sizeof( DEFAULT_PIXEL_FORMATS ) / sizeof( DEFAULT_PIXEL_FORMATS[0] ))
+{
+}
+
+ApiController::ApiController( const ICameraBackendPtr &pBackend )
+    : m_pBackend( pBackend )
+    , m_nStartCount( 0 )
+    , m_nCallCount( 0 )
+    , m_bIsBackendStarted( false )
+    , m_bIsLazyStartup( false )
+    , m_bHasListedCameras( false )
+    , m_bStopReaper( false )
+    , m_nIdleTimeoutMS( DEFAULT_IDLE_TIMEOUT_MS )
+    , m_pixelFormats( DEFAULT_PIXEL_FORMATS, DEFAULT_PIXEL_FORMATS + sizeof( DEFAULT_PIXEL_FORMATS ) / sizeof( DEFAULT_PIXEL_FORMATS[0] ))
 {
 }
 
 ApiController::~ApiController()
 {
+    StopReaper();
+    CloseAllSessions();
+
+    // Release the backend even if not every StartUp got its ShutDown
+    if ( m_bIsBackendStarted )
+    {
+        StopFlightRecorder();
+        m_cameraRegistry.Stop();
+        m_pBackend->Shutdown();
+    }
 }
 
 //
-// Starts the Vimba API and loads all transport layers
+// Takes a reference on the backend and starts it with the first one (for Vimba: the API and the transport layers)
+// With lazy startup the backend is started by the first call that needs it instead
+// Starts closing idle sessions in the background
+// Makes bitmaps recycle their memory through the default buffer pool, like the frames do
 //
 // Returns:
 //  An API status code
 //
 VmbErrorType ApiController::StartUp()
 {
-    return m_system.Startup();
+    // Once for all controllers, before the first frame can be saved
+    static std::once_flag bitmapPoolFlag;
+    std::call_once( bitmapPoolFlag, []() { BufferPool::GetDefault().UseForBitmaps(); } );
+
+    std::lock_guard<std::mutex> lock( m_startMutex );
+    if (    !m_bIsBackendStarted
+         && !m_bIsLazyStartup )
+    {
+        VmbErrorType res = StartBackend();
+        if ( VmbErrorSuccess != res )
+        {
+            return res;
+        }
+    }
+    ++m_nStartCount;
+
+    if ( !m_reaperThread.joinable() )
+    {
+        m_bStopReaper = false;
+        m_reaperThread = std::thread( &ApiController::ReapIdleSessions, this );
+    }
+    return VmbErrorSuccess;
 }
 
 //
-// Shuts down the API
+// Drops a reference on the backend
+// Closes all sessions and shuts down the backend with the last one
+// Calls still running keep the backend until they return, the last of them shuts it down
 //
 void ApiController::ShutDown()
 {
-    // Release Vimba
-    m_system.Shutdown();
+    std::lock_guard<std::mutex> lock( m_startMutex );
+    if ( 0 == m_nStartCount )
+    {
+        return;
+    }
+    --m_nStartCount;
+    if ( 0 == m_nCallCount )
+    {
+        ShutDownBackend();
+    }
 }
 
 //
-// Opens the given camera
-// Sets the maximum possible Ethernet packet size
-// Adjusts the image format
+// Defers starting the backend from StartUp to the first call that needs cameras,
+// so holding a reference costs nothing until then. Applies to the next start.
+//
+// Parameters:
+//  [in]    bIsLazy             True to start on first use
+//
+void ApiController::SetLazyStartup( bool bIsLazy )
+{
+    std::lock_guard<std::mutex> lock( m_startMutex );
+    m_bIsLazyStartup = bIsLazy;
+}
+
+//
+// Gets the steps of the last backend start and of listing and opening the cameras afterwards
+//
+// Returns:
+//  The steps and how long they took, in the order they happened
+//
+StartupPhaseVector ApiController::GetStartupPhases() const
+{
+    std::lock_guard<std::mutex> lock( m_startMutex );
+    return m_startupPhases;
+}
+
+//
+// Takes a reference on the backend for the duration of a call and starts the backend unless it is running already
+//
+// Parameters:
+//  [in]    rController         The controller whose backend the call uses
+//
+ApiController::CallReference::CallReference( ApiController &rController )
+    : m_rController( rController )
+{
+    std::lock_guard<std::mutex> lock( m_rController.m_startMutex );
+    if ( 0 == m_rController.m_nStartCount )
+    {
+        m_eResult = VmbErrorApiNotStarted;
+        return;
+    }
+    m_eResult = m_rController.m_bIsBackendStarted ? VmbErrorSuccess : m_rController.StartBackend();
+    if ( VmbErrorSuccess == m_eResult )
+    {
+        ++m_rController.m_nCallCount;
+    }
+}
+
+//
+// Drops the reference, the last one after the last ShutDown shuts down the backend
+//
+ApiController::CallReference::~CallReference()
+{
+    if ( VmbErrorSuccess != m_eResult )
+    {
+        return;
+    }
+    std::lock_guard<std::mutex> lock( m_rController.m_startMutex );
+    if (    0 == --m_rController.m_nCallCount
+         && 0 == m_rController.m_nStartCount )
+    {
+        m_rController.ShutDownBackend();
+    }
+}
+
+//
+// Gets whether the backend runs for the call
+//
+// Returns:
+//  VmbErrorApiNotStarted if StartUp was not called, else an API status code
+//
+VmbErrorType ApiController::CallReference::GetResult() const
+{
+    return m_eResult;
+}
+
+//
+// Starts the backend, m_startMutex must be held
+//
+// Returns:
+//  An API status code
+//
+VmbErrorType ApiController::StartBackend()
+{
+    m_startupPhases.clear();
+    m_bHasListedCameras = false;
+    m_openedCameraIDs.clear();
+
+    VmbErrorType res = m_pBackend->Startup( m_startupPhases );
+    if ( VmbErrorSuccess == res )
+    {
+        m_cameraRegistry.Start( m_pBackend, CAMERA_REFRESH_INTERVAL_MS );
+        m_bIsBackendStarted = true;
+    }
+    return res;
+}
+
+//
+// Closes all sessions and shuts down the backend, m_startMutex must be held
+//
+void ApiController::ShutDownBackend()
+{
+    // Running acquisitions and open cameras have to be closed before the API goes away
+    StopReaper();
+    CloseAllSessions();
+    StopFlightRecorder();
+
+    // Release the backend
+    if ( m_bIsBackendStarted )
+    {
+        m_cameraRegistry.Stop();
+        m_pBackend->Shutdown();
+        m_bIsBackendStarted = false;
+    }
+}
+
+//
+// Records a startup phase
+//
+// Parameters:
+//  [in]    rStrName            What was done
+//  [in]    tStart              When it started
+//
+void ApiController::AddStartupPhase( const std::string &rStrName, std::chrono::steady_clock::time_point tStart )
+{
+    StartupPhase phase;
+    phase.strName = rStrName;
+    phase.nDurationUS = static_cast<VmbUint32_t>( std::chrono::duration_cast<std::chrono::microseconds>( std::chrono::steady_clock::now() - tStart ).count() );
+
+    std::lock_guard<std::mutex> lock( m_startMutex );
+    m_startupPhases.push_back( phase );
+}
+
+//
+// Opens the given camera unless its session is open already
+// Sets the maximum possible Ethernet packet size (once per session)
+// Adjusts the image format (once per session)
 // Calls the API convenience function to start single image acquisition
 // Closes the camera in case of failure
 //
 // Parameters:
 //  [in]    rStrCameraID        The ID of the camera to work on
 //  [out]   rpFrame             The frame that will be filled. Does not need to be initialized.
+//  [out]   rFrame              The acquired image, for backends without SDK frames
 //
 // Returns:
 //  An API status code
 //
 VmbErrorType ApiController::AcquireSingleImage( const std::string &rStrCameraID, FramePtr &rpFrame )
 {
-    // Open the desired camera by its ID
-    VmbErrorType res = m_system.OpenCameraByID( rStrCameraID.c_str(), VmbAccessModeFull, m_pCamera );
+    ImageFrame image;
+    VmbErrorType res = AcquireSingleImage( rStrCameraID, image );
     if ( VmbErrorSuccess == res )
     {
-        // Set the GeV packet size to the highest possible value
-        // (In this example we do not test whether this cam actually is a GigE cam)
-        FeaturePtr pCommandFeature;
-        if ( VmbErrorSuccess == m_pCamera->GetFeatureByName( "GVSPAdjustPacketSize", pCommandFeature ))
+        // Only the Vimba backend delivers SDK frames
+        if ( SP_ISNULL( image.pFrame ))
+        {
+            return VmbErrorNotSupported;
+        }
+        rpFrame = image.pFrame;
+    }
+    return res;
+}
+
+VmbErrorType ApiController::AcquireSingleImage( const std::string &rStrCameraID, ImageFrame &rFrame )
+{
+    VmbUint32_t nOpenUS = 0;
+    VmbUint32_t nAcquireUS = 0;
+    return AcquireSingleImage( rStrCameraID, rFrame, nOpenUS, nAcquireUS );
+}
+
+//
+// Acquires a single image from several cameras at once
+// Opens and prepares the cameras that have no session yet and acquires from all of them in parallel
+//
+// Parameters:
+//  [in]    rCameraIDs          The IDs of the cameras to work on
+//  [out]   rSnapshots          One entry per camera, in the order of rCameraIDs (of GetCameraList())
+//
+// Returns:
+//  VmbErrorSuccess if every camera delivered an image, else the first error
+//
+VmbErrorType ApiController::AcquireSnapshot( const std::vector<std::string> &rCameraIDs, CameraSnapshotVector &rSnapshots )
+{
+    rSnapshots.clear();
+    rSnapshots.resize( rCameraIDs.size() );
+    if ( rCameraIDs.empty() )
+    {
+        return VmbErrorSuccess;
+    }
+
+    // Opening and acquiring mostly waits for the cameras, so every camera gets its own thread
+    // (the calling thread takes one of them)
+    const VmbUint32_t nThreadCount = ( std::max )( static_cast<VmbUint32_t>( rCameraIDs.size() - 1 ), 1u );
+    WorkerPoolPtr pWorkerPool;
+    {
+        std::lock_guard<std::mutex> lock( m_workerPoolMutex );
+        if (    !m_pWorkerPool
+             || m_pWorkerPool->GetThreadCount() < nThreadCount )
+        {
+            m_pWorkerPool.reset( new WorkerPool( nThreadCount ));
+        }
+        pWorkerPool = m_pWorkerPool;
+    }
+
+    pWorkerPool->ParallelFor(   static_cast<VmbUint32_t>( rCameraIDs.size() ),
+                                [this, &rCameraIDs, &rSnapshots]( VmbUint32_t i )
+                                {
+                                    CameraSnapshot &rSnapshot = rSnapshots[i];
+                                    rSnapshot.strCameraID = rCameraIDs[i];
+                                    rSnapshot.eResult = AcquireSingleImage( rSnapshot.strCameraID, rSnapshot.frame, rSnapshot.nOpenUS, rSnapshot.nAcquireUS );
+                                } );
+
+    for (   CameraSnapshotVector::const_iterator iter = rSnapshots.begin();
+            rSnapshots.end() != iter;
+            ++iter )
+    {
+        if ( VmbErrorSuccess != iter->eResult )
+        {
+            return iter->eResult;
+        }
+    }
+    return VmbErrorSuccess;
+}
+
+VmbErrorType ApiController::AcquireSnapshot( CameraSnapshotVector &rSnapshots )
+{
+    std::vector<std::string> cameraIDs;
+    const CameraInfoSnapshot pCameras = GetCameraSnapshot();
+    if ( pCameras )
+    {
+        cameraIDs.reserve( pCameras->size() );
+        for (   CameraInfoVector::const_iterator iter = pCameras->begin();
+                pCameras->end() != iter;
+                ++iter )
+        {
+            cameraIDs.push_back( iter->strID );
+        }
+    }
+    return AcquireSnapshot( cameraIDs, rSnapshots );
+}
+
+//
+// Acquires a single image and reports how long the two steps took
+//
+// Parameters:
+//  [in]    rStrCameraID        The ID of the camera to work on
+//  [out]   rFrame              The acquired image
+//  [out]   rnOpenUS            How long getting the open and prepared camera took in microseconds
+//  [out]   rnAcquireUS         How long the acquisition took in microseconds
+//
+// Returns:
+//  An API status code
+//
+VmbErrorType ApiController::AcquireSingleImage( const std::string &rStrCameraID, ImageFrame &rFrame, VmbUint32_t &rnOpenUS, VmbUint32_t &rnAcquireUS )
+{
+    typedef std::chrono::steady_clock Clock;
+    const Clock::time_point tStart = Clock::now();
+
+    const CallReference reference( *this );
+    CameraSessionPtr pSession;
+    std::unique_lock<std::mutex> lock;
+    VmbErrorType res = LockSession( reference, rStrCameraID, pSession, lock );
+    const Clock::time_point tOpened = Clock::now();
+    rnOpenUS = static_cast<VmbUint32_t>( std::chrono::duration_cast<std::chrono::microseconds>( tOpened - tStart ).count() );
+    rnAcquireUS = 0;
+    if ( VmbErrorSuccess != res )
+    {
+        return res;
+    }
+    // A streaming camera does not take single image requests
+    if ( pSession->IsStreaming() )
+    {
+        return VmbErrorInvalidCall;
+    }
+
+    // Acquire
+    res = pSession->GetCamera()->AcquireSingleImage( rFrame, 5000 );
+    pSession->Touch();
+    lock.unlock();
+    rnAcquireUS = static_cast<VmbUint32_t>( std::chrono::duration_cast<std::chrono::microseconds>( Clock::now() - tOpened ).count() );
+
+    // A timeout leaves the camera usable, anything else might not
+    if (    VmbErrorSuccess != res
+         && VmbErrorTimeout != res )
+    {
+        CloseSession( rStrCameraID );
+    }
+
+    return res;
+}
+
+//
+// Opens the given camera unless its session is open already
+// Sets the maximum possible Ethernet packet size (once per session)
+// Adjusts the image format (once per session)
+// Announces and queues a ring of frames and starts the acquisition
+// Every completed frame is handed to the given callback and requeued afterwards
+//
+// Parameters:
+//  [in]    rStrCameraID        The ID of the camera to work on
+//  [in]    rCallback           The function that gets every completed frame (called from the API's thread)
+//  [in]    nFrameCount         The number of frames in the ring
+//
+// Returns:
+//  An API status code
+//
+VmbErrorType ApiController::StartContinuousAcquisition( const std::string &rStrCameraID, const FrameCallback &rCallback )
+{
+    return StartContinuousAcquisition( rStrCameraID, rCallback, NUM_FRAMES );
+}
+
+VmbErrorType ApiController::StartContinuousAcquisition( const std::string &rStrCameraID, const FrameCallback &rCallback, VmbUint32_t nFrameCount )
+{
+    {
+        std::lock_guard<std::mutex> lock( m_sessionsMutex );
+        if ( m_pStreamingSession )
+        {
+            return VmbErrorInvalidCall;
+        }
+    }
+    if ( 0 == nFrameCount )
+    {
+        return VmbErrorBadParameter;
+    }
+
+    const CallReference reference( *this );
+    CameraSessionPtr pSession;
+    std::unique_lock<std::mutex> lock;
+    VmbErrorType res = LockSession( reference, rStrCameraID, pSession, lock );
+    if ( VmbErrorSuccess != res )
+    {
+        return res;
+    }
+
+    // The camera timestamps count ticks of the camera clock
+    VmbInt64_t nTickFrequency = 0;
+    if (    VmbErrorSuccess != pSession->GetCamera()->GetFeatureValue( "GevTimestampTickFrequency", nTickFrequency )
+         || nTickFrequency <= 0 )
+    {
+        nTickFrequency = DEFAULT_TIMESTAMP_TICK_FREQUENCY;
+    }
+
+    // Feeds the flight recorder if one runs, it may be started and stopped while streaming
+    // Measures how the frame got here and how long the callback takes, and counts it for the camera
+    const CameraMetricsPtr pMetrics( new CameraMetrics( rStrCameraID ));
+    const std::shared_ptr<StreamTiming> pTiming( new StreamTiming( static_cast<VmbUint64_t>( nTickFrequency )));
+    const FrameCallback callback = [this, rCallback, pMetrics, pTiming]( const ImageFrame &rFrame )
+    {
+        LatencyMonitor &rMonitor = LatencyMonitor::GetDefault();
+        const VmbUint64_t nCallbackStart = GetLatencyClock();
+        pMetrics->RecordFrame( rFrame );
+        if ( 0 != pTiming->nLastCallbackStart )
+        {
+            rMonitor.Record( LatencyStageInterval, nCallbackStart - pTiming->nLastCallbackStart );
+        }
+        pTiming->nLastCallbackStart = nCallbackStart;
+        if ( 0 != rFrame.nReceiveTime )
         {
-            if ( VmbErrorSuccess == pCommandFeature->RunCommand() )
+            // Camera and host clocks start at different times, so the transport time is
+            // measured against the fastest frame of the stream
+            const VmbInt64_t nOffsetNS = static_cast<VmbInt64_t>( rFrame.nReceiveTime - pTiming->ToNanoseconds( rFrame.nTimestamp ));
+            if ( nOffsetNS < pTiming->nMinTransportOffsetNS )
             {
-                bool bIsCommandDone = false;
-                do
-                {
-                    if ( VmbErrorSuccess != pCommandFeature->IsCommandDone( bIsCommandDone ))
-                    {
-                        break;
-                    }
-                } while ( false == bIsCommandDone );
+                pTiming->nMinTransportOffsetNS = nOffsetNS;
             }
+            rMonitor.Record( LatencyStageTransport, static_cast<VmbUint64_t>( nOffsetNS - pTiming->nMinTransportOffsetNS ));
+            rMonitor.Record( LatencyStageDelivery, nCallbackStart - rFrame.nReceiveTime );
         }
-        FeaturePtr pFormatFeature;
-        // Set pixel format. For the sake of simplicity we only support Mono and BGR in this example.
-        res = m_pCamera->GetFeatureByName( "PixelFormat", pFormatFeature );
-        if ( VmbErrorSuccess == res )
+
+        const FlightRecorderPtr pFlightRecorder = std::atomic_load( &m_pFlightRecorder );
+        if ( pFlightRecorder )
         {
-            // Try to set BGR
-            res = pFormatFeature->SetValue( VmbPixelFormatRgb8 );
-            if ( VmbErrorSuccess != res )
+            TraceScope trace( "FlightRecorder", rFrame.nFrameID );
+            pFlightRecorder->Push( rFrame );
+        }
+        if ( rCallback )
+        {
+            rCallback( rFrame );
+        }
+        const VmbUint64_t nCallbackEnd = GetLatencyClock();
+        rMonitor.Record( LatencyStageCallback, nCallbackEnd - nCallbackStart );
+
+        FrameTracer &rTracer = FrameTracer::GetDefault();
+        if ( rTracer.IsEnabled() )
+        {
+            if ( 0 != rFrame.nReceiveTime )
             {
-                // Fall back to Mono
-                res = pFormatFeature->SetValue( VmbPixelFormatMono8 );
+                rTracer.AddSpan( "Delivery", rFrame.nFrameID, rFrame.nReceiveTime, nCallbackStart );
             }
-
-            if ( VmbErrorSuccess == res )
+            rTracer.AddSpan( "Callback", rFrame.nFrameID, nCallbackStart, nCallbackEnd );
+        }
+    };
+    res = pSession->GetCamera()->StartStreaming( callback, nFrameCount );
+    pSession->Touch();
+    if ( VmbErrorSuccess == res )
+    {
+        bool bIsOtherStreaming;
+        {
+            std::lock_guard<std::mutex> sessionsLock( m_sessionsMutex );
+            bIsOtherStreaming = static_cast<bool>( m_pStreamingSession );
+            if ( !bIsOtherStreaming )
             {
-                // Acquire
-                res = m_pCamera->AcquireSingleImage( rpFrame, 5000 );
+                pSession->SetStreaming( true );
+                m_pStreamingSession = pSession;
             }
         }
+        if ( bIsOtherStreaming )
+        {
+            // Another camera started streaming meanwhile
+            pSession->GetCamera()->StopStreaming();
+            res = VmbErrorInvalidCall;
+        }
+    }
+
+    return res;
+}
 
-        m_pCamera->Close();
+//
+// Stops the acquisition and revokes all frames
+// The camera stays open in its session
+//
+// Returns:
+//  An API status code
+//
+VmbErrorType ApiController::StopContinuousAcquisition()
+{
+    CameraSessionPtr pSession;
+    {
+        std::lock_guard<std::mutex> lock( m_sessionsMutex );
+        pSession.swap( m_pStreamingSession );
+    }
+    if ( !pSession )
+    {
+        return VmbErrorInvalidCall;
+    }
+
+    std::lock_guard<std::mutex> lock( pSession->GetMutex() );
+    if ( !pSession->GetCamera() )
+    {
+        // The session was closed meanwhile, which stopped the acquisition as well
+        return VmbErrorSuccess;
     }
+    VmbErrorType res = pSession->GetCamera()->StopStreaming();
+    pSession->SetStreaming( false );
+    pSession->Touch();
 
     return res;
 }
 
 //
-// Gets all cameras known to Vimba
+// Keeps the latest frames of continuous acquisitions in a ring of preallocated memory,
+// so the frames around an event can be written with TriggerFlightRecorder
+//
+// Parameters:
+//  [in]    rConfig             The size of the ring and of the window around an event
+//
+// Returns:
+//  An API status code
+//
+VmbErrorType ApiController::StartFlightRecorder( const FlightRecorderConfig &rConfig )
+{
+    if ( std::atomic_load( &m_pFlightRecorder ))
+    {
+        return VmbErrorInvalidCall;
+    }
+    FlightRecorderPtr pFlightRecorder( new FlightRecorder() );
+    VmbErrorType res = pFlightRecorder->Allocate( rConfig );
+    if ( VmbErrorSuccess == res )
+    {
+        std::atomic_store( &m_pFlightRecorder, pFlightRecorder );
+    }
+    return res;
+}
+
+//
+// Writes the frames before and after this moment to a recording file in the background
+//
+// Parameters:
+//  [in]    rFileName           The path of the recording to write
+//  [in]    rCallback           Gets called once the recording was written (may be empty)
+//
+// Returns:
+//  An API status code
+//
+VmbErrorType ApiController::TriggerFlightRecorder( const std::string &rFileName, const FlightRecorder::EventCallback &rCallback )
+{
+    const FlightRecorderPtr pFlightRecorder = std::atomic_load( &m_pFlightRecorder );
+    if ( !pFlightRecorder )
+    {
+        return VmbErrorInvalidCall;
+    }
+    return pFlightRecorder->Trigger( rFileName, rCallback );
+}
+
+//
+// Writes the pending events and frees the ring
 //
 // Returns:
-//  A vector of camera shared pointers
+//  An API status code
 //
-CameraPtrVector ApiController::GetCameraList()
+VmbErrorType ApiController::StopFlightRecorder()
 {
-    CameraPtrVector cameras;
+    const FlightRecorderPtr pFlightRecorder = std::atomic_exchange( &m_pFlightRecorder, FlightRecorderPtr() );
+    if ( !pFlightRecorder )
+    {
+        return VmbErrorInvalidCall;
+    }
+    // A frame callback may still hold the recorder, it frees the ring once that returns
+    pFlightRecorder->Flush();
+    return VmbErrorSuccess;
+}
+
+//
+// Gets the counters of the flight recorder
+//
+// Parameters:
+//  [out]   rStatistics         The counters
+//
+// Returns:
+//  False if the flight recorder is not running
+//
+bool ApiController::GetFlightRecorderStatistics( FlightRecorderStatistics &rStatistics ) const
+{
+    const FlightRecorderPtr pFlightRecorder = std::atomic_load( &m_pFlightRecorder );
+    if ( !pFlightRecorder )
+    {
+        return false;
+    }
+    rStatistics = pFlightRecorder->GetStatistics();
+    return true;
+}
+
+//
+// Switches the recording of per-frame spans of the pipeline on or off, while acquiring or not
+//
+// Parameters:
+//  [in]    bIsEnabled          True to record, enabling again drops the spans of the last run
+//
+void ApiController::SetTracing( bool bIsEnabled )
+{
+    if ( bIsEnabled )
+    {
+        FrameTracer::GetDefault().Enable();
+    }
+    else
+    {
+        FrameTracer::GetDefault().Disable();
+    }
+}
+
+//
+// Writes the spans recorded since tracing was enabled as a Chrome trace (open it in Perfetto)
+//
+// Parameters:
+//  [in]    rFileName           The path of the JSON file to write
+//
+// Returns:
+//  An API status code
+//
+VmbErrorType ApiController::WriteTrace( const std::string &rFileName ) const
+{
+    return FrameTracer::GetDefault().WriteChromeTrace( rFileName );
+}
+
+//
+// Writes a feature of the given camera, opening its session if needed
+// Values the session wrote before are not written again
+//
+// Parameters:
+//  [in]    rStrCameraID        The ID of the camera to work on
+//  [in]    pName               The name of the feature
+//  [in]    nValue / dValue     The value to write
+//
+// Returns:
+//  An API status code
+//
+VmbErrorType ApiController::SetFeatureValue( const std::string &rStrCameraID, const char *pName, VmbInt64_t nValue )
+{
+    const CallReference reference( *this );
+    CameraSessionPtr pSession;
+    std::unique_lock<std::mutex> lock;
+    VmbErrorType res = LockSession( reference, rStrCameraID, pSession, lock );
+    if ( VmbErrorSuccess == res )
+    {
+        res = pSession->SetFeatureValue( pName, nValue );
+        pSession->Touch();
+    }
+    return res;
+}
+
+VmbErrorType ApiController::SetFeatureValue( const std::string &rStrCameraID, const char *pName, double dValue )
+{
+    const CallReference reference( *this );
+    CameraSessionPtr pSession;
+    std::unique_lock<std::mutex> lock;
+    VmbErrorType res = LockSession( reference, rStrCameraID, pSession, lock );
+    if ( VmbErrorSuccess == res )
+    {
+        res = pSession->SetFeatureValue( pName, dValue );
+        pSession->Touch();
+    }
+    return res;
+}
+
+//
+// Writes one of the features resolved when the camera was opened, skipping the lookup by name
+// Values the session wrote before are not written again
+//
+// Parameters:
+//  [in]    rStrCameraID        The ID of the camera to work on
+//  [in]    eFeature            The feature
+//  [in]    nValue / dValue     The value to write
+//
+// Returns:
+//  An API status code
+//
+VmbErrorType ApiController::SetFeatureValue( const std::string &rStrCameraID, CameraFeature eFeature, VmbInt64_t nValue )
+{
+    const CallReference reference( *this );
+    CameraSessionPtr pSession;
+    std::unique_lock<std::mutex> lock;
+    VmbErrorType res = LockSession( reference, rStrCameraID, pSession, lock );
+    if ( VmbErrorSuccess == res )
+    {
+        res = pSession->SetFeatureValue( eFeature, nValue );
+        pSession->Touch();
+    }
+    return res;
+}
+
+VmbErrorType ApiController::SetFeatureValue( const std::string &rStrCameraID, CameraFeature eFeature, double dValue )
+{
+    const CallReference reference( *this );
+    CameraSessionPtr pSession;
+    std::unique_lock<std::mutex> lock;
+    VmbErrorType res = LockSession( reference, rStrCameraID, pSession, lock );
+    if ( VmbErrorSuccess == res )
+    {
+        res = pSession->SetFeatureValue( eFeature, dValue );
+        pSession->Touch();
+    }
+    return res;
+}
+
+//
+// Sets after how long an unused session gets closed
+//
+// Parameters:
+//  [in]    nTimeoutMS          The idle time in milliseconds, 0 keeps sessions open until ShutDown
+//
+void ApiController::SetSessionIdleTimeout( VmbUint32_t nTimeoutMS )
+{
+    std::lock_guard<std::mutex> lock( m_sessionsMutex );
+    m_nIdleTimeoutMS = nTimeoutMS;
+    m_reaperCondition.notify_all();
+}
+
+//
+// Sets the pixel formats asked for when a camera gets opened, the first one the camera
+// accepts is used. Applies to sessions opened afterwards.
+//
+// Parameters:
+//  [in]    rPixelFormats       The pixel formats in the order of preference
+//
+void ApiController::SetPixelFormats( const std::vector<VmbPixelFormatType> &rPixelFormats )
+{
+    std::lock_guard<std::mutex> lock( m_pixelFormatsMutex );
+    m_pixelFormats = rPixelFormats;
+}
+
+//
+// Closes the session of the given camera
+//
+// Parameters:
+//  [in]    rStrCameraID        The ID of the camera to close
+//
+// Returns:
+//  An API status code
+//
+VmbErrorType ApiController::CloseSession( const std::string &rStrCameraID )
+{
+    CameraSessionPtr pSession;
+    {
+        std::lock_guard<std::mutex> lock( m_sessionsMutex );
+        std::map<std::string, CameraSessionPtr>::iterator iter = m_sessions.find( rStrCameraID );
+        if ( m_sessions.end() == iter )
+        {
+            return VmbErrorNotFound;
+        }
+        pSession = iter->second;
+        m_sessions.erase( iter );
+        if ( m_pStreamingSession == pSession )
+        {
+            m_pStreamingSession.reset();
+        }
+    }
+
+    // Closing also stops a running acquisition
+    std::lock_guard<std::mutex> lock( pSession->GetMutex() );
+    return pSession->Close();
+}
+
+//
+// Closes all open sessions
+// Idle sessions keep getting reaped afterwards
+//
+void ApiController::CloseAllSessions()
+{
+    StopContinuousAcquisition();
+
+    // The reaper only closes sessions it took out of the map, so it cannot close one of these twice
+    std::map<std::string, CameraSessionPtr> sessions;
+    {
+        std::lock_guard<std::mutex> lock( m_sessionsMutex );
+        sessions.swap( m_sessions );
+    }
+    for (   std::map<std::string, CameraSessionPtr>::iterator iter = sessions.begin();
+            sessions.end() != iter;
+            ++iter )
+    {
+        std::lock_guard<std::mutex> lock( iter->second->GetMutex() );
+        iter->second->Close();
+    }
+}
+
+//
+// Gets the session of the given camera and locks it
+// Opens and prepares the camera if there is no session yet
+//
+// Parameters:
+//  [in]    rReference          The reference the calling function holds on the backend
+//  [in]    rStrCameraID        The ID of the camera to work on
+//  [out]   rpSession           The open session
+//  [out]   rLock               Holds the lock of the session
+//
+// Returns:
+//  An API status code
+//
+VmbErrorType ApiController::LockSession( const CallReference &rReference, const std::string &rStrCameraID, CameraSessionPtr &rpSession, std::unique_lock<std::mutex> &rLock )
+{
+    VmbErrorType res = rReference.GetResult();
+    if ( VmbErrorSuccess != res )
+    {
+        return res;
+    }
+
+    for ( ;; )
+    {
+        CameraSessionPtr pSession;
+        {
+            std::lock_guard<std::mutex> lock( m_sessionsMutex );
+            std::map<std::string, CameraSessionPtr>::const_iterator iter = m_sessions.find( rStrCameraID );
+            if ( m_sessions.end() != iter )
+            {
+                pSession = iter->second;
+            }
+        }
+
+        if ( !pSession )
+        {
+            // The first open of a camera after the start is part of the cold start
+            bool bIsFirstOpen;
+            {
+                std::lock_guard<std::mutex> lock( m_startMutex );
+                bIsFirstOpen = 0 == m_openedCameraIDs.count( rStrCameraID );
+            }
+
+            // Open the desired camera by its ID (outside the map lock, this may take a while)
+            std::chrono::steady_clock::time_point tStart = std::chrono::steady_clock::now();
+            ICameraPtr pCamera;
+            res = m_pBackend->OpenCamera( rStrCameraID, pCamera );
+            if ( VmbErrorSuccess != res )
+            {
+                return res;
+            }
+            if ( bIsFirstOpen )
+            {
+                AddStartupPhase( "Open " + rStrCameraID, tStart );
+            }
+
+            tStart = std::chrono::steady_clock::now();
+            pSession.reset( new CameraSession( pCamera ));
+            res = PrepareCamera( rStrCameraID, *pSession );
+            if ( VmbErrorSuccess != res )
+            {
+                pSession->Close();
+                return res;
+            }
+            if ( bIsFirstOpen )
+            {
+                AddStartupPhase( "Prepare " + rStrCameraID, tStart );
+                std::lock_guard<std::mutex> lock( m_startMutex );
+                m_openedCameraIDs.insert( rStrCameraID );
+            }
+
+            std::lock_guard<std::mutex> lock( m_sessionsMutex );
+            std::pair<std::map<std::string, CameraSessionPtr>::iterator, bool> inserted = m_sessions.insert( std::make_pair( rStrCameraID, pSession ));
+            if ( !inserted.second )
+            {
+                // Somebody else opened the camera meanwhile, use theirs
+                pSession->Close();
+                continue;
+            }
+        }
+
+        std::unique_lock<std::mutex> lock( pSession->GetMutex() );
+        if ( pSession->GetCamera() )
+        {
+            rpSession = pSession;
+            rLock = std::move( lock );
+            return VmbErrorSuccess;
+        }
+        // The session was closed before we got hold of it, try again
+    }
+}
+
+//
+// Sets the maximum possible Ethernet packet size
+// Adjusts the image format
+//
+// Parameters:
+//  [in]    rStrCameraID        The ID of the camera
+//  [in]    rSession            The session of the opened camera to work on
+//
+// Returns:
+//  An API status code
+//
+VmbErrorType ApiController::PrepareCamera( const std::string &rStrCameraID, CameraSession &rSession )
+{
+    // Set the GeV packet size to the highest possible value
+    // (In this example we do not test whether this cam actually is a GigE cam, so failing here is fine)
+    AdjustPacketSize( rStrCameraID, rSession );
+
+    // Set the first pixel format of our list the camera accepts
+    std::vector<VmbPixelFormatType> pixelFormats;
+    {
+        std::lock_guard<std::mutex> lock( m_pixelFormatsMutex );
+        pixelFormats = m_pixelFormats;
+    }
+    VmbErrorType res = VmbErrorBadParameter;
+    for (   std::vector<VmbPixelFormatType>::const_iterator iter = pixelFormats.begin();
+            pixelFormats.end() != iter && VmbErrorSuccess != res;
+            ++iter )
+    {
+        res = rSession.SetFeatureValue( FeaturePixelFormat, static_cast<VmbInt64_t>( *iter ));
+    }
+
+    return res;
+}
+
+//
+// Applies the packet size cached for the camera or negotiates the highest possible one
+// Waits for the negotiation with backoff, but not longer than PACKET_SIZE_TIMEOUT_MS
+//
+// Parameters:
+//  [in]    rStrCameraID        The ID of the camera
+//  [in]    rSession            The session of the opened camera to work on
+//
+// Returns:
+//  An API status code
+//
+VmbErrorType ApiController::AdjustPacketSize( const std::string &rStrCameraID, CameraSession &rSession )
+{
+    typedef std::chrono::steady_clock Clock;
+    const Clock::time_point tStart = Clock::now();
+
+    PacketSizeNegotiation negotiation;
+    bool bIsCached = false;
+    {
+        std::lock_guard<std::mutex> lock( m_packetSizesMutex );
+        std::map<std::string, PacketSizeNegotiation>::const_iterator iter = m_packetSizes.find( rStrCameraID );
+        if ( m_packetSizes.end() != iter )
+        {
+            negotiation = iter->second;
+            bIsCached = true;
+        }
+    }
+
+    // Applying the known value is much faster than letting the camera find it again
+    VmbErrorType res = VmbErrorNotFound;
+    if ( bIsCached )
+    {
+        res = rSession.SetFeatureValue( FeatureGVSPPacketSize, negotiation.nPacketSize );
+    }
+
+    if ( VmbErrorSuccess != res )
+    {
+        bIsCached = false;
+        const ICameraPtr &pCamera = rSession.GetCamera();
+        res = pCamera->RunFeatureCommand( FeatureGVSPAdjustPacketSize );
+        if ( VmbErrorSuccess != res )
+        {
+            return res;
+        }
+
+        // Poll for the end of the command, backing off so we do not burn a core
+        const Clock::time_point tDeadline = tStart + std::chrono::milliseconds( PACKET_SIZE_TIMEOUT_MS );
+        std::chrono::milliseconds backoff( 1 );
+        bool bIsCommandDone = false;
+        for ( ;; )
+        {
+            res = pCamera->IsFeatureCommandDone( FeatureGVSPAdjustPacketSize, bIsCommandDone );
+            if (    VmbErrorSuccess != res
+                 || bIsCommandDone )
+            {
+                break;
+            }
+            if ( Clock::now() >= tDeadline )
+            {
+                res = VmbErrorTimeout;
+                break;
+            }
+            std::this_thread::sleep_for( backoff );
+            backoff = ( std::min )( backoff * 2, std::chrono::milliseconds( MAX_PACKET_SIZE_BACKOFF_MS ));
+        }
+        if ( VmbErrorSuccess == res )
+        {
+            res = pCamera->GetFeatureValue( FeatureGVSPPacketSize, negotiation.nPacketSize );
+        }
+        if ( VmbErrorSuccess != res )
+        {
+            return res;
+        }
+    }
+
+    negotiation.bIsCached = bIsCached;
+    negotiation.nDurationUS = static_cast<VmbUint32_t>( std::chrono::duration_cast<std::chrono::microseconds>( Clock::now() - tStart ).count() );
+    std::lock_guard<std::mutex> lock( m_packetSizesMutex );
+    m_packetSizes[rStrCameraID] = negotiation;
+
+    return VmbErrorSuccess;
+}
+
+//
+// Gets the packet size negotiated for the given camera and how long that took
+//
+// Parameters:
+//  [in]    rStrCameraID        The ID of the camera
+//  [out]   rNegotiation        The negotiated packet size
+//
+// Returns:
+//  False if no packet size was negotiated for the camera (yet)
+//
+bool ApiController::GetPacketSizeNegotiation( const std::string &rStrCameraID, PacketSizeNegotiation &rNegotiation ) const
+{
+    std::lock_guard<std::mutex> lock( m_packetSizesMutex );
+    std::map<std::string, PacketSizeNegotiation>::const_iterator iter = m_packetSizes.find( rStrCameraID );
+    if ( m_packetSizes.end() == iter )
+    {
+        return false;
+    }
+    rNegotiation = iter->second;
+    return true;
+}
+
+//
+// Forgets the packet size of the given camera so the next open negotiates it again
+//
+// Parameters:
+//  [in]    rStrCameraID        The ID of the camera
+//
+void ApiController::ForgetPacketSize( const std::string &rStrCameraID )
+{
+    std::lock_guard<std::mutex> lock( m_packetSizesMutex );
+    m_packetSizes.erase( rStrCameraID );
+}
+
+//
+// Stops closing idle sessions in the background, StartUp starts it again
+//
+void ApiController::StopReaper()
+{
+    {
+        std::lock_guard<std::mutex> lock( m_sessionsMutex );
+        m_bStopReaper = true;
+        m_reaperCondition.notify_all();
+    }
+    if ( m_reaperThread.joinable() )
+    {
+        m_reaperThread.join();
+    }
+}
+
+//
+// Closes sessions that have not been used for longer than the idle timeout (runs on m_reaperThread)
+//
+void ApiController::ReapIdleSessions()
+{
+    std::unique_lock<std::mutex> lock( m_sessionsMutex );
+    while ( !m_bStopReaper )
+    {
+        // Look often enough to close a session close to its timeout
+        VmbUint32_t nIntervalMS = MAX_REAP_INTERVAL_MS;
+        if (    0 != m_nIdleTimeoutMS
+             && m_nIdleTimeoutMS / 4 < nIntervalMS )
+        {
+            nIntervalMS = ( std::max )( m_nIdleTimeoutMS / 4, 1u );
+        }
+        m_reaperCondition.wait_for( lock, std::chrono::milliseconds( nIntervalMS ));
+        if (    m_bStopReaper
+             || 0 == m_nIdleTimeoutMS )
+        {
+            continue;
+        }
+
+        // Take the idle sessions out of the map, locked so nobody uses them meanwhile
+        const CameraSession::Clock::time_point tNow = CameraSession::Clock::now();
+        const std::chrono::milliseconds idleTimeout( m_nIdleTimeoutMS );
+        std::vector<CameraSessionPtr> idleSessions;
+        std::vector<std::unique_lock<std::mutex> > idleLocks;
+        std::map<std::string, CameraSessionPtr>::iterator iter = m_sessions.begin();
+        while ( m_sessions.end() != iter )
+        {
+            // Busy sessions are in use right now and thus not idle
+            std::unique_lock<std::mutex> sessionLock( iter->second->GetMutex(), std::try_to_lock );
+            if (    sessionLock.owns_lock()
+                 && !iter->second->IsStreaming()
+                 && tNow - iter->second->GetLastUse() >= idleTimeout )
+            {
+                idleSessions.push_back( iter->second );
+                idleLocks.push_back( std::move( sessionLock ));
+                iter = m_sessions.erase( iter );
+            }
+            else
+            {
+                ++iter;
+            }
+        }
+        if ( idleSessions.empty() )
+        {
+            continue;
+        }
+
+        // Closing takes seconds on GigE, the other sessions must not wait for that
+        lock.unlock();
+        for ( size_t i = 0; i < idleSessions.size(); ++i )
+        {
+            idleSessions[i]->Close();
+            idleLocks[i].unlock();
+        }
+        lock.lock();
+    }
+}
+
+//
+// Gets all cameras known to the backend
+// Only the first call after the start lists them, later calls are served from memory
+// that hot-plug events keep up to date
+//
+// Returns:
+//  A vector of camera descriptions
+//
+CameraInfoVector ApiController::GetCameraList()
+{
+    const CameraInfoSnapshot pCameras = GetCameraSnapshot();
+    if ( pCameras )
+    {
+        return *pCameras;
+    }
+    return CameraInfoVector();
+}
+
+//
+// Gets the same list without copying it. The list never changes, a change of the cameras publishes a new one.
+// Meant for threads that look at the cameras often.
+//
+// Returns:
+//  The cameras, NULL if the backend is not started or could not list them
+//
+CameraInfoSnapshot ApiController::GetCameraSnapshot()
+{
+    const CallReference reference( *this );
+    if ( VmbErrorSuccess != reference.GetResult() )
+    {
+        return CameraInfoSnapshot();
+    }
+
     // Get all known cameras
-    if ( VmbErrorSuccess == m_system.GetCameras( cameras ))
+    const std::chrono::steady_clock::time_point tStart = std::chrono::steady_clock::now();
+    const CameraInfoSnapshot pCameras = m_cameraRegistry.GetSnapshot();
+    if (    pCameras
+         && !m_bHasListedCameras
+         && !m_bHasListedCameras.exchange( true ))
     {
-        // And return them
-        return cameras;
+        // The transport layers discover the cameras behind their interfaces here
+        AddStartupPhase( "List cameras", tStart );
     }
-    return CameraPtrVector();
+    return pCameras;
 }
 
 //
@@ -165,21 +1285,18 @@ CameraPtrVector ApiController::GetCameraList()
 //
 std::string ApiController::ErrorCodeToMessage( VmbErrorType eErr ) const
 {
-    //return AVT::VmbAPI::Examples::ErrorCodeToMessage( eErr );
-	return "code";
+    return AVT::VmbAPI::Examples::ErrorCodeToMessage( eErr );
 }
 
 //
-// Gets the version of the Vimba API
+// Gets the version of the backend (for Vimba: the Vimba API)
 //
 // Returns:
 //  The version as string
 //
 std::string ApiController::GetVersion() const
 {
-    std::ostringstream os;
-    os<<m_system;
-    return os.str();
+    return m_pBackend->GetVersion();
 }
 
 }}} // namespace AVT::VmbAPI::Examples
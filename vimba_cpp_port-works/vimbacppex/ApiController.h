@@ -30,22 +30,88 @@
 #ifndef AVT_VMBAPI_EXAMPLES_APICONTROLLER
 #define AVT_VMBAPI_EXAMPLES_APICONTROLLER
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <set>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include "VimbaCPP/Include/VimbaCPP.h"
 
+#include "CameraBackend.h"
+#include "CameraRegistry.h"
+#include "CameraSession.h"
+#include "FlightRecorder.h"
+#include "ImageFrame.h"
+#include "WorkerPool.h"
+
 namespace AVT {
 namespace VmbAPI {
 namespace Examples {
 
+//
+// The outcome of the packet size negotiation of a camera
+//
+struct PacketSizeNegotiation
+{
+    VmbInt64_t      nPacketSize;            // The negotiated GVSPPacketSize
+    VmbUint32_t     nDurationUS;            // How long the last negotiation (or applying the cached value) took in microseconds
+    bool            bIsCached;              // True if the cached value was applied instead of negotiating again
+
+    PacketSizeNegotiation()
+        : nPacketSize( 0 )
+        , nDurationUS( 0 )
+        , bIsCached( false )
+    {
+    }
+};
+
+//
+// The image of one camera taken by a multi-camera snapshot
+//
+struct CameraSnapshot
+{
+    std::string     strCameraID;            // The ID of the camera
+    VmbErrorType    eResult;                // The outcome of the acquisition
+    ImageFrame      frame;                  // The acquired image, valid if eResult is VmbErrorSuccess
+    VmbUint32_t     nOpenUS;                // How long getting the open and prepared camera took in microseconds
+    VmbUint32_t     nAcquireUS;             // How long the acquisition itself took in microseconds
+
+    CameraSnapshot()
+        : eResult( VmbErrorOther )
+        , nOpenUS( 0 )
+        , nAcquireUS( 0 )
+    {
+    }
+};
+typedef std::vector<CameraSnapshot> CameraSnapshotVector;
+
 class ApiController
 {
   public:
+    //
+    // Works on real cameras through VimbaCPP
+    //
     ApiController();
+
+    //
+    // Works on the cameras of the given backend
+    //
+    // Parameters:
+    //  [in]    pBackend            The backend to list, open and acquire from
+    //
+    explicit ApiController( const ICameraBackendPtr &pBackend );
+
     ~ApiController();
 
     //
-    // Starts the Vimba API and loads all transport layers
+    // Takes a reference on the backend and starts it with the first one (for Vimba: the API and the transport layers)
+    // With lazy startup the backend is started by the first call that needs it instead
+    // Makes bitmaps recycle their memory through the default buffer pool, like the frames do
     //
     // Returns:
     //  An API status code
@@ -53,33 +119,254 @@ class ApiController
     VmbErrorType    StartUp();
     
     //
-    // Shuts down the API
+    // Drops a reference on the backend and shuts it down with the last one
+    // Calls still running keep the backend until they return, the last of them shuts it down
     //
     void            ShutDown();
 
     //
-    // Opens the given camera
-    // Sets the maximum possible Ethernet packet size
-    // Adjusts the image format
+    // Defers starting the backend from StartUp to the first call that needs cameras,
+    // so holding a reference costs nothing until then. Applies to the next start.
+    //
+    // Parameters:
+    //  [in]    bIsLazy             True to start on first use
+    //
+    void            SetLazyStartup( bool bIsLazy );
+
+    //
+    // Gets the steps of the last backend start and of listing and opening the cameras afterwards
+    //
+    // Returns:
+    //  The steps and how long they took, in the order they happened
+    //
+    StartupPhaseVector GetStartupPhases() const;
+
+    //
+    // Opens the given camera unless its session is open already
+    // Sets the maximum possible Ethernet packet size (once per session)
+    // Adjusts the image format (once per session)
     // Calls the API convenience function to start single image acquisition
     // Closes the camera in case of failure
     //
     // Parameters:
     //  [in]    rStrCameraID        The ID of the camera to work on
     //  [out]   rpFrame             The frame that will be filled. Does not need to be initialized.
+    //  [out]   rFrame              The acquired image, for backends without SDK frames
     //
     // Returns:
     //  An API status code
     //
     VmbErrorType    AcquireSingleImage( const std::string &rStrCameraID, FramePtr &rpFrame );
+    VmbErrorType    AcquireSingleImage( const std::string &rStrCameraID, ImageFrame &rFrame );
+
+    //
+    // Acquires a single image from several cameras at once
+    // Opens and prepares the cameras that have no session yet and acquires from all of them in parallel
+    //
+    // Parameters:
+    //  [in]    rCameraIDs          The IDs of the cameras to work on
+    //  [out]   rSnapshots          One entry per camera, in the order of rCameraIDs (of GetCameraList())
+    //
+    // Returns:
+    //  VmbErrorSuccess if every camera delivered an image, else the first error
+    //
+    VmbErrorType    AcquireSnapshot( const std::vector<std::string> &rCameraIDs, CameraSnapshotVector &rSnapshots );
+    VmbErrorType    AcquireSnapshot( CameraSnapshotVector &rSnapshots );
+
+    //
+    // Opens the given camera unless its session is open already
+    // Sets the maximum possible Ethernet packet size (once per session)
+    // Adjusts the image format (once per session)
+    // Announces and queues a ring of frames and starts the acquisition
+    // Every completed frame is handed to the given callback and requeued afterwards
+    //
+    // Parameters:
+    //  [in]    rStrCameraID        The ID of the camera to work on
+    //  [in]    rCallback           The function that gets every completed frame (called from the API's thread)
+    //  [in]    nFrameCount         The number of frames in the ring
+    //
+    // Returns:
+    //  An API status code
+    //
+    VmbErrorType    StartContinuousAcquisition( const std::string &rStrCameraID, const FrameCallback &rCallback );
+    VmbErrorType    StartContinuousAcquisition( const std::string &rStrCameraID, const FrameCallback &rCallback, VmbUint32_t nFrameCount );
+
+    //
+    // Stops the acquisition and revokes all frames
+    // The camera stays open in its session
+    //
+    // Returns:
+    //  An API status code
+    //
+    VmbErrorType    StopContinuousAcquisition();
+
+    //
+    // Keeps the latest frames of continuous acquisitions in a ring of preallocated memory,
+    // so the frames around an event can be written with TriggerFlightRecorder
+    //
+    // Parameters:
+    //  [in]    rConfig             The size of the ring and of the window around an event
+    //
+    // Returns:
+    //  An API status code
+    //
+    VmbErrorType    StartFlightRecorder( const FlightRecorderConfig &rConfig );
+
+    //
+    // Writes the frames before and after this moment to a recording file in the background
+    //
+    // Parameters:
+    //  [in]    rFileName           The path of the recording to write
+    //  [in]    rCallback           Gets called once the recording was written (may be empty)
+    //
+    // Returns:
+    //  An API status code
+    //
+    VmbErrorType    TriggerFlightRecorder( const std::string &rFileName, const FlightRecorder::EventCallback &rCallback = FlightRecorder::EventCallback() );
+
+    //
+    // Writes the pending events and frees the ring
+    //
+    // Returns:
+    //  An API status code
+    //
+    VmbErrorType    StopFlightRecorder();
+
+    //
+    // Gets the counters of the flight recorder
+    //
+    // Parameters:
+    //  [out]   rStatistics         The counters
+    //
+    // Returns:
+    //  False if the flight recorder is not running
+    //
+    bool            GetFlightRecorderStatistics( FlightRecorderStatistics &rStatistics ) const;
+
+    //
+    // Switches the recording of per-frame spans of the pipeline on or off, while acquiring or not
+    //
+    // Parameters:
+    //  [in]    bIsEnabled          True to record, enabling again drops the spans of the last run
+    //
+    void            SetTracing( bool bIsEnabled );
+
+    //
+    // Writes the spans recorded since tracing was enabled as a Chrome trace (open it in Perfetto)
+    //
+    // Parameters:
+    //  [in]    rFileName           The path of the JSON file to write
+    //
+    // Returns:
+    //  An API status code
+    //
+    VmbErrorType    WriteTrace( const std::string &rFileName ) const;
+
+    //
+    // Writes a feature of the given camera, opening its session if needed
+    // Values the session wrote before are not written again
+    //
+    // Parameters:
+    //  [in]    rStrCameraID        The ID of the camera to work on
+    //  [in]    pName               The name of the feature
+    //  [in]    nValue / dValue     The value to write
+    //
+    // Returns:
+    //  An API status code
+    //
+    VmbErrorType    SetFeatureValue( const std::string &rStrCameraID, const char *pName, VmbInt64_t nValue );
+    VmbErrorType    SetFeatureValue( const std::string &rStrCameraID, const char *pName, double dValue );
+
+    //
+    // Writes one of the features resolved when the camera was opened, skipping the lookup by name
+    // Values the session wrote before are not written again
+    //
+    // Parameters:
+    //  [in]    rStrCameraID        The ID of the camera to work on
+    //  [in]    eFeature            The feature
+    //  [in]    nValue / dValue     The value to write
+    //
+    // Returns:
+    //  An API status code
+    //
+    VmbErrorType    SetFeatureValue( const std::string &rStrCameraID, CameraFeature eFeature, VmbInt64_t nValue );
+    VmbErrorType    SetFeatureValue( const std::string &rStrCameraID, CameraFeature eFeature, double dValue );
+
+    //
+    // Sets after how long an unused session gets closed
+    //
+    // Parameters:
+    //  [in]    nTimeoutMS          The idle time in milliseconds, 0 keeps sessions open until ShutDown
+    //
+    void            SetSessionIdleTimeout( VmbUint32_t nTimeoutMS );
 
     //
-    // Gets all cameras known to Vimba
+    // Sets the pixel formats asked for when a camera gets opened, the first one the camera
+    // accepts is used. The default (RGB8, then Mono8) throws away the bit depth of mono sensors,
+    // e.g. Mono12p, Mono12Packed, Mono10p, Mono16, Mono8 keeps it at the least bandwidth.
+    // Applies to sessions opened afterwards.
+    //
+    // Parameters:
+    //  [in]    rPixelFormats       The pixel formats in the order of preference
+    //
+    void            SetPixelFormats( const std::vector<VmbPixelFormatType> &rPixelFormats );
+
+    //
+    // Closes the session of the given camera
+    //
+    // Parameters:
+    //  [in]    rStrCameraID        The ID of the camera to close
     //
     // Returns:
-    //  A vector of camera shared pointers
+    //  An API status code
+    //
+    VmbErrorType    CloseSession( const std::string &rStrCameraID );
+
+    //
+    // Closes all open sessions
+    // Idle sessions keep getting reaped afterwards
     //
-    CameraPtrVector GetCameraList();
+    void            CloseAllSessions();
+
+    //
+    // Gets the packet size negotiated for the given camera and how long that took
+    //
+    // Parameters:
+    //  [in]    rStrCameraID        The ID of the camera
+    //  [out]   rNegotiation        The negotiated packet size
+    //
+    // Returns:
+    //  False if no packet size was negotiated for the camera (yet)
+    //
+    bool            GetPacketSizeNegotiation( const std::string &rStrCameraID, PacketSizeNegotiation &rNegotiation ) const;
+
+    //
+    // Forgets the packet size of the given camera so the next open negotiates it again
+    // (e.g. after the network path of the camera changed)
+    //
+    // Parameters:
+    //  [in]    rStrCameraID        The ID of the camera
+    //
+    void            ForgetPacketSize( const std::string &rStrCameraID );
+
+    //
+    // Gets all cameras known to the backend
+    // Only the first call after the start lists them, later calls are served from memory
+    // that hot-plug events keep up to date
+    //
+    // Returns:
+    //  A vector of camera descriptions
+    //
+    CameraInfoVector GetCameraList();
+
+    //
+    // Gets the same list without copying it. The list never changes, a change of the cameras publishes a new one.
+    // Meant for threads that look at the cameras often.
+    //
+    // Returns:
+    //  The cameras, NULL if the backend is not started or could not list them
+    //
+    CameraInfoSnapshot GetCameraSnapshot();
 
     //
     // Translates Vimba error codes to readable error messages
@@ -93,7 +380,7 @@ class ApiController
     std::string     ErrorCodeToMessage( VmbErrorType eErr ) const;
     
     //
-    // Gets the version of the Vimba API
+    // Gets the version of the backend (for Vimba: the Vimba API)
     //
     // Returns:
     //  The version as string
@@ -101,10 +388,166 @@ class ApiController
     std::string     GetVersion() const;
 
   private:
-    // A reference to our Vimba singleton
-    VimbaSystem &m_system;
-    // The currently streaming camera
-    CameraPtr m_pCamera;
+    //
+    // Keeps the backend for the duration of a call, so a concurrent ShutDown cannot shut it down underneath.
+    // Starts the backend unless it is running already.
+    //
+    class CallReference
+    {
+      public:
+        //
+        // Takes a reference on the backend and starts it unless it is running already
+        //
+        // Parameters:
+        //  [in]    rController         The controller whose backend the call uses
+        //
+        explicit CallReference( ApiController &rController );
+
+        //
+        // Drops the reference, the last one after the last ShutDown shuts down the backend
+        //
+        ~CallReference();
+
+        //
+        // Gets whether the backend runs for the call
+        //
+        // Returns:
+        //  VmbErrorApiNotStarted if StartUp was not called, else an API status code
+        //
+        VmbErrorType    GetResult() const;
+
+      private:
+        ApiController  &m_rController;
+        VmbErrorType    m_eResult;
+
+        // No copies
+        CallReference( const CallReference& );
+        CallReference& operator=( const CallReference& );
+    };
+
+    //
+    // Starts the backend, m_startMutex must be held
+    //
+    // Returns:
+    //  An API status code
+    //
+    VmbErrorType    StartBackend();
+
+    //
+    // Closes all sessions and shuts down the backend, m_startMutex must be held
+    //
+    void            ShutDownBackend();
+
+    //
+    // Records a startup phase
+    //
+    // Parameters:
+    //  [in]    rStrName            What was done
+    //  [in]    tStart              When it started
+    //
+    void            AddStartupPhase( const std::string &rStrName, std::chrono::steady_clock::time_point tStart );
+
+    //
+    // Acquires a single image and reports how long the two steps took
+    //
+    // Parameters:
+    //  [in]    rStrCameraID        The ID of the camera to work on
+    //  [out]   rFrame              The acquired image
+    //  [out]   rnOpenUS            How long getting the open and prepared camera took in microseconds
+    //  [out]   rnAcquireUS         How long the acquisition took in microseconds
+    //
+    // Returns:
+    //  An API status code
+    //
+    VmbErrorType    AcquireSingleImage( const std::string &rStrCameraID, ImageFrame &rFrame, VmbUint32_t &rnOpenUS, VmbUint32_t &rnAcquireUS );
+
+    //
+    // Gets the session of the given camera and locks it
+    // Opens and prepares the camera if there is no session yet
+    //
+    // Parameters:
+    //  [in]    rReference          The reference the calling function holds on the backend
+    //  [in]    rStrCameraID        The ID of the camera to work on
+    //  [out]   rpSession           The open session
+    //  [out]   rLock               Holds the lock of the session
+    //
+    // Returns:
+    //  An API status code
+    //
+    VmbErrorType    LockSession( const CallReference &rReference, const std::string &rStrCameraID, CameraSessionPtr &rpSession, std::unique_lock<std::mutex> &rLock );
+
+    //
+    // Sets the maximum possible Ethernet packet size
+    // Adjusts the image format
+    //
+    // Parameters:
+    //  [in]    rStrCameraID        The ID of the camera
+    //  [in]    rSession            The session of the opened camera to work on
+    //
+    // Returns:
+    //  An API status code
+    //
+    VmbErrorType    PrepareCamera( const std::string &rStrCameraID, CameraSession &rSession );
+
+    //
+    // Applies the packet size cached for the camera or negotiates the highest possible one
+    // Waits for the negotiation with backoff, but not longer than PACKET_SIZE_TIMEOUT_MS
+    //
+    // Parameters:
+    //  [in]    rStrCameraID        The ID of the camera
+    //  [in]    rSession            The session of the opened camera to work on
+    //
+    // Returns:
+    //  An API status code
+    //
+    VmbErrorType    AdjustPacketSize( const std::string &rStrCameraID, CameraSession &rSession );
+
+    //
+    // Stops closing idle sessions in the background, StartUp starts it again
+    //
+    void            StopReaper();
+
+    //
+    // Closes sessions that have not been used for longer than the idle timeout (runs on m_reaperThread)
+    //
+    void            ReapIdleSessions();
+
+    // The system our cameras come from
+    ICameraBackendPtr m_pBackend;
+    // The references taken by StartUp and by running calls, the backend runs while there are any
+    // (and it was needed once if lazy). Guarded by m_startMutex like the rest of the startup state.
+    VmbUint32_t m_nStartCount;
+    VmbUint32_t m_nCallCount;
+    bool m_bIsBackendStarted;
+    bool m_bIsLazyStartup;
+    // The steps since the last backend start, with the cameras listed and opened since
+    StartupPhaseVector m_startupPhases;
+    std::atomic<bool> m_bHasListedCameras;
+    std::set<std::string> m_openedCameraIDs;
+    mutable std::mutex m_startMutex;
+    // The cameras of the backend, kept while it runs
+    CameraRegistry m_cameraRegistry;
+    // The open sessions by camera ID
+    std::map<std::string, CameraSessionPtr> m_sessions;
+    std::mutex m_sessionsMutex;
+    // Closes idle sessions in the background
+    std::thread m_reaperThread;
+    std::condition_variable m_reaperCondition;
+    bool m_bStopReaper;
+    VmbUint32_t m_nIdleTimeoutMS;
+    // The pixel formats PrepareCamera tries, in the order of preference
+    std::vector<VmbPixelFormatType> m_pixelFormats;
+    std::mutex m_pixelFormatsMutex;
+    // The session of the currently streaming camera, guarded by m_sessionsMutex
+    CameraSessionPtr m_pStreamingSession;
+    // Keeps the latest frames of the continuous acquisition, read by the frame callback with std::atomic_load
+    FlightRecorderPtr m_pFlightRecorder;
+    // Runs multi-camera snapshots, created on first use
+    WorkerPoolPtr m_pWorkerPool;
+    std::mutex m_workerPoolMutex;
+    // The negotiated packet sizes by camera ID, kept across sessions
+    std::map<std::string, PacketSizeNegotiation> m_packetSizes;
+    mutable std::mutex m_packetSizesMutex;
 };
 
 }}} // namespace AVT::VmbAPI::Examples
@@ -0,0 +1,122 @@
+/*=============================================================================
+  Copyright (C) 2013 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        BayerImage.cpp
+
+  Description: Host side demosaicing of raw Bayer frames, so cameras can stream a third
+               of the bandwidth of RGB8.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#include <algorithm>
+
+#include "BayerImage.h"
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+// The rows demosaiced by one task of a worker pool
+enum { DEMOSAIC_STRIPE_ROWS = 64, };
+
+//
+// Gets the Bayer pattern of an 8 bit Bayer pixel format
+//
+// Parameters:
+//  [in]    ePixelFormat        The pixel format to look at
+//  [out]   rePattern           The Bayer pattern
+//
+// Returns:
+//  False if the format is not 8 bit Bayer
+//
+bool GetBayerPattern( VmbPixelFormatType ePixelFormat, BayerPattern &rePattern )
+{
+    switch ( ePixelFormat )
+    {
+    case VmbPixelFormatBayerRG8:    rePattern = BayerPatternRG;     return true;
+    case VmbPixelFormatBayerGR8:    rePattern = BayerPatternGR;     return true;
+    case VmbPixelFormatBayerBG8:    rePattern = BayerPatternBG;     return true;
+    case VmbPixelFormatBayerGB8:    rePattern = BayerPatternGB;     return true;
+    default:                                                        return false;
+    }
+}
+
+//
+// Gets pixel formats for ApiController::SetPixelFormats that make color cameras stream raw Bayer
+//
+// Returns:
+//  The pixel formats in the order of preference
+//
+std::vector<VmbPixelFormatType> GetRawBayerPixelFormats()
+{
+    static const VmbPixelFormatType pixelFormats[] = {  VmbPixelFormatBayerRG8, VmbPixelFormatBayerGR8, VmbPixelFormatBayerBG8, VmbPixelFormatBayerGB8,
+                                                        VmbPixelFormatRgb8, VmbPixelFormatMono8 };
+    return std::vector<VmbPixelFormatType>( pixelFormats, pixelFormats + sizeof( pixelFormats ) / sizeof( pixelFormats[0] ));
+}
+
+//
+// Demosaics an 8 bit Bayer image into BGR8
+//
+// Parameters:
+//  [in]    rFrame              The image, any 8 bit Bayer format
+//  [in]    eMethod             How to interpolate
+//  [out]   pDestination        The BGR8 image, nWidth * nHeight * 3 bytes
+//  [in]    pPool               Demosaics stripes of the image in parallel (may be NULL)
+//
+// Returns:
+//  An API status code
+//
+VmbErrorType DemosaicImage( const ImageFrame &rFrame, DemosaicMethod eMethod, VmbUchar_t *pDestination, WorkerPool *pPool )
+{
+    BayerPattern ePattern;
+    if (    NULL == rFrame.pImage
+         || NULL == pDestination
+         || !GetBayerPattern( rFrame.ePixelFormat, ePattern )
+         || rFrame.nWidth < 2
+         || rFrame.nHeight < 2
+         || rFrame.nImageSize < GetImageSize( rFrame.nWidth, rFrame.nHeight, rFrame.ePixelFormat )
+         || eMethod < 0
+         || eMethod >= DemosaicMethodCount )
+    {
+        return VmbErrorBadParameter;
+    }
+
+    // Stripes read the rows around them but only write their own, so they do not depend on each other
+    const VmbUint32_t nStripeCount = ( rFrame.nHeight + DEMOSAIC_STRIPE_ROWS - 1 ) / DEMOSAIC_STRIPE_ROWS;
+    if (    NULL == pPool
+         || 1 == nStripeCount )
+    {
+        AVTDemosaic( ePattern, eMethod, rFrame.pImage, rFrame.nWidth, rFrame.nHeight, pDestination, 0, rFrame.nHeight );
+    }
+    else
+    {
+        const auto demosaicStripe = [&]( VmbUint32_t nStripe )
+        {
+            const VmbUint32_t nFirstRow = nStripe * DEMOSAIC_STRIPE_ROWS;
+            AVTDemosaic(    ePattern, eMethod, rFrame.pImage, rFrame.nWidth, rFrame.nHeight, pDestination,
+                            nFirstRow, std::min<VmbUint32_t>( DEMOSAIC_STRIPE_ROWS, rFrame.nHeight - nFirstRow ));
+        };
+        pPool->ParallelFor( nStripeCount, demosaicStripe );
+    }
+    return VmbErrorSuccess;
+}
+
+}}} // namespace AVT::VmbAPI::Examples
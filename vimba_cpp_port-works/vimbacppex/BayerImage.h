@@ -0,0 +1,81 @@
+/*=============================================================================
+  Copyright (C) 2013 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        BayerImage.h
+
+  Description: Host side demosaicing of raw Bayer frames, so cameras can stream a third
+               of the bandwidth of RGB8.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#ifndef AVT_VMBAPI_EXAMPLES_BAYERIMAGE
+#define AVT_VMBAPI_EXAMPLES_BAYERIMAGE
+
+#include <vector>
+
+#include "VimbaCPP/Include/VimbaCPP.h"
+
+#include "Demosaic.h"
+#include "ImageFrame.h"
+#include "WorkerPool.h"
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+//
+// Gets the Bayer pattern of an 8 bit Bayer pixel format
+//
+// Parameters:
+//  [in]    ePixelFormat        The pixel format to look at
+//  [out]   rePattern           The Bayer pattern
+//
+// Returns:
+//  False if the format is not 8 bit Bayer
+//
+bool GetBayerPattern( VmbPixelFormatType ePixelFormat, BayerPattern &rePattern );
+
+//
+// Gets pixel formats for ApiController::SetPixelFormats that make color cameras stream raw Bayer.
+// Cameras only accept their own pattern, RGB8 and Mono8 follow for cameras without 8 bit Bayer.
+//
+// Returns:
+//  The pixel formats in the order of preference
+//
+std::vector<VmbPixelFormatType> GetRawBayerPixelFormats();
+
+//
+// Demosaics an 8 bit Bayer image into BGR8
+//
+// Parameters:
+//  [in]    rFrame              The image, any 8 bit Bayer format
+//  [in]    eMethod             How to interpolate
+//  [out]   pDestination        The BGR8 image, nWidth * nHeight * 3 bytes
+//  [in]    pPool               Demosaics stripes of the image in parallel (may be NULL)
+//
+// Returns:
+//  An API status code
+//
+VmbErrorType DemosaicImage( const ImageFrame &rFrame, DemosaicMethod eMethod, VmbUchar_t *pDestination, WorkerPool *pPool = NULL );
+
+}}} // namespace AVT::VmbAPI::Examples
+
+#endif
@@ -28,39 +28,356 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <errno.h>
+
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/uio.h>
+#endif
 
 #include "Bitmap.h"
+#include "FrameTracer.h"
+#include "LatencyMonitor.h"
+#include "MetricsRegistry.h"
+#include "PixelSwizzle.h"
 
 enum { THREE_CHANNEL    = 0xC,};
 enum { BMP_HEADER_SIZE  = 54, };
 enum { ALIGNMENT_SIZE   = 4, };
+enum { MAX_IO_VECTORS   = 64, };
+enum { STAGING_SIZE     = 256 * 1024, };
+
+enum { PALETTE_SIZE     = 256, };
+enum { HEADER_CACHE_SIZE = 4, };
+
+// What AVTCreateBitmap hands to the stripes it converts
+typedef struct AVTConvertJob AVTConvertJob;
+
+// Converts rows of an image into bitmap rows, one instantiation per color code and padding case
+typedef void (*AVTConvertRowsFunc)( AVTConvertJob const* pJob, unsigned long nFirstRow, unsigned long nRowCount );
+
+struct AVTConvertJob
+{
+    const unsigned char*    pSource;                // The image
+    unsigned char*          pDestination;           // The first row of the bitmap
+    unsigned long           width;
+    unsigned long           height;
+    unsigned long           numColors;              // Bytes per pixel
+    unsigned long           padLength;              // The padding after every bitmap row
+    unsigned long           stripeRows;             // The number of rows per stripe (the last one may have less)
+    AVTConvertRowsFunc      convert;                // Converts the rows of a stripe
+};
+
+// A header made for a certain geometry
+typedef struct
+{
+    unsigned long   width;
+    unsigned long   height;
+    unsigned long   bufferSize;
+    ColorCode       colorCode;
+    AVTBitmapHeader header;                         // Not valid yet if header.size is 0
+    AVTConvertRowsFunc convert;                     // The row converter for the geometry
+} AVTCachedBitmapHeader;
+
+// Streams keep their geometry, so a few headers per thread cover them and need no locking
+static thread_local AVTCachedBitmapHeader   g_headerCache[HEADER_CACHE_SIZE];
+static thread_local unsigned int            g_nNextHeaderCacheEntry;
+
+#ifdef _WIN32
+typedef struct
+{
+    void*           iov_base;
+    unsigned long   iov_len;
+} AVTIoVec;
+#else
+typedef struct iovec AVTIoVec;
+#endif
+
+static void* AVTDefaultAlloc( unsigned long nSize, void* /*pContext*/ )
+{
+    return malloc( nSize );
+}
+
+static void AVTDefaultFree( void* pBuffer, void* /*pContext*/ )
+{
+    free( pBuffer );
+}
+
+// The functions bitmap memory comes from
+static AVTBitmapAllocFunc   g_pBitmapAlloc      = AVTDefaultAlloc;
+static AVTBitmapFreeFunc    g_pBitmapFree       = AVTDefaultFree;
+static void*                g_pBitmapContext    = NULL;
+static AVTBitmapParallelForFunc g_pBitmapParallelFor     = NULL;
+static void*                    g_pBitmapParallelContext = NULL;
+static unsigned long            g_nBitmapMinStripeSize   = AVT_BITMAP_DEFAULT_MIN_STRIPE_SIZE;
 
 //
-// Creates a MS Windows bitmap with header and color palette.
-// Fills it with the content of the given byte buffer
-// 
+// Sets the functions AVTCreateBitmap and AVTReleaseBitmap use for the bitmap memory
+// and AVTWriteImageToFile uses for its staging buffer (e.g. a buffer pool).
+// Call this before creating bitmaps, not while bitmaps are in use.
+//
 // Parameters:
-//  [out]   pBitmap         A pointer to an AVTBitmap that will get filled
-//  [in]    pBuffer         The buffer that will be used to fill the created bitmap
+//  [in]    pAlloc          The allocation function, NULL for malloc
+//  [in]    pFree           The function that frees what pAlloc returned, NULL for free
+//  [in]    pContext        Handed to both functions
+//
+void AVTSetBitmapAllocator( AVTBitmapAllocFunc pAlloc, AVTBitmapFreeFunc pFree, void* pContext )
+{
+    if (    NULL == pAlloc
+         || NULL == pFree )
+    {
+        pAlloc      = AVTDefaultAlloc;
+        pFree       = AVTDefaultFree;
+        pContext    = NULL;
+    }
+    g_pBitmapAlloc      = pAlloc;
+    g_pBitmapFree       = pFree;
+    g_pBitmapContext    = pContext;
+}
+
+//
+// Sets the function AVTCreateBitmap uses to convert horizontal stripes of large images in parallel
+// (e.g. on a thread pool). Call this before creating bitmaps, not while bitmaps are created.
+//
+// Parameters:
+//  [in]    pParallelFor    The function that runs the stripes, NULL to convert on the calling thread
+//  [in]    pContext        Handed to pParallelFor
+//  [in]    nMinStripeSize  The least bytes of image data per stripe, smaller images are not split (0 for the default)
+//
+void AVTSetBitmapParallelFor( AVTBitmapParallelForFunc pParallelFor, void* pContext, unsigned long nMinStripeSize )
+{
+    g_pBitmapParallelFor        = pParallelFor;
+    g_pBitmapParallelContext    = NULL != pParallelFor ? pContext : NULL;
+    g_nBitmapMinStripeSize      = nMinStripeSize;
+    if ( 0 == nMinStripeSize )
+    {
+        g_nBitmapMinStripeSize  = AVT_BITMAP_DEFAULT_MIN_STRIPE_SIZE;
+    }
+}
+
+static int AVTBuildGrayPalette( unsigned char* pPalette )
+{
+    unsigned long i;                                // Counter for some iteration
+
+    for(i = 0; i < PALETTE_SIZE; ++i)
+    {
+        pPalette[0] = (char)(i);
+        pPalette[1] = (char)(i);
+        pPalette[2] = (char)(i);
+        pPalette[3] = 0;
+        pPalette += 4;
+    }
+    return 1;
+}
+
+//
+// Gets the grayscale palette every 8 bit bitmap uses (built once)
+//
+static const unsigned char* AVTGetGrayPalette()
+{
+    static unsigned char    palette[PALETTE_SIZE * 4];
+    static const int        bIsBuilt = AVTBuildGrayPalette( palette );
+    (void)bIsBuilt;
+    return palette;
+}
+
+//
+// The pixel layout of a color code, known at compile time
+//
+template <ColorCode SourceCode>
+struct AVTPixelTraits
+{
+    enum { BYTES_PER_PIXEL = 1, };
+
+    // Bitmaps keep the layout of the image
+    static void ConvertPixels( const unsigned char* pSource, unsigned char* pDestination, unsigned long nPixelCount )
+    {
+        memcpy( pDestination, pSource, nPixelCount * BYTES_PER_PIXEL );
+    }
+};
+
+template <>
+struct AVTPixelTraits<ColorCodeBGR24>
+{
+    enum { BYTES_PER_PIXEL = 3, };
+
+    static void ConvertPixels( const unsigned char* pSource, unsigned char* pDestination, unsigned long nPixelCount )
+    {
+        memcpy( pDestination, pSource, nPixelCount * BYTES_PER_PIXEL );
+    }
+};
+
+template <>
+struct AVTPixelTraits<ColorCodeRGB24>
+{
+    enum { BYTES_PER_PIXEL = 3, };
+
+    // A Windows bitmap is BGR
+    static void ConvertPixels( const unsigned char* pSource, unsigned char* pDestination, unsigned long nPixelCount )
+    {
+        AVTSwapRGB( pSource, pDestination, nPixelCount );
+    }
+};
+
+//
+// Converts rows of an image into bitmap rows. Color code and padding are template parameters,
+// so the loops carry no format or padding decisions.
+//
+// Parameters:
+//  [in]    pJob            What to convert
+//  [in]    nFirstRow       The first row to convert
+//  [in]    nRowCount       The number of rows to convert
+//
+template <ColorCode SourceCode, bool IsPadded>
+static void AVTConvertRows( AVTConvertJob const* pJob, unsigned long nFirstRow, unsigned long nRowCount )
+{
+    typedef AVTPixelTraits<SourceCode> Traits;
+
+    const unsigned long     nRowSize        = pJob->width * Traits::BYTES_PER_PIXEL;
+    const unsigned long     nPadLength      = IsPadded ? pJob->padLength : 0;
+    const unsigned char*    pCurSrc         = pJob->pSource + nFirstRow * nRowSize;
+    unsigned char*          pCurBitmapBuf   = pJob->pDestination + nFirstRow * ( nRowSize + nPadLength );
+    unsigned long           y;
+
+    if ( !IsPadded )
+    {
+        // Rows follow each other without a gap, convert all rows at once
+        Traits::ConvertPixels( pCurSrc, pCurBitmapBuf, pJob->width * nRowCount );
+        return;
+    }
+    for ( y = 0; y < nRowCount; ++y )
+    {
+        Traits::ConvertPixels( pCurSrc, pCurBitmapBuf, pJob->width );
+        memset( pCurBitmapBuf + nRowSize, 0, nPadLength );
+        pCurSrc         += nRowSize;
+        pCurBitmapBuf   += nRowSize + nPadLength;
+    }
+}
+
+//
+// Converts rows of color codes without a specialization, bytes per pixel come from the header
+//
+static void AVTConvertRowsGeneric( AVTConvertJob const* pJob, unsigned long nFirstRow, unsigned long nRowCount )
+{
+    const unsigned long     nRowSize        = pJob->width * pJob->numColors;
+    const unsigned char*    pCurSrc         = pJob->pSource + nFirstRow * nRowSize;
+    unsigned char*          pCurBitmapBuf   = pJob->pDestination + nFirstRow * ( nRowSize + pJob->padLength );
+    unsigned long           y;
+
+    for ( y = 0; y < nRowCount; ++y )
+    {
+        memcpy( pCurBitmapBuf, pCurSrc, nRowSize );
+        memset( pCurBitmapBuf + nRowSize, 0, pJob->padLength );
+        pCurSrc         += nRowSize;
+        pCurBitmapBuf   += nRowSize + pJob->padLength;
+    }
+}
+
+// The row converters by color code, without and with row padding
+static const struct
+{
+    ColorCode           colorCode;
+    AVTConvertRowsFunc  convert[2];
+} g_rowConverters[] =
+{
+    { ColorCodeMono8,   { AVTConvertRows<ColorCodeMono8, false>,  AVTConvertRows<ColorCodeMono8, true> } },
+    { ColorCodeBGR24,   { AVTConvertRows<ColorCodeBGR24, false>,  AVTConvertRows<ColorCodeBGR24, true> } },
+    { ColorCodeRGB24,   { AVTConvertRows<ColorCodeRGB24, false>,  AVTConvertRows<ColorCodeRGB24, true> } },
+};
+
+//
+// Picks the row converter for a color code and padding
+//
+// Parameters:
+//  [in]    colorCode       The color code of the image
+//  [in]    padLength       The padding after every bitmap row
+//
+// Returns:
+//  The converter
+//
+static AVTConvertRowsFunc AVTSelectRowConverter( ColorCode colorCode, unsigned long padLength )
+{
+    unsigned long i;                                // Counter for some iteration
+
+    for ( i = 0; i < sizeof( g_rowConverters ) / sizeof( g_rowConverters[0] ); ++i )
+    {
+        if ( colorCode == g_rowConverters[i].colorCode )
+        {
+            return g_rowConverters[i].convert[0 != padLength ? 1 : 0];
+        }
+    }
+    return AVTConvertRowsGeneric;
+}
+
+//
+// Gets the header for the geometry of the given bitmap from the cache of this thread, creates it if needed
+//
+// Parameters:
+//  [in]    pBitmap         Width, height, color code and image size (bufferSize) of the bitmap
+//
+// Returns:
+//  The header and row converter, valid until this thread asks for HEADER_CACHE_SIZE other geometries.
+//  NULL in case of error.
+//
+static AVTCachedBitmapHeader const* AVTGetCachedBitmapHeader( AVTBitmap const * const pBitmap )
+{
+    AVTCachedBitmapHeader*  pEntry;                 // The cache entry for the geometry
+    unsigned int            i;                      // Counter for some iteration
+
+    for ( i = 0; i < HEADER_CACHE_SIZE; ++i )
+    {
+        pEntry = &g_headerCache[i];
+        if (    0 != pEntry->header.size
+             && pBitmap->width == pEntry->width
+             && pBitmap->height == pEntry->height
+             && pBitmap->bufferSize == pEntry->bufferSize
+             && pBitmap->colorCode == pEntry->colorCode )
+        {
+            return pEntry;
+        }
+    }
+
+    // Replace the oldest entry
+    pEntry = &g_headerCache[g_nNextHeaderCacheEntry];
+    g_nNextHeaderCacheEntry = ( g_nNextHeaderCacheEntry + 1 ) % HEADER_CACHE_SIZE;
+    if ( 0 == AVTCreateBitmapHeader( pBitmap, &pEntry->header ))
+    {
+        pEntry->header.size = 0;
+        return NULL;
+    }
+    pEntry->width       = pBitmap->width;
+    pEntry->height      = pBitmap->height;
+    pEntry->bufferSize  = pBitmap->bufferSize;
+    pEntry->colorCode   = pBitmap->colorCode;
+    // Picking the converter here means it is picked once per stream
+    pEntry->convert     = AVTSelectRowConverter( pBitmap->colorCode, pEntry->header.padLength );
+    return pEntry;
+}
+
+//
+// Creates the header and color palette of a MS Windows bitmap
+//
+// Parameters:
+//  [in]    pBitmap         Width, height, color code and image size (bufferSize) of the bitmap
+//  [out]   pHeader         The header that will get filled
 //
 // Returns:
 //  0 in case of error
 //  1 in case of success
 //
-unsigned char AVTCreateBitmap( AVTBitmap * const pBitmap, const void* pBuffer )
+unsigned char AVTCreateBitmapHeader( AVTBitmap const * const pBitmap, AVTBitmapHeader * const pHeader )
 {
     unsigned char   nNumColors;                     // Number of colors of our image
     unsigned char   nPadLength;                     // The padding we need to align the bitmap ALIGNMENT_SIZE
     unsigned long   nPaletteSize = 0;               // The size of the bitmap's palette
     unsigned long   nHeaderSize;                    // The size of the bitmap's header
     unsigned long   nFileSize;                      // The size of the bitmap file
-    unsigned char*  pBitmapBuffer;                  // A buffer we use for creating the bitmap
-    unsigned char*  pCurBitmapBuf;                  // A cursor to move over "pBitmapBuffer"
-    unsigned char*  pCurSrc;                        // A cursor to move over the given buffer "pBuffer"
-    unsigned long   px;                             // A single pixel for storing transformed color information
-    unsigned long   x;                              // The horizontal position within our image
-    unsigned long   y;                              // The vertical position within our image
-    unsigned long   i;                              // Counter for some iteration
+    unsigned char*  pCurBitmapBuf;                  // A cursor to move over the header
 
     // The bitmap header
     char fileHeader[14] = { 'B','M',                // Default
@@ -74,9 +391,12 @@ unsigned char AVTCreateBitmap( AVTBitmap * const pBitmap, const void* pBuffer )
                             0, 0 };                 // bpp
 
     if (    NULL == pBitmap
+         || NULL == pHeader
          || 0 == pBitmap->bufferSize
          || 0 == pBitmap->width
-         || 0 == pBitmap->height )
+         || 0 == pBitmap->height
+         // Windows bitmaps have no 16 bit gray, such images have to be mapped to Mono8 first
+         || ColorCodeMono16 == pBitmap->colorCode )
     {
         return 0;
     }
@@ -99,11 +419,10 @@ unsigned char AVTCreateBitmap( AVTBitmap * const pBitmap, const void* pBuffer )
 
     if ( ColorCodeRGB24 != pBitmap->colorCode )
     {
-        nPaletteSize = 256;
+        nPaletteSize = PALETTE_SIZE;
     }
     
     nHeaderSize     = BMP_HEADER_SIZE + nPaletteSize * 4;
-    pBitmapBuffer   = (unsigned char*)malloc( nHeaderSize + pBitmap->bufferSize + (nPadLength * pBitmap->height) );
     nFileSize       = nHeaderSize + pBitmap->bufferSize + (nPadLength * pBitmap->height);
 
     // File size
@@ -146,71 +465,115 @@ unsigned char AVTCreateBitmap( AVTBitmap * const pBitmap, const void* pBuffer )
     infoHeader[39]  = (char)(nPaletteSize >> 24);
 
     // Write header
-    pCurBitmapBuf   = pBitmapBuffer;
+    pCurBitmapBuf   = pHeader->data;
     memcpy( pCurBitmapBuf, fileHeader, 14 );
     pCurBitmapBuf += 14;
     memcpy( pCurBitmapBuf, infoHeader, 40 );
     pCurBitmapBuf += 40;
-    for(i = 0; i < nPaletteSize; ++i)
+    memcpy( pCurBitmapBuf, AVTGetGrayPalette(), nPaletteSize * 4 );
+
+    pHeader->size       = nHeaderSize;
+    pHeader->fileSize   = nFileSize;
+    pHeader->padLength  = nPadLength;
+    pHeader->rowSize    = pBitmap->width * nNumColors;
+    return 1;
+}
+
+//
+// Converts the rows of a single stripe of an image into a bitmap
+//
+// Parameters:
+//  [in]    nStripe         The index of the stripe
+//  [in]    pContext        The AVTConvertJob
+//
+static void AVTConvertStripe( unsigned long nStripe, void* pContext )
+{
+    AVTConvertJob const*    pJob;                   // What to convert
+    unsigned long           nFirstRow;              // The first row of the stripe
+    unsigned long           nRowCount;              // The number of rows of the stripe
+
+    pJob        = (AVTConvertJob const*)pContext;
+    nFirstRow   = nStripe * pJob->stripeRows;
+    nRowCount   = pJob->height - nFirstRow < pJob->stripeRows ? pJob->height - nFirstRow : pJob->stripeRows;
+    pJob->convert( pJob, nFirstRow, nRowCount );
+}
+
+//
+// Creates a MS Windows bitmap with header and color palette.
+// Fills it with the content of the given byte buffer
+// 
+// Parameters:
+//  [out]   pBitmap         A pointer to an AVTBitmap that will get filled
+//  [in]    pBuffer         The buffer that will be used to fill the created bitmap
+//
+// Returns:
+//  0 in case of error
+//  1 in case of success
+//
+unsigned char AVTCreateBitmap( AVTBitmap * const pBitmap, const void* pBuffer )
+{
+    unsigned char   nNumColors;                     // Number of colors of our image
+    unsigned char   nPadLength;                     // The padding we need to align the bitmap ALIGNMENT_SIZE
+    unsigned char*  pBitmapBuffer;                  // A buffer we use for creating the bitmap
+    unsigned long   nStripeCount;                   // The number of stripes the image is converted in
+    AVTConvertJob   job;                            // What the stripes convert
+    AVTCachedBitmapHeader const* pCached;           // The header and row converter of the geometry
+    AVTBitmapHeader const* pHeader;                 // The header and palette of the bitmap
+    AVT::VmbAPI::Examples::LatencyScope latency( AVT::VmbAPI::Examples::LatencyStageConvert );
+    AVT::VmbAPI::Examples::TraceScope trace( "Convert" );
+
+    // Header and converter only depend on the geometry, so they are only made for the first frame of a stream
+    pCached = AVTGetCachedBitmapHeader( pBitmap );
+    if ( NULL == pCached )
     {
-        pCurBitmapBuf[0] = (char)(i);
-        pCurBitmapBuf[1] = (char)(i);
-        pCurBitmapBuf[2] = (char)(i);
-        pCurBitmapBuf[3] = 0;
-        pCurBitmapBuf += 4;
+        return 0;
     }
+    pHeader = &pCached->header;
+    nPadLength = (unsigned char)pHeader->padLength;
+    nNumColors = (unsigned char)(pHeader->rowSize / pBitmap->width);
 
-    // RGB -> BGR (a Windows bitmap is BGR)
-    if ( ColorCodeRGB24 == pBitmap->colorCode )
+    pBitmapBuffer   = (unsigned char*)g_pBitmapAlloc( pHeader->fileSize, g_pBitmapContext );
+    if ( NULL == pBitmapBuffer )
     {
-        pCurSrc = (unsigned char*)pBuffer;
-        for ( y=0; y<pBitmap->height; ++y, pCurBitmapBuf+=nPadLength )
-        {
-            for (   x = 0;
-                    x < pBitmap->width;
-                    ++x,
-                    pCurSrc += 3,
-                    pCurBitmapBuf += 3 )
-            {
-                px = 0;
-                // Create a 4 Byte structure to store ARGB (we don't use A)
-                px = px | (pCurSrc[0] << 16) | (pCurSrc[1] << 8) | pCurSrc[2];
-                // Due to endianess ARGB is stored as BGRA 
-                // and we only have to write the first three Bytes
-                memcpy( pCurBitmapBuf, &px, 3 );
-            }
-            // Add padding at the end of each row
-            memset( pCurBitmapBuf, 0, nPadLength );
-        }
-        pBitmap->colorCode = ColorCodeBGR24;
+        return 0;
+    }
+
+    // Write header
+    memcpy( pBitmapBuffer, pHeader->data, pHeader->size );
+
+    // Large images are converted in horizontal stripes, in parallel if a parallel for is set
+    job.pSource         = (const unsigned char*)pBuffer;
+    job.pDestination    = pBitmapBuffer + pHeader->size;
+    job.width           = pBitmap->width;
+    job.height          = pBitmap->height;
+    job.numColors       = nNumColors;
+    job.padLength       = nPadLength;
+    job.convert         = pCached->convert;
+    nStripeCount        = 1;
+    if ( NULL != g_pBitmapParallelFor )
+    {
+        nStripeCount = pHeader->rowSize * pBitmap->height / g_nBitmapMinStripeSize;
+        nStripeCount = nStripeCount < 1 ? 1 : nStripeCount > pBitmap->height ? pBitmap->height : nStripeCount;
+    }
+    job.stripeRows = ( pBitmap->height + nStripeCount - 1 ) / nStripeCount;
+    nStripeCount = ( pBitmap->height + job.stripeRows - 1 ) / job.stripeRows;
+    if ( 1 == nStripeCount )
+    {
+        AVTConvertStripe( 0, &job );
     }
-    // Mono8
     else
     {
-        if ( 0 == nPadLength )
-        {
-            memcpy( pCurBitmapBuf, pBuffer, pBitmap->bufferSize );
-        }
-        else
-        {
-            pCurSrc = (unsigned char*)pBuffer;
-            for (   y=0;
-                    y<pBitmap->height;
-                    ++y,
-                    pCurSrc += pBitmap->width * nNumColors )
-            {
-                // Write a single row of colored pixels
-                memcpy( pCurBitmapBuf, pCurSrc, pBitmap->width * nNumColors );
-                pCurBitmapBuf += pBitmap->width * nNumColors;
-                // Write padding pixels
-                memset( pCurBitmapBuf, 0, nPadLength );
-                pCurBitmapBuf += nPadLength;
-            }
-        }
+        g_pBitmapParallelFor( nStripeCount, AVTConvertStripe, &job, g_pBitmapParallelContext );
+    }
+
+    // RGB -> BGR (a Windows bitmap is BGR)
+    if ( ColorCodeRGB24 == pBitmap->colorCode )
+    {
+        pBitmap->colorCode = ColorCodeBGR24;
     }
 
     pBitmap->buffer     = pBitmapBuffer;
-    pBitmap->bufferSize = nFileSize;
+    pBitmap->bufferSize = pHeader->fileSize;
     return 1;
 }
 
@@ -230,7 +593,7 @@ unsigned char AVTReleaseBitmap( AVTBitmap * const pBitmap )
          && NULL != pBitmap->buffer
          && 0 < pBitmap->bufferSize )
     {
-        free( pBitmap->buffer );
+        g_pBitmapFree( pBitmap->buffer, g_pBitmapContext );
         pBitmap->buffer = NULL;
         return 1;
     }
@@ -251,17 +614,270 @@ unsigned char AVTReleaseBitmap( AVTBitmap * const pBitmap )
 //
 unsigned char AVTWriteBitmapToFile( AVTBitmap const * const pBitmap, char const * const pFileName )
 {
-    FILE *file;
+    FILE*           file;                           // The bitmap file
+    size_t          nWritten;                       // The bytes fwrite wrote
+    AVT::VmbAPI::Examples::LatencyScope latency( AVT::VmbAPI::Examples::LatencyStageWrite );
+    AVT::VmbAPI::Examples::TraceScope trace( "Write" );
     if (    NULL != pBitmap
          && NULL != pBitmap->buffer
          && NULL != pFileName )
     {
         file = fopen(pFileName, "wb");
-        fwrite(pBitmap->buffer, 1, pBitmap->bufferSize, file );
-        fclose(file);
+        if ( NULL == file )
+        {
+            return 0;
+        }
+        nWritten = fwrite(pBitmap->buffer, 1, pBitmap->bufferSize, file );
+        // fclose flushes, so it may fail as well
+        if (    0 != fclose(file)
+             || pBitmap->bufferSize != nWritten )
+        {
+            return 0;
+        }
 
+        AVT::VmbAPI::Examples::WriteMetrics::GetDefault().pBytesWritten->Add( nWritten );
         return 1;
     }
 
     return 0;
 }
+
+//
+// Writes all given buffers to a file, in order
+//
+// Parameters:
+//  [in] file               The file descriptor
+//  [in] pVectors           The buffers, get modified
+//  [in] nCount             The number of buffers
+//
+// Returns:
+//  0 in case of error
+//  1 in case of success
+//
+static unsigned char AVTWriteVectors( int file, AVTIoVec* pVectors, int nCount )
+{
+#ifdef _WIN32
+    int             nWritten;                       // The bytes written by a single call
+    int             i;                              // Counter for some iteration
+
+    // There is no writev for files opened with _open, so write the buffers one after another
+    for ( i = 0; i < nCount; ++i )
+    {
+        while ( 0 < pVectors[i].iov_len )
+        {
+            nWritten = _write( file, pVectors[i].iov_base, pVectors[i].iov_len );
+            if ( 0 >= nWritten )
+            {
+                return 0;
+            }
+            pVectors[i].iov_base = (char*)pVectors[i].iov_base + nWritten;
+            pVectors[i].iov_len -= nWritten;
+        }
+    }
+#else
+    ssize_t         nWritten;                       // The bytes written by a single call
+
+    while ( 0 < nCount )
+    {
+        nWritten = writev( file, pVectors, nCount );
+        if ( 0 > nWritten )
+        {
+            if ( EINTR == errno )
+            {
+                continue;
+            }
+            return 0;
+        }
+        // Skip what has been written, a write may stop in the middle of a buffer
+        while (    0 < nCount
+                && (size_t)nWritten >= pVectors->iov_len )
+        {
+            nWritten -= pVectors->iov_len;
+            ++pVectors;
+            --nCount;
+        }
+        if ( 0 < nCount )
+        {
+            pVectors->iov_base = (char*)pVectors->iov_base + nWritten;
+            pVectors->iov_len -= nWritten;
+        }
+    }
+#endif
+    return 1;
+}
+
+//
+// Writes an image straight from its buffer to a bitmap file without creating the bitmap in memory.
+// Header and rows go to the file with scatter-gather I/O, row padding comes from a small zero buffer.
+// Mono8 and BGR24 pixels are never copied, RGB24 rows are swapped to BGR in a small staging buffer
+// that comes from the bitmap allocator, so a buffer pool recycles it.
+//
+// Parameters:
+//  [in] pBitmap            Width, height, color code, image size (bufferSize) and pixels (buffer) of the image
+//  [in] pHeader            The header created by AVTCreateBitmapHeader for this geometry, NULL to use the cached header of the geometry
+//  [in] pFileName          The destination (complete path) where to write the bitmap to
+//
+// Returns:
+//  0 in case of error
+//  1 in case of success
+//
+unsigned char AVTWriteImageToFile( AVTBitmap const * const pBitmap, AVTBitmapHeader const * const pHeader, char const * const pFileName )
+{
+    static const unsigned char padding[ALIGNMENT_SIZE] = { 0 };     // The zeros every row is padded with
+
+    AVTCachedBitmapHeader const* pCached;           // The cached header for the geometry
+    AVTBitmapHeader const*  pUsedHeader = pHeader;  // The header we write
+    AVTIoVec                vectors[MAX_IO_VECTORS];// The buffers of one write
+    int                     nVectors;               // The number of buffers in "vectors"
+    int                     file;                   // The destination file
+    unsigned char           bResult = 1;            // Whether everything has been written
+    const unsigned char*    pCurSrc;                // A cursor to move over the image
+    unsigned char*          pStaging = NULL;        // The buffer RGB rows are converted in
+    unsigned char*          pCurStaging;            // A cursor to move over "pStaging"
+    unsigned long           nPaddedRowSize;         // The size of a row in the file
+    unsigned long           nRowsPerChunk;          // The rows converted at once
+    unsigned long           nRows;                  // The rows of the current chunk
+    unsigned long           y;                      // The vertical position within our image
+    unsigned long           i;                      // Counter for some iteration
+    VmbUint64_t             nConvertStart;          // When swapping the current chunk started
+    VmbUint64_t             nConvertNS = 0;         // The time spent swapping, recorded as converting
+    AVT::VmbAPI::Examples::LatencyScope latency( AVT::VmbAPI::Examples::LatencyStageWrite );
+    AVT::VmbAPI::Examples::TraceScope trace( "Write" );
+
+    if (    NULL == pBitmap
+         || NULL == pBitmap->buffer
+         || NULL == pFileName )
+    {
+        return 0;
+    }
+    if ( NULL == pUsedHeader )
+    {
+        pCached = AVTGetCachedBitmapHeader( pBitmap );
+        if ( NULL == pCached )
+        {
+            return 0;
+        }
+        pUsedHeader = &pCached->header;
+    }
+    // The header has to be made for this image
+    if (    pUsedHeader->rowSize * pBitmap->height != pBitmap->bufferSize
+         || pUsedHeader->size + pBitmap->bufferSize + pUsedHeader->padLength * pBitmap->height != pUsedHeader->fileSize )
+    {
+        return 0;
+    }
+
+    nPaddedRowSize = pUsedHeader->rowSize + pUsedHeader->padLength;
+    if ( ColorCodeRGB24 == pBitmap->colorCode )
+    {
+        // Swapping needs a copy, but only of a few rows at a time
+        nRowsPerChunk = STAGING_SIZE / nPaddedRowSize;
+        if ( 0 == nRowsPerChunk )
+        {
+            nRowsPerChunk = 1;
+        }
+        if ( nRowsPerChunk > pBitmap->height )
+        {
+            nRowsPerChunk = pBitmap->height;
+        }
+        pStaging = (unsigned char*)g_pBitmapAlloc( nRowsPerChunk * nPaddedRowSize, g_pBitmapContext );
+        if ( NULL == pStaging )
+        {
+            return 0;
+        }
+    }
+
+#ifdef _WIN32
+    file = _open( pFileName, _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE );
+#else
+    file = open( pFileName, O_WRONLY | O_CREAT | O_TRUNC, 0644 );
+#endif
+    if ( 0 > file )
+    {
+        if ( NULL != pStaging )
+        {
+            g_pBitmapFree( pStaging, g_pBitmapContext );
+        }
+        return 0;
+    }
+
+    vectors[0].iov_base = (void*)pUsedHeader->data;
+    vectors[0].iov_len  = pUsedHeader->size;
+    nVectors            = 1;
+    pCurSrc             = (const unsigned char*)pBitmap->buffer;
+
+    if ( NULL != pStaging )
+    {
+        // RGB -> BGR (a Windows bitmap is BGR)
+        for ( y = 0; y < pBitmap->height && 0 != bResult; y += nRows )
+        {
+            nRows = pBitmap->height - y;
+            if ( nRows > nRowsPerChunk )
+            {
+                nRows = nRowsPerChunk;
+            }
+            {
+                AVT::VmbAPI::Examples::TraceScope trace( "Convert" );
+                nConvertStart = AVT::VmbAPI::Examples::GetLatencyClock();
+                pCurStaging = pStaging;
+                for ( i = 0; i < nRows; ++i )
+                {
+                    AVTSwapRGB( pCurSrc, pCurStaging, pBitmap->width );
+                    pCurSrc     += pUsedHeader->rowSize;
+                    pCurStaging += pUsedHeader->rowSize;
+                    memset( pCurStaging, 0, pUsedHeader->padLength );
+                    pCurStaging += pUsedHeader->padLength;
+                }
+                nConvertNS += AVT::VmbAPI::Examples::GetLatencyClock() - nConvertStart;
+            }
+            vectors[nVectors].iov_base  = pStaging;
+            vectors[nVectors].iov_len   = nRows * nPaddedRowSize;
+            bResult = AVTWriteVectors( file, vectors, nVectors + 1 );
+            nVectors = 0;
+        }
+        // The chunks of one image count as one conversion
+        AVT::VmbAPI::Examples::LatencyMonitor::GetDefault().Record( AVT::VmbAPI::Examples::LatencyStageConvert, nConvertNS );
+    }
+    else if ( 0 == pUsedHeader->padLength )
+    {
+        // The pixels go to the file as they are
+        vectors[1].iov_base = (void*)pCurSrc;
+        vectors[1].iov_len  = pBitmap->bufferSize;
+        bResult = AVTWriteVectors( file, vectors, 2 );
+    }
+    else
+    {
+        // Every row is followed by its padding
+        for ( y = 0; y < pBitmap->height && 0 != bResult; ++y, pCurSrc += pUsedHeader->rowSize )
+        {
+            vectors[nVectors].iov_base      = (void*)pCurSrc;
+            vectors[nVectors].iov_len       = pUsedHeader->rowSize;
+            vectors[nVectors + 1].iov_base  = (void*)padding;
+            vectors[nVectors + 1].iov_len   = pUsedHeader->padLength;
+            nVectors += 2;
+            if (    MAX_IO_VECTORS < nVectors + 2
+                 || pBitmap->height == y + 1 )
+            {
+                bResult = AVTWriteVectors( file, vectors, nVectors );
+                nVectors = 0;
+            }
+        }
+    }
+
+#ifdef _WIN32
+    if ( 0 != _close( file ))
+#else
+    if ( 0 != close( file ))
+#endif
+    {
+        bResult = 0;
+    }
+    if ( NULL != pStaging )
+    {
+        g_pBitmapFree( pStaging, g_pBitmapContext );
+    }
+    if ( 0 != bResult )
+    {
+        AVT::VmbAPI::Examples::WriteMetrics::GetDefault().pBytesWritten->Add( pUsedHeader->fileSize );
+    }
+    return bResult;
+}
@@ -45,6 +45,73 @@ typedef struct
     ColorCode       colorCode;
 } AVTBitmap;
 
+// The largest header: file header, info header and a palette of 256 colors
+enum { AVT_BITMAP_MAX_HEADER_SIZE = 54 + 256 * 4, };
+
+typedef struct
+{
+    unsigned char   data[AVT_BITMAP_MAX_HEADER_SIZE];   // File header, info header and palette
+    unsigned long   size;                               // The number of valid bytes in data, the offset of the pixels in the file
+    unsigned long   fileSize;                           // The size of the whole bitmap file
+    unsigned long   rowSize;                            // The size of an image row without padding
+    unsigned long   padLength;                          // The number of padding bytes after every row
+} AVTBitmapHeader;
+
+//
+// Allocates and frees the memory of bitmaps
+//
+typedef void* (*AVTBitmapAllocFunc)( unsigned long nSize, void* pContext );
+typedef void  (*AVTBitmapFreeFunc)( void* pBuffer, void* pContext );
+
+//
+// Sets the functions AVTCreateBitmap and AVTReleaseBitmap use for the bitmap memory
+// and AVTWriteImageToFile uses for its staging buffer (e.g. a buffer pool).
+// Call this before creating bitmaps, not while bitmaps are in use.
+//
+// Parameters:
+//  [in]    pAlloc          The allocation function, NULL for malloc
+//  [in]    pFree           The function that frees what pAlloc returned, NULL for free
+//  [in]    pContext        Handed to both functions
+//
+void AVTSetBitmapAllocator( AVTBitmapAllocFunc pAlloc, AVTBitmapFreeFunc pFree, void* pContext );
+
+// The least image data per stripe AVTCreateBitmap converts in parallel, by default
+enum { AVT_BITMAP_DEFAULT_MIN_STRIPE_SIZE = 512 * 1024, };
+
+//
+// Runs pTask( 0, pTaskContext ) to pTask( nCount - 1, pTaskContext ), possibly in parallel,
+// and returns once all of them have finished
+//
+typedef void (*AVTBitmapTaskFunc)( unsigned long nIndex, void* pTaskContext );
+typedef void (*AVTBitmapParallelForFunc)( unsigned long nCount, AVTBitmapTaskFunc pTask, void* pTaskContext, void* pContext );
+
+//
+// Sets the function AVTCreateBitmap uses to convert horizontal stripes of large images in parallel
+// (e.g. on a thread pool). Call this before creating bitmaps, not while bitmaps are created.
+// The bitmap is the same as the one converted on the calling thread.
+//
+// Parameters:
+//  [in]    pParallelFor    The function that runs the stripes, NULL to convert on the calling thread
+//  [in]    pContext        Handed to pParallelFor
+//  [in]    nMinStripeSize  The least bytes of image data per stripe, smaller images are not split (0 for the default)
+//
+void AVTSetBitmapParallelFor( AVTBitmapParallelForFunc pParallelFor, void* pContext, unsigned long nMinStripeSize );
+
+//
+// Creates the header and color palette of a MS Windows bitmap.
+// The header only depends on the geometry and can be reused for all images of that geometry.
+// Bitmaps have no 16 bit gray, ColorCodeMono16 is refused.
+//
+// Parameters:
+//  [in]    pBitmap         Width, height, color code and image size (bufferSize) of the bitmap
+//  [out]   pHeader         The header that will get filled
+//
+// Returns:
+//  0 in case of error
+//  1 in case of success
+//
+unsigned char AVTCreateBitmapHeader( AVTBitmap const * const pBitmap, AVTBitmapHeader * const pHeader );
+
 //
 // Creates a MS Windows bitmap with header and color palette.
 // Fills it with the content of the given byte buffer
@@ -84,4 +151,20 @@ unsigned char AVTReleaseBitmap( AVTBitmap * const pBitmap );
 //
 unsigned char AVTWriteBitmapToFile( AVTBitmap const * const pBitmap, char const * const pFileName );
 
+//
+// Writes an image straight from its buffer to a bitmap file without creating the bitmap in memory.
+// Header and rows go to the file with scatter-gather I/O, row padding comes from a small zero buffer.
+// Mono8 and BGR24 pixels are never copied, RGB24 rows are swapped to BGR in a small staging buffer.
+//
+// Parameters:
+//  [in] pBitmap            Width, height, color code, image size (bufferSize) and pixels (buffer) of the image
+//  [in] pHeader            The header created by AVTCreateBitmapHeader for this geometry, NULL to use the cached header of the geometry
+//  [in] pFileName          The destination (complete path) where to write the bitmap to
+//
+// Returns:
+//  0 in case of error
+//  1 in case of success
+//
+unsigned char AVTWriteImageToFile( AVTBitmap const * const pBitmap, AVTBitmapHeader const * const pHeader, char const * const pFileName );
+
 #endif
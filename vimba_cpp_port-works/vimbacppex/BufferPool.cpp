@@ -0,0 +1,347 @@
+/*=============================================================================
+  Copyright (C) 2013 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        BufferPool.cpp
+
+  Description: A pool of aligned image buffers that recycles them by size so
+               steady state acquisition and bitmap creation do not allocate.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <malloc.h>
+#else
+#include <sys/mman.h>
+#endif
+
+#include "BufferPool.h"
+#include "Bitmap.h"
+#include "ImageFrame.h"
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+enum { PREFAULT_STRIDE = 4096, };
+
+struct BufferPool::State
+{
+    struct Block
+    {
+        size_t  nSize;                  // The size the block was allocated with
+        bool    bIsHugePage;            // Allocated with huge pages, needs to be freed differently
+        bool    bIsIdle;                // Waiting in m_idle
+    };
+
+    State( size_t nAlignment, VmbUint32_t nFlags )
+        : nAlignment( nAlignment )
+        , nFlags( nFlags )
+        , bIsPoolAlive( true )
+    {
+        memset( &statistics, 0, sizeof( statistics ));
+    }
+
+    ~State()
+    {
+        FreeIdle();
+    }
+
+    void* Acquire( size_t nSize )
+    {
+        // Round up so nearly equal requests share buffers
+        nSize = ( nSize + nAlignment - 1 ) & ~( nAlignment - 1 );
+        if ( 0 == nSize )
+        {
+            nSize = nAlignment;
+        }
+
+        std::lock_guard<std::mutex> lock( mutex );
+        ++statistics.nAcquisitions;
+        std::map< size_t, std::vector<void*> >::iterator iter = idle.find( nSize );
+        if (    idle.end() != iter
+             && !iter->second.empty() )
+        {
+            void *pBuffer = iter->second.back();
+            iter->second.pop_back();
+            blocks[pBuffer].bIsIdle = false;
+            ++statistics.nRecycled;
+            return pBuffer;
+        }
+
+        Block block;
+        block.nSize = nSize;
+        block.bIsIdle = false;
+        void *pBuffer = Allocate( nSize, block.bIsHugePage );
+        if ( NULL == pBuffer )
+        {
+            return NULL;
+        }
+        blocks[pBuffer] = block;
+        ++statistics.nSystemAllocations;
+        statistics.nBytesAllocated += nSize;
+        if ( block.bIsHugePage )
+        {
+            ++statistics.nHugePageBuffers;
+        }
+        return pBuffer;
+    }
+
+    void Release( void *pBuffer )
+    {
+        if ( NULL == pBuffer )
+        {
+            return;
+        }
+        std::lock_guard<std::mutex> lock( mutex );
+        std::unordered_map<void*, Block>::iterator iter = blocks.find( pBuffer );
+        if (    blocks.end() == iter
+             || iter->second.bIsIdle )
+        {
+            // Not ours or released twice
+            return;
+        }
+        if ( bIsPoolAlive )
+        {
+            iter->second.bIsIdle = true;
+            idle[iter->second.nSize].push_back( pBuffer );
+        }
+        else
+        {
+            FreeBlock( iter );
+        }
+    }
+
+    void FreeIdle()
+    {
+        for (   std::map< size_t, std::vector<void*> >::iterator iter = idle.begin();
+                idle.end() != iter;
+                ++iter )
+        {
+            for (   std::vector<void*>::const_iterator iterBuffer = iter->second.begin();
+                    iter->second.end() != iterBuffer;
+                    ++iterBuffer )
+            {
+                FreeBlock( blocks.find( *iterBuffer ));
+            }
+        }
+        idle.clear();
+    }
+
+    void FreeBlock( std::unordered_map<void*, Block>::iterator iter )
+    {
+        Free( iter->first, iter->second.nSize, iter->second.bIsHugePage );
+        ++statistics.nSystemFrees;
+        statistics.nBytesAllocated -= iter->second.nSize;
+        if ( iter->second.bIsHugePage )
+        {
+            --statistics.nHugePageBuffers;
+        }
+        blocks.erase( iter );
+    }
+
+    void* Allocate( size_t nSize, bool &rbIsHugePage ) const
+    {
+        void *pBuffer = NULL;
+        rbIsHugePage = false;
+#ifdef _WIN32
+        if ( 0 != ( nFlags & BufferPoolHugePages ))
+        {
+            // Needs the "Lock pages in memory" privilege and a multiple of the large page size
+            const SIZE_T nLargePage = GetLargePageMinimum();
+            if (    0 != nLargePage
+                 && 0 == nSize % nLargePage )
+            {
+                pBuffer = VirtualAlloc( NULL, nSize, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE );
+                rbIsHugePage = NULL != pBuffer;
+            }
+        }
+        if ( NULL == pBuffer )
+        {
+            pBuffer = _aligned_malloc( nSize, nAlignment );
+        }
+#else
+        if ( 0 != posix_memalign( &pBuffer, nAlignment < sizeof( void* ) ? sizeof( void* ) : nAlignment, nSize ))
+        {
+            pBuffer = NULL;
+        }
+#ifdef MADV_HUGEPAGE
+        if (    NULL != pBuffer
+             && 0 != ( nFlags & BufferPoolHugePages ))
+        {
+            // Only a hint, transparent huge pages back the aligned part of the buffer if available
+            madvise( pBuffer, nSize, MADV_HUGEPAGE );
+        }
+#endif
+#endif
+        if (    NULL != pBuffer
+             && 0 != ( nFlags & BufferPoolPrefault ))
+        {
+            // Take the page faults now instead of on the first frame
+            volatile VmbUchar_t *pCursor = static_cast<VmbUchar_t*>( pBuffer );
+            for ( size_t i = 0; i < nSize; i += PREFAULT_STRIDE )
+            {
+                pCursor[i] = 0;
+            }
+        }
+        return pBuffer;
+    }
+
+    static void Free( void *pBuffer, size_t nSize, bool bIsHugePage )
+    {
+#ifdef _WIN32
+        if ( bIsHugePage )
+        {
+            VirtualFree( pBuffer, 0, MEM_RELEASE );
+        }
+        else
+        {
+            _aligned_free( pBuffer );
+        }
+#else
+        free( pBuffer );
+#endif
+        (void)nSize;
+        (void)bIsHugePage;
+    }
+
+    const size_t                                nAlignment;
+    const VmbUint32_t                           nFlags;
+    mutable std::mutex                          mutex;
+    // All buffers allocated from the system, by address
+    std::unordered_map<void*, Block>            blocks;
+    // The buffers waiting to be handed out again, by size
+    std::map< size_t, std::vector<void*> >      idle;
+    BufferPoolStatistics                        statistics;
+    bool                                        bIsPoolAlive;
+};
+
+//
+// Parameters:
+//  [in]    nAlignment          The alignment of the buffers, a power of two (e.g. BUFFER_ALIGNMENT_PAGE)
+//  [in]    nFlags              A combination of BufferPoolFlags
+//
+BufferPool::BufferPool( size_t nAlignment, VmbUint32_t nFlags )
+    : m_pState( new State( nAlignment, nFlags ))
+{
+}
+
+//
+// Frees all idle buffers. Buffers still in use are freed when they come back.
+//
+BufferPool::~BufferPool()
+{
+    std::lock_guard<std::mutex> lock( m_pState->mutex );
+    m_pState->bIsPoolAlive = false;
+    m_pState->FreeIdle();
+}
+
+//
+// Gets the pool used by the acquisition and by bitmap creation
+//
+BufferPool& BufferPool::GetDefault()
+{
+    static BufferPool pool;
+    return pool;
+}
+
+//
+// Gets a buffer of at least nSize bytes, recycling an idle one of that size if there is one
+//
+// Parameters:
+//  [in]    nSize               The size of the buffer in bytes
+//
+// Returns:
+//  The buffer, empty if the system is out of memory
+//
+BufferPtr BufferPool::Acquire( size_t nSize )
+{
+    VmbUchar_t *pBuffer = static_cast<VmbUchar_t*>( m_pState->Acquire( nSize ));
+    if ( NULL == pBuffer )
+    {
+        return BufferPtr();
+    }
+    std::shared_ptr<State> pState = m_pState;
+    return BufferPtr( pBuffer, [pState]( VmbUchar_t *pReleased ) { pState->Release( pReleased ); } );
+}
+
+BufferPtr BufferPool::Acquire( VmbUint32_t nWidth, VmbUint32_t nHeight, VmbPixelFormatType ePixelFormat )
+{
+    return Acquire( GetImageSize( nWidth, nHeight, ePixelFormat ));
+}
+
+//
+// The same for code that cannot hold a BufferPtr. Every buffer has to be given back with Release.
+//
+void* BufferPool::AcquireRaw( size_t nSize )
+{
+    return m_pState->Acquire( nSize );
+}
+
+void BufferPool::Release( void *pBuffer )
+{
+    m_pState->Release( pBuffer );
+}
+
+//
+// Frees all idle buffers
+//
+void BufferPool::Trim()
+{
+    std::lock_guard<std::mutex> lock( m_pState->mutex );
+    m_pState->FreeIdle();
+}
+
+//
+// Gets the counters of the pool
+//
+BufferPoolStatistics BufferPool::GetStatistics() const
+{
+    std::lock_guard<std::mutex> lock( m_pState->mutex );
+    return m_pState->statistics;
+}
+
+static void* AllocateBitmapBuffer( unsigned long nSize, void *pContext )
+{
+    return static_cast<BufferPool*>( pContext )->AcquireRaw( nSize );
+}
+
+static void FreeBitmapBuffer( void *pBuffer, void *pContext )
+{
+    static_cast<BufferPool*>( pContext )->Release( pBuffer );
+}
+
+//
+// Makes AVTCreateBitmap, AVTReleaseBitmap and the staging buffer of AVTWriteImageToFile use this pool
+//
+void BufferPool::UseForBitmaps()
+{
+    AVTSetBitmapAllocator( AllocateBitmapBuffer, FreeBitmapBuffer, this );
+}
+
+}}} // namespace AVT::VmbAPI::Examples
@@ -0,0 +1,138 @@
+/*=============================================================================
+  Copyright (C) 2013 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        BufferPool.h
+
+  Description: A pool of aligned image buffers that recycles them by size so
+               steady state acquisition and bitmap creation do not allocate.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#ifndef AVT_VMBAPI_EXAMPLES_BUFFERPOOL
+#define AVT_VMBAPI_EXAMPLES_BUFFERPOOL
+
+#include <memory>
+
+#include "VimbaCPP/Include/VimbaCPP.h"
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+// A buffer handed out by a BufferPool. It goes back to the pool when the last reference is gone.
+typedef std::shared_ptr<VmbUchar_t> BufferPtr;
+
+//
+// Options of a BufferPool
+//
+enum BufferPoolFlags
+{
+    BufferPoolPrefault  = 0x1,          // Touch every page of a new buffer so the first frame does not page fault
+    BufferPoolHugePages = 0x2,          // Try to back buffers with huge (large) pages, falls back to normal pages
+};
+
+enum { BUFFER_ALIGNMENT_CACHE_LINE = 64, };
+enum { BUFFER_ALIGNMENT_PAGE = 4096, };
+
+//
+// The counters of a BufferPool
+//
+struct BufferPoolStatistics
+{
+    VmbUint64_t     nSystemAllocations;     // Buffers allocated from the system
+    VmbUint64_t     nSystemFrees;           // Buffers given back to the system
+    VmbUint64_t     nAcquisitions;          // Buffers handed out
+    VmbUint64_t     nRecycled;              // Buffers handed out again without allocating
+    VmbUint64_t     nBytesAllocated;        // Bytes currently allocated from the system
+    VmbUint64_t     nHugePageBuffers;       // Buffers currently backed by huge pages
+};
+
+class BufferPool
+{
+  public:
+    //
+    // Parameters:
+    //  [in]    nAlignment          The alignment of the buffers, a power of two (e.g. BUFFER_ALIGNMENT_PAGE)
+    //  [in]    nFlags              A combination of BufferPoolFlags
+    //
+    explicit BufferPool( size_t nAlignment = BUFFER_ALIGNMENT_CACHE_LINE, VmbUint32_t nFlags = 0 );
+
+    //
+    // Frees all idle buffers. Buffers still in use are freed when they come back.
+    //
+    ~BufferPool();
+
+    //
+    // Gets the pool used by the acquisition and by bitmap creation
+    //
+    static BufferPool&  GetDefault();
+
+    //
+    // Gets a buffer of at least nSize bytes, recycling an idle one of that size if there is one
+    //
+    // Parameters:
+    //  [in]    nSize               The size of the buffer in bytes
+    //
+    // Returns:
+    //  The buffer, empty if the system is out of memory
+    //
+    BufferPtr           Acquire( size_t nSize );
+
+    //
+    // Gets a buffer for an image of the given geometry and pixel format
+    //
+    BufferPtr           Acquire( VmbUint32_t nWidth, VmbUint32_t nHeight, VmbPixelFormatType ePixelFormat );
+
+    //
+    // The same for code that cannot hold a BufferPtr. Every buffer has to be given back with Release.
+    //
+    void*               AcquireRaw( size_t nSize );
+    void                Release( void *pBuffer );
+
+    //
+    // Frees all idle buffers
+    //
+    void                Trim();
+
+    //
+    // Gets the counters of the pool
+    //
+    BufferPoolStatistics GetStatistics() const;
+
+    //
+    // Makes AVTCreateBitmap, AVTReleaseBitmap and the staging buffer of AVTWriteImageToFile use this pool
+    // (call before creating bitmaps, the pool has to outlive them)
+    //
+    void                UseForBitmaps();
+
+  private:
+    struct State;
+    // Buffers in use keep the state alive, so they can come back after the pool is gone
+    std::shared_ptr<State> m_pState;
+
+    // No copies
+    BufferPool( const BufferPool& );
+    BufferPool& operator=( const BufferPool& );
+};
+
+}}} // namespace AVT::VmbAPI::Examples
+
+#endif
@@ -0,0 +1,256 @@
+/*=============================================================================
+  Copyright (C) 2013 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        CameraBackend.h
+
+  Description: The interfaces ApiController uses to talk to cameras. They are
+               implemented on top of VimbaCPP as well as by simulated cameras
+               that work without any hardware attached.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#ifndef AVT_VMBAPI_EXAMPLES_CAMERABACKEND
+#define AVT_VMBAPI_EXAMPLES_CAMERABACKEND
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "VimbaCPP/Include/VimbaCPP.h"
+
+#include "CameraFeature.h"
+#include "ImageFrame.h"
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+//
+// Describes a camera as listed by a backend
+//
+struct CameraInfo
+{
+    std::string     strID;                  // The ID used to open the camera
+    std::string     strName;                // The name of the camera
+    std::string     strModel;               // The model name of the camera
+    std::string     strSerialNumber;        // The serial number of the camera
+};
+typedef std::vector<CameraInfo> CameraInfoVector;
+
+//
+// How the list of cameras changed
+//
+enum CameraListChange
+{
+    CameraPluggedIn,                        // The camera appeared
+    CameraPluggedOut,                       // The camera is gone
+    CameraChanged,                          // The camera is still there, but its description or state changed
+};
+typedef std::function<void( const CameraInfo &rInfo, CameraListChange eChange )> CameraListCallback;
+
+//
+// A step of bringing up a backend and its cameras, to see where cold-start time goes
+//
+struct StartupPhase
+{
+    std::string     strName;                // What was done
+    VmbUint32_t     nDurationUS;            // How long it took in microseconds
+};
+typedef std::vector<StartupPhase> StartupPhaseVector;
+
+//
+// An opened camera
+//
+class ICamera
+{
+  public:
+    virtual ~ICamera() {}
+
+    //
+    // Gets the ID the camera was opened with
+    //
+    virtual const std::string&  GetID() const = 0;
+
+    //
+    // Closes the camera. Stops a running acquisition first.
+    //
+    // Returns:
+    //  An API status code
+    //
+    virtual VmbErrorType    Close() = 0;
+
+    //
+    // Reads or writes an integer (or enumeration) feature
+    //
+    // Parameters:
+    //  [in]    pName               The name of the feature
+    //  [in]    nValue              The value to write
+    //  [out]   rnValue             The value read
+    //
+    // Returns:
+    //  An API status code
+    //
+    virtual VmbErrorType    SetFeatureValue( const char *pName, VmbInt64_t nValue ) = 0;
+    virtual VmbErrorType    GetFeatureValue( const char *pName, VmbInt64_t &rnValue ) = 0;
+
+    //
+    // Reads or writes a float feature
+    //
+    // Parameters:
+    //  [in]    pName               The name of the feature
+    //  [in]    dValue              The value to write
+    //  [out]   rdValue             The value read
+    //
+    // Returns:
+    //  An API status code
+    //
+    virtual VmbErrorType    SetFeatureValue( const char *pName, double dValue ) = 0;
+    virtual VmbErrorType    GetFeatureValue( const char *pName, double &rdValue ) = 0;
+
+    //
+    // Runs a command feature or checks whether it has finished
+    //
+    // Parameters:
+    //  [in]    pName               The name of the command feature
+    //  [out]   rbIsDone            True if the command has finished
+    //
+    // Returns:
+    //  An API status code
+    //
+    virtual VmbErrorType    RunFeatureCommand( const char *pName ) = 0;
+    virtual VmbErrorType    IsFeatureCommandDone( const char *pName, bool &rbIsDone ) = 0;
+
+    //
+    // The same accessors for the features resolved when the camera was opened.
+    // These skip the lookup by name and are meant for hot paths.
+    //
+    // Parameters:
+    //  [in]    eFeature            The feature to work on
+    //
+    // Returns:
+    //  An API status code, VmbErrorNotFound if the camera does not have the feature
+    //
+    virtual VmbErrorType    SetFeatureValue( CameraFeature eFeature, VmbInt64_t nValue ) = 0;
+    virtual VmbErrorType    GetFeatureValue( CameraFeature eFeature, VmbInt64_t &rnValue ) = 0;
+    virtual VmbErrorType    SetFeatureValue( CameraFeature eFeature, double dValue ) = 0;
+    virtual VmbErrorType    GetFeatureValue( CameraFeature eFeature, double &rdValue ) = 0;
+    virtual VmbErrorType    RunFeatureCommand( CameraFeature eFeature ) = 0;
+    virtual VmbErrorType    IsFeatureCommandDone( CameraFeature eFeature, bool &rbIsDone ) = 0;
+
+    //
+    // Acquires a single image with the current settings
+    //
+    // Parameters:
+    //  [out]   rFrame              The acquired image. Its memory is kept alive by the frame itself.
+    //  [in]    nTimeout            The time to wait for the image in milliseconds
+    //
+    // Returns:
+    //  An API status code
+    //
+    virtual VmbErrorType    AcquireSingleImage( ImageFrame &rFrame, VmbUint32_t nTimeout ) = 0;
+
+    //
+    // Starts a continuous acquisition into a ring of frames
+    //
+    // Parameters:
+    //  [in]    rCallback           The function that gets every completed frame
+    //  [in]    nFrameCount         The number of frames in the ring
+    //
+    // Returns:
+    //  An API status code
+    //
+    virtual VmbErrorType    StartStreaming( const FrameCallback &rCallback, VmbUint32_t nFrameCount ) = 0;
+
+    //
+    // Stops a continuous acquisition and waits for the last callback to return
+    //
+    // Returns:
+    //  An API status code
+    //
+    virtual VmbErrorType    StopStreaming() = 0;
+};
+typedef std::shared_ptr<ICamera> ICameraPtr;
+
+//
+// A system that knows a set of cameras
+//
+class ICameraBackend
+{
+  public:
+    virtual ~ICameraBackend() {}
+
+    //
+    // Starts and shuts down the backend
+    //
+    // Parameters:
+    //  [out]   rPhases             Gets the steps of the startup and how long they took appended
+    //
+    // Returns:
+    //  An API status code
+    //
+    virtual VmbErrorType    Startup( StartupPhaseVector &rPhases ) = 0;
+    virtual void            Shutdown() = 0;
+
+    //
+    // Gets all cameras known to the backend
+    //
+    // Parameters:
+    //  [out]   rCameras            The list of cameras
+    //
+    // Returns:
+    //  An API status code
+    //
+    virtual VmbErrorType    GetCameras( CameraInfoVector &rCameras ) = 0;
+
+    //
+    // Reports cameras that get plugged in or out while the backend runs
+    //
+    // Parameters:
+    //  [in]    rCallback           Gets every change (called from a thread of the backend), empty to stop reporting
+    //
+    // Returns:
+    //  VmbErrorNotSupported if the backend cannot report changes, else an API status code
+    //
+    virtual VmbErrorType    SetCameraListCallback( const CameraListCallback &rCallback ) = 0;
+
+    //
+    // Opens the camera with the given ID
+    //
+    // Parameters:
+    //  [in]    rStrCameraID        The ID of the camera to open
+    //  [out]   rpCamera            The opened camera
+    //
+    // Returns:
+    //  An API status code
+    //
+    virtual VmbErrorType    OpenCamera( const std::string &rStrCameraID, ICameraPtr &rpCamera ) = 0;
+
+    //
+    // Gets the version of the backend
+    //
+    virtual std::string     GetVersion() const = 0;
+};
+typedef std::shared_ptr<ICameraBackend> ICameraBackendPtr;
+
+}}} // namespace AVT::VmbAPI::Examples
+
+#endif
@@ -0,0 +1,111 @@
+/*=============================================================================
+  Copyright (C) 2013 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        CameraFeature.h
+
+  Description: The features the examples work with, keyed by an enumeration so
+               hot paths can use handles resolved once when the camera opens.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#ifndef AVT_VMBAPI_EXAMPLES_CAMERAFEATURE
+#define AVT_VMBAPI_EXAMPLES_CAMERAFEATURE
+
+#include <cstring>
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+//
+// The features a camera resolves when it is opened.
+// Keep in sync with the names in GetCameraFeatureName().
+//
+enum CameraFeature
+{
+    FeatureWidth,
+    FeatureHeight,
+    FeaturePixelFormat,
+    FeaturePayloadSize,
+    FeatureGVSPPacketSize,
+    FeatureGVSPAdjustPacketSize,
+    FeatureAcquisitionStart,
+    FeatureAcquisitionStop,
+    FeatureAcquisitionFrameRate,
+    FeatureExposureTime,
+    FeatureGain,
+    FeatureCount,
+};
+
+//
+// Gets the SFNC name of a feature
+//
+// Parameters:
+//  [in]    eFeature            The feature
+//
+// Returns:
+//  The name of the feature
+//
+inline const char* GetCameraFeatureName( CameraFeature eFeature )
+{
+    static const char* const names[FeatureCount] =
+    {
+        "Width",
+        "Height",
+        "PixelFormat",
+        "PayloadSize",
+        "GVSPPacketSize",
+        "GVSPAdjustPacketSize",
+        "AcquisitionStart",
+        "AcquisitionStop",
+        "AcquisitionFrameRate",
+        "ExposureTime",
+        "Gain",
+    };
+    return names[eFeature];
+}
+
+//
+// Looks up the feature with the given name
+//
+// Parameters:
+//  [in]    pName               The name of the feature
+//  [out]   reFeature           The feature
+//
+// Returns:
+//  False if the feature is not one of the known features
+//
+inline bool FindCameraFeature( const char *pName, CameraFeature &reFeature )
+{
+    for ( int i = 0; i < FeatureCount; ++i )
+    {
+        if ( 0 == std::strcmp( pName, GetCameraFeatureName( static_cast<CameraFeature>( i ))))
+        {
+            reFeature = static_cast<CameraFeature>( i );
+            return true;
+        }
+    }
+    return false;
+}
+
+}}} // namespace AVT::VmbAPI::Examples
+
+#endif
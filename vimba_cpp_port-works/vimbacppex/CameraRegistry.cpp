@@ -0,0 +1,308 @@
+/*=============================================================================
+  Copyright (C) 2013 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        CameraRegistry.cpp
+
+  Description: Keeps the list of cameras of a backend in memory and up to date
+               with hot-plug events, so it can be read without asking the backend.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#include <chrono>
+
+#include "CameraRegistry.h"
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+// How often a listing is repeated because cameras came or went while it ran, the last one is published regardless
+enum { MAX_LISTING_ATTEMPTS = 3, };
+
+namespace {
+
+bool IsSameCamera( const CameraInfo &rA, const CameraInfo &rB )
+{
+    return      rA.strID == rB.strID
+            &&  rA.strName == rB.strName
+            &&  rA.strModel == rB.strModel
+            &&  rA.strSerialNumber == rB.strSerialNumber;
+}
+
+bool IsSameList( const CameraInfoVector &rA, const CameraInfoVector &rB )
+{
+    if ( rA.size() != rB.size() )
+    {
+        return false;
+    }
+    for ( size_t i = 0; i < rA.size(); ++i )
+    {
+        if ( !IsSameCamera( rA[i], rB[i] ))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+CameraRegistry::CameraRegistry()
+    : m_nEventCount( 0 )
+    , m_nListingCount( 0 )
+    , m_bStopRefresh( false )
+    , m_nRefreshIntervalMS( 0 )
+{
+}
+
+CameraRegistry::~CameraRegistry()
+{
+    Stop();
+}
+
+//
+// Starts following the cameras of the given (started) backend
+// Listens to its hot-plug events, or lists the cameras again every nRefreshIntervalMS if it has none
+//
+// Parameters:
+//  [in]    pBackend            The backend
+//  [in]    nRefreshIntervalMS  How often to list the cameras without events, 0 for never
+//
+void CameraRegistry::Start( const ICameraBackendPtr &pBackend, VmbUint32_t nRefreshIntervalMS )
+{
+    Stop();
+    {
+        std::lock_guard<std::mutex> listLock( m_listMutex );
+        std::lock_guard<std::mutex> updateLock( m_updateMutex );
+        m_pBackend = pBackend;
+        m_nEventCount = 0;
+        m_nListingCount = 0;
+    }
+
+    // The list itself is taken by the first reader
+    const CameraListCallback callback = [this]( const CameraInfo &rInfo, CameraListChange eChange )
+    {
+        OnCameraListChanged( rInfo, eChange );
+    };
+    if (    VmbErrorSuccess != pBackend->SetCameraListCallback( callback )
+         && 0 != nRefreshIntervalMS )
+    {
+        m_bStopRefresh = false;
+        m_nRefreshIntervalMS = nRefreshIntervalMS;
+        m_refreshThread = std::thread( &CameraRegistry::RefreshPeriodically, this );
+    }
+}
+
+//
+// Stops following the backend and forgets its cameras, has to be called before the backend shuts down
+//
+void CameraRegistry::Stop()
+{
+    ICameraBackendPtr pBackend;
+    {
+        std::lock_guard<std::mutex> lock( m_listMutex );
+        pBackend = m_pBackend;
+    }
+    if ( !pBackend )
+    {
+        return;
+    }
+    pBackend->SetCameraListCallback( CameraListCallback() );
+
+    {
+        std::lock_guard<std::mutex> lock( m_updateMutex );
+        m_bStopRefresh = true;
+        m_refreshCondition.notify_all();
+    }
+    if ( m_refreshThread.joinable() )
+    {
+        m_refreshThread.join();
+    }
+
+    std::lock_guard<std::mutex> listLock( m_listMutex );
+    std::lock_guard<std::mutex> updateLock( m_updateMutex );
+    m_pBackend.reset();
+    std::atomic_store( &m_pSnapshot, CameraInfoSnapshot() );
+}
+
+//
+// Gets the current list of cameras
+// Only the first call after the start asks the backend, later ones are served from memory without locking
+//
+// Returns:
+//  The cameras, NULL if they could not be listed
+//
+CameraInfoSnapshot CameraRegistry::GetSnapshot()
+{
+    CameraInfoSnapshot pSnapshot = std::atomic_load( &m_pSnapshot );
+    if ( pSnapshot )
+    {
+        return pSnapshot;
+    }
+
+    // Whoever comes first lists the cameras, the others wait for the list
+    std::lock_guard<std::mutex> lock( m_listMutex );
+    pSnapshot = std::atomic_load( &m_pSnapshot );
+    if (    !pSnapshot
+         && VmbErrorSuccess == ListCameras() )
+    {
+        pSnapshot = std::atomic_load( &m_pSnapshot );
+    }
+    return pSnapshot;
+}
+
+//
+// Lists the cameras again and publishes the new list if it differs
+//
+// Returns:
+//  An API status code
+//
+VmbErrorType CameraRegistry::Refresh()
+{
+    std::lock_guard<std::mutex> lock( m_listMutex );
+    return ListCameras();
+}
+
+//
+// Gets how often the backend was asked for its cameras since the start
+//
+VmbUint64_t CameraRegistry::GetListingCount() const
+{
+    return m_nListingCount;
+}
+
+//
+// Asks the backend for its cameras and publishes them if they differ from the published ones, m_listMutex must be held
+//
+// Returns:
+//  An API status code
+//
+VmbErrorType CameraRegistry::ListCameras()
+{
+    if ( !m_pBackend )
+    {
+        return VmbErrorApiNotStarted;
+    }
+
+    for ( int nAttempt = 1; ; ++nAttempt )
+    {
+        VmbUint64_t nEventCount;
+        {
+            std::lock_guard<std::mutex> lock( m_updateMutex );
+            nEventCount = m_nEventCount;
+        }
+
+        // Outside the update lock, events must not wait for a discovery
+        CameraInfoVector cameras;
+        VmbErrorType res = m_pBackend->GetCameras( cameras );
+        ++m_nListingCount;
+        if ( VmbErrorSuccess != res )
+        {
+            return res;
+        }
+
+        std::lock_guard<std::mutex> lock( m_updateMutex );
+        // A camera that came or went while listing may or may not be in the list, so list again
+        if (    nEventCount != m_nEventCount
+             && nAttempt < MAX_LISTING_ATTEMPTS )
+        {
+            continue;
+        }
+        const CameraInfoSnapshot pSnapshot = std::atomic_load( &m_pSnapshot );
+        if (    !pSnapshot
+             || !IsSameList( *pSnapshot, cameras ))
+        {
+            std::atomic_store( &m_pSnapshot, CameraInfoSnapshot( new CameraInfoVector( std::move( cameras ))));
+        }
+        return VmbErrorSuccess;
+    }
+}
+
+//
+// Applies a hot-plug event to the published list (called from a thread of the backend)
+//
+// Parameters:
+//  [in]    rInfo               The camera
+//  [in]    eChange             What happened to it
+//
+void CameraRegistry::OnCameraListChanged( const CameraInfo &rInfo, CameraListChange eChange )
+{
+    std::lock_guard<std::mutex> lock( m_updateMutex );
+    ++m_nEventCount;
+
+    const CameraInfoSnapshot pSnapshot = std::atomic_load( &m_pSnapshot );
+    if ( !pSnapshot )
+    {
+        // Nobody asked for the list yet, the first listing will see the change
+        return;
+    }
+
+    // Readers may still hold the old list, so the change goes into a copy
+    std::shared_ptr<CameraInfoVector> pCameras( new CameraInfoVector( *pSnapshot ));
+    CameraInfoVector::iterator iter = pCameras->begin();
+    while (    pCameras->end() != iter
+            && rInfo.strID != iter->strID )
+    {
+        ++iter;
+    }
+    if ( CameraPluggedOut == eChange )
+    {
+        if ( pCameras->end() == iter )
+        {
+            return;
+        }
+        pCameras->erase( iter );
+    }
+    else if ( pCameras->end() != iter )
+    {
+        if ( IsSameCamera( *iter, rInfo ))
+        {
+            return;
+        }
+        *iter = rInfo;
+    }
+    else
+    {
+        pCameras->push_back( rInfo );
+    }
+    std::atomic_store( &m_pSnapshot, CameraInfoSnapshot( pCameras ));
+}
+
+//
+// Calls Refresh every m_nRefreshIntervalMS (runs on m_refreshThread)
+//
+void CameraRegistry::RefreshPeriodically()
+{
+    std::unique_lock<std::mutex> lock( m_updateMutex );
+    while ( !m_bStopRefresh )
+    {
+        m_refreshCondition.wait_for( lock, std::chrono::milliseconds( m_nRefreshIntervalMS ));
+        if ( m_bStopRefresh )
+        {
+            break;
+        }
+        lock.unlock();
+        Refresh();
+        lock.lock();
+    }
+}
+
+}}} // namespace AVT::VmbAPI::Examples
@@ -0,0 +1,140 @@
+/*=============================================================================
+  Copyright (C) 2013 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        CameraRegistry.h
+
+  Description: Keeps the list of cameras of a backend in memory and up to date
+               with hot-plug events, so it can be read without asking the backend.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#ifndef AVT_VMBAPI_EXAMPLES_CAMERAREGISTRY
+#define AVT_VMBAPI_EXAMPLES_CAMERAREGISTRY
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "VimbaCPP/Include/VimbaCPP.h"
+
+#include "CameraBackend.h"
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+//
+// A list of cameras that never changes once published, a change publishes a new one
+//
+typedef std::shared_ptr<const CameraInfoVector> CameraInfoSnapshot;
+
+class CameraRegistry
+{
+  public:
+    CameraRegistry();
+
+    ~CameraRegistry();
+
+    //
+    // Starts following the cameras of the given (started) backend
+    // Listens to its hot-plug events, or lists the cameras again every nRefreshIntervalMS if it has none
+    //
+    // Parameters:
+    //  [in]    pBackend            The backend
+    //  [in]    nRefreshIntervalMS  How often to list the cameras without events, 0 for never
+    //
+    void                Start( const ICameraBackendPtr &pBackend, VmbUint32_t nRefreshIntervalMS );
+
+    //
+    // Stops following the backend and forgets its cameras, has to be called before the backend shuts down
+    //
+    void                Stop();
+
+    //
+    // Gets the current list of cameras
+    // Only the first call after the start asks the backend, later ones are served from memory without locking
+    //
+    // Returns:
+    //  The cameras, NULL if they could not be listed
+    //
+    CameraInfoSnapshot  GetSnapshot();
+
+    //
+    // Lists the cameras again and publishes the new list if it differs
+    //
+    // Returns:
+    //  An API status code
+    //
+    VmbErrorType        Refresh();
+
+    //
+    // Gets how often the backend was asked for its cameras since the start
+    //
+    VmbUint64_t         GetListingCount() const;
+
+  private:
+    //
+    // Asks the backend for its cameras and publishes them if they differ from the published ones, m_listMutex must be held
+    //
+    // Returns:
+    //  An API status code
+    //
+    VmbErrorType        ListCameras();
+
+    //
+    // Applies a hot-plug event to the published list (called from a thread of the backend)
+    //
+    // Parameters:
+    //  [in]    rInfo               The camera
+    //  [in]    eChange             What happened to it
+    //
+    void                OnCameraListChanged( const CameraInfo &rInfo, CameraListChange eChange );
+
+    //
+    // Calls Refresh every m_nRefreshIntervalMS (runs on m_refreshThread)
+    //
+    void                RefreshPeriodically();
+
+    ICameraBackendPtr           m_pBackend;
+    // The published list, read with std::atomic_load and replaced with std::atomic_store
+    CameraInfoSnapshot          m_pSnapshot;
+    // Serializes listing the cameras, so many first readers cause one listing only
+    std::mutex                  m_listMutex;
+    // Serializes publishing, counts the events so a listing knows it may have missed one
+    std::mutex                  m_updateMutex;
+    VmbUint64_t                 m_nEventCount;
+    std::atomic<VmbUint64_t>    m_nListingCount;
+    // Lists the cameras in the background if the backend has no events
+    std::thread                 m_refreshThread;
+    std::condition_variable     m_refreshCondition;
+    bool                        m_bStopRefresh;
+    VmbUint32_t                 m_nRefreshIntervalMS;
+
+    // No copies
+    CameraRegistry( const CameraRegistry& );
+    CameraRegistry& operator=( const CameraRegistry& );
+};
+
+}}} // namespace AVT::VmbAPI::Examples
+
+#endif
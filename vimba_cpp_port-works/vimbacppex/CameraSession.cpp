@@ -0,0 +1,243 @@
+/*=============================================================================
+  Copyright (C) 2013 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        CameraSession.cpp
+
+  Description: An opened and configured camera that stays open across
+               acquisitions and only writes features whose value changed.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#include "CameraSession.h"
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+CameraSession::CameraSession( const ICameraPtr &pCamera )
+    : m_pCamera( pCamera )
+    , m_tLastUse( Clock::now() )
+    , m_bIsStreaming( false )
+{
+    ForgetWrittenValues();
+}
+
+CameraSession::~CameraSession()
+{
+    Close();
+}
+
+//
+// Gets the camera of this session, empty after Close()
+//
+const ICameraPtr& CameraSession::GetCamera() const
+{
+    return m_pCamera;
+}
+
+//
+// Writes a feature unless the session already wrote the same value before
+//
+// Parameters:
+//  [in]    pName               The name of the feature
+//  [in]    nValue / dValue     The value to write
+//
+// Returns:
+//  An API status code
+//
+VmbErrorType CameraSession::SetFeatureValue( const char *pName, VmbInt64_t nValue )
+{
+    if ( !m_pCamera )
+    {
+        return VmbErrorDeviceNotOpen;
+    }
+    CameraFeature eFeature;
+    if ( FindCameraFeature( pName, eFeature ))
+    {
+        return SetFeatureValue( eFeature, nValue );
+    }
+    std::map<std::string, VmbInt64_t>::const_iterator iter = m_intValues.find( pName );
+    if (    m_intValues.end() != iter
+         && nValue == iter->second )
+    {
+        return VmbErrorSuccess;
+    }
+    VmbErrorType res = m_pCamera->SetFeatureValue( pName, nValue );
+    if ( VmbErrorSuccess == res )
+    {
+        m_intValues[pName] = nValue;
+    }
+    else
+    {
+        // We do not know what the camera holds now
+        m_intValues.erase( pName );
+    }
+    return res;
+}
+
+VmbErrorType CameraSession::SetFeatureValue( const char *pName, double dValue )
+{
+    if ( !m_pCamera )
+    {
+        return VmbErrorDeviceNotOpen;
+    }
+    CameraFeature eFeature;
+    if ( FindCameraFeature( pName, eFeature ))
+    {
+        return SetFeatureValue( eFeature, dValue );
+    }
+    std::map<std::string, double>::const_iterator iter = m_floatValues.find( pName );
+    if (    m_floatValues.end() != iter
+         && dValue == iter->second )
+    {
+        return VmbErrorSuccess;
+    }
+    VmbErrorType res = m_pCamera->SetFeatureValue( pName, dValue );
+    if ( VmbErrorSuccess == res )
+    {
+        m_floatValues[pName] = dValue;
+    }
+    else
+    {
+        // We do not know what the camera holds now
+        m_floatValues.erase( pName );
+    }
+    return res;
+}
+
+//
+// Writes a resolved feature unless the session already wrote the same value before
+//
+// Parameters:
+//  [in]    eFeature            The feature
+//  [in]    nValue / dValue     The value to write
+//
+// Returns:
+//  An API status code
+//
+VmbErrorType CameraSession::SetFeatureValue( CameraFeature eFeature, VmbInt64_t nValue )
+{
+    if ( !m_pCamera )
+    {
+        return VmbErrorDeviceNotOpen;
+    }
+    WrittenValue &rWritten = m_written[eFeature];
+    if (    rWritten.bHasInt
+         && nValue == rWritten.nValue )
+    {
+        return VmbErrorSuccess;
+    }
+    VmbErrorType res = m_pCamera->SetFeatureValue( eFeature, nValue );
+    // On failure we do not know what the camera holds now
+    rWritten.bHasInt = VmbErrorSuccess == res;
+    rWritten.nValue = nValue;
+    return res;
+}
+
+VmbErrorType CameraSession::SetFeatureValue( CameraFeature eFeature, double dValue )
+{
+    if ( !m_pCamera )
+    {
+        return VmbErrorDeviceNotOpen;
+    }
+    WrittenValue &rWritten = m_written[eFeature];
+    if (    rWritten.bHasFloat
+         && dValue == rWritten.dValue )
+    {
+        return VmbErrorSuccess;
+    }
+    VmbErrorType res = m_pCamera->SetFeatureValue( eFeature, dValue );
+    // On failure we do not know what the camera holds now
+    rWritten.bHasFloat = VmbErrorSuccess == res;
+    rWritten.dValue = dValue;
+    return res;
+}
+
+//
+// Closes the camera and forgets all written feature values
+//
+// Returns:
+//  An API status code
+//
+VmbErrorType CameraSession::Close()
+{
+    if ( !m_pCamera )
+    {
+        return VmbErrorSuccess;
+    }
+    VmbErrorType res = m_pCamera->Close();
+    m_pCamera.reset();
+    ForgetWrittenValues();
+    m_bIsStreaming = false;
+    return res;
+}
+
+//
+// Marks the session as used right now
+//
+void CameraSession::Touch()
+{
+    m_tLastUse = Clock::now();
+}
+
+//
+// Gets the time the session was used last
+//
+CameraSession::Clock::time_point CameraSession::GetLastUse() const
+{
+    return m_tLastUse;
+}
+
+//
+// Tells whether the camera is running a continuous acquisition
+//
+bool CameraSession::IsStreaming() const
+{
+    return m_bIsStreaming;
+}
+
+void CameraSession::SetStreaming( bool bIsStreaming )
+{
+    m_bIsStreaming = bIsStreaming;
+}
+
+//
+// The mutex that serializes all work on this session
+//
+std::mutex& CameraSession::GetMutex()
+{
+    return m_mutex;
+}
+
+void CameraSession::ForgetWrittenValues()
+{
+    for ( int i = 0; i < FeatureCount; ++i )
+    {
+        m_written[i].bHasInt = false;
+        m_written[i].nValue = 0;
+        m_written[i].bHasFloat = false;
+        m_written[i].dValue = 0.0;
+    }
+    m_intValues.clear();
+    m_floatValues.clear();
+}
+
+}}} // namespace AVT::VmbAPI::Examples
@@ -0,0 +1,147 @@
+/*=============================================================================
+  Copyright (C) 2013 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        CameraSession.h
+
+  Description: An opened and configured camera that stays open across
+               acquisitions and only writes features whose value changed.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#ifndef AVT_VMBAPI_EXAMPLES_CAMERASESSION
+#define AVT_VMBAPI_EXAMPLES_CAMERASESSION
+
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "VimbaCPP/Include/VimbaCPP.h"
+
+#include "CameraBackend.h"
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+class CameraSession
+{
+  public:
+    typedef std::chrono::steady_clock Clock;
+
+    //
+    // Parameters:
+    //  [in]    pCamera             The opened camera this session owns
+    //
+    explicit CameraSession( const ICameraPtr &pCamera );
+
+    //
+    // Closes the camera
+    //
+    ~CameraSession();
+
+    //
+    // Gets the camera of this session, empty after Close()
+    //
+    const ICameraPtr&   GetCamera() const;
+
+    //
+    // Writes a feature unless the session already wrote the same value before
+    //
+    // Parameters:
+    //  [in]    pName               The name of the feature
+    //  [in]    nValue / dValue     The value to write
+    //
+    // Returns:
+    //  An API status code
+    //
+    VmbErrorType        SetFeatureValue( const char *pName, VmbInt64_t nValue );
+    VmbErrorType        SetFeatureValue( const char *pName, double dValue );
+
+    //
+    // Writes a resolved feature unless the session already wrote the same value before
+    //
+    // Parameters:
+    //  [in]    eFeature            The feature
+    //  [in]    nValue / dValue     The value to write
+    //
+    // Returns:
+    //  An API status code
+    //
+    VmbErrorType        SetFeatureValue( CameraFeature eFeature, VmbInt64_t nValue );
+    VmbErrorType        SetFeatureValue( CameraFeature eFeature, double dValue );
+
+    //
+    // Closes the camera and forgets all written feature values
+    //
+    // Returns:
+    //  An API status code
+    //
+    VmbErrorType        Close();
+
+    //
+    // Marks the session as used right now
+    //
+    void                Touch();
+
+    //
+    // Gets the time the session was used last
+    //
+    Clock::time_point   GetLastUse() const;
+
+    //
+    // Tells whether the camera is running a continuous acquisition
+    //
+    bool                IsStreaming() const;
+    void                SetStreaming( bool bIsStreaming );
+
+    //
+    // The mutex that serializes all work on this session
+    //
+    std::mutex&         GetMutex();
+
+  private:
+    struct WrittenValue
+    {
+        bool            bHasInt;
+        VmbInt64_t      nValue;
+        bool            bHasFloat;
+        double          dValue;
+    };
+
+    void                ForgetWrittenValues();
+
+    ICameraPtr                          m_pCamera;
+    // The values this session wrote to the known features
+    WrittenValue                        m_written[FeatureCount];
+    // The values this session wrote to other features
+    std::map<std::string, VmbInt64_t>   m_intValues;
+    std::map<std::string, double>       m_floatValues;
+    Clock::time_point                   m_tLastUse;
+    bool                                m_bIsStreaming;
+    std::mutex                          m_mutex;
+};
+typedef std::shared_ptr<CameraSession> CameraSessionPtr;
+
+}}} // namespace AVT::VmbAPI::Examples
+
+#endif
@@ -0,0 +1,616 @@
+/*=============================================================================
+  Copyright (C) 2013 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        Demosaic.cpp
+
+  Description: Bayer demosaicing to BGR24, bilinear and edge-aware (SSSE3, AVX2) with a
+               scalar reference, chosen at runtime by the features of the CPU.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#include <stdlib.h>
+
+#if defined( _M_IX86 ) || defined( _M_X64 ) || defined( __i386__ ) || defined( __x86_64__ )
+#define AVT_DEMOSAIC_X86
+#include <immintrin.h>
+#endif
+
+// MSVC compiles any intrinsic, GCC and Clang need to be told per function
+#if defined( AVT_DEMOSAIC_X86 ) && !defined( _MSC_VER )
+#define AVT_TARGET( x ) __attribute__(( target( x )))
+#else
+#define AVT_TARGET( x )
+#endif
+
+#include "Demosaic.h"
+
+//
+// One row to demosaic. Every pixel is either a color pixel (red or blue, depending on the row)
+// or a green pixel. At color pixels green comes from the four direct neighbors and the other
+// color from the four diagonal ones. At green pixels the color of the row comes from the left
+// and right neighbors, the other color from the ones above and below.
+//
+typedef struct
+{
+    const unsigned char*    pUp2;                   // The row two above (mirrored at the top)
+    const unsigned char*    pUp;                    // The row above (mirrored at the top)
+    const unsigned char*    pCurrent;               // The row itself
+    const unsigned char*    pDown;                  // The row below (mirrored at the bottom)
+    const unsigned char*    pDown2;                 // The row two below (mirrored at the bottom)
+    unsigned char*          pDestination;           // The BGR24 row
+    unsigned long           nWidth;                 // The width of the image
+    unsigned long           nColorPhase;            // x & 1 of the color pixels of the row
+    int                     isBlueRow;              // Whether the color pixels are blue (else red)
+    int                     isEdgeAware;            // Whether to use DemosaicEdgeAware
+} AVTDemosaicRow;
+
+// Demosaics a whole row, x86 kernels are vectorized in the middle and scalar at the borders
+typedef void (*AVTDemosaicRowFunc)( AVTDemosaicRow const* pRow );
+
+//
+// The rounding average of two values, the same as the one of SSE2
+//
+static unsigned char AVTAverage( unsigned char a, unsigned char b )
+{
+    return (unsigned char)(( a + b + 1 ) >> 1 );
+}
+
+static unsigned char AVTClamp( int nValue )
+{
+    return (unsigned char)( nValue < 0 ? 0 : ( nValue > 255 ? 255 : nValue ));
+}
+
+//
+// The reference for a part of a row. All kernels use its arithmetic.
+//
+// Bilinear averages of four values are averages of two averages.
+//
+// Edge-aware interpolates green along the direction with the smaller gradient and corrects
+// every average with the curvature (Laplacian) of the pixel's own channel, like Hamilton-Adams
+// and Malvar-He-Cutler do. Shifts of negative sums are arithmetic, like those of the vector kernels.
+//
+// Parameters:
+//  [in]    pRow            The row
+//  [in]    nFirstX         The first pixel to demosaic
+//  [in]    nEndX           The pixel after the last one to demosaic
+//
+static void AVTDemosaicPixelsScalar( AVTDemosaicRow const* pRow, unsigned long nFirstX, unsigned long nEndX )
+{
+    const unsigned char*    pUp         = pRow->pUp;
+    const unsigned char*    pCurrent    = pRow->pCurrent;
+    const unsigned char*    pDown       = pRow->pDown;
+    unsigned char*          pCurDest    = pRow->pDestination + 3 * nFirstX;    // A cursor to move over the BGR24 row
+    unsigned long           x;                      // The horizontal position within our row
+    unsigned long           nLeft;                  // The left neighbor of x (mirrored)
+    unsigned long           nRight;                 // The right neighbor of x (mirrored)
+    unsigned long           nLeft2;                 // The pixel two to the left of x, the same color as x
+    unsigned long           nRight2;                // The pixel two to the right of x, the same color as x
+    int                     nLaplaceH;              // The horizontal curvature of the channel at x
+    int                     nLaplaceV;              // The vertical curvature of the channel at x
+    int                     nGreenH;                // Green interpolated along the row
+    int                     nGreenV;                // Green interpolated along the column
+    int                     nGradientH;             // How much the row changes at x
+    int                     nGradientV;             // How much the column changes at x
+    unsigned char           rowColor;               // The color of the row at x
+    unsigned char           green;                  // Green at x
+    unsigned char           otherColor;             // The color of the other rows at x
+    int                     isColor;                // Whether x is a color pixel
+
+    for ( x = nFirstX; x < nEndX; ++x, pCurDest += 3 )
+    {
+        nLeft       = 0 != x ? x - 1 : 1;
+        nRight      = x + 1 < pRow->nWidth ? x + 1 : pRow->nWidth - 2;
+        isColor     = ( x & 1 ) == pRow->nColorPhase;
+        if ( !pRow->isEdgeAware )
+        {
+            if ( isColor )
+            {
+                rowColor    = pCurrent[x];
+                green       = AVTAverage( AVTAverage( pCurrent[nLeft], pCurrent[nRight] ), AVTAverage( pUp[x], pDown[x] ));
+                otherColor  = AVTAverage( AVTAverage( pUp[nLeft], pUp[nRight] ), AVTAverage( pDown[nLeft], pDown[nRight] ));
+            }
+            else
+            {
+                rowColor    = AVTAverage( pCurrent[nLeft], pCurrent[nRight] );
+                green       = pCurrent[x];
+                otherColor  = AVTAverage( pUp[x], pDown[x] );
+            }
+        }
+        else
+        {
+            // Narrow images use the pixel itself where there is no pixel two away
+            nLeft2      = x >= 2 ? x - 2 : ( x + 2 < pRow->nWidth ? x + 2 : x );
+            nRight2     = x + 2 < pRow->nWidth ? x + 2 : ( x >= 2 ? x - 2 : x );
+            nLaplaceH   = 2 * pCurrent[x] - pCurrent[nLeft2] - pCurrent[nRight2];
+            nLaplaceV   = 2 * pCurrent[x] - pRow->pUp2[x] - pRow->pDown2[x];
+            // At green pixels these are the colors of the row and of the column
+            nGreenH     = ( 2 * ( pCurrent[nLeft] + pCurrent[nRight] ) + nLaplaceH + 2 ) >> 2;
+            nGreenV     = ( 2 * ( pUp[x] + pDown[x] ) + nLaplaceV + 2 ) >> 2;
+            if ( isColor )
+            {
+                nGradientH  = abs( pCurrent[nLeft] - pCurrent[nRight] ) + abs( nLaplaceH );
+                nGradientV  = abs( pUp[x] - pDown[x] ) + abs( nLaplaceV );
+                rowColor    = pCurrent[x];
+                green       = AVTClamp(   nGradientH < nGradientV ? nGreenH
+                                        : nGradientV < nGradientH ? nGreenV
+                                        : ( nGreenH + nGreenV + 1 ) >> 1 );
+                otherColor  = AVTClamp(( 2 * ( pUp[nLeft] + pUp[nRight] + pDown[nLeft] + pDown[nRight] ) + nLaplaceH + nLaplaceV + 4 ) >> 3 );
+            }
+            else
+            {
+                rowColor    = AVTClamp( nGreenH );
+                green       = pCurrent[x];
+                otherColor  = AVTClamp( nGreenV );
+            }
+        }
+        pCurDest[0] = pRow->isBlueRow ? rowColor : otherColor;
+        pCurDest[1] = green;
+        pCurDest[2] = pRow->isBlueRow ? otherColor : rowColor;
+    }
+}
+
+static void AVTDemosaicRowScalar( AVTDemosaicRow const* pRow )
+{
+    AVTDemosaicPixelsScalar( pRow, 0, pRow->nWidth );
+}
+
+#ifdef AVT_DEMOSAIC_X86
+
+//
+// 16 pixels of three planes become 48 bytes of BGR24 in three registers. Every output
+// register takes bytes from all three planes.
+//
+#define AVT_INTERLEAVE_MASKS                                                                            \
+    const __m128i maskB0 = _mm_setr_epi8(  0, -1, -1,  1, -1, -1,  2, -1, -1,  3, -1, -1,  4, -1, -1,  5 ); \
+    const __m128i maskG0 = _mm_setr_epi8( -1,  0, -1, -1,  1, -1, -1,  2, -1, -1,  3, -1, -1,  4, -1, -1 ); \
+    const __m128i maskR0 = _mm_setr_epi8( -1, -1,  0, -1, -1,  1, -1, -1,  2, -1, -1,  3, -1, -1,  4, -1 ); \
+    const __m128i maskB1 = _mm_setr_epi8( -1, -1,  6, -1, -1,  7, -1, -1,  8, -1, -1,  9, -1, -1, 10, -1 ); \
+    const __m128i maskG1 = _mm_setr_epi8(  5, -1, -1,  6, -1, -1,  7, -1, -1,  8, -1, -1,  9, -1, -1, 10 ); \
+    const __m128i maskR1 = _mm_setr_epi8( -1,  5, -1, -1,  6, -1, -1,  7, -1, -1,  8, -1, -1,  9, -1, -1 ); \
+    const __m128i maskB2 = _mm_setr_epi8( -1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15, -1, -1 ); \
+    const __m128i maskG2 = _mm_setr_epi8( -1, -1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15, -1 ); \
+    const __m128i maskR2 = _mm_setr_epi8( 10, -1, -1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15 );
+
+// Selects a where the mask is set and b elsewhere
+#define AVT_SELECT_128( mask, a, b )    _mm_or_si128( _mm_and_si128( mask, a ), _mm_andnot_si128( mask, b ))
+#define AVT_SELECT_256( mask, a, b )    _mm256_or_si256( _mm256_and_si256( mask, a ), _mm256_andnot_si256( mask, b ))
+
+//
+// Gets a mask of the color pixels among 16 pixels that start at an even x
+//
+AVT_TARGET( "ssse3" )
+static __m128i AVTGetColorMask( unsigned long nColorPhase )
+{
+    const __m128i evenBytes = _mm_setr_epi8( -1, 0, -1, 0, -1, 0, -1, 0, -1, 0, -1, 0, -1, 0, -1, 0 );
+    return 0 == nColorPhase ? evenBytes : _mm_xor_si128( evenBytes, _mm_set1_epi8( -1 ));
+}
+
+//
+// Writes 16 pixels of three planes as BGR24
+//
+AVT_TARGET( "ssse3" )
+static void AVTStoreBGRSSSE3( unsigned char* pDestination, __m128i blue, __m128i green, __m128i red )
+{
+    AVT_INTERLEAVE_MASKS
+    _mm_storeu_si128( (__m128i*)( pDestination ),      _mm_or_si128( _mm_or_si128( _mm_shuffle_epi8( blue, maskB0 ), _mm_shuffle_epi8( green, maskG0 )), _mm_shuffle_epi8( red, maskR0 )));
+    _mm_storeu_si128( (__m128i*)( pDestination + 16 ), _mm_or_si128( _mm_or_si128( _mm_shuffle_epi8( blue, maskB1 ), _mm_shuffle_epi8( green, maskG1 )), _mm_shuffle_epi8( red, maskR1 )));
+    _mm_storeu_si128( (__m128i*)( pDestination + 32 ), _mm_or_si128( _mm_or_si128( _mm_shuffle_epi8( blue, maskB2 ), _mm_shuffle_epi8( green, maskG2 )), _mm_shuffle_epi8( red, maskR2 )));
+}
+
+//
+// Writes two blocks of 16 pixels as BGR24, one block per 128 bit lane. The shuffles work per lane,
+// so the low lanes of the three results hold the first block and the high lanes the second.
+//
+AVT_TARGET( "avx2" )
+static void AVTStoreBGRAVX2( unsigned char* pDestination, __m256i blue, __m256i green, __m256i red )
+{
+    AVT_INTERLEAVE_MASKS
+    const __m256i o0 = _mm256_or_si256( _mm256_or_si256(    _mm256_shuffle_epi8( blue, _mm256_broadcastsi128_si256( maskB0 )),
+                                                            _mm256_shuffle_epi8( green, _mm256_broadcastsi128_si256( maskG0 ))),
+                                                            _mm256_shuffle_epi8( red, _mm256_broadcastsi128_si256( maskR0 )));
+    const __m256i o1 = _mm256_or_si256( _mm256_or_si256(    _mm256_shuffle_epi8( blue, _mm256_broadcastsi128_si256( maskB1 )),
+                                                            _mm256_shuffle_epi8( green, _mm256_broadcastsi128_si256( maskG1 ))),
+                                                            _mm256_shuffle_epi8( red, _mm256_broadcastsi128_si256( maskR1 )));
+    const __m256i o2 = _mm256_or_si256( _mm256_or_si256(    _mm256_shuffle_epi8( blue, _mm256_broadcastsi128_si256( maskB2 )),
+                                                            _mm256_shuffle_epi8( green, _mm256_broadcastsi128_si256( maskG2 ))),
+                                                            _mm256_shuffle_epi8( red, _mm256_broadcastsi128_si256( maskR2 )));
+    _mm_storeu_si128( (__m128i*)( pDestination      ), _mm256_castsi256_si128( o0 ));
+    _mm_storeu_si128( (__m128i*)( pDestination + 16 ), _mm256_castsi256_si128( o1 ));
+    _mm_storeu_si128( (__m128i*)( pDestination + 32 ), _mm256_castsi256_si128( o2 ));
+    _mm_storeu_si128( (__m128i*)( pDestination + 48 ), _mm256_extracti128_si256( o0, 1 ));
+    _mm_storeu_si128( (__m128i*)( pDestination + 64 ), _mm256_extracti128_si256( o1, 1 ));
+    _mm_storeu_si128( (__m128i*)( pDestination + 80 ), _mm256_extracti128_si256( o2, 1 ));
+}
+
+//
+// Bilinear on 8 bit lanes, the averages of SSE2 round like the reference
+//
+AVT_TARGET( "ssse3" )
+static void AVTDemosaicBilinearSSSE3( AVTDemosaicRow const* pRow )
+{
+    const __m128i   isColor = AVTGetColorMask( pRow->nColorPhase );
+    __m128i         horizontal, vertical;           // The averages of the direct neighbors
+    __m128i         diagonal;                       // The average of the diagonal neighbors
+    __m128i         center;                         // The pixels themselves
+    __m128i         rowColor, green, otherColor;    // The three planes
+    unsigned long   x;                              // The horizontal position within our row
+
+    AVTDemosaicPixelsScalar( pRow, 0, 2 );
+    for ( x = 2; x + 17 <= pRow->nWidth; x += 16 )
+    {
+        center      = _mm_loadu_si128( (const __m128i*)( pRow->pCurrent + x ));
+        horizontal  = _mm_avg_epu8( _mm_loadu_si128( (const __m128i*)( pRow->pCurrent + x - 1 )), _mm_loadu_si128( (const __m128i*)( pRow->pCurrent + x + 1 )));
+        vertical    = _mm_avg_epu8( _mm_loadu_si128( (const __m128i*)( pRow->pUp + x )), _mm_loadu_si128( (const __m128i*)( pRow->pDown + x )));
+        diagonal    = _mm_avg_epu8( _mm_avg_epu8( _mm_loadu_si128( (const __m128i*)( pRow->pUp + x - 1 )), _mm_loadu_si128( (const __m128i*)( pRow->pUp + x + 1 ))),
+                                    _mm_avg_epu8( _mm_loadu_si128( (const __m128i*)( pRow->pDown + x - 1 )), _mm_loadu_si128( (const __m128i*)( pRow->pDown + x + 1 ))));
+        rowColor    = AVT_SELECT_128( isColor, center, horizontal );
+        green       = AVT_SELECT_128( isColor, _mm_avg_epu8( horizontal, vertical ), center );
+        otherColor  = AVT_SELECT_128( isColor, diagonal, vertical );
+        AVTStoreBGRSSSE3(   pRow->pDestination + 3 * x,
+                            pRow->isBlueRow ? rowColor : otherColor,
+                            green,
+                            pRow->isBlueRow ? otherColor : rowColor );
+    }
+    AVTDemosaicPixelsScalar( pRow, x, pRow->nWidth );
+}
+
+AVT_TARGET( "avx2" )
+static void AVTDemosaicBilinearAVX2( AVTDemosaicRow const* pRow )
+{
+    const __m256i   isColor = _mm256_broadcastsi128_si256( AVTGetColorMask( pRow->nColorPhase ));
+    __m256i         horizontal, vertical;           // The averages of the direct neighbors
+    __m256i         diagonal;                       // The average of the diagonal neighbors
+    __m256i         center;                         // The pixels themselves
+    __m256i         rowColor, green, otherColor;    // The three planes
+    unsigned long   x;                              // The horizontal position within our row
+
+    AVTDemosaicPixelsScalar( pRow, 0, 2 );
+    for ( x = 2; x + 33 <= pRow->nWidth; x += 32 )
+    {
+        center      = _mm256_loadu_si256( (const __m256i*)( pRow->pCurrent + x ));
+        horizontal  = _mm256_avg_epu8( _mm256_loadu_si256( (const __m256i*)( pRow->pCurrent + x - 1 )), _mm256_loadu_si256( (const __m256i*)( pRow->pCurrent + x + 1 )));
+        vertical    = _mm256_avg_epu8( _mm256_loadu_si256( (const __m256i*)( pRow->pUp + x )), _mm256_loadu_si256( (const __m256i*)( pRow->pDown + x )));
+        diagonal    = _mm256_avg_epu8( _mm256_avg_epu8( _mm256_loadu_si256( (const __m256i*)( pRow->pUp + x - 1 )), _mm256_loadu_si256( (const __m256i*)( pRow->pUp + x + 1 ))),
+                                       _mm256_avg_epu8( _mm256_loadu_si256( (const __m256i*)( pRow->pDown + x - 1 )), _mm256_loadu_si256( (const __m256i*)( pRow->pDown + x + 1 ))));
+        rowColor    = AVT_SELECT_256( isColor, center, horizontal );
+        green       = AVT_SELECT_256( isColor, _mm256_avg_epu8( horizontal, vertical ), center );
+        otherColor  = AVT_SELECT_256( isColor, diagonal, vertical );
+        AVTStoreBGRAVX2(    pRow->pDestination + 3 * x,
+                            pRow->isBlueRow ? rowColor : otherColor,
+                            green,
+                            pRow->isBlueRow ? otherColor : rowColor );
+    }
+    // Less than 32 pixels left
+    AVTDemosaicPixelsScalar( pRow, x, pRow->nWidth );
+}
+
+// The pixels edge-aware demosaicing looks at, relative to the pixel itself
+enum
+{
+    TAP_CENTER, TAP_LEFT, TAP_RIGHT, TAP_LEFT2, TAP_RIGHT2, TAP_UP, TAP_DOWN, TAP_UP2, TAP_DOWN2,
+    TAP_UP_LEFT, TAP_UP_RIGHT, TAP_DOWN_LEFT, TAP_DOWN_RIGHT, TAP_COUNT
+};
+
+//
+// Loads the taps of 16 (SSSE3) or 32 (AVX2) pixels starting at x
+//
+#define AVT_LOAD_TAPS( pTaps, load, type, pRow, x )                  \
+    pTaps[TAP_CENTER]       = load( (const type*)( pRow->pCurrent + x ));     \
+    pTaps[TAP_LEFT]         = load( (const type*)( pRow->pCurrent + x - 1 )); \
+    pTaps[TAP_RIGHT]        = load( (const type*)( pRow->pCurrent + x + 1 )); \
+    pTaps[TAP_LEFT2]        = load( (const type*)( pRow->pCurrent + x - 2 )); \
+    pTaps[TAP_RIGHT2]       = load( (const type*)( pRow->pCurrent + x + 2 )); \
+    pTaps[TAP_UP]           = load( (const type*)( pRow->pUp + x ));          \
+    pTaps[TAP_DOWN]         = load( (const type*)( pRow->pDown + x ));        \
+    pTaps[TAP_UP2]          = load( (const type*)( pRow->pUp2 + x ));         \
+    pTaps[TAP_DOWN2]        = load( (const type*)( pRow->pDown2 + x ));       \
+    pTaps[TAP_UP_LEFT]      = load( (const type*)( pRow->pUp + x - 1 ));      \
+    pTaps[TAP_UP_RIGHT]     = load( (const type*)( pRow->pUp + x + 1 ));      \
+    pTaps[TAP_DOWN_LEFT]    = load( (const type*)( pRow->pDown + x - 1 ));    \
+    pTaps[TAP_DOWN_RIGHT]   = load( (const type*)( pRow->pDown + x + 1 ));
+
+//
+// Edge-aware demosaicing of 8 pixels in 16 bit lanes, the same arithmetic as the reference.
+// Results are not clamped yet, packing with unsigned saturation does that.
+//
+// Parameters:
+//  [in]    pTaps           The taps of the pixels, 16 bit
+//  [in]    isColor         The mask of the color pixels, 16 bit
+//  [out]   pRowColor       The color of the row
+//  [out]   pGreen          Green
+//  [out]   pOtherColor     The color of the other rows
+//
+AVT_TARGET( "ssse3" )
+static void AVTEdgeAwareSSSE3( const __m128i* pTaps, __m128i isColor, __m128i* pRowColor, __m128i* pGreen, __m128i* pOtherColor )
+{
+    const __m128i   laplaceH    = _mm_sub_epi16( _mm_sub_epi16( _mm_slli_epi16( pTaps[TAP_CENTER], 1 ), pTaps[TAP_LEFT2] ), pTaps[TAP_RIGHT2] );
+    const __m128i   laplaceV    = _mm_sub_epi16( _mm_sub_epi16( _mm_slli_epi16( pTaps[TAP_CENTER], 1 ), pTaps[TAP_UP2] ), pTaps[TAP_DOWN2] );
+    const __m128i   greenH      = _mm_srai_epi16( _mm_add_epi16( _mm_add_epi16( _mm_slli_epi16( _mm_add_epi16( pTaps[TAP_LEFT], pTaps[TAP_RIGHT] ), 1 ), laplaceH ), _mm_set1_epi16( 2 )), 2 );
+    const __m128i   greenV      = _mm_srai_epi16( _mm_add_epi16( _mm_add_epi16( _mm_slli_epi16( _mm_add_epi16( pTaps[TAP_UP], pTaps[TAP_DOWN] ), 1 ), laplaceV ), _mm_set1_epi16( 2 )), 2 );
+    const __m128i   gradientH   = _mm_add_epi16( _mm_abs_epi16( _mm_sub_epi16( pTaps[TAP_LEFT], pTaps[TAP_RIGHT] )), _mm_abs_epi16( laplaceH ));
+    const __m128i   gradientV   = _mm_add_epi16( _mm_abs_epi16( _mm_sub_epi16( pTaps[TAP_UP], pTaps[TAP_DOWN] )), _mm_abs_epi16( laplaceV ));
+    const __m128i   alongH      = _mm_cmplt_epi16( gradientH, gradientV );
+    const __m128i   alongV      = _mm_cmplt_epi16( gradientV, gradientH );
+    const __m128i   greenHV     = _mm_srai_epi16( _mm_add_epi16( _mm_add_epi16( greenH, greenV ), _mm_set1_epi16( 1 )), 1 );
+    const __m128i   green       = _mm_or_si128( _mm_or_si128( _mm_and_si128( alongH, greenH ), _mm_and_si128( alongV, greenV )),
+                                                _mm_andnot_si128( _mm_or_si128( alongH, alongV ), greenHV ));
+    const __m128i   diagonal    = _mm_add_epi16( _mm_add_epi16( pTaps[TAP_UP_LEFT], pTaps[TAP_UP_RIGHT] ), _mm_add_epi16( pTaps[TAP_DOWN_LEFT], pTaps[TAP_DOWN_RIGHT] ));
+    const __m128i   otherColor  = _mm_srai_epi16( _mm_add_epi16( _mm_add_epi16( _mm_slli_epi16( diagonal, 1 ), _mm_add_epi16( laplaceH, laplaceV )), _mm_set1_epi16( 4 )), 3 );
+
+    *pRowColor      = AVT_SELECT_128( isColor, pTaps[TAP_CENTER], greenH );
+    *pGreen         = AVT_SELECT_128( isColor, green, pTaps[TAP_CENTER] );
+    *pOtherColor    = AVT_SELECT_128( isColor, otherColor, greenV );
+}
+
+AVT_TARGET( "avx2" )
+static void AVTEdgeAwareAVX2( const __m256i* pTaps, __m256i isColor, __m256i* pRowColor, __m256i* pGreen, __m256i* pOtherColor )
+{
+    const __m256i   laplaceH    = _mm256_sub_epi16( _mm256_sub_epi16( _mm256_slli_epi16( pTaps[TAP_CENTER], 1 ), pTaps[TAP_LEFT2] ), pTaps[TAP_RIGHT2] );
+    const __m256i   laplaceV    = _mm256_sub_epi16( _mm256_sub_epi16( _mm256_slli_epi16( pTaps[TAP_CENTER], 1 ), pTaps[TAP_UP2] ), pTaps[TAP_DOWN2] );
+    const __m256i   greenH      = _mm256_srai_epi16( _mm256_add_epi16( _mm256_add_epi16( _mm256_slli_epi16( _mm256_add_epi16( pTaps[TAP_LEFT], pTaps[TAP_RIGHT] ), 1 ), laplaceH ), _mm256_set1_epi16( 2 )), 2 );
+    const __m256i   greenV      = _mm256_srai_epi16( _mm256_add_epi16( _mm256_add_epi16( _mm256_slli_epi16( _mm256_add_epi16( pTaps[TAP_UP], pTaps[TAP_DOWN] ), 1 ), laplaceV ), _mm256_set1_epi16( 2 )), 2 );
+    const __m256i   gradientH   = _mm256_add_epi16( _mm256_abs_epi16( _mm256_sub_epi16( pTaps[TAP_LEFT], pTaps[TAP_RIGHT] )), _mm256_abs_epi16( laplaceH ));
+    const __m256i   gradientV   = _mm256_add_epi16( _mm256_abs_epi16( _mm256_sub_epi16( pTaps[TAP_UP], pTaps[TAP_DOWN] )), _mm256_abs_epi16( laplaceV ));
+    const __m256i   alongH      = _mm256_cmpgt_epi16( gradientV, gradientH );
+    const __m256i   alongV      = _mm256_cmpgt_epi16( gradientH, gradientV );
+    const __m256i   greenHV     = _mm256_srai_epi16( _mm256_add_epi16( _mm256_add_epi16( greenH, greenV ), _mm256_set1_epi16( 1 )), 1 );
+    const __m256i   green       = _mm256_or_si256( _mm256_or_si256( _mm256_and_si256( alongH, greenH ), _mm256_and_si256( alongV, greenV )),
+                                                   _mm256_andnot_si256( _mm256_or_si256( alongH, alongV ), greenHV ));
+    const __m256i   diagonal    = _mm256_add_epi16( _mm256_add_epi16( pTaps[TAP_UP_LEFT], pTaps[TAP_UP_RIGHT] ), _mm256_add_epi16( pTaps[TAP_DOWN_LEFT], pTaps[TAP_DOWN_RIGHT] ));
+    const __m256i   otherColor  = _mm256_srai_epi16( _mm256_add_epi16( _mm256_add_epi16( _mm256_slli_epi16( diagonal, 1 ), _mm256_add_epi16( laplaceH, laplaceV )), _mm256_set1_epi16( 4 )), 3 );
+
+    *pRowColor      = AVT_SELECT_256( isColor, pTaps[TAP_CENTER], greenH );
+    *pGreen         = AVT_SELECT_256( isColor, green, pTaps[TAP_CENTER] );
+    *pOtherColor    = AVT_SELECT_256( isColor, otherColor, greenV );
+}
+
+//
+// Edge-aware needs 16 bit, the 16 pixels are widened in two halves and packed again with saturation
+//
+AVT_TARGET( "ssse3" )
+static void AVTDemosaicEdgeAwareSSSE3( AVTDemosaicRow const* pRow )
+{
+    // Every pair of bytes of the mask is equal, so its low half masks the 16 bit lanes of both halves
+    const __m128i   isColor16   = _mm_unpacklo_epi8( AVTGetColorMask( pRow->nColorPhase ), AVTGetColorMask( pRow->nColorPhase ));
+    const __m128i   zero        = _mm_setzero_si128();
+    __m128i         taps[TAP_COUNT];                // The taps of 16 pixels
+    __m128i         low[TAP_COUNT];                 // The taps of the first 8 pixels, 16 bit
+    __m128i         high[TAP_COUNT];                // The taps of the last 8 pixels, 16 bit
+    __m128i         rowColor[2], green[2], otherColor[2];   // The three planes of both halves
+    __m128i         packedRowColor, packedOtherColor;       // The two colors of all 16 pixels
+    unsigned long   x;                              // The horizontal position within our row
+    int             i;                              // Counter for some iteration
+
+    AVTDemosaicPixelsScalar( pRow, 0, 2 );
+    for ( x = 2; x + 18 <= pRow->nWidth; x += 16 )
+    {
+        AVT_LOAD_TAPS( taps, _mm_loadu_si128, __m128i, pRow, x )
+        for ( i = 0; i < TAP_COUNT; ++i )
+        {
+            low[i]  = _mm_unpacklo_epi8( taps[i], zero );
+            high[i] = _mm_unpackhi_epi8( taps[i], zero );
+        }
+        AVTEdgeAwareSSSE3( low, isColor16, &rowColor[0], &green[0], &otherColor[0] );
+        AVTEdgeAwareSSSE3( high, isColor16, &rowColor[1], &green[1], &otherColor[1] );
+        packedRowColor      = _mm_packus_epi16( rowColor[0], rowColor[1] );
+        packedOtherColor    = _mm_packus_epi16( otherColor[0], otherColor[1] );
+        AVTStoreBGRSSSE3(   pRow->pDestination + 3 * x,
+                            pRow->isBlueRow ? packedRowColor : packedOtherColor,
+                            _mm_packus_epi16( green[0], green[1] ),
+                            pRow->isBlueRow ? packedOtherColor : packedRowColor );
+    }
+    AVTDemosaicPixelsScalar( pRow, x, pRow->nWidth );
+}
+
+//
+// Widening and packing works per 128 bit lane, so the packed results are in pixel order again
+//
+AVT_TARGET( "avx2" )
+static void AVTDemosaicEdgeAwareAVX2( AVTDemosaicRow const* pRow )
+{
+    const __m128i   isColor8    = AVTGetColorMask( pRow->nColorPhase );
+    const __m256i   isColor16   = _mm256_broadcastsi128_si256( _mm_unpacklo_epi8( isColor8, isColor8 ));
+    const __m256i   zero        = _mm256_setzero_si256();
+    __m256i         taps[TAP_COUNT];                // The taps of 32 pixels
+    __m256i         low[TAP_COUNT];                 // The taps of the first 8 pixels of each lane, 16 bit
+    __m256i         high[TAP_COUNT];                // The taps of the last 8 pixels of each lane, 16 bit
+    __m256i         rowColor[2], green[2], otherColor[2];   // The three planes of both halves
+    __m256i         packedRowColor, packedOtherColor;       // The two colors of all 32 pixels
+    unsigned long   x;                              // The horizontal position within our row
+    int             i;                              // Counter for some iteration
+
+    AVTDemosaicPixelsScalar( pRow, 0, 2 );
+    for ( x = 2; x + 34 <= pRow->nWidth; x += 32 )
+    {
+        AVT_LOAD_TAPS( taps, _mm256_loadu_si256, __m256i, pRow, x )
+        for ( i = 0; i < TAP_COUNT; ++i )
+        {
+            low[i]  = _mm256_unpacklo_epi8( taps[i], zero );
+            high[i] = _mm256_unpackhi_epi8( taps[i], zero );
+        }
+        AVTEdgeAwareAVX2( low, isColor16, &rowColor[0], &green[0], &otherColor[0] );
+        AVTEdgeAwareAVX2( high, isColor16, &rowColor[1], &green[1], &otherColor[1] );
+        packedRowColor      = _mm256_packus_epi16( rowColor[0], rowColor[1] );
+        packedOtherColor    = _mm256_packus_epi16( otherColor[0], otherColor[1] );
+        AVTStoreBGRAVX2(    pRow->pDestination + 3 * x,
+                            pRow->isBlueRow ? packedRowColor : packedOtherColor,
+                            _mm256_packus_epi16( green[0], green[1] ),
+                            pRow->isBlueRow ? packedOtherColor : packedRowColor );
+    }
+    // Less than 32 pixels left
+    AVTDemosaicPixelsScalar( pRow, x, pRow->nWidth );
+}
+
+AVT_TARGET( "ssse3" )
+static void AVTDemosaicRowSSSE3( AVTDemosaicRow const* pRow )
+{
+    if ( pRow->isEdgeAware )
+    {
+        AVTDemosaicEdgeAwareSSSE3( pRow );
+    }
+    else
+    {
+        AVTDemosaicBilinearSSSE3( pRow );
+    }
+}
+
+AVT_TARGET( "avx2" )
+static void AVTDemosaicRowAVX2( AVTDemosaicRow const* pRow )
+{
+    if ( pRow->isEdgeAware )
+    {
+        AVTDemosaicEdgeAwareAVX2( pRow );
+    }
+    else
+    {
+        AVTDemosaicBilinearAVX2( pRow );
+    }
+}
+
+#endif // AVT_DEMOSAIC_X86
+
+//
+// Demosaics rows with the given row kernel
+//
+// Parameters:
+//  [in]    pRowKernel      Demosaics a single row
+//  Others as AVTDemosaic
+//
+// Returns:
+//  0 in case of error
+//  1 in case of success
+//
+static unsigned char AVTDemosaicRows(   AVTDemosaicRowFunc pRowKernel, BayerPattern ePattern, DemosaicMethod eMethod, const unsigned char* pSource,
+                                        unsigned long nWidth, unsigned long nHeight, unsigned char* pDestination,
+                                        unsigned long nFirstRow, unsigned long nRowCount )
+{
+    AVTDemosaicRow  row;                            // The row to demosaic
+    unsigned long   y;                              // The vertical position within our image
+
+    if (    NULL == pSource
+         || NULL == pDestination
+         || nWidth < 2
+         || nHeight < 2
+         || nFirstRow > nHeight
+         || nRowCount > nHeight - nFirstRow
+         || (unsigned int)ePattern > BayerPatternGB
+         || (unsigned int)eMethod >= DemosaicMethodCount )
+    {
+        return 0;
+    }
+
+    row.nWidth      = nWidth;
+    row.isEdgeAware = DemosaicEdgeAware == eMethod;
+    for ( y = nFirstRow; y < nFirstRow + nRowCount; ++y )
+    {
+        // Rows alternate their color phase and color, the pattern holds those of the first row
+        row.pUp2            = pSource + ( y >= 2 ? y - 2 : ( y + 2 < nHeight ? y + 2 : y )) * nWidth;
+        row.pUp             = pSource + ( 0 != y ? y - 1 : 1 ) * nWidth;
+        row.pCurrent        = pSource + y * nWidth;
+        row.pDown           = pSource + ( y + 1 < nHeight ? y + 1 : nHeight - 2 ) * nWidth;
+        row.pDown2          = pSource + ( y + 2 < nHeight ? y + 2 : ( y >= 2 ? y - 2 : y )) * nWidth;
+        row.pDestination    = pDestination + y * nWidth * 3;
+        row.nColorPhase     = ( ePattern & 1 ) ^ ( y & 1 );
+        row.isBlueRow       = (int)((( ePattern >> 1 ) ^ y ) & 1 );
+        pRowKernel( &row );
+    }
+    return 1;
+}
+
+static unsigned char AVTDemosaicScalar( BayerPattern ePattern, DemosaicMethod eMethod, const unsigned char* pSource,
+                                        unsigned long nWidth, unsigned long nHeight, unsigned char* pDestination,
+                                        unsigned long nFirstRow, unsigned long nRowCount )
+{
+    return AVTDemosaicRows( AVTDemosaicRowScalar, ePattern, eMethod, pSource, nWidth, nHeight, pDestination, nFirstRow, nRowCount );
+}
+
+#ifdef AVT_DEMOSAIC_X86
+
+static unsigned char AVTDemosaicSSSE3(  BayerPattern ePattern, DemosaicMethod eMethod, const unsigned char* pSource,
+                                        unsigned long nWidth, unsigned long nHeight, unsigned char* pDestination,
+                                        unsigned long nFirstRow, unsigned long nRowCount )
+{
+    return AVTDemosaicRows( AVTDemosaicRowSSSE3, ePattern, eMethod, pSource, nWidth, nHeight, pDestination, nFirstRow, nRowCount );
+}
+
+static unsigned char AVTDemosaicAVX2(   BayerPattern ePattern, DemosaicMethod eMethod, const unsigned char* pSource,
+                                        unsigned long nWidth, unsigned long nHeight, unsigned char* pDestination,
+                                        unsigned long nFirstRow, unsigned long nRowCount )
+{
+    return AVTDemosaicRows( AVTDemosaicRowAVX2, ePattern, eMethod, pSource, nWidth, nHeight, pDestination, nFirstRow, nRowCount );
+}
+
+#endif // AVT_DEMOSAIC_X86
+
+//
+// Gets a certain kernel, e.g. to compare it against the scalar reference
+//
+// Parameters:
+//  [in]    eKernel         The kernel
+//
+// Returns:
+//  The kernel, NULL if it was not built or the CPU does not support it
+//
+AVTDemosaicFunc AVTGetDemosaicKernel( SwizzleKernel eKernel )
+{
+    switch ( eKernel )
+    {
+    case SwizzleKernelScalar:
+        return AVTDemosaicScalar;
+#ifdef AVT_DEMOSAIC_X86
+    // The swizzle kernels need the same instruction sets
+    case SwizzleKernelSSSE3:
+        return NULL != AVTGetSwapRGBKernel( SwizzleKernelSSSE3 ) ? AVTDemosaicSSSE3 : NULL;
+    case SwizzleKernelAVX2:
+        return NULL != AVTGetSwapRGBKernel( SwizzleKernelAVX2 ) ? AVTDemosaicAVX2 : NULL;
+#endif
+    default:
+        return NULL;
+    }
+}
+
+//
+// Demosaics rows of an 8 bit Bayer image into BGR24 with the fastest kernel this CPU supports
+//
+// Parameters:
+//  [in]    ePattern        The Bayer pattern of the image
+//  [in]    eMethod         How to interpolate
+//  [in]    pSource         The whole Bayer image, nWidth * nHeight bytes
+//  [in]    nWidth          The width of the image, at least 2
+//  [in]    nHeight         The height of the image, at least 2
+//  [out]   pDestination    The whole BGR24 image, nWidth * nHeight * 3 bytes, only the given rows are written
+//  [in]    nFirstRow       The first row to demosaic
+//  [in]    nRowCount       The number of rows to demosaic
+//
+// Returns:
+//  0 in case of error
+//  1 in case of success
+//
+unsigned char AVTDemosaic(  BayerPattern ePattern, DemosaicMethod eMethod, const unsigned char* pSource,
+                            unsigned long nWidth, unsigned long nHeight, unsigned char* pDestination,
+                            unsigned long nFirstRow, unsigned long nRowCount )
+{
+    // Detected once, the CPU does not change. NEON has no demosaic kernel, it uses the reference.
+    static const AVTDemosaicFunc pDemosaic = NULL != AVTGetDemosaicKernel( AVTGetBestSwizzleKernel() )
+                                           ? AVTGetDemosaicKernel( AVTGetBestSwizzleKernel() )
+                                           : AVTDemosaicScalar;
+    return pDemosaic( ePattern, eMethod, pSource, nWidth, nHeight, pDestination, nFirstRow, nRowCount );
+}
@@ -0,0 +1,104 @@
+/*=============================================================================
+  Copyright (C) 2013 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        Demosaic.h
+
+  Description: Bayer demosaicing to BGR24, bilinear and edge-aware (SSSE3, AVX2) with a
+               scalar reference, chosen at runtime by the features of the CPU.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#ifndef AVT_DEMOSAIC_H
+#define AVT_DEMOSAIC_H
+
+#include "PixelSwizzle.h"
+
+// The colors of the first two pixels of the first row (the second row holds the other two)
+typedef enum
+{
+    BayerPatternRG  = 0,
+    BayerPatternGR  = 1,
+    BayerPatternBG  = 2,
+    BayerPatternGB  = 3
+} BayerPattern;
+
+typedef enum
+{
+    DemosaicBilinear    = 0,    // Every missing color is the average of its nearest neighbors
+    DemosaicEdgeAware   = 1,    // Green along edges rather than across them, all colors corrected by the curvature of the pixel's own channel
+    DemosaicMethodCount = 2
+} DemosaicMethod;
+
+//
+// Demosaics rows of an 8 bit Bayer image into BGR24. The neighbors of the rows are read as well,
+// so any split of an image into stripes gives the same result. Borders are mirrored.
+//
+// Parameters:
+//  [in]    ePattern        The Bayer pattern of the image
+//  [in]    eMethod         How to interpolate
+//  [in]    pSource         The whole Bayer image, nWidth * nHeight bytes
+//  [in]    nWidth          The width of the image, at least 2
+//  [in]    nHeight         The height of the image, at least 2
+//  [out]   pDestination    The whole BGR24 image, nWidth * nHeight * 3 bytes, only the given rows are written
+//  [in]    nFirstRow       The first row to demosaic
+//  [in]    nRowCount       The number of rows to demosaic
+//
+// Returns:
+//  0 in case of error
+//  1 in case of success
+//
+typedef unsigned char (*AVTDemosaicFunc)(   BayerPattern ePattern, DemosaicMethod eMethod, const unsigned char* pSource,
+                                            unsigned long nWidth, unsigned long nHeight, unsigned char* pDestination,
+                                            unsigned long nFirstRow, unsigned long nRowCount );
+
+//
+// Demosaics rows of an 8 bit Bayer image into BGR24 with the fastest kernel this CPU supports
+//
+// Parameters:
+//  [in]    ePattern        The Bayer pattern of the image
+//  [in]    eMethod         How to interpolate
+//  [in]    pSource         The whole Bayer image, nWidth * nHeight bytes
+//  [in]    nWidth          The width of the image, at least 2
+//  [in]    nHeight         The height of the image, at least 2
+//  [out]   pDestination    The whole BGR24 image, nWidth * nHeight * 3 bytes, only the given rows are written
+//  [in]    nFirstRow       The first row to demosaic
+//  [in]    nRowCount       The number of rows to demosaic
+//
+// Returns:
+//  0 in case of error
+//  1 in case of success
+//
+unsigned char AVTDemosaic(  BayerPattern ePattern, DemosaicMethod eMethod, const unsigned char* pSource,
+                            unsigned long nWidth, unsigned long nHeight, unsigned char* pDestination,
+                            unsigned long nFirstRow, unsigned long nRowCount );
+
+//
+// Gets a certain kernel, e.g. to compare it against the scalar reference
+//
+// Parameters:
+//  [in]    eKernel         The kernel
+//
+// Returns:
+//  The kernel, NULL if it was not built or the CPU does not support it
+//
+AVTDemosaicFunc AVTGetDemosaicKernel( SwizzleKernel eKernel );
+
+#endif
@@ -0,0 +1,477 @@
+/*=============================================================================
+  Copyright (C) 2013 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        DirectRecorder.cpp
+
+  Description: Records frames with unbuffered (direct) I/O into a preallocated file.
+               Frames are copied into page aligned chunks that a writer thread
+               hands to the disk while acquisition fills the next chunk.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#include <algorithm>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "DirectRecorder.h"
+#include "MetricsRegistry.h"
+#include "RecordingFile.h"
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+//
+// A file opened for unbuffered sequential writes
+//
+struct DirectRecorder::File
+{
+#ifdef _WIN32
+    HANDLE  hFile;
+#else
+    int     nFile;
+#endif
+    bool    bIsDirect;
+
+    File()
+#ifdef _WIN32
+        : hFile( INVALID_HANDLE_VALUE )
+#else
+        : nFile( -1 )
+#endif
+        , bIsDirect( false )
+    {
+    }
+
+    ~File()
+    {
+        Close();
+    }
+
+    //
+    // Opens without the page cache, or buffered if the file system does not allow that (e.g. tmpfs)
+    //
+    bool Open( const std::string &rFileName )
+    {
+#ifdef _WIN32
+        hFile = CreateFileA(    rFileName.c_str(), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS,
+                                FILE_ATTRIBUTE_NORMAL | FILE_FLAG_NO_BUFFERING | FILE_FLAG_WRITE_THROUGH, NULL );
+        bIsDirect = INVALID_HANDLE_VALUE != hFile;
+        if ( !bIsDirect )
+        {
+            hFile = CreateFileA( rFileName.c_str(), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL );
+        }
+        return INVALID_HANDLE_VALUE != hFile;
+#else
+#ifdef O_DIRECT
+        nFile = open( rFileName.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_DIRECT, 0644 );
+        bIsDirect = 0 <= nFile;
+#endif
+        if ( 0 > nFile )
+        {
+            nFile = open( rFileName.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644 );
+        }
+        return 0 <= nFile;
+#endif
+    }
+
+    //
+    // Reserves disk space without changing the file size, so the writes do not have to grow the file
+    //
+    void Preallocate( VmbUint64_t nSize )
+    {
+        // Not being able to reserve the space only costs speed, so errors are ignored
+#ifdef _WIN32
+        FILE_ALLOCATION_INFO info;
+        info.AllocationSize.QuadPart = static_cast<LONGLONG>( nSize );
+        SetFileInformationByHandle( hFile, FileAllocationInfo, &info, sizeof( info ));
+#elif defined( __linux__ )
+        fallocate( nFile, FALLOC_FL_KEEP_SIZE, 0, static_cast<off_t>( nSize ));
+#else
+        (void)nSize;
+#endif
+    }
+
+    bool Write( const VmbUchar_t *pData, size_t nSize )
+    {
+        while ( 0 < nSize )
+        {
+#ifdef _WIN32
+            DWORD nWritten = 0;
+            if ( !WriteFile( hFile, pData, static_cast<DWORD>( nSize ), &nWritten, NULL ))
+            {
+                return false;
+            }
+#else
+            const ssize_t nWritten = write( nFile, pData, nSize );
+            if ( 0 > nWritten )
+            {
+                if ( EINTR == errno )
+                {
+                    continue;
+                }
+                return false;
+            }
+#endif
+            pData += nWritten;
+            nSize -= nWritten;
+        }
+        return true;
+    }
+
+    bool Close()
+    {
+        bool bResult = true;
+#ifdef _WIN32
+        if ( INVALID_HANDLE_VALUE != hFile )
+        {
+            bResult = FALSE != CloseHandle( hFile );
+            hFile = INVALID_HANDLE_VALUE;
+        }
+#else
+        if ( 0 <= nFile )
+        {
+            bResult = 0 == close( nFile );
+            nFile = -1;
+        }
+#endif
+        return bResult;
+    }
+};
+
+//
+// Parameters:
+//  [in]    nChunkSize          The size of a single write, rounded up to DIRECT_IO_ALIGNMENT
+//  [in]    nChunkCount         The number of chunks, 2 for double buffering
+//
+DirectRecorder::DirectRecorder( size_t nChunkSize, VmbUint32_t nChunkCount )
+    : m_nChunkSize( ( ( std::max )( nChunkSize, static_cast<size_t>( 1 )) + DIRECT_IO_ALIGNMENT - 1 ) / DIRECT_IO_ALIGNMENT * DIRECT_IO_ALIGNMENT )
+    , m_nChunkCount( ( std::max )( nChunkCount, 2u ))
+    , m_bufferPool( BUFFER_ALIGNMENT_PAGE, BufferPoolPrefault )
+    , m_nCurrentChunk( 0 )
+    , m_nOffset( 0 )
+    , m_bStop( false )
+    , m_eWriteError( VmbErrorSuccess )
+    , m_bIsDirect( false )
+    , m_nFrameCount( 0 )
+    , m_nBytesWritten( 0 )
+    , m_nWriteTimeUS( 0 )
+    , m_nStallCount( 0 )
+    , m_nStallTimeUS( 0 )
+{
+}
+
+DirectRecorder::~DirectRecorder()
+{
+    Close();
+}
+
+//
+// Creates a recording file, an existing file gets overwritten
+//
+// Parameters:
+//  [in]    rFileName           The path of the recording
+//  [in]    nPreallocateSize    The number of bytes to reserve on disk up front, 0 for none
+//
+// Returns:
+//  An API status code
+//
+VmbErrorType DirectRecorder::Open( const std::string &rFileName, VmbUint64_t nPreallocateSize )
+{
+    std::lock_guard<std::mutex> appendLock( m_appendMutex );
+    if ( m_pFile )
+    {
+        return VmbErrorInvalidCall;
+    }
+
+    // All chunk memory is taken up front, page aligned as unbuffered I/O requires
+    m_chunks.resize( m_nChunkCount );
+    for (   std::vector<Chunk>::iterator iter = m_chunks.begin();
+            m_chunks.end() != iter;
+            ++iter )
+    {
+        iter->pBuffer       = m_bufferPool.Acquire( m_nChunkSize );
+        iter->nUsed         = 0;
+        iter->nWriteSize    = 0;
+        iter->bIsBusy       = false;
+        if ( !iter->pBuffer )
+        {
+            m_chunks.clear();
+            return VmbErrorResources;
+        }
+    }
+
+    std::unique_ptr<File> pFile( new File() );
+    if ( !pFile->Open( rFileName ))
+    {
+        m_chunks.clear();
+        return VmbErrorOther;
+    }
+    if ( 0 != nPreallocateSize )
+    {
+        pFile->Preallocate( nPreallocateSize );
+    }
+
+    m_pFile         = std::move( pFile );
+    m_strFileName   = rFileName;
+    m_nCurrentChunk = 0;
+    m_nOffset       = 0;
+    m_index.clear();
+    {
+        // GetStatistics may run at any time
+        std::lock_guard<std::mutex> lock( m_mutex );
+        m_fullChunks.clear();
+        m_bStop         = false;
+        m_eWriteError   = VmbErrorSuccess;
+        m_bIsDirect     = m_pFile->bIsDirect;
+        m_nFrameCount   = 0;
+        m_nBytesWritten = 0;
+        m_nWriteTimeUS  = 0;
+        m_nStallCount   = 0;
+        m_nStallTimeUS  = 0;
+        m_tOpen         = Clock::now();
+        m_tLastWrite    = m_tOpen;
+    }
+    m_thread        = std::thread( &DirectRecorder::Run, this );
+
+    RecordingFileHeader header;
+    InitRecordingFileHeader( header );
+    Put( &header, sizeof( header ));
+    m_nOffset = sizeof( header );
+    return VmbErrorSuccess;
+}
+
+//
+// Copies a frame into the current chunk. Only waits if the disk fell behind by all chunks.
+//
+// Parameters:
+//  [in]    rFrame              The frame to append
+//
+// Returns:
+//  An API status code, or the error of a previous write
+//
+VmbErrorType DirectRecorder::Append( const ImageFrame &rFrame )
+{
+    static const VmbUchar_t padding[RECORDING_ALIGNMENT] = { 0 };
+
+    if ( NULL == rFrame.pImage )
+    {
+        return VmbErrorBadParameter;
+    }
+    std::lock_guard<std::mutex> appendLock( m_appendMutex );
+    if ( !m_pFile )
+    {
+        return VmbErrorInvalidCall;
+    }
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        if ( VmbErrorSuccess != m_eWriteError )
+        {
+            return m_eWriteError;
+        }
+    }
+
+    RecordingFrameHeader header;
+    InitRecordingFrameHeader( rFrame, header );
+    const VmbUint64_t nRecordSize = GetRecordingRecordSize( rFrame.nImageSize );
+    Put( &header, sizeof( header ));
+    Put( rFrame.pImage, rFrame.nImageSize );
+    Put( padding, static_cast<size_t>( nRecordSize - sizeof( header ) - rFrame.nImageSize ));
+
+    m_index.push_back( m_nOffset );
+    m_nOffset += nRecordSize;
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        ++m_nFrameCount;
+    }
+    return VmbErrorSuccess;
+}
+
+//
+// Writes the last chunk and the index and closes the file
+//
+// Returns:
+//  An API status code
+//
+VmbErrorType DirectRecorder::Close()
+{
+    std::lock_guard<std::mutex> appendLock( m_appendMutex );
+    if ( !m_pFile )
+    {
+        return VmbErrorSuccess;
+    }
+
+    // The last chunk gets padded, FinishRecordingFile cuts the padding off again
+    if ( 0 != m_chunks[m_nCurrentChunk].nUsed )
+    {
+        SubmitChunk();
+    }
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        m_bStop = true;
+    }
+    m_chunkFull.notify_all();
+    m_thread.join();
+
+    VmbErrorType res = m_eWriteError;
+    if ( !m_pFile->Close() )
+    {
+        res = VmbErrorOther;
+    }
+    m_pFile.reset();
+    m_chunks.clear();
+
+    // The index is small, so it is written buffered
+    if ( VmbErrorSuccess == res )
+    {
+        res = FinishRecordingFile( m_strFileName, m_nOffset, m_index );
+    }
+    return res;
+}
+
+//
+// Gets the counters and the achieved throughput
+//
+DirectRecorderStatistics DirectRecorder::GetStatistics() const
+{
+    std::lock_guard<std::mutex> lock( m_mutex );
+    DirectRecorderStatistics statistics;
+    statistics.nFrameCount      = m_nFrameCount;
+    statistics.nBytesWritten    = m_nBytesWritten;
+    const double dSeconds       = std::chrono::duration<double>( m_tLastWrite - m_tOpen ).count();
+    statistics.dBytesPerSecond  = dSeconds > 0.0 ? m_nBytesWritten / dSeconds : 0.0;
+    statistics.dDiskBytesPerSecond = 0 != m_nWriteTimeUS ? m_nBytesWritten * 1000000.0 / m_nWriteTimeUS : 0.0;
+    statistics.nStallCount      = m_nStallCount;
+    statistics.nStallTimeUS     = m_nStallTimeUS;
+    statistics.bIsDirect        = m_bIsDirect;
+    return statistics;
+}
+
+//
+// Copies bytes into the chunks, hands every full chunk to the writer thread
+//
+// Parameters:
+//  [in]    pData               The bytes to copy
+//  [in]    nSize               The number of bytes
+//
+void DirectRecorder::Put( const void *pData, size_t nSize )
+{
+    const VmbUchar_t *pBytes = static_cast<const VmbUchar_t*>( pData );
+    while ( 0 < nSize )
+    {
+        Chunk &rChunk = m_chunks[m_nCurrentChunk];
+        const size_t nCopySize = ( std::min )( nSize, m_nChunkSize - rChunk.nUsed );
+        memcpy( rChunk.pBuffer.get() + rChunk.nUsed, pBytes, nCopySize );
+        rChunk.nUsed += nCopySize;
+        pBytes += nCopySize;
+        nSize -= nCopySize;
+        if ( m_nChunkSize == rChunk.nUsed )
+        {
+            SubmitChunk();
+        }
+    }
+}
+
+//
+// Hands the current chunk to the writer thread and moves on to the next one,
+// waits if that one is still being written
+//
+void DirectRecorder::SubmitChunk()
+{
+    Chunk &rChunk = m_chunks[m_nCurrentChunk];
+    rChunk.nWriteSize = ( rChunk.nUsed + DIRECT_IO_ALIGNMENT - 1 ) / DIRECT_IO_ALIGNMENT * DIRECT_IO_ALIGNMENT;
+    memset( rChunk.pBuffer.get() + rChunk.nUsed, 0, rChunk.nWriteSize - rChunk.nUsed );
+
+    std::unique_lock<std::mutex> lock( m_mutex );
+    rChunk.bIsBusy = true;
+    m_fullChunks.push_back( m_nCurrentChunk );
+    m_chunkFull.notify_one();
+
+    m_nCurrentChunk = ( m_nCurrentChunk + 1 ) % m_chunks.size();
+    if ( m_chunks[m_nCurrentChunk].bIsBusy )
+    {
+        const Clock::time_point tStart = Clock::now();
+        while ( m_chunks[m_nCurrentChunk].bIsBusy )
+        {
+            m_chunkFree.wait( lock );
+        }
+        ++m_nStallCount;
+        m_nStallTimeUS += std::chrono::duration_cast<std::chrono::microseconds>( Clock::now() - tStart ).count();
+    }
+}
+
+//
+// The writer thread, writes full chunks in order
+//
+void DirectRecorder::Run()
+{
+    for ( ;; )
+    {
+        size_t nChunk = 0;
+        {
+            std::unique_lock<std::mutex> lock( m_mutex );
+            while (    m_fullChunks.empty()
+                    && !m_bStop )
+            {
+                m_chunkFull.wait( lock );
+            }
+            if ( m_fullChunks.empty() )
+            {
+                return;
+            }
+            nChunk = m_fullChunks.front();
+            m_fullChunks.pop_front();
+        }
+
+        // Append does not touch a busy chunk, so it is written without the lock
+        Chunk &rChunk = m_chunks[nChunk];
+        const Clock::time_point tStart = Clock::now();
+        const bool bIsWritten = m_pFile->Write( rChunk.pBuffer.get(), rChunk.nWriteSize );
+        const Clock::time_point tEnd = Clock::now();
+
+        {
+            std::lock_guard<std::mutex> lock( m_mutex );
+            if ( bIsWritten )
+            {
+                m_nBytesWritten += rChunk.nWriteSize;
+                WriteMetrics::GetDefault().pBytesWritten->Add( rChunk.nWriteSize );
+            }
+            else if ( VmbErrorSuccess == m_eWriteError )
+            {
+                m_eWriteError = VmbErrorOther;
+            }
+            m_nWriteTimeUS += std::chrono::duration_cast<std::chrono::microseconds>( tEnd - tStart ).count();
+            m_tLastWrite = tEnd;
+            rChunk.nUsed = 0;
+            rChunk.bIsBusy = false;
+        }
+        m_chunkFree.notify_one();
+    }
+}
+
+}}} // namespace AVT::VmbAPI::Examples
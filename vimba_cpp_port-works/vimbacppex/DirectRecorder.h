@@ -0,0 +1,179 @@
+/*=============================================================================
+  Copyright (C) 2013 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        DirectRecorder.h
+
+  Description: Records frames with unbuffered (direct) I/O into a preallocated file.
+               Frames are copied into page aligned chunks that a writer thread
+               hands to the disk while acquisition fills the next chunk.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#ifndef AVT_VMBAPI_EXAMPLES_DIRECTRECORDER
+#define AVT_VMBAPI_EXAMPLES_DIRECTRECORDER
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "VimbaCPP/Include/VimbaCPP.h"
+
+#include "BufferPool.h"
+#include "ImageFrame.h"
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+enum { DIRECT_IO_ALIGNMENT = 4096, };
+enum { DEFAULT_DIRECT_CHUNK_SIZE = 8 * 1024 * 1024, };
+enum { DEFAULT_DIRECT_CHUNK_COUNT = 2, };
+
+//
+// The counters of a DirectRecorder
+//
+struct DirectRecorderStatistics
+{
+    VmbUint64_t     nFrameCount;            // Frames appended
+    VmbUint64_t     nBytesWritten;          // Bytes that reached the file
+    double          dBytesPerSecond;        // Sustained throughput, from Open until the last chunk was written
+    double          dDiskBytesPerSecond;    // Throughput of the write calls alone
+    VmbUint64_t     nStallCount;            // Times Append had to wait for the disk because all chunks were full
+    VmbUint64_t     nStallTimeUS;           // The time Append waited for the disk
+    bool            bIsDirect;              // Whether the writes bypass the page cache
+};
+
+//
+// Records frames in the format of RecordingWriter, so RecordingReader can replay them,
+// but bypasses the page cache (O_DIRECT, FILE_FLAG_NO_BUFFERING). Falls back to buffered
+// writes where the file system does not support that.
+//
+class DirectRecorder
+{
+  public:
+    //
+    // Parameters:
+    //  [in]    nChunkSize          The size of a single write, rounded up to DIRECT_IO_ALIGNMENT
+    //  [in]    nChunkCount         The number of chunks, 2 for double buffering
+    //
+    explicit DirectRecorder( size_t nChunkSize = DEFAULT_DIRECT_CHUNK_SIZE, VmbUint32_t nChunkCount = DEFAULT_DIRECT_CHUNK_COUNT );
+
+    //
+    // Closes the recording
+    //
+    ~DirectRecorder();
+
+    //
+    // Creates a recording file, an existing file gets overwritten
+    //
+    // Parameters:
+    //  [in]    rFileName           The path of the recording
+    //  [in]    nPreallocateSize    The number of bytes to reserve on disk up front, 0 for none
+    //
+    // Returns:
+    //  An API status code
+    //
+    VmbErrorType    Open( const std::string &rFileName, VmbUint64_t nPreallocateSize = 0 );
+
+    //
+    // Copies a frame into the current chunk. Only waits if the disk fell behind by all chunks.
+    //
+    // Parameters:
+    //  [in]    rFrame              The frame to append
+    //
+    // Returns:
+    //  An API status code, or the error of a previous write
+    //
+    VmbErrorType    Append( const ImageFrame &rFrame );
+
+    //
+    // Writes the last chunk and the index and closes the file
+    //
+    // Returns:
+    //  An API status code
+    //
+    VmbErrorType    Close();
+
+    //
+    // Gets the counters and the achieved throughput
+    //
+    DirectRecorderStatistics GetStatistics() const;
+
+  private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct File;
+
+    struct Chunk
+    {
+        BufferPtr   pBuffer;
+        size_t      nUsed;                  // Bytes filled by Append
+        size_t      nWriteSize;             // nUsed rounded up to DIRECT_IO_ALIGNMENT
+        bool        bIsBusy;                // Handed to the writer thread
+    };
+
+    void            Put( const void *pData, size_t nSize );
+    void            SubmitChunk();
+    void            Run();
+
+    const size_t                m_nChunkSize;
+    const VmbUint32_t           m_nChunkCount;
+    BufferPool                  m_bufferPool;
+    std::unique_ptr<File>       m_pFile;
+    std::string                 m_strFileName;
+
+    // Producer side, guarded by m_appendMutex
+    std::mutex                  m_appendMutex;
+    std::vector<Chunk>          m_chunks;
+    size_t                      m_nCurrentChunk;
+    VmbUint64_t                 m_nOffset;              // The size of the recording so far
+    std::vector<VmbUint64_t>    m_index;                // The offset of every frame header
+
+    // Shared with the writer thread, guarded by m_mutex
+    std::thread                 m_thread;
+    mutable std::mutex          m_mutex;
+    std::condition_variable     m_chunkFull;            // Signals the writer thread
+    std::condition_variable     m_chunkFree;            // Signals a waiting Append
+    std::deque<size_t>          m_fullChunks;
+    bool                        m_bStop;
+    VmbErrorType                m_eWriteError;
+    bool                        m_bIsDirect;
+    VmbUint64_t                 m_nFrameCount;
+    VmbUint64_t                 m_nBytesWritten;
+    VmbUint64_t                 m_nWriteTimeUS;
+    VmbUint64_t                 m_nStallCount;
+    VmbUint64_t                 m_nStallTimeUS;
+    Clock::time_point           m_tOpen;
+    Clock::time_point           m_tLastWrite;
+
+    // No copies
+    DirectRecorder( const DirectRecorder& );
+    DirectRecorder& operator=( const DirectRecorder& );
+};
+
+}}} // namespace AVT::VmbAPI::Examples
+
+#endif
@@ -0,0 +1,342 @@
+/*=============================================================================
+  Copyright (C) 2013 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        FlightRecorder.cpp
+
+  Description: Keeps the latest frames in a fixed ring of preallocated memory and
+               writes the frames around a triggered event to a recording file.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#include <algorithm>
+#include <cstring>
+
+#include "FlightRecorder.h"
+#include "RecordingFile.h"
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+FlightRecorder::FlightRecorder()
+    : m_bufferPool( BUFFER_ALIGNMENT_CACHE_LINE, BufferPoolPrefault )
+    , m_nNextSlot( 0 )
+    , m_nWritingCount( 0 )
+    , m_bStop( false )
+{
+    memset( &m_statistics, 0, sizeof( m_statistics ));
+    m_thread = std::thread( &FlightRecorder::Run, this );
+}
+
+//
+// Writes the events still pending
+//
+FlightRecorder::~FlightRecorder()
+{
+    Flush();
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        m_bStop = true;
+    }
+    m_eventReady.notify_all();
+    m_thread.join();
+}
+
+//
+// Allocates the ring, all memory is taken here and never per frame
+//
+// Parameters:
+//  [in]    rConfig             The size of the ring and of the event window
+//
+// Returns:
+//  An API status code
+//
+VmbErrorType FlightRecorder::Allocate( const FlightRecorderConfig &rConfig )
+{
+    if (    0 == rConfig.nFrameCount
+         || 0 == rConfig.nMaxImageSize )
+    {
+        return VmbErrorBadParameter;
+    }
+    std::lock_guard<std::mutex> lock( m_mutex );
+    if ( !m_slots.empty() )
+    {
+        return VmbErrorInvalidCall;
+    }
+
+    std::vector<Slot> slots( rConfig.nFrameCount );
+    for (   std::vector<Slot>::iterator iter = slots.begin();
+            slots.end() != iter;
+            ++iter )
+    {
+        // The pool touches every page, so the first round through the ring does not page fault either
+        iter->pBuffer = m_bufferPool.Acquire( rConfig.nMaxImageSize );
+        if ( !iter->pBuffer )
+        {
+            return VmbErrorResources;
+        }
+        iter->frame.pImage  = iter->pBuffer.get();
+        iter->bIsFilled     = false;
+        iter->bIsPinned     = false;
+    }
+    m_slots.swap( slots );
+    m_config = rConfig;
+    m_nNextSlot = 0;
+    m_statistics.nMemorySize = static_cast<VmbUint64_t>( rConfig.nFrameCount ) * rConfig.nMaxImageSize;
+    return VmbErrorSuccess;
+}
+
+//
+// Copies a frame into the ring, overwriting the oldest one
+//
+// Parameters:
+//  [in]    rFrame              The frame
+//
+// Returns:
+//  An API status code
+//  VmbErrorResources if the frame was dropped
+//
+VmbErrorType FlightRecorder::Push( const ImageFrame &rFrame )
+{
+    if ( NULL == rFrame.pImage )
+    {
+        return VmbErrorBadParameter;
+    }
+    const Clock::time_point tNow = Clock::now();
+
+    std::lock_guard<std::mutex> lock( m_mutex );
+    if ( m_slots.empty() )
+    {
+        return VmbErrorInvalidCall;
+    }
+    if (    m_pOpenEvent
+         && 0 != m_config.nPostTriggerMS
+         && tNow - m_pOpenEvent->tTrigger >= std::chrono::milliseconds( m_config.nPostTriggerMS ))
+    {
+        CloseEvent();
+    }
+
+    Slot &rSlot = m_slots[m_nNextSlot];
+    if (    rFrame.nImageSize > m_config.nMaxImageSize
+         || rSlot.bIsPinned )
+    {
+        ++m_statistics.nDroppedCount;
+        // An event that filled the whole ring cannot grow any further
+        if (    m_pOpenEvent
+             && !m_pOpenEvent->slots.empty()
+             && m_nNextSlot == m_pOpenEvent->slots.front() )
+        {
+            CloseEvent();
+        }
+        return VmbErrorResources;
+    }
+
+    memcpy( rSlot.pBuffer.get(), rFrame.pImage, rFrame.nImageSize );
+    rSlot.frame.nImageSize      = rFrame.nImageSize;
+    rSlot.frame.nWidth          = rFrame.nWidth;
+    rSlot.frame.nHeight         = rFrame.nHeight;
+    rSlot.frame.ePixelFormat    = rFrame.ePixelFormat;
+    rSlot.frame.nFrameID        = rFrame.nFrameID;
+    rSlot.frame.nTimestamp      = rFrame.nTimestamp;
+    rSlot.frame.eReceiveStatus  = rFrame.eReceiveStatus;
+    rSlot.tReceived             = tNow;
+    rSlot.bIsFilled             = true;
+    ++m_statistics.nFrameCount;
+
+    if ( m_pOpenEvent )
+    {
+        // Capacity was reserved at the trigger
+        rSlot.bIsPinned = true;
+        m_pOpenEvent->slots.push_back( m_nNextSlot );
+        if (    0 != m_config.nPostTriggerFrames
+             && ++m_pOpenEvent->nPostTriggerCount >= m_config.nPostTriggerFrames )
+        {
+            CloseEvent();
+        }
+    }
+    m_nNextSlot = ( m_nNextSlot + 1 ) % m_slots.size();
+    return VmbErrorSuccess;
+}
+
+//
+// Keeps the frames before the trigger and the ones that follow within the window, then writes
+// them to a recording file in the background. The ring keeps running meanwhile.
+//
+// Parameters:
+//  [in]    rFileName           The path of the recording to write
+//  [in]    rCallback           Gets called once the event was written (may be empty)
+//
+// Returns:
+//  An API status code
+//  VmbErrorInvalidCall if the window of the previous event is still open
+//
+VmbErrorType FlightRecorder::Trigger( const std::string &rFileName, const EventCallback &rCallback )
+{
+    const Clock::time_point tNow = Clock::now();
+
+    std::lock_guard<std::mutex> lock( m_mutex );
+    if (    m_slots.empty()
+         || m_pOpenEvent )
+    {
+        return VmbErrorInvalidCall;
+    }
+
+    EventPtr pEvent( new Event() );
+    pEvent->strFileName         = rFileName;
+    pEvent->callback            = rCallback;
+    pEvent->tTrigger            = tNow;
+    pEvent->nPostTriggerCount   = 0;
+    pEvent->slots.reserve( m_slots.size() );
+
+    // Walk back from the newest frame. Frames of events still being written are not taken twice.
+    size_t nSlot = m_nNextSlot;
+    for ( size_t i = 0; i < m_slots.size(); ++i )
+    {
+        nSlot = ( nSlot + m_slots.size() - 1 ) % m_slots.size();
+        Slot &rSlot = m_slots[nSlot];
+        if (    !rSlot.bIsFilled
+             || rSlot.bIsPinned
+             || (    0 != m_config.nPreTriggerMS
+                  && tNow - rSlot.tReceived > std::chrono::milliseconds( m_config.nPreTriggerMS )))
+        {
+            break;
+        }
+        rSlot.bIsPinned = true;
+        pEvent->slots.push_back( nSlot );
+    }
+    std::reverse( pEvent->slots.begin(), pEvent->slots.end() );
+
+    m_pOpenEvent = pEvent;
+    if (    0 == m_config.nPostTriggerFrames
+         && 0 == m_config.nPostTriggerMS )
+    {
+        CloseEvent();
+    }
+    return VmbErrorSuccess;
+}
+
+//
+// Ends the window of an open event and waits until all events are written
+//
+void FlightRecorder::Flush()
+{
+    std::unique_lock<std::mutex> lock( m_mutex );
+    if ( m_pOpenEvent )
+    {
+        CloseEvent();
+    }
+    while (    !m_events.empty()
+            || 0 != m_nWritingCount )
+    {
+        m_eventWritten.wait( lock );
+    }
+}
+
+//
+// Gets the counters
+//
+FlightRecorderStatistics FlightRecorder::GetStatistics() const
+{
+    std::lock_guard<std::mutex> lock( m_mutex );
+    return m_statistics;
+}
+
+//
+// Hands the open event to the writer thread (m_mutex is held)
+//
+void FlightRecorder::CloseEvent()
+{
+    m_events.push_back( m_pOpenEvent );
+    m_pOpenEvent.reset();
+    m_eventReady.notify_one();
+}
+
+//
+// The writer thread, writes one event after the other
+//
+void FlightRecorder::Run()
+{
+    for ( ;; )
+    {
+        EventPtr pEvent;
+        {
+            std::unique_lock<std::mutex> lock( m_mutex );
+            while (    m_events.empty()
+                    && !m_bStop )
+            {
+                m_eventReady.wait( lock );
+            }
+            if ( m_events.empty() )
+            {
+                return;
+            }
+            pEvent = m_events.front();
+            m_events.pop_front();
+            ++m_nWritingCount;
+        }
+
+        // Push leaves pinned slots alone, so they are read without the lock
+        RecordingWriter writer;
+        VmbErrorType res = writer.Open( pEvent->strFileName );
+        for (   std::vector<size_t>::const_iterator iter = pEvent->slots.begin();
+                pEvent->slots.end() != iter && VmbErrorSuccess == res;
+                ++iter )
+        {
+            res = writer.Append( m_slots[*iter].frame );
+        }
+        const VmbErrorType closeResult = writer.Close();
+        if ( VmbErrorSuccess == res )
+        {
+            res = closeResult;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock( m_mutex );
+            for (   std::vector<size_t>::const_iterator iter = pEvent->slots.begin();
+                    pEvent->slots.end() != iter;
+                    ++iter )
+            {
+                m_slots[*iter].bIsPinned = false;
+            }
+            if ( VmbErrorSuccess == res )
+            {
+                ++m_statistics.nEventCount;
+            }
+            else
+            {
+                ++m_statistics.nFailedEventCount;
+            }
+        }
+
+        if ( pEvent->callback )
+        {
+            pEvent->callback( pEvent->strFileName, static_cast<VmbUint32_t>( pEvent->slots.size() ), res );
+        }
+
+        {
+            std::lock_guard<std::mutex> lock( m_mutex );
+            --m_nWritingCount;
+        }
+        m_eventWritten.notify_all();
+    }
+}
+
+}}} // namespace AVT::VmbAPI::Examples
@@ -0,0 +1,195 @@
+/*=============================================================================
+  Copyright (C) 2013 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        FlightRecorder.h
+
+  Description: Keeps the latest frames in a fixed ring of preallocated memory and
+               writes the frames around a triggered event to a recording file.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#ifndef AVT_VMBAPI_EXAMPLES_FLIGHTRECORDER
+#define AVT_VMBAPI_EXAMPLES_FLIGHTRECORDER
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "VimbaCPP/Include/VimbaCPP.h"
+
+#include "BufferPool.h"
+#include "ImageFrame.h"
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+//
+// The size of the ring and the window around an event
+//
+struct FlightRecorderConfig
+{
+    VmbUint32_t     nFrameCount;            // The number of frames the ring holds
+    VmbUint32_t     nMaxImageSize;          // The largest image in bytes, larger images are dropped
+    VmbUint32_t     nPreTriggerMS;          // Keep only frames this young at the trigger, 0 for the whole ring
+    VmbUint32_t     nPostTriggerFrames;     // The number of frames to add after the trigger, 0 for no limit
+    VmbUint32_t     nPostTriggerMS;         // The time to add frames after the trigger, 0 for no limit
+                                            // (the window ends with whichever limit comes first, without any limit
+                                            // it ends at the trigger)
+
+    FlightRecorderConfig()
+        : nFrameCount( 0 )
+        , nMaxImageSize( 0 )
+        , nPreTriggerMS( 0 )
+        , nPostTriggerFrames( 0 )
+        , nPostTriggerMS( 0 )
+    {
+    }
+};
+
+//
+// The counters of a FlightRecorder
+//
+struct FlightRecorderStatistics
+{
+    VmbUint64_t     nMemorySize;            // The bytes allocated for the ring
+    VmbUint64_t     nFrameCount;            // Frames pushed into the ring
+    VmbUint64_t     nDroppedCount;          // Frames dropped (too large, or the ring was held by events being written)
+    VmbUint64_t     nEventCount;            // Events written
+    VmbUint64_t     nFailedEventCount;      // Events that could not be written
+};
+
+class FlightRecorder
+{
+  public:
+    //
+    // Gets called on the writer thread once the frames of an event are written
+    //
+    typedef std::function<void( const std::string &rFileName, VmbUint32_t nFrameCount, VmbErrorType eResult )> EventCallback;
+
+    FlightRecorder();
+
+    //
+    // Writes the events still pending
+    //
+    ~FlightRecorder();
+
+    //
+    // Allocates the ring, all memory is taken here and never per frame
+    //
+    // Parameters:
+    //  [in]    rConfig             The size of the ring and of the event window
+    //
+    // Returns:
+    //  An API status code
+    //
+    VmbErrorType    Allocate( const FlightRecorderConfig &rConfig );
+
+    //
+    // Copies a frame into the ring, overwriting the oldest one
+    //
+    // Parameters:
+    //  [in]    rFrame              The frame
+    //
+    // Returns:
+    //  An API status code
+    //  VmbErrorResources if the frame was dropped
+    //
+    VmbErrorType    Push( const ImageFrame &rFrame );
+
+    //
+    // Keeps the frames before the trigger and the ones that follow within the window, then writes
+    // them to a recording file in the background. The ring keeps running meanwhile.
+    //
+    // Parameters:
+    //  [in]    rFileName           The path of the recording to write
+    //  [in]    rCallback           Gets called once the event was written (may be empty)
+    //
+    // Returns:
+    //  An API status code
+    //  VmbErrorInvalidCall if the window of the previous event is still open
+    //
+    VmbErrorType    Trigger( const std::string &rFileName, const EventCallback &rCallback = EventCallback() );
+
+    //
+    // Ends the window of an open event and waits until all events are written
+    //
+    void            Flush();
+
+    //
+    // Gets the counters
+    //
+    FlightRecorderStatistics GetStatistics() const;
+
+  private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Slot
+    {
+        BufferPtr           pBuffer;
+        ImageFrame          frame;              // The image points into pBuffer
+        Clock::time_point   tReceived;
+        bool                bIsFilled;
+        bool                bIsPinned;          // Part of an event that is not written yet
+    };
+
+    struct Event
+    {
+        std::string         strFileName;
+        EventCallback       callback;
+        std::vector<size_t> slots;              // The slots of the event, oldest first
+        Clock::time_point   tTrigger;
+        VmbUint32_t         nPostTriggerCount;
+    };
+    typedef std::shared_ptr<Event> EventPtr;
+
+    void            CloseEvent();
+    void            Run();
+
+    FlightRecorderConfig        m_config;
+    BufferPool                  m_bufferPool;
+    std::vector<Slot>           m_slots;
+    size_t                      m_nNextSlot;
+    EventPtr                    m_pOpenEvent;           // The event whose window is still open
+    std::deque<EventPtr>        m_events;               // Events waiting to be written
+    VmbUint32_t                 m_nWritingCount;        // Events being written right now
+    std::thread                 m_thread;
+    mutable std::mutex          m_mutex;
+    std::condition_variable     m_eventReady;
+    std::condition_variable     m_eventWritten;
+    bool                        m_bStop;
+    FlightRecorderStatistics    m_statistics;
+
+    // No copies
+    FlightRecorder( const FlightRecorder& );
+    FlightRecorder& operator=( const FlightRecorder& );
+};
+typedef std::shared_ptr<FlightRecorder> FlightRecorderPtr;
+
+}}} // namespace AVT::VmbAPI::Examples
+
+#endif
@@ -0,0 +1,97 @@
+/*=============================================================================
+  Copyright (C) 2013 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        FrameObserver.cpp
+
+  Description: The frame observer that is used for notifications from VimbaCPP
+               regarding the arrival of a newly acquired frame.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#include "FrameObserver.h"
+#include "LatencyMonitor.h"
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+//
+// We pass the camera that will deliver the frames to the constructor
+//
+// Parameters:
+//  [in]    pCamera             The camera the frame was queued at
+//  [in]    rCallback           The function that gets every completed frame
+//
+FrameObserver::FrameObserver( CameraPtr pCamera, const FrameCallback &rCallback )
+    : IFrameObserver( pCamera )
+    , m_callback( rCallback )
+{
+}
+
+//
+// This is our callback routine that will be executed on every received frame.
+// Hands the frame to the user callback and requeues it right afterwards.
+//
+// Parameters:
+//  [in]    pFrame              The frame returned from the API
+//
+void FrameObserver::FrameReceived( const FramePtr pFrame )
+{
+    if ( SP_ISNULL( pFrame ))
+    {
+        return;
+    }
+
+    if ( m_callback )
+    {
+        ImageFrame image;
+        image.nReceiveTime = GetLatencyClock();
+        GetImageFrame( pFrame, image );
+        m_callback( image );
+    }
+
+    // Hand the frame back to the camera so the ring keeps going
+    SP_ACCESS( m_pCamera )->QueueFrame( pFrame );
+}
+
+//
+// Describes an SDK frame as an ImageFrame
+//
+// Parameters:
+//  [in]    pFrame              The frame returned from the API
+//  [out]   rImage              The description of the frame
+//
+void GetImageFrame( const FramePtr &pFrame, ImageFrame &rImage )
+{
+    VmbUchar_t *pImage = NULL;
+    rImage.pFrame = pFrame;
+    SP_ACCESS( pFrame )->GetReceiveStatus( rImage.eReceiveStatus );
+    SP_ACCESS( pFrame )->GetImage( pImage );
+    SP_ACCESS( pFrame )->GetImageSize( rImage.nImageSize );
+    SP_ACCESS( pFrame )->GetWidth( rImage.nWidth );
+    SP_ACCESS( pFrame )->GetHeight( rImage.nHeight );
+    SP_ACCESS( pFrame )->GetPixelFormat( rImage.ePixelFormat );
+    SP_ACCESS( pFrame )->GetFrameID( rImage.nFrameID );
+    SP_ACCESS( pFrame )->GetTimestamp( rImage.nTimestamp );
+    rImage.pImage = pImage;
+}
+
+}}} // namespace AVT::VmbAPI::Examples
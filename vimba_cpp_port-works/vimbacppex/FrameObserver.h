@@ -0,0 +1,76 @@
+/*=============================================================================
+  Copyright (C) 2013 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        FrameObserver.h
+
+  Description: The frame observer that is used for notifications from VimbaCPP
+               regarding the arrival of a newly acquired frame.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#ifndef AVT_VMBAPI_EXAMPLES_FRAMEOBSERVER
+#define AVT_VMBAPI_EXAMPLES_FRAMEOBSERVER
+
+#include "VimbaCPP/Include/VimbaCPP.h"
+
+#include "ImageFrame.h"
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+class FrameObserver : virtual public IFrameObserver
+{
+  public:
+    //
+    // We pass the camera that will deliver the frames to the constructor
+    //
+    // Parameters:
+    //  [in]    pCamera             The camera the frame was queued at
+    //  [in]    rCallback           The function that gets every completed frame
+    //
+    FrameObserver( CameraPtr pCamera, const FrameCallback &rCallback );
+
+    //
+    // This is our callback routine that will be executed on every received frame.
+    // Hands the frame to the user callback and requeues it right afterwards.
+    //
+    // Parameters:
+    //  [in]    pFrame              The frame returned from the API
+    //
+    virtual void FrameReceived( const FramePtr pFrame );
+
+  private:
+    FrameCallback m_callback;
+};
+
+//
+// Describes an SDK frame as an ImageFrame
+//
+// Parameters:
+//  [in]    pFrame              The frame returned from the API
+//  [out]   rImage              The description of the frame
+//
+void GetImageFrame( const FramePtr &pFrame, ImageFrame &rImage );
+
+}}} // namespace AVT::VmbAPI::Examples
+
+#endif
@@ -0,0 +1,650 @@
+/*=============================================================================
+  Copyright (C) 2013 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        FrameQueue.h
+
+  Description: Bounded lock-free ring queues that hand frames from the acquisition
+               callbacks to processing and storage threads.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#ifndef AVT_VMBAPI_EXAMPLES_FRAMEQUEUE
+#define AVT_VMBAPI_EXAMPLES_FRAMEQUEUE
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#include "VimbaCPP/Include/VimbaCPP.h"
+
+#include "FrameTracer.h"
+#include "ImageFrame.h"
+#include "LatencyMonitor.h"
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+//
+// How Push and Pop deal with a full or empty queue
+//
+enum QueueMode
+{
+    QueueModeTry,           // Give up at once
+    QueueModeSpin,          // Keep trying without sleeping (lowest latency, burns a core)
+    QueueModeBlock,         // Spin shortly, then sleep until the other side signals
+};
+
+enum { QUEUE_WAIT_INFINITE = 0xFFFFFFFF, };
+enum { QUEUE_CACHE_LINE_SIZE = 64, };
+
+//
+// Rounds up to the next power of two (at least 2) so ring indices can be masked
+//
+inline size_t RoundUpToPowerOfTwo( size_t nValue )
+{
+    size_t nResult = 2;
+    while ( nResult < nValue )
+    {
+        nResult <<= 1;
+    }
+    return nResult;
+}
+
+//
+// Gets the frame an item of a queue carries, the queue stamps it with the time it entered.
+// Items that carry more than a frame (e.g. the jobs of an image writer) overload this.
+//
+inline ImageFrame& GetQueuedFrame( ImageFrame &rFrame )
+{
+    return rFrame;
+}
+
+//
+// A ring for exactly one producer and one consumer thread
+//
+template <typename T>
+class SpscRing
+{
+  public:
+    typedef T ValueType;
+
+    explicit SpscRing( size_t nCapacity )
+        : m_nMask( RoundUpToPowerOfTwo( nCapacity ) - 1 )
+        , m_pItems( new T[m_nMask + 1] )
+        , m_nHead( 0 )
+        , m_nCachedTail( 0 )
+        , m_nTail( 0 )
+        , m_nCachedHead( 0 )
+    {
+    }
+
+    size_t GetCapacity() const
+    {
+        return m_nMask + 1;
+    }
+
+    size_t GetSize() const
+    {
+        return m_nTail.load( std::memory_order_acquire ) - m_nHead.load( std::memory_order_acquire );
+    }
+
+    //
+    // Moves the item into the ring (producer thread only). Leaves it untouched if the ring is full.
+    //
+    bool TryPush( T &rItem )
+    {
+        const size_t nTail = m_nTail.load( std::memory_order_relaxed );
+        if ( nTail - m_nCachedHead > m_nMask )
+        {
+            // Only look at the consumer's index when our copy says full
+            m_nCachedHead = m_nHead.load( std::memory_order_acquire );
+            if ( nTail - m_nCachedHead > m_nMask )
+            {
+                return false;
+            }
+        }
+        m_pItems[nTail & m_nMask] = std::move( rItem );
+        m_nTail.store( nTail + 1, std::memory_order_release );
+        return true;
+    }
+
+    //
+    // Moves the oldest item out of the ring (consumer thread only)
+    //
+    bool TryPop( T &rItem )
+    {
+        const size_t nHead = m_nHead.load( std::memory_order_relaxed );
+        if ( nHead == m_nCachedTail )
+        {
+            m_nCachedTail = m_nTail.load( std::memory_order_acquire );
+            if ( nHead == m_nCachedTail )
+            {
+                return false;
+            }
+        }
+        T &rSlot = m_pItems[nHead & m_nMask];
+        rItem = std::move( rSlot );
+        // Do not keep the frame's buffer alive in an empty slot
+        rSlot = T();
+        m_nHead.store( nHead + 1, std::memory_order_release );
+        return true;
+    }
+
+  private:
+    const size_t                m_nMask;
+    std::unique_ptr<T[]>        m_pItems;
+    // Consumer side, on its own cache line
+    char                        m_padding0[QUEUE_CACHE_LINE_SIZE];
+    std::atomic<size_t>         m_nHead;
+    size_t                      m_nCachedTail;
+    // Producer side, on its own cache line
+    char                        m_padding1[QUEUE_CACHE_LINE_SIZE];
+    std::atomic<size_t>         m_nTail;
+    size_t                      m_nCachedHead;
+    char                        m_padding2[QUEUE_CACHE_LINE_SIZE];
+
+    // No copies
+    SpscRing( const SpscRing& );
+    SpscRing& operator=( const SpscRing& );
+};
+
+//
+// A ring for any number of producer threads and one consumer thread.
+// Every slot carries a sequence number that tells whose turn it is (after D. Vyukov's bounded queue).
+//
+template <typename T>
+class MpscRing
+{
+  public:
+    typedef T ValueType;
+
+    explicit MpscRing( size_t nCapacity )
+        : m_nMask( RoundUpToPowerOfTwo( nCapacity ) - 1 )
+        , m_pSlots( new Slot[m_nMask + 1] )
+        , m_nHead( 0 )
+        , m_nTail( 0 )
+    {
+        for ( size_t i = 0; i <= m_nMask; ++i )
+        {
+            m_pSlots[i].nSequence.store( i, std::memory_order_relaxed );
+        }
+    }
+
+    size_t GetCapacity() const
+    {
+        return m_nMask + 1;
+    }
+
+    size_t GetSize() const
+    {
+        const size_t nTail = m_nTail.load( std::memory_order_acquire );
+        const size_t nHead = m_nHead.load( std::memory_order_acquire );
+        return nTail > nHead ? nTail - nHead : 0;
+    }
+
+    //
+    // Moves the item into the ring (any thread). Leaves it untouched if the ring is full.
+    //
+    bool TryPush( T &rItem )
+    {
+        size_t nTail = m_nTail.load( std::memory_order_relaxed );
+        for ( ;; )
+        {
+            Slot &rSlot = m_pSlots[nTail & m_nMask];
+            const size_t nSequence = rSlot.nSequence.load( std::memory_order_acquire );
+            const ptrdiff_t nDiff = static_cast<ptrdiff_t>( nSequence ) - static_cast<ptrdiff_t>( nTail );
+            if ( 0 == nDiff )
+            {
+                // The slot is free, claim it
+                if ( m_nTail.compare_exchange_weak( nTail, nTail + 1, std::memory_order_relaxed ))
+                {
+                    rSlot.value = std::move( rItem );
+                    rSlot.nSequence.store( nTail + 1, std::memory_order_release );
+                    return true;
+                }
+            }
+            else if ( nDiff < 0 )
+            {
+                // The consumer has not freed the slot yet
+                return false;
+            }
+            else
+            {
+                // Another producer took the slot
+                nTail = m_nTail.load( std::memory_order_relaxed );
+            }
+        }
+    }
+
+    //
+    // Moves the oldest item out of the ring (consumer thread only)
+    //
+    bool TryPop( T &rItem )
+    {
+        const size_t nHead = m_nHead.load( std::memory_order_relaxed );
+        Slot &rSlot = m_pSlots[nHead & m_nMask];
+        if ( rSlot.nSequence.load( std::memory_order_acquire ) != nHead + 1 )
+        {
+            return false;
+        }
+        rItem = std::move( rSlot.value );
+        // Do not keep the frame's buffer alive in an empty slot
+        rSlot.value = T();
+        rSlot.nSequence.store( nHead + m_nMask + 1, std::memory_order_release );
+        m_nHead.store( nHead + 1, std::memory_order_release );
+        return true;
+    }
+
+  private:
+    struct Slot
+    {
+        std::atomic<size_t>     nSequence;
+        T                       value;
+    };
+
+    const size_t                m_nMask;
+    std::unique_ptr<Slot[]>     m_pSlots;
+    char                        m_padding0[QUEUE_CACHE_LINE_SIZE];
+    std::atomic<size_t>         m_nHead;
+    char                        m_padding1[QUEUE_CACHE_LINE_SIZE];
+    std::atomic<size_t>         m_nTail;
+    char                        m_padding2[QUEUE_CACHE_LINE_SIZE];
+
+    // No copies
+    MpscRing( const MpscRing& );
+    MpscRing& operator=( const MpscRing& );
+};
+
+//
+// A ring for any number of producer and consumer threads. Consumers claim slots the way producers do,
+// which costs a compare and swap per pop that MpscRing saves.
+//
+template <typename T>
+class MpmcRing
+{
+  public:
+    typedef T ValueType;
+
+    explicit MpmcRing( size_t nCapacity )
+        : m_nMask( RoundUpToPowerOfTwo( nCapacity ) - 1 )
+        , m_pSlots( new Slot[m_nMask + 1] )
+        , m_nHead( 0 )
+        , m_nTail( 0 )
+    {
+        for ( size_t i = 0; i <= m_nMask; ++i )
+        {
+            m_pSlots[i].nSequence.store( i, std::memory_order_relaxed );
+        }
+    }
+
+    size_t GetCapacity() const
+    {
+        return m_nMask + 1;
+    }
+
+    size_t GetSize() const
+    {
+        const size_t nTail = m_nTail.load( std::memory_order_acquire );
+        const size_t nHead = m_nHead.load( std::memory_order_acquire );
+        return nTail > nHead ? nTail - nHead : 0;
+    }
+
+    //
+    // Moves the item into the ring (any thread). Leaves it untouched if the ring is full.
+    //
+    bool TryPush( T &rItem )
+    {
+        size_t nTail = m_nTail.load( std::memory_order_relaxed );
+        for ( ;; )
+        {
+            Slot &rSlot = m_pSlots[nTail & m_nMask];
+            const size_t nSequence = rSlot.nSequence.load( std::memory_order_acquire );
+            const ptrdiff_t nDiff = static_cast<ptrdiff_t>( nSequence ) - static_cast<ptrdiff_t>( nTail );
+            if ( 0 == nDiff )
+            {
+                // The slot is free, claim it
+                if ( m_nTail.compare_exchange_weak( nTail, nTail + 1, std::memory_order_relaxed ))
+                {
+                    rSlot.value = std::move( rItem );
+                    rSlot.nSequence.store( nTail + 1, std::memory_order_release );
+                    return true;
+                }
+            }
+            else if ( nDiff < 0 )
+            {
+                // The consumers have not freed the slot yet
+                return false;
+            }
+            else
+            {
+                // Another producer took the slot
+                nTail = m_nTail.load( std::memory_order_relaxed );
+            }
+        }
+    }
+
+    //
+    // Moves the oldest item out of the ring (any thread)
+    //
+    bool TryPop( T &rItem )
+    {
+        size_t nHead = m_nHead.load( std::memory_order_relaxed );
+        for ( ;; )
+        {
+            Slot &rSlot = m_pSlots[nHead & m_nMask];
+            const size_t nSequence = rSlot.nSequence.load( std::memory_order_acquire );
+            const ptrdiff_t nDiff = static_cast<ptrdiff_t>( nSequence ) - static_cast<ptrdiff_t>( nHead + 1 );
+            if ( 0 == nDiff )
+            {
+                // The slot is filled, claim it
+                if ( m_nHead.compare_exchange_weak( nHead, nHead + 1, std::memory_order_relaxed ))
+                {
+                    rItem = std::move( rSlot.value );
+                    // Do not keep the frame's buffer alive in an empty slot
+                    rSlot.value = T();
+                    rSlot.nSequence.store( nHead + m_nMask + 1, std::memory_order_release );
+                    return true;
+                }
+            }
+            else if ( nDiff < 0 )
+            {
+                // The producer has not filled the slot yet
+                return false;
+            }
+            else
+            {
+                // Another consumer took the item
+                nHead = m_nHead.load( std::memory_order_relaxed );
+            }
+        }
+    }
+
+  private:
+    struct Slot
+    {
+        std::atomic<size_t>     nSequence;
+        T                       value;
+    };
+
+    const size_t                m_nMask;
+    std::unique_ptr<Slot[]>     m_pSlots;
+    char                        m_padding0[QUEUE_CACHE_LINE_SIZE];
+    std::atomic<size_t>         m_nHead;
+    char                        m_padding1[QUEUE_CACHE_LINE_SIZE];
+    std::atomic<size_t>         m_nTail;
+    char                        m_padding2[QUEUE_CACHE_LINE_SIZE];
+
+    // No copies
+    MpmcRing( const MpmcRing& );
+    MpmcRing& operator=( const MpmcRing& );
+};
+
+//
+// Lets a thread sleep until the other side of a queue made progress.
+// Notify only takes the mutex if somebody is waiting, so the fast path stays lock-free.
+//
+class QueueSignal
+{
+  public:
+    QueueSignal()
+        : m_nWaiters( 0 )
+    {
+    }
+
+    void Notify()
+    {
+        // Orders the queue update before reading the waiter count (pairs with the increment in Wait)
+        std::atomic_thread_fence( std::memory_order_seq_cst );
+        if ( 0 != m_nWaiters.load( std::memory_order_relaxed ))
+        {
+            std::lock_guard<std::mutex> lock( m_mutex );
+            m_condition.notify_all();
+        }
+    }
+
+    //
+    // Waits until the predicate holds or the timeout expires
+    //
+    template <typename Predicate>
+    bool Wait( Predicate predicate, VmbUint32_t nTimeoutMS )
+    {
+        const std::chrono::steady_clock::time_point tDeadline = std::chrono::steady_clock::now() + std::chrono::milliseconds( nTimeoutMS );
+        std::unique_lock<std::mutex> lock( m_mutex );
+        m_nWaiters.fetch_add( 1, std::memory_order_seq_cst );
+        bool bResult = predicate();
+        while ( !bResult )
+        {
+            if ( QUEUE_WAIT_INFINITE == nTimeoutMS )
+            {
+                m_condition.wait( lock );
+            }
+            else if ( std::cv_status::timeout == m_condition.wait_until( lock, tDeadline ))
+            {
+                bResult = predicate();
+                break;
+            }
+            bResult = predicate();
+        }
+        m_nWaiters.fetch_sub( 1, std::memory_order_relaxed );
+        return bResult;
+    }
+
+  private:
+    std::atomic<VmbUint32_t>    m_nWaiters;
+    std::mutex                  m_mutex;
+    std::condition_variable     m_condition;
+};
+
+//
+// A bounded queue on top of SpscRing, MpscRing or MpmcRing that can try, spin or block,
+// counts how often producers found it full and can be closed to release waiting threads
+//
+template <typename Ring>
+class FrameQueue
+{
+  public:
+    typedef typename Ring::ValueType ValueType;
+
+    //
+    // Parameters:
+    //  [in]    nCapacity           The number of items the queue holds at least (rounded up to a power of two)
+    //
+    explicit FrameQueue( size_t nCapacity )
+        : m_ring( nCapacity )
+        , m_nOverflows( 0 )
+        , m_bIsClosed( false )
+    {
+    }
+
+    //
+    // Adds an item, stamped with the time it entered the queue
+    //
+    // Parameters:
+    //  [in]    item                The item to add
+    //  [in]    eMode               What to do if the queue is full
+    //  [in]    nTimeoutMS          How long to spin or block at most
+    //
+    // Returns:
+    //  False if the queue is closed, or stayed full
+    //
+    bool Push( ValueType item, QueueMode eMode = QueueModeBlock, VmbUint32_t nTimeoutMS = QUEUE_WAIT_INFINITE )
+    {
+        if ( m_bIsClosed.load( std::memory_order_acquire ))
+        {
+            return false;
+        }
+        GetQueuedFrame( item ).nQueueTime = GetLatencyClock();
+        bool bIsPushed = m_ring.TryPush( item );
+        if ( !bIsPushed )
+        {
+            m_nOverflows.fetch_add( 1, std::memory_order_relaxed );
+            Wait(   m_notFull, eMode, nTimeoutMS,
+                    [this, &item, &bIsPushed]()
+                    {
+                        bIsPushed = m_ring.TryPush( item );
+                        return bIsPushed || m_bIsClosed.load( std::memory_order_acquire );
+                    } );
+        }
+        if ( bIsPushed )
+        {
+            m_notEmpty.Notify();
+        }
+        return bIsPushed;
+    }
+
+    //
+    // Takes the oldest item and records how long it waited (LatencyStageQueue)
+    //
+    // Parameters:
+    //  [out]   rItem               The item
+    //  [in]    eMode               What to do if the queue is empty
+    //  [in]    nTimeoutMS          How long to spin or block at most
+    //
+    // Returns:
+    //  False if the queue is closed and drained, or stayed empty
+    //
+    bool Pop( ValueType &rItem, QueueMode eMode = QueueModeBlock, VmbUint32_t nTimeoutMS = QUEUE_WAIT_INFINITE )
+    {
+        bool bIsPopped = m_ring.TryPop( rItem );
+        if ( !bIsPopped )
+        {
+            Wait(   m_notEmpty, eMode, nTimeoutMS,
+                    [this, &rItem, &bIsPopped]()
+                    {
+                        if ( m_bIsClosed.load( std::memory_order_acquire ))
+                        {
+                            // Producers are done, take what is left
+                            bIsPopped = m_ring.TryPop( rItem );
+                            return true;
+                        }
+                        bIsPopped = m_ring.TryPop( rItem );
+                        return bIsPopped;
+                    } );
+        }
+        if ( bIsPopped )
+        {
+            m_notFull.Notify();
+            const ImageFrame &rFrame = GetQueuedFrame( rItem );
+            const VmbUint64_t nPopTime = GetLatencyClock();
+            LatencyMonitor::GetDefault().Record( LatencyStageQueue, nPopTime - rFrame.nQueueTime );
+            FrameTracer &rTracer = FrameTracer::GetDefault();
+            if ( rTracer.IsEnabled() )
+            {
+                rTracer.AddSpan( "Queue", rFrame.nFrameID, rFrame.nQueueTime, nPopTime );
+            }
+        }
+        return bIsPopped;
+    }
+
+    //
+    // Refuses further pushes and wakes all waiting threads. Consumers still get the remaining items.
+    //
+    void Close()
+    {
+        m_bIsClosed.store( true, std::memory_order_release );
+        m_notFull.Notify();
+        m_notEmpty.Notify();
+    }
+
+    bool IsClosed() const
+    {
+        return m_bIsClosed.load( std::memory_order_acquire );
+    }
+
+    //
+    // Gets how often a producer found the queue full
+    //
+    VmbUint64_t GetOverflowCount() const
+    {
+        return m_nOverflows.load( std::memory_order_relaxed );
+    }
+
+    size_t GetCapacity() const
+    {
+        return m_ring.GetCapacity();
+    }
+
+    //
+    // Gets the number of queued items (a snapshot while other threads work on the queue)
+    //
+    size_t GetSize() const
+    {
+        return m_ring.GetSize();
+    }
+
+  private:
+    enum { SPIN_COUNT = 256, };
+
+    template <typename Predicate>
+    void Wait( QueueSignal &rSignal, QueueMode eMode, VmbUint32_t nTimeoutMS, Predicate predicate )
+    {
+        if ( QueueModeTry == eMode )
+        {
+            return;
+        }
+        // A short spin catches the other side when it is just about to finish
+        for ( int i = 0; i < SPIN_COUNT; ++i )
+        {
+            if ( predicate() )
+            {
+                return;
+            }
+        }
+        if ( QueueModeBlock == eMode )
+        {
+            rSignal.Wait( predicate, nTimeoutMS );
+            return;
+        }
+        const std::chrono::steady_clock::time_point tDeadline = std::chrono::steady_clock::now() + std::chrono::milliseconds( nTimeoutMS );
+        while ( !predicate() )
+        {
+            if (    QUEUE_WAIT_INFINITE != nTimeoutMS
+                 && std::chrono::steady_clock::now() >= tDeadline )
+            {
+                return;
+            }
+            std::this_thread::yield();
+        }
+    }
+
+    Ring                        m_ring;
+    std::atomic<VmbUint64_t>    m_nOverflows;
+    std::atomic<bool>           m_bIsClosed;
+    QueueSignal                 m_notFull;
+    QueueSignal                 m_notEmpty;
+
+    // No copies
+    FrameQueue( const FrameQueue& );
+    FrameQueue& operator=( const FrameQueue& );
+};
+
+// Frame queues for one callback thread and for several cameras feeding one consumer
+typedef FrameQueue< SpscRing<ImageFrame> > SpscFrameQueue;
+typedef FrameQueue< MpscRing<ImageFrame> > MpscFrameQueue;
+
+}}} // namespace AVT::VmbAPI::Examples
+
+#endif
@@ -0,0 +1,296 @@
+/*=============================================================================
+  Copyright (C) 2013 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        FrameTracer.cpp
+
+  Description: Records per-frame spans of the acquisition pipeline into per-thread
+               buffers and writes them as a Chrome trace (viewable in Perfetto).
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#include <algorithm>
+#include <cstdio>
+#include <new>
+#include <vector>
+
+#include "FrameTracer.h"
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+namespace {
+
+//
+// Gets the smallest power of two that is not below a value
+//
+VmbUint64_t RoundUpToPowerOfTwo( VmbUint64_t nValue )
+{
+    VmbUint64_t nPower = 1;
+    while ( nPower < nValue )
+    {
+        nPower *= 2;
+    }
+    return nPower;
+}
+
+// Hands out the serials that tell tracers apart
+std::atomic<VmbUint64_t> g_nNextTracerSerial( 1 );
+
+// The buffer the calling thread used last and the tracer it belongs to
+thread_local VmbUint64_t g_nCachedBufferSerial = 0;
+thread_local void* g_pCachedBuffer = NULL;
+
+} // namespace
+
+const VmbUint64_t FrameTracer::NO_FRAME_ID;
+
+FrameTracer::FrameTracer( VmbUint32_t nSpansPerThread )
+    : m_nSpanMask( RoundUpToPowerOfTwo(( std::max )( nSpansPerThread, 1U )) - 1 )
+    , m_nSerial( g_nNextTracerSerial++ )
+    , m_bIsEnabled( false )
+    , m_nEnableTimeNS( 0 )
+    , m_pBuffers( NULL )
+    , m_nThreadCount( 0 )
+{
+}
+
+FrameTracer::~FrameTracer()
+{
+    ThreadBuffer *pBuffer = m_pBuffers.load();
+    while ( NULL != pBuffer )
+    {
+        ThreadBuffer *pNext = pBuffer->pNext;
+        delete pBuffer;
+        pBuffer = pNext;
+    }
+}
+
+//
+// Gets the tracer the pipeline records into
+//
+FrameTracer& FrameTracer::GetDefault()
+{
+    static FrameTracer tracer;
+    return tracer;
+}
+
+//
+// Starts recording, the spans of an earlier run are not written any more
+//
+void FrameTracer::Enable()
+{
+    m_nEnableTimeNS = GetLatencyClock();
+    m_bIsEnabled = true;
+}
+
+//
+// Stops recording, the spans recorded so far can still be written
+//
+void FrameTracer::Disable()
+{
+    m_bIsEnabled = false;
+}
+
+//
+// Records a span of the calling thread (lock-free, any thread)
+//
+// Parameters:
+//  [in]    pName               What was done, a string literal (it is kept as a pointer)
+//  [in]    nFrameID            The frame it was done with or NO_FRAME_ID
+//  [in]    nBeginNS            When it began in GetLatencyClock() time
+//  [in]    nEndNS              When it ended in GetLatencyClock() time
+//
+void FrameTracer::AddSpan( const char *pName, VmbUint64_t nFrameID, VmbUint64_t nBeginNS, VmbUint64_t nEndNS )
+{
+    ThreadBuffer *pBuffer = GetBuffer();
+    if (    NULL == pBuffer
+         || NULL == pName )
+    {
+        return;
+    }
+
+    // A sequence lock: the start count tells readers the slot is being overwritten before it is,
+    // the write count tells them it is complete after it is
+    const VmbUint64_t nIndex = pBuffer->nWriteCount.load( std::memory_order_relaxed );
+    pBuffer->nStartCount.store( nIndex + 1, std::memory_order_relaxed );
+    std::atomic_thread_fence( std::memory_order_release );
+    Span &rSpan = pBuffer->pSpans[nIndex & m_nSpanMask];
+    rSpan.pName.store( pName, std::memory_order_relaxed );
+    rSpan.nFrameID.store( nFrameID, std::memory_order_relaxed );
+    rSpan.nBeginNS.store( nBeginNS, std::memory_order_relaxed );
+    rSpan.nEndNS.store( nEndNS, std::memory_order_relaxed );
+    pBuffer->nWriteCount.store( nIndex + 1, std::memory_order_release );
+}
+
+//
+// Writes the spans since the last Enable as Chrome trace-event JSON, which Perfetto and
+// chrome://tracing open. Spans can be written while threads record.
+//
+// Parameters:
+//  [in]    rFileName           The path of the file to write
+//
+// Returns:
+//  An API status code
+//
+VmbErrorType FrameTracer::WriteChromeTrace( const std::string &rFileName ) const
+{
+    struct TracedSpan
+    {
+        const char*     pName;
+        VmbUint64_t     nFrameID;
+        VmbUint64_t     nBeginNS;
+        VmbUint64_t     nEndNS;
+        VmbUint32_t     nThreadIndex;
+    };
+
+    // Copy the spans first so the file is not written while the rings keep turning
+    const VmbUint64_t nEnableTimeNS = m_nEnableTimeNS;
+    const VmbUint64_t nSpanCount = m_nSpanMask + 1;
+    std::vector<TracedSpan> spans;
+    std::vector<VmbUint32_t> threadIndices;
+    VmbUint64_t nFirstBeginNS = ~0ULL;
+    for (   const ThreadBuffer *pBuffer = m_pBuffers.load( std::memory_order_acquire );
+            NULL != pBuffer;
+            pBuffer = pBuffer->pNext )
+    {
+        threadIndices.push_back( pBuffer->nThreadIndex );
+        const VmbUint64_t nEnd = pBuffer->nWriteCount.load( std::memory_order_acquire );
+        const VmbUint64_t nBegin = nEnd > nSpanCount ? nEnd - nSpanCount : 0;
+        const size_t nFirstSpan = spans.size();
+        for ( VmbUint64_t i = nBegin; i < nEnd; ++i )
+        {
+            const Span &rSpan = pBuffer->pSpans[i & m_nSpanMask];
+            TracedSpan span;
+            span.pName          = rSpan.pName.load( std::memory_order_relaxed );
+            span.nFrameID       = rSpan.nFrameID.load( std::memory_order_relaxed );
+            span.nBeginNS       = rSpan.nBeginNS.load( std::memory_order_relaxed );
+            span.nEndNS         = rSpan.nEndNS.load( std::memory_order_relaxed );
+            span.nThreadIndex   = pBuffer->nThreadIndex;
+            spans.push_back( span );
+        }
+
+        // Drop what the thread overwrote while it was copied, and what ended before tracing was enabled
+        std::atomic_thread_fence( std::memory_order_acquire );
+        const VmbUint64_t nStarted = pBuffer->nStartCount.load( std::memory_order_relaxed );
+        const VmbUint64_t nValidBegin = nStarted > nSpanCount ? nStarted - nSpanCount : 0;
+        size_t nKept = nFirstSpan;
+        for ( size_t i = nFirstSpan; i < spans.size(); ++i )
+        {
+            if (    nBegin + ( i - nFirstSpan ) >= nValidBegin
+                 && spans[i].nEndNS >= nEnableTimeNS )
+            {
+                spans[nKept++] = spans[i];
+                nFirstBeginNS = ( std::min )( nFirstBeginNS, spans[i].nBeginNS );
+            }
+        }
+        spans.resize( nKept );
+    }
+
+    FILE *pFile = fopen( rFileName.c_str(), "w" );
+    if ( NULL == pFile )
+    {
+        return VmbErrorOther;
+    }
+    // Complete events ("X") in microseconds since the first span, one track per thread
+    fprintf( pFile, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n" );
+    fprintf( pFile, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"Acquisition\"}}" );
+    for (   std::vector<VmbUint32_t>::const_iterator iter = threadIndices.begin();
+            threadIndices.end() != iter;
+            ++iter )
+    {
+        fprintf( pFile, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"Thread %u\"}}", *iter, *iter );
+    }
+    for (   std::vector<TracedSpan>::const_iterator iter = spans.begin();
+            spans.end() != iter;
+            ++iter )
+    {
+        const VmbUint64_t nBeginNS = ( std::max )( iter->nBeginNS, nFirstBeginNS );
+        const VmbUint64_t nDurationNS = iter->nEndNS > nBeginNS ? iter->nEndNS - nBeginNS : 0;
+        fprintf( pFile, ",\n{\"name\":\"%s\",\"cat\":\"frame\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f",
+                 iter->pName,
+                 iter->nThreadIndex,
+                 ( nBeginNS - nFirstBeginNS ) / 1000.0,
+                 nDurationNS / 1000.0 );
+        if ( NO_FRAME_ID != iter->nFrameID )
+        {
+            fprintf( pFile, ",\"args\":{\"frame\":%llu}", static_cast<unsigned long long>( iter->nFrameID ));
+        }
+        fprintf( pFile, "}" );
+    }
+    fprintf( pFile, "\n]}\n" );
+
+    const bool bIsWritten = 0 == ferror( pFile );
+    if (    0 != fclose( pFile )
+         || !bIsWritten )
+    {
+        return VmbErrorOther;
+    }
+    return VmbErrorSuccess;
+}
+
+//
+// Gets the buffer of the calling thread, adds one on its first call
+//
+FrameTracer::ThreadBuffer* FrameTracer::GetBuffer()
+{
+    if ( m_nSerial == g_nCachedBufferSerial )
+    {
+        return static_cast<ThreadBuffer*>( g_pCachedBuffer );
+    }
+
+    // The thread may have recorded into this tracer before it recorded into another one
+    const std::thread::id threadID = std::this_thread::get_id();
+    ThreadBuffer *pBuffer = m_pBuffers.load( std::memory_order_acquire );
+    while (    NULL != pBuffer
+            && threadID != pBuffer->threadID )
+    {
+        pBuffer = pBuffer->pNext;
+    }
+    if ( NULL == pBuffer )
+    {
+        // The only allocation of a thread, the ring is zeroed here and then only written by the thread
+        pBuffer = new ( std::nothrow ) ThreadBuffer();
+        if ( NULL == pBuffer )
+        {
+            return NULL;
+        }
+        pBuffer->pSpans.reset( new ( std::nothrow ) Span[m_nSpanMask + 1]() );
+        if ( !pBuffer->pSpans )
+        {
+            delete pBuffer;
+            return NULL;
+        }
+        pBuffer->nStartCount = 0;
+        pBuffer->nWriteCount = 0;
+        pBuffer->nThreadIndex = ++m_nThreadCount;
+        pBuffer->threadID = threadID;
+        pBuffer->pNext = m_pBuffers.load( std::memory_order_relaxed );
+        while ( !m_pBuffers.compare_exchange_weak( pBuffer->pNext, pBuffer, std::memory_order_release, std::memory_order_relaxed ))
+        {
+        }
+    }
+    g_nCachedBufferSerial = m_nSerial;
+    g_pCachedBuffer = pBuffer;
+    return pBuffer;
+}
+
+}}} // namespace AVT::VmbAPI::Examples
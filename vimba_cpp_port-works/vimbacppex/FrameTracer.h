@@ -0,0 +1,187 @@
+/*=============================================================================
+  Copyright (C) 2013 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        FrameTracer.h
+
+  Description: Records per-frame spans of the acquisition pipeline into per-thread
+               buffers and writes them as a Chrome trace (viewable in Perfetto).
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#ifndef AVT_VMBAPI_EXAMPLES_FRAMETRACER
+#define AVT_VMBAPI_EXAMPLES_FRAMETRACER
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "VimbaCPP/Include/VimbaCPP.h"
+
+#include "LatencyMonitor.h"
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+//
+// Records begin and end of what the pipeline does with every frame, per thread, while enabled.
+// Every thread gets a ring of spans on its first span, recording into it never locks or allocates
+// and keeps the latest spans once the ring is full. Disabled, a span costs one relaxed load and a branch.
+//
+class FrameTracer
+{
+  public:
+    enum { DEFAULT_SPANS_PER_THREAD = 16384, };
+    // The frame ID of spans that do not belong to a frame
+    static const VmbUint64_t NO_FRAME_ID = ~0ULL;
+
+    //
+    // Parameters:
+    //  [in]    nSpansPerThread     The spans every thread keeps, rounded up to a power of two
+    //
+    explicit FrameTracer( VmbUint32_t nSpansPerThread = DEFAULT_SPANS_PER_THREAD );
+
+    ~FrameTracer();
+
+    //
+    // Gets the tracer the pipeline records into
+    //
+    static FrameTracer& GetDefault();
+
+    //
+    // Starts recording, the spans of an earlier run are not written any more
+    //
+    void            Enable();
+
+    //
+    // Stops recording, the spans recorded so far can still be written
+    //
+    void            Disable();
+
+    //
+    // Tells whether spans are recorded
+    //
+    bool            IsEnabled() const
+    {
+        return m_bIsEnabled.load( std::memory_order_relaxed );
+    }
+
+    //
+    // Records a span of the calling thread (lock-free, any thread)
+    //
+    // Parameters:
+    //  [in]    pName               What was done, a string literal (it is kept as a pointer)
+    //  [in]    nFrameID            The frame it was done with or NO_FRAME_ID
+    //  [in]    nBeginNS            When it began in GetLatencyClock() time
+    //  [in]    nEndNS              When it ended in GetLatencyClock() time
+    //
+    void            AddSpan( const char *pName, VmbUint64_t nFrameID, VmbUint64_t nBeginNS, VmbUint64_t nEndNS );
+
+    //
+    // Writes the spans since the last Enable as Chrome trace-event JSON, which Perfetto and
+    // chrome://tracing open. Spans can be written while threads record.
+    //
+    // Parameters:
+    //  [in]    rFileName           The path of the file to write
+    //
+    // Returns:
+    //  An API status code
+    //
+    VmbErrorType    WriteChromeTrace( const std::string &rFileName ) const;
+
+  private:
+    // A span as its thread wrote it, atomic so the writer of the trace may read it while it gets overwritten
+    struct Span
+    {
+        std::atomic<const char*>    pName;
+        std::atomic<VmbUint64_t>    nFrameID;
+        std::atomic<VmbUint64_t>    nBeginNS;
+        std::atomic<VmbUint64_t>    nEndNS;
+    };
+
+    // The ring of one thread, only that thread writes it
+    struct ThreadBuffer
+    {
+        std::unique_ptr<Span[]>     pSpans;
+        // Spans started and finished writing, a reader drops the spans that were overwritten while it read
+        std::atomic<VmbUint64_t>    nStartCount;
+        std::atomic<VmbUint64_t>    nWriteCount;
+        VmbUint32_t                 nThreadIndex;
+        std::thread::id             threadID;
+        ThreadBuffer*               pNext;
+    };
+
+    //
+    // Gets the buffer of the calling thread, adds one on its first call
+    //
+    ThreadBuffer*   GetBuffer();
+
+    const VmbUint64_t           m_nSpanMask;
+    // Tells the buffers of the thread local cache of different tracers apart
+    const VmbUint64_t           m_nSerial;
+    std::atomic<bool>           m_bIsEnabled;
+    // Spans that ended before the last Enable are not written
+    std::atomic<VmbUint64_t>    m_nEnableTimeNS;
+    // The buffers of all threads that ever recorded, pushed to the front lock-free and freed with the tracer
+    std::atomic<ThreadBuffer*>  m_pBuffers;
+    std::atomic<VmbUint32_t>    m_nThreadCount;
+
+    // No copies
+    FrameTracer( const FrameTracer& );
+    FrameTracer& operator=( const FrameTracer& );
+};
+
+//
+// Records the time from its construction to its destruction as a span of the default tracer,
+// if tracing was enabled at its construction
+//
+class TraceScope
+{
+  public:
+    explicit TraceScope( const char *pName, VmbUint64_t nFrameID = FrameTracer::NO_FRAME_ID )
+        : m_pName( pName )
+        , m_nFrameID( nFrameID )
+        , m_nBeginNS( FrameTracer::GetDefault().IsEnabled() ? GetLatencyClock() : 0 )
+    {
+    }
+
+    ~TraceScope()
+    {
+        if ( 0 != m_nBeginNS )
+        {
+            FrameTracer::GetDefault().AddSpan( m_pName, m_nFrameID, m_nBeginNS, GetLatencyClock() );
+        }
+    }
+
+  private:
+    const char* const   m_pName;
+    const VmbUint64_t   m_nFrameID;
+    const VmbUint64_t   m_nBeginNS;
+
+    // No copies
+    TraceScope( const TraceScope& );
+    TraceScope& operator=( const TraceScope& );
+};
+
+}}} // namespace AVT::VmbAPI::Examples
+
+#endif
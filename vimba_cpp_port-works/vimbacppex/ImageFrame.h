@@ -0,0 +1,114 @@
+/*=============================================================================
+  Copyright (C) 2013 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        ImageFrame.h
+
+  Description: A lightweight description of a completed image that is handed
+               to frame callbacks, independent of where the image came from.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#ifndef AVT_VMBAPI_EXAMPLES_IMAGEFRAME
+#define AVT_VMBAPI_EXAMPLES_IMAGEFRAME
+
+#include <functional>
+#include <memory>
+
+#include "VimbaCPP/Include/VimbaCPP.h"
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+//
+// A completed image as seen by frame callbacks.
+// Inside a frame callback the image memory is owned by the source of the
+// frame and is only valid until the callback returns (the buffer is requeued
+// afterwards). Single images keep their memory alive through pFrame or pOwner.
+//
+struct ImageFrame
+{
+    const VmbUchar_t*   pImage;             // The first byte of the image data
+    VmbUint32_t         nImageSize;         // The size of the image data in bytes
+    VmbUint32_t         nWidth;             // The width of the image in pixels
+    VmbUint32_t         nHeight;            // The height of the image in pixels
+    VmbPixelFormatType  ePixelFormat;       // The pixel format of the image data
+    VmbUint64_t         nFrameID;           // The ID the camera assigned to this frame
+    VmbUint64_t         nTimestamp;         // The camera timestamp of this frame
+    VmbUint64_t         nReceiveTime;       // When the host got the frame (GetLatencyClock), 0 if unknown
+    VmbUint64_t         nQueueTime;         // When the frame entered its last frame queue (GetLatencyClock)
+    VmbFrameStatusType  eReceiveStatus;     // Whether the frame was received completely
+    FramePtr            pFrame;             // The SDK frame backing the image (empty for non SDK sources)
+    std::shared_ptr<void> pOwner;           // Keeps the image memory of non SDK sources alive (may be empty)
+
+    ImageFrame()
+        : pImage( NULL )
+        , nImageSize( 0 )
+        , nWidth( 0 )
+        , nHeight( 0 )
+        , ePixelFormat( VmbPixelFormatMono8 )
+        , nFrameID( 0 )
+        , nTimestamp( 0 )
+        , nReceiveTime( 0 )
+        , nQueueTime( 0 )
+        , eReceiveStatus( VmbFrameStatusInvalid )
+    {
+    }
+};
+
+//
+// The function that gets called for every completed frame of a continuous acquisition
+//
+typedef std::function<void( const ImageFrame &rFrame )> FrameCallback;
+
+//
+// Gets the number of bits a single pixel occupies in memory
+//
+// Parameters:
+//  [in]    ePixelFormat        The pixel format to look at
+//
+// Returns:
+//  The number of bits per pixel as encoded in the pixel format
+//
+inline VmbUint32_t GetBitsPerPixel( VmbPixelFormatType ePixelFormat )
+{
+    return ( static_cast<VmbUint32_t>( ePixelFormat ) >> 16 ) & 0xFF;
+}
+
+//
+// Gets the size in bytes of an unpadded image
+//
+// Parameters:
+//  [in]    nWidth              The width of the image in pixels
+//  [in]    nHeight             The height of the image in pixels
+//  [in]    ePixelFormat        The pixel format of the image
+//
+// Returns:
+//  The size of the image data in bytes
+//
+inline VmbUint32_t GetImageSize( VmbUint32_t nWidth, VmbUint32_t nHeight, VmbPixelFormatType ePixelFormat )
+{
+    return static_cast<VmbUint32_t>( ( static_cast<VmbUint64_t>( nWidth ) * nHeight * GetBitsPerPixel( ePixelFormat ) + 7 ) / 8 );
+}
+
+}}} // namespace AVT::VmbAPI::Examples
+
+#endif
@@ -0,0 +1,471 @@
+/*=============================================================================
+  Copyright (C) 2013 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        ImageWriter.cpp
+
+  Description: Writes images to bitmap files on a small pool of I/O threads so
+               acquisition never waits for the disk.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#include <algorithm>
+#include <cstring>
+
+#include "ImageWriter.h"
+#include "BayerImage.h"
+#include "Bitmap.h"
+#include "BufferPool.h"
+#include "FrameTracer.h"
+#include "LatencyMonitor.h"
+#include "MetricsRegistry.h"
+#include "MonoImage.h"
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+//
+// Starts the I/O threads
+//
+// Parameters:
+//  [in]    nThreadCount        The number of I/O threads
+//  [in]    nQueueCapacity      The number of images that may wait to be written (rounded up to a power of two)
+//  [in]    ePolicy             What Submit does when the queue is full
+//  [in]    nBlockTimeoutMS     How long Submit waits for a free slot with WriterPolicyBlock
+//  [in]    nBatchSize          The number of images an I/O thread takes from the queue at once
+//
+ImageWriter::ImageWriter( VmbUint32_t nThreadCount, VmbUint32_t nQueueCapacity, WriterPolicy ePolicy, VmbUint32_t nBlockTimeoutMS, VmbUint32_t nBatchSize )
+    : m_jobs( ( std::max )( nQueueCapacity, 1u ))
+    , m_ePolicy( ePolicy )
+    , m_nBlockTimeoutMS( nBlockTimeoutMS )
+    , m_nBatchSize( ( std::max )( nBatchSize, 1u ))
+    , m_nPendingCount( 0 )
+    , m_nMinStripeSize( AVT_BITMAP_DEFAULT_MIN_STRIPE_SIZE )
+    , m_nMaxQueueDepth( 0 )
+    , m_nDroppedCount( 0 )
+{
+    ResetStatistics();
+    nThreadCount = ( std::max )( nThreadCount, 1u );
+    m_threads.reserve( nThreadCount );
+    for ( VmbUint32_t i = 0; i < nThreadCount; ++i )
+    {
+        m_threads.push_back( std::thread( &ImageWriter::Run, this ));
+    }
+}
+
+//
+// Writes the images still queued and joins the threads
+//
+ImageWriter::~ImageWriter()
+{
+    // The I/O threads drain the queue before they end
+    m_jobs.Close();
+    for (   std::vector<std::thread>::iterator iter = m_threads.begin();
+            m_threads.end() != iter;
+            ++iter )
+    {
+        iter->join();
+    }
+}
+
+//
+// Queues an image to be written to a bitmap file. The image memory must stay valid until the
+// image is written, which pFrame or pOwner of the frame take care of.
+//
+// Parameters:
+//  [in]    rFrame              The image, any mono format, 8 bit Bayer, RGB8 or BGR8
+//  [in]    rFileName           The destination (complete path) of the bitmap, a name ending
+//                              in .pgm keeps all bits of a mono image
+//  [in]    rCallback           Gets called once the image was written (may be empty)
+//
+// Returns:
+//  An API status code
+//  VmbErrorTimeout if the queue stayed full for the block timeout
+//  VmbErrorResources if the queue was full and the policy drops new images
+//
+VmbErrorType ImageWriter::Submit( const ImageFrame &rFrame, const std::string &rFileName, const CompletionCallback &rCallback )
+{
+    if (    NULL == rFrame.pImage
+         || rFileName.empty() )
+    {
+        return VmbErrorBadParameter;
+    }
+
+    Job job;
+    job.frame       = rFrame;
+    job.strFileName = rFileName;
+    job.callback    = rCallback;
+    job.nSubmitTime = GetLatencyClock();
+
+    const WriteMetrics &rMetrics = WriteMetrics::GetDefault();
+    m_nPendingCount.fetch_add( 1 );
+    bool bIsQueued = false;
+    switch ( m_ePolicy )
+    {
+    case WriterPolicyDropNewest:
+        bIsQueued = m_jobs.Push( std::move( job ), QueueModeTry );
+        break;
+    case WriterPolicyDropOldest:
+        // Make room by throwing away the oldest waiting images, I/O threads may take them meanwhile
+        while (    !bIsQueued
+                && !m_jobs.IsClosed() )
+        {
+            bIsQueued = m_jobs.Push( job, QueueModeTry );
+            Job droppedJob;
+            if (    !bIsQueued
+                 && m_jobs.Pop( droppedJob, QueueModeTry ))
+            {
+                m_nDroppedCount.fetch_add( 1 );
+                rMetrics.pFramesNotSaved->Add();
+                rMetrics.pWriterQueueDepth->Add( -1 );
+                if ( droppedJob.callback )
+                {
+                    droppedJob.callback( droppedJob.frame, droppedJob.strFileName, VmbErrorResources );
+                }
+                CompleteJobs( 1 );
+            }
+        }
+        break;
+    default:
+        bIsQueued = m_jobs.Push( std::move( job ), QueueModeBlock, m_nBlockTimeoutMS );
+        break;
+    }
+
+    if ( !bIsQueued )
+    {
+        m_nDroppedCount.fetch_add( 1 );
+        rMetrics.pFramesNotSaved->Add();
+        CompleteJobs( 1 );
+        return WriterPolicyBlock == m_ePolicy ? VmbErrorTimeout : VmbErrorResources;
+    }
+    rMetrics.pWriterQueueDepth->Add( 1 );
+    // Keep the highest depth seen, other producers may raise it meanwhile
+    const VmbUint32_t nQueueDepth = static_cast<VmbUint32_t>( m_jobs.GetSize() );
+    VmbUint32_t nMaxQueueDepth = m_nMaxQueueDepth.load( std::memory_order_relaxed );
+    while (    nQueueDepth > nMaxQueueDepth
+            && !m_nMaxQueueDepth.compare_exchange_weak( nMaxQueueDepth, nQueueDepth, std::memory_order_relaxed ))
+    {
+    }
+    return VmbErrorSuccess;
+}
+
+//
+// Copies the image into a pooled buffer and queues the copy, so the caller may reuse its
+// image memory right away (e.g. inside a frame callback)
+//
+// Parameters:
+//  [in]    rFrame              The image, any mono format, 8 bit Bayer, RGB8 or BGR8
+//  [in]    rFileName           The destination (complete path) of the bitmap, a name ending
+//                              in .pgm keeps all bits of a mono image
+//  [in]    rCallback           Gets called once the image was written (may be empty)
+//
+// Returns:
+//  An API status code
+//
+VmbErrorType ImageWriter::SubmitCopy( const ImageFrame &rFrame, const std::string &rFileName, const CompletionCallback &rCallback )
+{
+    if ( NULL == rFrame.pImage )
+    {
+        return VmbErrorBadParameter;
+    }
+    BufferPtr pBuffer = BufferPool::GetDefault().Acquire( rFrame.nImageSize );
+    if ( !pBuffer )
+    {
+        return VmbErrorResources;
+    }
+    memcpy( pBuffer.get(), rFrame.pImage, rFrame.nImageSize );
+
+    ImageFrame copy = rFrame;
+    copy.pImage = pBuffer.get();
+    SP_RESET( copy.pFrame );
+    copy.pOwner = pBuffer;
+    return Submit( copy, rFileName, rCallback );
+}
+
+//
+// Waits until all queued images are written
+//
+void ImageWriter::Flush()
+{
+    std::unique_lock<std::mutex> lock( m_mutex );
+    while ( 0 != m_nPendingCount.load() )
+    {
+        m_idle.wait( lock );
+    }
+}
+
+//
+// Counts images as done with and wakes Flush once there are none left
+//
+// Parameters:
+//  [in]    nCount              The number of images written or dropped
+//
+void ImageWriter::CompleteJobs( VmbUint32_t nCount )
+{
+    if ( nCount == m_nPendingCount.fetch_sub( nCount ))
+    {
+        // Taking the lock makes sure Flush either sees the count or waits already
+        std::lock_guard<std::mutex> lock( m_mutex );
+        m_idle.notify_all();
+    }
+}
+
+//
+// Gets the counters (the time from Submit until the file was closed is LatencyStageSave of LatencyMonitor)
+//
+ImageWriterStatistics ImageWriter::GetStatistics() const
+{
+    ImageWriterStatistics statistics;
+    std::lock_guard<std::mutex> lock( m_mutex );
+    statistics.nQueueDepth      = static_cast<VmbUint32_t>( m_jobs.GetSize() );
+    statistics.nMaxQueueDepth   = m_nMaxQueueDepth.load();
+    statistics.nWrittenCount    = m_nWrittenCount;
+    statistics.nFailedCount     = m_nFailedCount;
+    statistics.nDroppedCount    = m_nDroppedCount.load();
+    statistics.nBytesWritten    = m_nBytesWritten;
+    const double dSeconds = std::chrono::duration<double>( Clock::now() - m_tStatisticsStart ).count();
+    statistics.dBytesPerSecond  = dSeconds > 0.0 ? m_nBytesWritten / dSeconds : 0.0;
+    return statistics;
+}
+
+//
+// Sets all counters to zero and restarts the bytes per second measurement
+//
+void ImageWriter::ResetStatistics()
+{
+    std::lock_guard<std::mutex> lock( m_mutex );
+    m_nMaxQueueDepth    = static_cast<VmbUint32_t>( m_jobs.GetSize() );
+    m_nWrittenCount     = 0;
+    m_nFailedCount      = 0;
+    m_nDroppedCount     = 0;
+    m_nBytesWritten     = 0;
+    m_tStatisticsStart  = Clock::now();
+}
+
+//
+// Demosaics Bayer images in stripes on a worker pool instead of on the I/O thread alone.
+// Call this before submitting images.
+//
+// Parameters:
+//  [in]    pPool               The pool, empty to convert on the I/O threads
+//  [in]    nMinStripeSize      The least bytes of converted image per stripe, smaller images are not split (0 for the default)
+//
+void ImageWriter::SetConversionPool( const WorkerPoolPtr &pPool, VmbUint32_t nMinStripeSize )
+{
+    m_pConversionPool   = pPool;
+    m_nMinStripeSize    = ( 0 != nMinStripeSize ) ? nMinStripeSize : static_cast<VmbUint32_t>( AVT_BITMAP_DEFAULT_MIN_STRIPE_SIZE );
+}
+
+//
+// The loop of an I/O thread. Takes up to m_nBatchSize images at once, so the statistics
+// are only touched once per batch.
+//
+void ImageWriter::Run()
+{
+    std::vector<Job> batch;
+    batch.reserve( m_nBatchSize );
+
+    for ( ;; )
+    {
+        // Sleeps until there is an image, ends once the writer is closed and drained
+        Job job;
+        if ( !m_jobs.Pop( job ))
+        {
+            return;
+        }
+        batch.push_back( std::move( job ));
+        while (    batch.size() < m_nBatchSize
+                && m_jobs.Pop( job, QueueModeTry ))
+        {
+            batch.push_back( std::move( job ));
+        }
+        WriteMetrics::GetDefault().pWriterQueueDepth->Add( -static_cast<VmbInt64_t>( batch.size() ));
+
+        VmbUint64_t nWrittenCount = 0;
+        VmbUint64_t nFailedCount = 0;
+        VmbUint64_t nBytesWritten = 0;
+        for (   std::vector<Job>::iterator iter = batch.begin();
+                batch.end() != iter;
+                ++iter )
+        {
+            VmbErrorType res;
+            {
+                TraceScope trace( "Save", iter->frame.nFrameID );
+                res = Write( *iter );
+            }
+            LatencyMonitor::GetDefault().Record( LatencyStageSave, GetLatencyClock() - iter->nSubmitTime );
+            if ( VmbErrorSuccess == res )
+            {
+                ++nWrittenCount;
+                nBytesWritten += iter->frame.nImageSize;
+            }
+            else
+            {
+                ++nFailedCount;
+            }
+            if ( iter->callback )
+            {
+                iter->callback( iter->frame, iter->strFileName, res );
+            }
+            // Hand the image memory back to its owner right away
+            iter->frame = ImageFrame();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock( m_mutex );
+            m_nWrittenCount += nWrittenCount;
+            m_nFailedCount  += nFailedCount;
+            m_nBytesWritten += nBytesWritten;
+        }
+        CompleteJobs( static_cast<VmbUint32_t>( batch.size() ));
+        batch.clear();
+    }
+}
+
+//
+// Writes a single image to its bitmap file, or to a PGM file if the name ends in .pgm
+//
+// Parameters:
+//  [in]    rJob                The image and its file name
+//
+// Returns:
+//  An API status code
+//
+VmbErrorType ImageWriter::Write( const Job &rJob ) const
+{
+    static const char   PGM_EXTENSION[]     = ".pgm";
+    const size_t        nExtensionLength    = sizeof( PGM_EXTENSION ) - 1;
+
+    if (    rJob.strFileName.size() >= nExtensionLength
+         && 0 == rJob.strFileName.compare( rJob.strFileName.size() - nExtensionLength, nExtensionLength, PGM_EXTENSION ))
+    {
+        return WritePgmFile( rJob.frame, rJob.strFileName.c_str() );
+    }
+    // Splitting small images costs more than it saves
+    WorkerPool *pPool = NULL;
+    if (    m_pConversionPool
+         && GetImageSize( rJob.frame.nWidth, rJob.frame.nHeight, VmbPixelFormatBgr8 ) >= 2 * static_cast<VmbUint64_t>( m_nMinStripeSize ))
+    {
+        pPool = m_pConversionPool.get();
+    }
+    return WriteBitmapFile( rJob.frame, rJob.strFileName.c_str(), pPool );
+}
+
+//
+// Writes an image to a bitmap file on the calling thread
+// Mono images deeper than 8 bit are mapped to 8 bit over their whole range, Bayer images are demosaiced.
+// The image bytes converted on the way count as vimba_bytes_converted_total.
+//
+// Parameters:
+//  [in]    rFrame              The image, any mono format, 8 bit Bayer, RGB8 or BGR8
+//  [in]    pFileName           The destination (complete path) of the bitmap
+//  [in]    pPool               Demosaics stripes of Bayer images in parallel (may be NULL)
+//
+// Returns:
+//  An API status code
+//
+VmbErrorType WriteBitmapFile( const ImageFrame &rFrame, const char *pFileName, WorkerPool *pPool )
+{
+    if (    NULL == rFrame.pImage
+         || NULL == pFileName )
+    {
+        return VmbErrorBadParameter;
+    }
+
+    // Bitmaps have no deeper gray and no Bayer patterns, such images go through a converted copy
+    ImageFrame image( rFrame );
+    BufferPtr pConverted;
+    BayerPattern ePattern;
+    if (    VmbPixelFormatMono8 != rFrame.ePixelFormat
+         && 0 != GetMonoBitDepth( rFrame.ePixelFormat ))
+    {
+        pConverted = BufferPool::GetDefault().Acquire( rFrame.nWidth, rFrame.nHeight, VmbPixelFormatMono8 );
+        if ( !pConverted )
+        {
+            return VmbErrorResources;
+        }
+        LatencyScope latency( LatencyStageConvert );
+        TraceScope trace( "Convert", rFrame.nFrameID );
+        const VmbErrorType res = ConvertMonoToMono8( rFrame, GetFullRangeWindow( rFrame.ePixelFormat ), pConverted.get() );
+        if ( VmbErrorSuccess != res )
+        {
+            return res;
+        }
+        image.ePixelFormat = VmbPixelFormatMono8;
+    }
+    else if ( GetBayerPattern( rFrame.ePixelFormat, ePattern ))
+    {
+        pConverted = BufferPool::GetDefault().Acquire( rFrame.nWidth, rFrame.nHeight, VmbPixelFormatBgr8 );
+        if ( !pConverted )
+        {
+            return VmbErrorResources;
+        }
+        LatencyScope latency( LatencyStageConvert );
+        TraceScope trace( "Convert", rFrame.nFrameID );
+        const VmbErrorType res = DemosaicImage( rFrame, DemosaicEdgeAware, pConverted.get(), pPool );
+        if ( VmbErrorSuccess != res )
+        {
+            return res;
+        }
+        image.ePixelFormat = VmbPixelFormatBgr8;
+    }
+    if ( pConverted )
+    {
+        image.pImage        = pConverted.get();
+        image.nImageSize    = GetImageSize( rFrame.nWidth, rFrame.nHeight, image.ePixelFormat );
+    }
+
+    AVTBitmap bitmap;
+    switch ( image.ePixelFormat )
+    {
+    case VmbPixelFormatMono8:
+        bitmap.colorCode = ColorCodeMono8;
+        break;
+    case VmbPixelFormatRgb8:
+        bitmap.colorCode = ColorCodeRGB24;
+        break;
+    case VmbPixelFormatBgr8:
+        bitmap.colorCode = ColorCodeBGR24;
+        break;
+    default:
+        return VmbErrorBadParameter;
+    }
+    bitmap.buffer       = const_cast<VmbUchar_t*>( image.pImage );
+    bitmap.bufferSize   = image.nImageSize;
+    bitmap.width        = image.nWidth;
+    bitmap.height       = image.nHeight;
+
+    // The header comes from the header cache of the calling thread
+    if ( 0 == AVTWriteImageToFile( &bitmap, NULL, pFileName ))
+    {
+        return VmbErrorOther;
+    }
+    // The only place the save path counts conversions: the converted copy, or the RGB rows
+    // AVTWriteImageToFile swapped to BGR on their way to the file (without header and padding)
+    if (    pConverted
+         || ColorCodeRGB24 == bitmap.colorCode )
+    {
+        WriteMetrics::GetDefault().pBytesConverted->Add( image.nImageSize );
+    }
+    return VmbErrorSuccess;
+}
+
+}}} // namespace AVT::VmbAPI::Examples
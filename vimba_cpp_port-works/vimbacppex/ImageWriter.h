@@ -0,0 +1,248 @@
+/*=============================================================================
+  Copyright (C) 2013 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        ImageWriter.h
+
+  Description: Writes images to bitmap files on a small pool of I/O threads so
+               acquisition never waits for the disk.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#ifndef AVT_VMBAPI_EXAMPLES_IMAGEWRITER
+#define AVT_VMBAPI_EXAMPLES_IMAGEWRITER
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "VimbaCPP/Include/VimbaCPP.h"
+
+#include "FrameQueue.h"
+#include "ImageFrame.h"
+#include "WorkerPool.h"
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+//
+// What Submit does when the queue is full
+//
+enum WriterPolicy
+{
+    WriterPolicyBlock,          // Wait for a free slot (backpressure), up to the block timeout
+    WriterPolicyDropNewest,     // Reject the new image
+    WriterPolicyDropOldest,     // Throw away the oldest waiting image to make room
+};
+
+enum { DEFAULT_WRITER_THREAD_COUNT = 2, };
+enum { DEFAULT_WRITER_QUEUE_CAPACITY = 32, };
+enum { DEFAULT_WRITER_BATCH_SIZE = 8, };
+enum { WRITER_WAIT_INFINITE = 0xFFFFFFFF, };
+
+//
+// The counters of an ImageWriter
+//
+struct ImageWriterStatistics
+{
+    VmbUint32_t     nQueueDepth;            // Images waiting to be written right now
+    VmbUint32_t     nMaxQueueDepth;         // The most images that waited at once
+    VmbUint64_t     nWrittenCount;          // Images written
+    VmbUint64_t     nFailedCount;           // Images that could not be written
+    VmbUint64_t     nDroppedCount;          // Images dropped or rejected because the queue was full
+    VmbUint64_t     nBytesWritten;          // Image bytes written
+    double          dBytesPerSecond;        // Image bytes written per second since the statistics were reset
+};
+
+//
+// Gets called on an I/O thread once an image was written (or dropped), right before
+// the writer lets go of the image memory
+//
+typedef std::function<void( const ImageFrame &rFrame, const std::string &rFileName, VmbErrorType eResult )> ImageWriterCallback;
+
+//
+// An image waiting in the queue of an ImageWriter
+//
+struct ImageWriterJob
+{
+    ImageFrame          frame;
+    std::string         strFileName;
+    ImageWriterCallback callback;
+    VmbUint64_t         nSubmitTime;        // When Submit got the image (GetLatencyClock)
+};
+
+//
+// Lets the frame queue of the writer stamp the image of a job
+//
+inline ImageFrame& GetQueuedFrame( ImageWriterJob &rJob )
+{
+    return rJob.frame;
+}
+
+class ImageWriter
+{
+  public:
+    // Gets called once an image was written (or dropped)
+    typedef ImageWriterCallback CompletionCallback;
+
+    //
+    // Starts the I/O threads
+    //
+    // Parameters:
+    //  [in]    nThreadCount        The number of I/O threads
+    //  [in]    nQueueCapacity      The number of images that may wait to be written (rounded up to a power of two)
+    //  [in]    ePolicy             What Submit does when the queue is full
+    //  [in]    nBlockTimeoutMS     How long Submit waits for a free slot with WriterPolicyBlock
+    //  [in]    nBatchSize          The number of images an I/O thread takes from the queue at once
+    //
+    explicit ImageWriter(   VmbUint32_t nThreadCount = DEFAULT_WRITER_THREAD_COUNT,
+                            VmbUint32_t nQueueCapacity = DEFAULT_WRITER_QUEUE_CAPACITY,
+                            WriterPolicy ePolicy = WriterPolicyBlock,
+                            VmbUint32_t nBlockTimeoutMS = WRITER_WAIT_INFINITE,
+                            VmbUint32_t nBatchSize = DEFAULT_WRITER_BATCH_SIZE );
+
+    //
+    // Writes the images still queued and joins the threads
+    //
+    ~ImageWriter();
+
+    //
+    // Queues an image to be written to a bitmap (or PGM) file. The image memory must stay valid until the
+    // image is written, which pFrame or pOwner of the frame take care of. Frames of a frame
+    // callback get requeued when the callback returns, so use SubmitCopy for them.
+    //
+    // Parameters:
+    //  [in]    rFrame              The image, any mono format, 8 bit Bayer, RGB8 or BGR8
+    //  [in]    rFileName           The destination (complete path) of the bitmap, a name ending
+    //                              in .pgm keeps all bits of a mono image
+    //  [in]    rCallback           Gets called once the image was written (may be empty)
+    //
+    // Returns:
+    //  An API status code
+    //  VmbErrorTimeout if the queue stayed full for the block timeout
+    //  VmbErrorResources if the queue was full and the policy drops new images
+    //
+    VmbErrorType    Submit( const ImageFrame &rFrame, const std::string &rFileName, const CompletionCallback &rCallback = CompletionCallback() );
+
+    //
+    // Copies the image into a pooled buffer and queues the copy, so the caller may reuse its
+    // image memory right away (e.g. inside a frame callback)
+    //
+    // Parameters:
+    //  [in]    rFrame              The image, any mono format, 8 bit Bayer, RGB8 or BGR8
+    //  [in]    rFileName           The destination (complete path) of the bitmap, a name ending
+    //                              in .pgm keeps all bits of a mono image
+    //  [in]    rCallback           Gets called once the image was written (may be empty)
+    //
+    // Returns:
+    //  An API status code
+    //
+    VmbErrorType    SubmitCopy( const ImageFrame &rFrame, const std::string &rFileName, const CompletionCallback &rCallback = CompletionCallback() );
+
+    //
+    // Waits until all queued images are written
+    //
+    void            Flush();
+
+    //
+    // Gets the counters (the time from Submit until the file was closed is LatencyStageSave of LatencyMonitor)
+    //
+    ImageWriterStatistics GetStatistics() const;
+
+    //
+    // Sets all counters to zero and restarts the bytes per second measurement
+    //
+    void            ResetStatistics();
+
+    //
+    // Demosaics Bayer images in stripes on a worker pool instead of on the I/O thread alone.
+    // Call this before submitting images.
+    //
+    // Parameters:
+    //  [in]    pPool               The pool, empty to convert on the I/O threads
+    //  [in]    nMinStripeSize      The least bytes of converted image per stripe, smaller images are not split (0 for the default)
+    //
+    void            SetConversionPool( const WorkerPoolPtr &pPool, VmbUint32_t nMinStripeSize = 0 );
+
+  private:
+    typedef std::chrono::steady_clock Clock;
+    typedef ImageWriterJob Job;
+
+    void            Run();
+    VmbErrorType    Write( const Job &rJob ) const;
+
+    //
+    // Counts images as done with and wakes Flush once there are none left
+    //
+    void            CompleteJobs( VmbUint32_t nCount );
+
+    // The frame callback hands images over without taking a lock, several I/O threads take them
+    FrameQueue< MpmcRing<Job> > m_jobs;
+    std::vector<std::thread>    m_threads;
+    mutable std::mutex          m_mutex;
+    std::condition_variable     m_idle;                 // Signals Flush
+    const WriterPolicy          m_ePolicy;
+    const VmbUint32_t           m_nBlockTimeoutMS;
+    const VmbUint32_t           m_nBatchSize;
+    std::atomic<VmbUint32_t>    m_nPendingCount;        // Images submitted but not written or dropped yet
+    WorkerPoolPtr               m_pConversionPool;      // Converts stripes of large images, may be empty
+    VmbUint32_t                 m_nMinStripeSize;
+
+    // Statistics of Submit
+    std::atomic<VmbUint32_t>    m_nMaxQueueDepth;
+    std::atomic<VmbUint64_t>    m_nDroppedCount;
+
+    // Statistics of the I/O threads, guarded by m_mutex
+    VmbUint64_t                 m_nWrittenCount;
+    VmbUint64_t                 m_nFailedCount;
+    VmbUint64_t                 m_nBytesWritten;
+    Clock::time_point           m_tStatisticsStart;
+
+    // No copies
+    ImageWriter( const ImageWriter& );
+    ImageWriter& operator=( const ImageWriter& );
+};
+typedef std::shared_ptr<ImageWriter> ImageWriterPtr;
+
+//
+// Writes an image to a bitmap file on the calling thread
+// Mono images deeper than 8 bit are mapped to 8 bit over their whole range, Bayer images are demosaiced.
+// The image bytes converted on the way count as vimba_bytes_converted_total.
+//
+// Parameters:
+//  [in]    rFrame              The image, any mono format, 8 bit Bayer, RGB8 or BGR8
+//  [in]    pFileName           The destination (complete path) of the bitmap
+//  [in]    pPool               Demosaics stripes of Bayer images in parallel (may be NULL)
+//
+// Returns:
+//  An API status code
+//
+VmbErrorType WriteBitmapFile( const ImageFrame &rFrame, const char *pFileName, WorkerPool *pPool = NULL );
+
+}}} // namespace AVT::VmbAPI::Examples
+
+#endif
@@ -0,0 +1,355 @@
+/*=============================================================================
+  Copyright (C) 2013 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        LatencyMonitor.cpp
+
+  Description: Always-on latency histograms of the acquisition pipeline stages,
+               recorded lock-free into per-thread shards and summed on query.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#include <algorithm>
+#include <cmath>
+#include <new>
+
+#include "LatencyMonitor.h"
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+namespace {
+
+//
+// Gets the position of the highest set bit of a value that is not 0
+//
+VmbUint32_t GetHighestBit( VmbUint64_t nValue )
+{
+    VmbUint32_t nBit = 0;
+    for ( VmbUint32_t nShift = 32; 0 != nShift; nShift /= 2 )
+    {
+        if ( 0 != ( nValue >> nShift ))
+        {
+            nValue >>= nShift;
+            nBit += nShift;
+        }
+    }
+    return nBit;
+}
+
+// Hands out the serials that tell monitors apart
+std::atomic<VmbUint64_t> g_nNextMonitorSerial( 1 );
+
+// The shard the calling thread used last and the monitor it belongs to
+thread_local VmbUint64_t g_nCachedShardSerial = 0;
+thread_local void* g_pCachedShard = NULL;
+
+} // namespace
+
+const VmbUint64_t LatencyHistogram::MAX_LATENCY_NS;
+
+//
+// Gets the name of a stage for printing
+//
+const char* GetLatencyStageName( LatencyStage eStage )
+{
+    switch ( eStage )
+    {
+    case LatencyStageInterval:  return "interval";
+    case LatencyStageTransport: return "transport";
+    case LatencyStageDelivery:  return "delivery";
+    case LatencyStageCallback:  return "callback";
+    case LatencyStageQueue:     return "queue";
+    case LatencyStageConvert:   return "convert";
+    case LatencyStageWrite:     return "write";
+    case LatencyStageSave:      return "save";
+    default:                    return "unknown";
+    }
+}
+
+LatencyHistogram::LatencyHistogram()
+    : m_counts( BUCKET_COUNT, 0 )
+    , m_nCount( 0 )
+    , m_nSumNS( 0 )
+    , m_nMaxNS( 0 )
+{
+}
+
+//
+// Counts a latency
+//
+// Parameters:
+//  [in]    nLatencyNS          The latency in nanoseconds
+//
+void LatencyHistogram::Add( VmbUint64_t nLatencyNS )
+{
+    nLatencyNS = ( std::min )( nLatencyNS, MAX_LATENCY_NS );
+    ++m_counts[GetBucketIndex( nLatencyNS )];
+    ++m_nCount;
+    m_nSumNS += nLatencyNS;
+    m_nMaxNS = ( std::max )( m_nMaxNS, nLatencyNS );
+}
+
+//
+// Removes the counts of an earlier state of the same histogram, leaving what happened since
+// (the maximum stays the one of the whole time)
+//
+// Parameters:
+//  [in]    rEarlier            The earlier state
+//
+void LatencyHistogram::Subtract( const LatencyHistogram &rEarlier )
+{
+    for ( size_t i = 0; i < m_counts.size(); ++i )
+    {
+        m_counts[i] -= ( std::min )( m_counts[i], rEarlier.m_counts[i] );
+    }
+    m_nCount -= ( std::min )( m_nCount, rEarlier.m_nCount );
+    m_nSumNS -= ( std::min )( m_nSumNS, rEarlier.m_nSumNS );
+}
+
+VmbUint64_t LatencyHistogram::GetCount() const
+{
+    return m_nCount;
+}
+
+VmbUint64_t LatencyHistogram::GetSumNS() const
+{
+    return m_nSumNS;
+}
+
+VmbUint64_t LatencyHistogram::GetMaxNS() const
+{
+    return m_nMaxNS;
+}
+
+//
+// Gets the latency the given share of all latencies does not exceed
+//
+// Parameters:
+//  [in]    dPercentile         The share in percent, e.g. 99.9
+//
+// Returns:
+//  The latency in nanoseconds, 0 if the histogram is empty
+//
+VmbUint64_t LatencyHistogram::GetPercentileNS( double dPercentile ) const
+{
+    if ( 0 == m_nCount )
+    {
+        return 0;
+    }
+    // The rank of the latency we are looking for, counting from 1
+    const double dRank = std::ceil( ( std::min )( ( std::max )( dPercentile, 0.0 ), 100.0 ) / 100.0 * m_nCount );
+    const VmbUint64_t nRank = ( std::max )( static_cast<VmbUint64_t>( dRank ), static_cast<VmbUint64_t>( 1 ));
+    VmbUint64_t nSeen = 0;
+    for ( VmbUint32_t i = 0; i < m_counts.size(); ++i )
+    {
+        nSeen += m_counts[i];
+        if ( nSeen >= nRank )
+        {
+            // No latency of the bucket was larger than the largest one
+            return ( std::min )( GetBucketLimit( i ), m_nMaxNS );
+        }
+    }
+    return m_nMaxNS;
+}
+
+//
+// Gets the number of latencies in the buckets up to the one of the given latency,
+// so latencies a little above it may count (by up to 1/SUB_BUCKET_COUNT)
+//
+// Parameters:
+//  [in]    nLatencyNS          The latency in nanoseconds
+//
+VmbUint64_t LatencyHistogram::GetCountUpTo( VmbUint64_t nLatencyNS ) const
+{
+    if ( nLatencyNS >= MAX_LATENCY_NS )
+    {
+        return m_nCount;
+    }
+    const VmbUint32_t nLastBucket = GetBucketIndex( nLatencyNS );
+    VmbUint64_t nCount = 0;
+    for ( VmbUint32_t i = 0; i <= nLastBucket; ++i )
+    {
+        nCount += m_counts[i];
+    }
+    return nCount;
+}
+
+//
+// Gets the bucket of a latency
+//
+VmbUint32_t LatencyHistogram::GetBucketIndex( VmbUint64_t nLatencyNS )
+{
+    if ( nLatencyNS < 2 * SUB_BUCKET_COUNT )
+    {
+        return static_cast<VmbUint32_t>( nLatencyNS );
+    }
+    // Keep the SUB_BUCKET_BITS + 1 highest bits, the shift says which power of two the bucket is in
+    const VmbUint32_t nShift = GetHighestBit( nLatencyNS ) - SUB_BUCKET_BITS;
+    return nShift * SUB_BUCKET_COUNT + static_cast<VmbUint32_t>( nLatencyNS >> nShift );
+}
+
+//
+// Gets the largest latency of a bucket
+//
+VmbUint64_t LatencyHistogram::GetBucketLimit( VmbUint32_t nIndex )
+{
+    if ( nIndex < 2 * SUB_BUCKET_COUNT )
+    {
+        return nIndex;
+    }
+    const VmbUint32_t nShift = nIndex / SUB_BUCKET_COUNT - 1;
+    const VmbUint64_t nTopBits = nIndex - nShift * SUB_BUCKET_COUNT;
+    return (( nTopBits + 1 ) << nShift ) - 1;
+}
+
+LatencyMonitor::LatencyMonitor()
+    : m_nSerial( g_nNextMonitorSerial++ )
+    , m_pShards( NULL )
+{
+}
+
+LatencyMonitor::~LatencyMonitor()
+{
+    Shard *pShard = m_pShards.load();
+    while ( NULL != pShard )
+    {
+        Shard *pNext = pShard->pNext;
+        delete pShard;
+        pShard = pNext;
+    }
+}
+
+//
+// Gets the monitor the pipeline records into
+//
+LatencyMonitor& LatencyMonitor::GetDefault()
+{
+    static LatencyMonitor monitor;
+    return monitor;
+}
+
+//
+// Counts a latency of a stage (any thread, lock-free)
+//
+// Parameters:
+//  [in]    eStage              The stage
+//  [in]    nLatencyNS          How long the frame spent in the stage in nanoseconds
+//
+void LatencyMonitor::Record( LatencyStage eStage, VmbUint64_t nLatencyNS )
+{
+    if (    eStage < 0
+         || eStage >= LatencyStageCount )
+    {
+        return;
+    }
+    Shard *pShard = GetShard();
+    if ( NULL == pShard )
+    {
+        return;
+    }
+
+    // Only this thread writes the shard, so load and store are enough and no locked instruction is needed.
+    // The atomics only keep the readers from seeing torn values.
+    nLatencyNS = ( std::min )( nLatencyNS, LatencyHistogram::MAX_LATENCY_NS );
+    std::atomic<VmbUint64_t> &rBucket = pShard->counts[eStage][LatencyHistogram::GetBucketIndex( nLatencyNS )];
+    rBucket.store( rBucket.load( std::memory_order_relaxed ) + 1, std::memory_order_relaxed );
+    pShard->nCount[eStage].store( pShard->nCount[eStage].load( std::memory_order_relaxed ) + 1, std::memory_order_relaxed );
+    pShard->nSumNS[eStage].store( pShard->nSumNS[eStage].load( std::memory_order_relaxed ) + nLatencyNS, std::memory_order_relaxed );
+    if ( nLatencyNS > pShard->nMaxNS[eStage].load( std::memory_order_relaxed ))
+    {
+        pShard->nMaxNS[eStage].store( nLatencyNS, std::memory_order_relaxed );
+    }
+}
+
+//
+// Gets the latencies of a stage recorded so far by all threads.
+// Two calls and LatencyHistogram::Subtract give the latencies of the time in between.
+//
+// Parameters:
+//  [in]    eStage              The stage
+//  [out]   rHistogram          The latencies
+//
+void LatencyMonitor::GetHistogram( LatencyStage eStage, LatencyHistogram &rHistogram ) const
+{
+    rHistogram = LatencyHistogram();
+    if (    eStage < 0
+         || eStage >= LatencyStageCount )
+    {
+        return;
+    }
+    // Shards are only ever added at the front, so the list can be walked while threads add theirs
+    for (   const Shard *pShard = m_pShards.load( std::memory_order_acquire );
+            NULL != pShard;
+            pShard = pShard->pNext )
+    {
+        for ( VmbUint32_t i = 0; i < LatencyHistogram::BUCKET_COUNT; ++i )
+        {
+            rHistogram.m_counts[i] += pShard->counts[eStage][i].load( std::memory_order_relaxed );
+        }
+        rHistogram.m_nCount += pShard->nCount[eStage].load( std::memory_order_relaxed );
+        rHistogram.m_nSumNS += pShard->nSumNS[eStage].load( std::memory_order_relaxed );
+        rHistogram.m_nMaxNS = ( std::max )( rHistogram.m_nMaxNS, pShard->nMaxNS[eStage].load( std::memory_order_relaxed ));
+    }
+}
+
+//
+// Gets the shard of the calling thread, adds one on its first call
+//
+LatencyMonitor::Shard* LatencyMonitor::GetShard()
+{
+    if ( m_nSerial == g_nCachedShardSerial )
+    {
+        return static_cast<Shard*>( g_pCachedShard );
+    }
+
+    // The thread may have recorded into this monitor before it recorded into another one
+    const std::thread::id threadID = std::this_thread::get_id();
+    Shard *pShard = m_pShards.load( std::memory_order_acquire );
+    while (    NULL != pShard
+            && threadID != pShard->threadID )
+    {
+        pShard = pShard->pNext;
+    }
+    if ( NULL != pShard )
+    {
+        g_nCachedShardSerial = m_nSerial;
+        g_pCachedShard = pShard;
+        return pShard;
+    }
+
+    // Shards are zeroed on creation and then only counted up by their thread
+    pShard = new ( std::nothrow ) Shard();
+    if ( NULL == pShard )
+    {
+        return NULL;
+    }
+    pShard->threadID = threadID;
+    pShard->pNext = m_pShards.load( std::memory_order_relaxed );
+    while ( !m_pShards.compare_exchange_weak( pShard->pNext, pShard, std::memory_order_release, std::memory_order_relaxed ))
+    {
+    }
+    g_nCachedShardSerial = m_nSerial;
+    g_pCachedShard = pShard;
+    return pShard;
+}
+
+}}} // namespace AVT::VmbAPI::Examples
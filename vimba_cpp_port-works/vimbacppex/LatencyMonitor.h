@@ -0,0 +1,239 @@
+/*=============================================================================
+  Copyright (C) 2013 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        LatencyMonitor.h
+
+  Description: Always-on latency histograms of the acquisition pipeline stages,
+               recorded lock-free into per-thread shards and summed on query.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#ifndef AVT_VMBAPI_EXAMPLES_LATENCYMONITOR
+#define AVT_VMBAPI_EXAMPLES_LATENCYMONITOR
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "VimbaCPP/Include/VimbaCPP.h"
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+//
+// The stages a frame passes on its way from the camera to the disk
+//
+enum LatencyStage
+{
+    LatencyStageInterval,       // Between two frame callbacks of the same stream
+    LatencyStageTransport,      // From the camera timestamp until the host got the frame, relative to the fastest frame of the stream
+    LatencyStageDelivery,       // From the host getting the frame until the frame callback got it
+    LatencyStageCallback,       // Inside the frame callback
+    LatencyStageQueue,          // Waiting in a frame queue or the queue of the image writer
+    LatencyStageConvert,        // Converting an image for a bitmap (AVTCreateBitmap, RGB rows in AVTWriteImageToFile, deeper mono and Bayer images)
+    LatencyStageWrite,          // Writing a bitmap file (AVTWriteBitmapToFile, AVTWriteImageToFile)
+    LatencyStageSave,           // From handing a frame to the image writer until its file is written
+    LatencyStageCount,
+};
+
+//
+// Gets the name of a stage for printing
+//
+const char* GetLatencyStageName( LatencyStage eStage );
+
+//
+// Gets the time of the clock all stages are measured with in nanoseconds
+//
+inline VmbUint64_t GetLatencyClock()
+{
+    return static_cast<VmbUint64_t>( std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now().time_since_epoch() ).count() );
+}
+
+//
+// A histogram of latencies in nanoseconds with buckets of constant relative width (after HdrHistogram):
+// below 2 * SUB_BUCKET_COUNT every value has its own bucket, above that every power of two is split
+// into SUB_BUCKET_COUNT buckets. Percentiles are thus off by at most 1 / SUB_BUCKET_COUNT (3%).
+// Values above MAX_LATENCY_NS count as MAX_LATENCY_NS.
+//
+class LatencyHistogram
+{
+  public:
+    enum { SUB_BUCKET_BITS = 5, };
+    enum { SUB_BUCKET_COUNT = 1 << SUB_BUCKET_BITS, };
+    enum { MAX_LATENCY_BITS = 36, };
+    enum { BUCKET_COUNT = ( MAX_LATENCY_BITS - SUB_BUCKET_BITS + 1 ) * SUB_BUCKET_COUNT, };
+    static const VmbUint64_t MAX_LATENCY_NS = ( 1ULL << MAX_LATENCY_BITS ) - 1;
+
+    LatencyHistogram();
+
+    //
+    // Counts a latency
+    //
+    // Parameters:
+    //  [in]    nLatencyNS          The latency in nanoseconds
+    //
+    void            Add( VmbUint64_t nLatencyNS );
+
+    //
+    // Removes the counts of an earlier state of the same histogram, leaving what happened since
+    // (the maximum stays the one of the whole time)
+    //
+    // Parameters:
+    //  [in]    rEarlier            The earlier state
+    //
+    void            Subtract( const LatencyHistogram &rEarlier );
+
+    //
+    // Gets the number of latencies, their sum and the largest one
+    //
+    VmbUint64_t     GetCount() const;
+    VmbUint64_t     GetSumNS() const;
+    VmbUint64_t     GetMaxNS() const;
+
+    //
+    // Gets the latency the given share of all latencies does not exceed
+    //
+    // Parameters:
+    //  [in]    dPercentile         The share in percent, e.g. 99.9
+    //
+    // Returns:
+    //  The latency in nanoseconds, 0 if the histogram is empty
+    //
+    VmbUint64_t     GetPercentileNS( double dPercentile ) const;
+
+    //
+    // Gets the number of latencies in the buckets up to the one of the given latency,
+    // so latencies a little above it may count (by up to 1/SUB_BUCKET_COUNT)
+    //
+    // Parameters:
+    //  [in]    nLatencyNS          The latency in nanoseconds
+    //
+    VmbUint64_t     GetCountUpTo( VmbUint64_t nLatencyNS ) const;
+
+    //
+    // Gets the bucket of a latency and the largest latency of a bucket
+    //
+    static VmbUint32_t GetBucketIndex( VmbUint64_t nLatencyNS );
+    static VmbUint64_t GetBucketLimit( VmbUint32_t nIndex );
+
+  private:
+    friend class LatencyMonitor;
+
+    std::vector<VmbUint64_t>    m_counts;
+    VmbUint64_t                 m_nCount;
+    VmbUint64_t                 m_nSumNS;
+    VmbUint64_t                 m_nMaxNS;
+};
+
+//
+// Collects the latencies of all stages from all threads.
+// Every thread records into a shard of its own with plain relaxed stores, so recording never locks
+// and threads do not share cache lines. Queries add the shards up.
+//
+class LatencyMonitor
+{
+  public:
+    LatencyMonitor();
+
+    ~LatencyMonitor();
+
+    //
+    // Gets the monitor the pipeline records into
+    //
+    static LatencyMonitor& GetDefault();
+
+    //
+    // Counts a latency of a stage (any thread, lock-free)
+    //
+    // Parameters:
+    //  [in]    eStage              The stage
+    //  [in]    nLatencyNS          How long the frame spent in the stage in nanoseconds
+    //
+    void            Record( LatencyStage eStage, VmbUint64_t nLatencyNS );
+
+    //
+    // Gets the latencies of a stage recorded so far by all threads.
+    // Two calls and LatencyHistogram::Subtract give the latencies of the time in between.
+    //
+    // Parameters:
+    //  [in]    eStage              The stage
+    //  [out]   rHistogram          The latencies
+    //
+    void            GetHistogram( LatencyStage eStage, LatencyHistogram &rHistogram ) const;
+
+  private:
+    // The counters of one thread, only that thread writes them
+    struct Shard
+    {
+        std::atomic<VmbUint64_t>    counts[LatencyStageCount][LatencyHistogram::BUCKET_COUNT];
+        std::atomic<VmbUint64_t>    nCount[LatencyStageCount];
+        std::atomic<VmbUint64_t>    nSumNS[LatencyStageCount];
+        std::atomic<VmbUint64_t>    nMaxNS[LatencyStageCount];
+        std::thread::id             threadID;
+        Shard*                      pNext;
+    };
+
+    //
+    // Gets the shard of the calling thread, adds one on its first call
+    //
+    Shard*          GetShard();
+
+    // Tells the shards of the thread local cache of different monitors apart
+    const VmbUint64_t           m_nSerial;
+    // The shards of all threads that ever recorded, pushed to the front lock-free and freed with the monitor
+    std::atomic<Shard*>         m_pShards;
+
+    // No copies
+    LatencyMonitor( const LatencyMonitor& );
+    LatencyMonitor& operator=( const LatencyMonitor& );
+};
+
+//
+// Records the time from its construction to its destruction as a latency of the given stage
+//
+class LatencyScope
+{
+  public:
+    explicit LatencyScope( LatencyStage eStage )
+        : m_eStage( eStage )
+        , m_nStart( GetLatencyClock() )
+    {
+    }
+
+    ~LatencyScope()
+    {
+        LatencyMonitor::GetDefault().Record( m_eStage, GetLatencyClock() - m_nStart );
+    }
+
+  private:
+    const LatencyStage  m_eStage;
+    const VmbUint64_t   m_nStart;
+
+    // No copies
+    LatencyScope( const LatencyScope& );
+    LatencyScope& operator=( const LatencyScope& );
+};
+
+}}} // namespace AVT::VmbAPI::Examples
+
+#endif
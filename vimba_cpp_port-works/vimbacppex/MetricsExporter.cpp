@@ -0,0 +1,325 @@
+/*=============================================================================
+  Copyright (C) 2013 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        MetricsExporter.cpp
+
+  Description: Publishes the metrics registry periodically as a Prometheus text file
+               and as a shared memory block that agents read without IPC.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "MetricsExporter.h"
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+//
+// A named shared memory block that other processes can map
+//
+struct MetricsExporter::SharedBlock
+{
+#ifdef _WIN32
+    HANDLE          hMapping;
+#else
+    int             nFile;
+    std::string     strName;
+#endif
+    void*           pData;
+    size_t          nSize;
+
+    SharedBlock()
+#ifdef _WIN32
+        : hMapping( NULL )
+#else
+        : nFile( -1 )
+#endif
+        , pData( NULL )
+        , nSize( 0 )
+    {
+    }
+
+    ~SharedBlock()
+    {
+        Close();
+    }
+
+    //
+    // Creates the block, or maps the existing one of that name
+    //
+    bool Open( const std::string &rName, size_t nBlockSize )
+    {
+        nSize = nBlockSize;
+#ifdef _WIN32
+        hMapping = CreateFileMappingA( INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0, static_cast<DWORD>( nSize ), rName.c_str() );
+        if ( NULL == hMapping )
+        {
+            return false;
+        }
+        pData = MapViewOfFile( hMapping, FILE_MAP_WRITE, 0, 0, nSize );
+#else
+        // POSIX names start with a slash
+        strName = ( !rName.empty() && '/' == rName[0] ) ? rName : "/" + rName;
+        nFile = shm_open( strName.c_str(), O_CREAT | O_RDWR, 0644 );
+        if (    0 > nFile
+             || 0 != ftruncate( nFile, static_cast<off_t>( nSize )))
+        {
+            return false;
+        }
+        pData = mmap( NULL, nSize, PROT_READ | PROT_WRITE, MAP_SHARED, nFile, 0 );
+        if ( MAP_FAILED == pData )
+        {
+            pData = NULL;
+        }
+#endif
+        if ( NULL == pData )
+        {
+            return false;
+        }
+        memset( pData, 0, nSize );
+        return true;
+    }
+
+    void Close()
+    {
+#ifdef _WIN32
+        if ( NULL != pData )
+        {
+            UnmapViewOfFile( pData );
+        }
+        if ( NULL != hMapping )
+        {
+            CloseHandle( hMapping );
+            hMapping = NULL;
+        }
+#else
+        if ( NULL != pData )
+        {
+            munmap( pData, nSize );
+        }
+        if ( 0 <= nFile )
+        {
+            close( nFile );
+            shm_unlink( strName.c_str() );
+            nFile = -1;
+        }
+#endif
+        pData = NULL;
+    }
+
+    //
+    // Writes the samples into the slots under the sequence number
+    //
+    void Publish( const MetricFamilyVector &rFamilies )
+    {
+        SharedMetricsHeader *pHeader = static_cast<SharedMetricsHeader*>( pData );
+        SharedMetricsSlot *pSlots = reinterpret_cast<SharedMetricsSlot*>( pHeader + 1 );
+        volatile VmbUint64_t *pSequence = &pHeader->nSequence;
+
+        // Odd tells readers to retry, the slots are only written after that
+        const VmbUint64_t nSequence = *pSequence + 1;
+        *pSequence = nSequence;
+        std::atomic_thread_fence( std::memory_order_release );
+
+        memcpy( pHeader->magic, "VMBMETRC", sizeof( pHeader->magic ));
+        pHeader->nVersion   = SHARED_METRICS_VERSION;
+        pHeader->nSlotCount = static_cast<VmbUint32_t>(( nSize - sizeof( SharedMetricsHeader )) / sizeof( SharedMetricsSlot ));
+        VmbUint32_t nUsed = 0;
+        VmbUint32_t nDropped = 0;
+        for (   MetricFamilyVector::const_iterator family = rFamilies.begin();
+                rFamilies.end() != family;
+                ++family )
+        {
+            for (   std::vector<MetricSample>::const_iterator sample = family->samples.begin();
+                    family->samples.end() != sample;
+                    ++sample )
+            {
+                const std::string strName = sample->strLabels.empty() ? sample->strName : sample->strName + "{" + sample->strLabels + "}";
+                if (    nUsed >= pHeader->nSlotCount
+                     || strName.size() >= SHARED_METRICS_NAME_SIZE )
+                {
+                    ++nDropped;
+                    continue;
+                }
+                SharedMetricsSlot &rSlot = pSlots[nUsed++];
+                memset( rSlot.name, 0, sizeof( rSlot.name ));
+                memcpy( rSlot.name, strName.c_str(), strName.size() );
+                rSlot.dValue = sample->dValue;
+            }
+        }
+        // Slots of samples that went away are cleared
+        for ( VmbUint32_t i = nUsed; i < pHeader->nUsedSlotCount && i < pHeader->nSlotCount; ++i )
+        {
+            memset( &pSlots[i], 0, sizeof( SharedMetricsSlot ));
+        }
+        pHeader->nUsedSlotCount         = nUsed;
+        pHeader->nDroppedSampleCount    = nDropped;
+        pHeader->nUpdateTimeMS          = static_cast<VmbUint64_t>( std::chrono::duration_cast<std::chrono::milliseconds>( std::chrono::system_clock::now().time_since_epoch() ).count() );
+
+        std::atomic_thread_fence( std::memory_order_release );
+        *pSequence = nSequence + 1;
+    }
+};
+
+//
+// Parameters:
+//  [in]    rRegistry           The registry to publish, has to outlive the exporter
+//
+MetricsExporter::MetricsExporter( const MetricsRegistry &rRegistry )
+    : m_rRegistry( rRegistry )
+    , m_bStop( false )
+{
+}
+
+MetricsExporter::~MetricsExporter()
+{
+    Stop();
+}
+
+//
+// Creates the shared memory block and starts publishing
+//
+// Parameters:
+//  [in]    rConfig             Where and how often to publish
+//
+// Returns:
+//  An API status code
+//
+VmbErrorType MetricsExporter::Start( const MetricsExporterConfig &rConfig )
+{
+    if ( m_thread.joinable() )
+    {
+        return VmbErrorInvalidCall;
+    }
+    if (    0 == rConfig.nIntervalMS
+         || ( rConfig.strTextFile.empty() && rConfig.strSharedMemoryName.empty() )
+         || ( !rConfig.strSharedMemoryName.empty() && 0 == rConfig.nSlotCount ))
+    {
+        return VmbErrorBadParameter;
+    }
+
+    std::unique_ptr<SharedBlock> pSharedBlock;
+    if ( !rConfig.strSharedMemoryName.empty() )
+    {
+        pSharedBlock.reset( new SharedBlock() );
+        if ( !pSharedBlock->Open( rConfig.strSharedMemoryName, sizeof( SharedMetricsHeader ) + rConfig.nSlotCount * sizeof( SharedMetricsSlot )))
+        {
+            return VmbErrorResources;
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock( m_exportMutex );
+        m_config = rConfig;
+        m_pSharedBlock = std::move( pSharedBlock );
+    }
+    const VmbErrorType res = Export();
+    if ( VmbErrorSuccess != res )
+    {
+        std::lock_guard<std::mutex> lock( m_exportMutex );
+        m_pSharedBlock.reset();
+        return res;
+    }
+
+    m_bStop = false;
+    m_thread = std::thread( &MetricsExporter::ExportPeriodically, this );
+    return VmbErrorSuccess;
+}
+
+//
+// Publishes one last time, stops and removes the shared memory block
+//
+// Returns:
+//  An API status code of the last publication
+//
+VmbErrorType MetricsExporter::Stop()
+{
+    if ( !m_thread.joinable() )
+    {
+        return VmbErrorSuccess;
+    }
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        m_bStop = true;
+        m_stopCondition.notify_all();
+    }
+    m_thread.join();
+
+    const VmbErrorType res = Export();
+    std::lock_guard<std::mutex> lock( m_exportMutex );
+    m_pSharedBlock.reset();
+    return res;
+}
+
+//
+// Publishes now
+//
+// Returns:
+//  An API status code
+//
+VmbErrorType MetricsExporter::Export()
+{
+    std::lock_guard<std::mutex> lock( m_exportMutex );
+    VmbErrorType res = VmbErrorSuccess;
+    if ( !m_config.strTextFile.empty() )
+    {
+        res = m_rRegistry.WriteTextFile( m_config.strTextFile );
+    }
+    if ( m_pSharedBlock )
+    {
+        MetricFamilyVector families;
+        m_rRegistry.GetFamilies( families );
+        m_pSharedBlock->Publish( families );
+    }
+    return res;
+}
+
+//
+// Calls Export every nIntervalMS (runs on m_thread)
+//
+void MetricsExporter::ExportPeriodically()
+{
+    std::unique_lock<std::mutex> lock( m_mutex );
+    while ( !m_bStop )
+    {
+        m_stopCondition.wait_for( lock, std::chrono::milliseconds( m_config.nIntervalMS ));
+        if ( m_bStop )
+        {
+            break;
+        }
+        lock.unlock();
+        Export();
+        lock.lock();
+    }
+}
+
+}}} // namespace AVT::VmbAPI::Examples
@@ -0,0 +1,157 @@
+/*=============================================================================
+  Copyright (C) 2013 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        MetricsExporter.h
+
+  Description: Publishes the metrics registry periodically as a Prometheus text file
+               and as a shared memory block that agents read without IPC.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#ifndef AVT_VMBAPI_EXAMPLES_METRICSEXPORTER
+#define AVT_VMBAPI_EXAMPLES_METRICSEXPORTER
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "VimbaCPP/Include/VimbaCPP.h"
+
+#include "MetricsRegistry.h"
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+//
+// The layout of the shared memory block, for agents that read it.
+// The block is a SharedMetricsHeader followed by nSlotCount SharedMetricsSlots, little endian.
+// A reader copies the slots while nSequence is even and unchanged before and after the copy,
+// the exporter makes it odd while it writes.
+//
+enum
+{
+    SHARED_METRICS_VERSION      = 1,
+    SHARED_METRICS_NAME_SIZE    = 120,
+};
+
+struct SharedMetricsHeader
+{
+    char            magic[8];               // "VMBMETRC"
+    VmbUint32_t     nVersion;               // SHARED_METRICS_VERSION
+    VmbUint32_t     nSlotCount;             // The slots of the block
+    VmbUint64_t     nSequence;              // Odd while the exporter writes
+    VmbUint64_t     nUpdateTimeMS;          // When the exporter wrote last, in milliseconds since 1970
+    VmbUint32_t     nUsedSlotCount;         // The slots that hold samples, the others are zero
+    VmbUint32_t     nDroppedSampleCount;    // Samples that did not fit
+};
+
+struct SharedMetricsSlot
+{
+    char            name[SHARED_METRICS_NAME_SIZE]; // The sample as in the text file, e.g. vimba_frames_acquired_total{camera="DEV_1"}
+    double          dValue;
+};
+
+//
+// Where and how often the metrics are published
+//
+struct MetricsExporterConfig
+{
+    std::string     strTextFile;            // The Prometheus text file to write, empty for none
+    std::string     strSharedMemoryName;    // The name of the shared memory block, empty for none
+    VmbUint32_t     nIntervalMS;            // How often both are updated
+    VmbUint32_t     nSlotCount;             // The samples the shared memory block holds
+
+    MetricsExporterConfig()
+        : nIntervalMS( 1000 )
+        , nSlotCount( 1024 )
+    {
+    }
+};
+
+//
+// Publishes a metrics registry on a thread of its own
+//
+class MetricsExporter
+{
+  public:
+    //
+    // Parameters:
+    //  [in]    rRegistry           The registry to publish, has to outlive the exporter
+    //
+    explicit MetricsExporter( const MetricsRegistry &rRegistry = MetricsRegistry::GetDefault() );
+
+    ~MetricsExporter();
+
+    //
+    // Creates the shared memory block and starts publishing
+    //
+    // Parameters:
+    //  [in]    rConfig             Where and how often to publish
+    //
+    // Returns:
+    //  An API status code
+    //
+    VmbErrorType    Start( const MetricsExporterConfig &rConfig );
+
+    //
+    // Publishes one last time, stops and removes the shared memory block
+    //
+    // Returns:
+    //  An API status code of the last publication
+    //
+    VmbErrorType    Stop();
+
+    //
+    // Publishes now
+    //
+    // Returns:
+    //  An API status code
+    //
+    VmbErrorType    Export();
+
+  private:
+    struct SharedBlock;
+
+    //
+    // Calls Export every nIntervalMS (runs on m_thread)
+    //
+    void            ExportPeriodically();
+
+    const MetricsRegistry&          m_rRegistry;
+    MetricsExporterConfig           m_config;
+    std::unique_ptr<SharedBlock>    m_pSharedBlock;
+    std::mutex                      m_exportMutex;
+    std::thread                     m_thread;
+    std::mutex                      m_mutex;
+    std::condition_variable         m_stopCondition;
+    bool                            m_bStop;
+
+    // No copies
+    MetricsExporter( const MetricsExporter& );
+    MetricsExporter& operator=( const MetricsExporter& );
+};
+
+}}} // namespace AVT::VmbAPI::Examples
+
+#endif
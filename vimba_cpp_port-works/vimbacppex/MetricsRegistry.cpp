@@ -0,0 +1,366 @@
+/*=============================================================================
+  Copyright (C) 2013 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        MetricsRegistry.cpp
+
+  Description: Counters and gauges of the acquisition and write paths, with the
+               latencies of the pipeline stages as histograms, in Prometheus format.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#include <cmath>
+#include <cstdio>
+#include <map>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#include "MetricsRegistry.h"
+#include "LatencyMonitor.h"
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+namespace {
+
+// The upper bounds of the latency histogram buckets in seconds
+const double LATENCY_BUCKETS_S[] = { 0.00001, 0.0001, 0.0005, 0.001, 0.002, 0.005, 0.01, 0.02, 0.05, 0.1, 0.5, 1.0 };
+
+//
+// Formats a value of a sample, counts without exponent and fraction
+//
+std::string FormatValue( double dValue )
+{
+    char text[32];
+    if (    dValue == std::floor( dValue )
+         && std::fabs( dValue ) < 9e15 )
+    {
+        snprintf( text, sizeof( text ), "%.0f", dValue );
+    }
+    else
+    {
+        snprintf( text, sizeof( text ), "%.9g", dValue );
+    }
+    return text;
+}
+
+//
+// Joins two label lists
+//
+std::string JoinLabels( const std::string &rFirst, const std::string &rSecond )
+{
+    if (    rFirst.empty()
+         || rSecond.empty() )
+    {
+        return rFirst + rSecond;
+    }
+    return rFirst + "," + rSecond;
+}
+
+//
+// Adds a sample to a family
+//
+void AddSample( MetricFamily &rFamily, const std::string &rName, const std::string &rLabels, double dValue )
+{
+    MetricSample sample;
+    sample.strName      = rName;
+    sample.strLabels    = rLabels;
+    sample.dValue       = dValue;
+    rFamily.samples.push_back( sample );
+}
+
+} // namespace
+
+MetricsRegistry::MetricsRegistry()
+{
+}
+
+//
+// Gets the registry the pipeline feeds
+//
+MetricsRegistry& MetricsRegistry::GetDefault()
+{
+    static MetricsRegistry registry;
+    return registry;
+}
+
+//
+// Gets a metric, registering it on the first call for its name and labels
+//
+// Parameters:
+//  [in]    rName               The name, e.g. vimba_frames_acquired_total
+//  [in]    rHelp               What it counts, only the first registration of a name sets it
+//  [in]    rLabels             The labels without braces (see MakeMetricLabel), may be empty
+//
+MetricCounter& MetricsRegistry::GetCounter( const std::string &rName, const std::string &rHelp, const std::string &rLabels )
+{
+    return GetMetric( rName, rHelp, rLabels, MetricTypeCounter ).counter;
+}
+
+MetricGauge& MetricsRegistry::GetGauge( const std::string &rName, const std::string &rHelp, const std::string &rLabels )
+{
+    return GetMetric( rName, rHelp, rLabels, MetricTypeGauge ).gauge;
+}
+
+//
+// Reads all metrics, grouped by name in the order they were registered
+//
+// Parameters:
+//  [out]   rFamilies           The metrics
+//
+void MetricsRegistry::GetFamilies( MetricFamilyVector &rFamilies ) const
+{
+    rFamilies.clear();
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        std::map<std::string, size_t> familyIndices;
+        for (   std::vector<std::unique_ptr<Metric> >::const_iterator iter = m_metrics.begin();
+                m_metrics.end() != iter;
+                ++iter )
+        {
+            const Metric &rMetric = **iter;
+            std::map<std::string, size_t>::const_iterator index = familyIndices.find( rMetric.strName );
+            if ( familyIndices.end() == index )
+            {
+                MetricFamily family;
+                family.strName  = rMetric.strName;
+                family.strHelp  = rMetric.strHelp;
+                family.eType    = rMetric.eType;
+                index = familyIndices.insert( std::make_pair( rMetric.strName, rFamilies.size() )).first;
+                rFamilies.push_back( family );
+            }
+            const double dValue = MetricTypeCounter == rMetric.eType
+                ? static_cast<double>( rMetric.counter.GetValue() )
+                : static_cast<double>( rMetric.gauge.GetValue() );
+            AddSample( rFamilies[index->second], rMetric.strName, rMetric.strLabels, dValue );
+        }
+    }
+
+    // The latencies come from the latency monitor, read at the same time
+    MetricFamily latencies;
+    latencies.strName   = "vimba_stage_latency_seconds";
+    latencies.strHelp   = "Time frames spent in the stages of the acquisition pipeline";
+    latencies.eType     = MetricTypeHistogram;
+    for ( int i = 0; i < LatencyStageCount; ++i )
+    {
+        LatencyHistogram histogram;
+        LatencyMonitor::GetDefault().GetHistogram( static_cast<LatencyStage>( i ), histogram );
+        if ( 0 == histogram.GetCount() )
+        {
+            continue;
+        }
+        const std::string strStage = MakeMetricLabel( "stage", GetLatencyStageName( static_cast<LatencyStage>( i )));
+        for ( size_t j = 0; j < sizeof( LATENCY_BUCKETS_S ) / sizeof( LATENCY_BUCKETS_S[0] ); ++j )
+        {
+            char bound[32];
+            snprintf( bound, sizeof( bound ), "%g", LATENCY_BUCKETS_S[j] );
+            const VmbUint64_t nCount = histogram.GetCountUpTo( static_cast<VmbUint64_t>( LATENCY_BUCKETS_S[j] * 1e9 ));
+            AddSample( latencies, latencies.strName + "_bucket", JoinLabels( strStage, MakeMetricLabel( "le", bound )), static_cast<double>( nCount ));
+        }
+        AddSample( latencies, latencies.strName + "_bucket", JoinLabels( strStage, MakeMetricLabel( "le", "+Inf" )), static_cast<double>( histogram.GetCount() ));
+        AddSample( latencies, latencies.strName + "_sum", strStage, histogram.GetSumNS() / 1e9 );
+        AddSample( latencies, latencies.strName + "_count", strStage, static_cast<double>( histogram.GetCount() ));
+    }
+    if ( !latencies.samples.empty() )
+    {
+        rFamilies.push_back( latencies );
+    }
+}
+
+//
+// Gets all metrics in the Prometheus text format
+//
+std::string MetricsRegistry::FormatText() const
+{
+    static const char* const TYPE_NAMES[] = { "counter", "gauge", "histogram" };
+
+    MetricFamilyVector families;
+    GetFamilies( families );
+    std::string strText;
+    for (   MetricFamilyVector::const_iterator family = families.begin();
+            families.end() != family;
+            ++family )
+    {
+        strText += "# HELP " + family->strName + " " + family->strHelp + "\n";
+        strText += "# TYPE " + family->strName + " " + TYPE_NAMES[family->eType] + "\n";
+        for (   std::vector<MetricSample>::const_iterator sample = family->samples.begin();
+                family->samples.end() != sample;
+                ++sample )
+        {
+            strText += sample->strName;
+            if ( !sample->strLabels.empty() )
+            {
+                strText += "{" + sample->strLabels + "}";
+            }
+            strText += " " + FormatValue( sample->dValue ) + "\n";
+        }
+    }
+    return strText;
+}
+
+//
+// Writes all metrics in the Prometheus text format, e.g. for the textfile collector of node_exporter.
+// The file is written next to the destination and then renamed, so readers never see half of it.
+//
+// Parameters:
+//  [in]    rFileName           The path of the file
+//
+// Returns:
+//  An API status code
+//
+VmbErrorType MetricsRegistry::WriteTextFile( const std::string &rFileName ) const
+{
+    const std::string strText = FormatText();
+    const std::string strTempFileName = rFileName + ".tmp";
+    FILE *pFile = fopen( strTempFileName.c_str(), "wb" );
+    if ( NULL == pFile )
+    {
+        return VmbErrorOther;
+    }
+    const size_t nWritten = fwrite( strText.data(), 1, strText.size(), pFile );
+    if (    0 != fclose( pFile )
+         || strText.size() != nWritten )
+    {
+        remove( strTempFileName.c_str() );
+        return VmbErrorOther;
+    }
+#ifdef _WIN32
+    const bool bIsRenamed = FALSE != MoveFileExA( strTempFileName.c_str(), rFileName.c_str(), MOVEFILE_REPLACE_EXISTING );
+#else
+    const bool bIsRenamed = 0 == rename( strTempFileName.c_str(), rFileName.c_str() );
+#endif
+    if ( !bIsRenamed )
+    {
+        remove( strTempFileName.c_str() );
+        return VmbErrorOther;
+    }
+    return VmbErrorSuccess;
+}
+
+//
+// Gets the metric of a name and labels, registering it if needed
+//
+MetricsRegistry::Metric& MetricsRegistry::GetMetric( const std::string &rName, const std::string &rHelp, const std::string &rLabels, MetricType eType )
+{
+    std::lock_guard<std::mutex> lock( m_mutex );
+    for (   std::vector<std::unique_ptr<Metric> >::const_iterator iter = m_metrics.begin();
+            m_metrics.end() != iter;
+            ++iter )
+    {
+        if (    rName == ( *iter )->strName
+             && rLabels == ( *iter )->strLabels )
+        {
+            return **iter;
+        }
+    }
+    std::unique_ptr<Metric> pMetric( new Metric() );
+    pMetric->strName    = rName;
+    pMetric->strHelp    = rHelp;
+    pMetric->strLabels  = rLabels;
+    pMetric->eType      = eType;
+    m_metrics.push_back( std::move( pMetric ));
+    return *m_metrics.back();
+}
+
+//
+// Makes a label for a metric, escaping the value as Prometheus needs it
+//
+// Parameters:
+//  [in]    pName               The name of the label
+//  [in]    rValue              The value
+//
+// Returns:
+//  The label, e.g. camera="DEV_1"
+//
+std::string MakeMetricLabel( const char *pName, const std::string &rValue )
+{
+    std::string strLabel = std::string( pName ) + "=\"";
+    for (   std::string::const_iterator iter = rValue.begin();
+            rValue.end() != iter;
+            ++iter )
+    {
+        switch ( *iter )
+        {
+        case '\\':  strLabel += "\\\\"; break;
+        case '"':   strLabel += "\\\""; break;
+        case '\n':  strLabel += "\\n";  break;
+        default:    strLabel += *iter;  break;
+        }
+    }
+    return strLabel + "\"";
+}
+
+//
+// Gets the metrics of the write path, registering them on the first call
+//
+const WriteMetrics& WriteMetrics::GetDefault()
+{
+    static const WriteMetrics metrics =
+    {
+        &MetricsRegistry::GetDefault().GetCounter( "vimba_bytes_converted_total", "Image bytes converted to another pixel format for saving" ),
+        &MetricsRegistry::GetDefault().GetCounter( "vimba_bytes_written_total", "Bytes of image and recording files written" ),
+        &MetricsRegistry::GetDefault().GetCounter( "vimba_frames_not_saved_total", "Frames the image writer dropped because its queue was full" ),
+        &MetricsRegistry::GetDefault().GetGauge( "vimba_writer_queue_depth", "Frames waiting in the queues of the image writers" ),
+    };
+    return metrics;
+}
+
+//
+// Parameters:
+//  [in]    rCameraID           The ID of the camera, used as the camera label
+//
+CameraMetrics::CameraMetrics( const std::string &rCameraID )
+    : m_rFramesAcquired( MetricsRegistry::GetDefault().GetCounter( "vimba_frames_acquired_total", "Frames the camera delivered, complete or not", MakeMetricLabel( "camera", rCameraID )))
+    , m_rFramesIncomplete( MetricsRegistry::GetDefault().GetCounter( "vimba_frames_incomplete_total", "Frames the camera delivered incompletely", MakeMetricLabel( "camera", rCameraID )))
+    , m_rFramesDropped( MetricsRegistry::GetDefault().GetCounter( "vimba_frames_dropped_total", "Frames the camera never delivered (gaps in the frame IDs)", MakeMetricLabel( "camera", rCameraID )))
+    , m_rBytesAcquired( MetricsRegistry::GetDefault().GetCounter( "vimba_bytes_acquired_total", "Image bytes the camera delivered", MakeMetricLabel( "camera", rCameraID )))
+    , m_nNextFrameID( 0 )
+    , m_bHasFrame( false )
+{
+}
+
+//
+// Counts a frame, only to be called by one thread at a time in the order of the frames
+//
+// Parameters:
+//  [in]    rFrame              The frame the camera delivered
+//
+void CameraMetrics::RecordFrame( const ImageFrame &rFrame )
+{
+    // A frame ID below the expected one means the camera restarted counting, that is no loss
+    if (    m_bHasFrame
+         && rFrame.nFrameID > m_nNextFrameID )
+    {
+        m_rFramesDropped.Add( rFrame.nFrameID - m_nNextFrameID );
+    }
+    m_nNextFrameID = rFrame.nFrameID + 1;
+    m_bHasFrame = true;
+    if ( VmbFrameStatusComplete != rFrame.eReceiveStatus )
+    {
+        m_rFramesIncomplete.Add();
+    }
+    m_rFramesAcquired.Add();
+    m_rBytesAcquired.Add( rFrame.nImageSize );
+}
+
+}}} // namespace AVT::VmbAPI::Examples
@@ -0,0 +1,281 @@
+/*=============================================================================
+  Copyright (C) 2013 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        MetricsRegistry.h
+
+  Description: Counters and gauges of the acquisition and write paths, with the
+               latencies of the pipeline stages as histograms, in Prometheus format.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#ifndef AVT_VMBAPI_EXAMPLES_METRICSREGISTRY
+#define AVT_VMBAPI_EXAMPLES_METRICSREGISTRY
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "VimbaCPP/Include/VimbaCPP.h"
+
+#include "ImageFrame.h"
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+enum MetricType
+{
+    MetricTypeCounter,          // Only goes up
+    MetricTypeGauge,            // Goes up and down
+    MetricTypeHistogram,        // Cumulative buckets with sum and count
+};
+
+//
+// A value that only goes up, lock-free
+//
+class MetricCounter
+{
+  public:
+    MetricCounter()
+        : m_nValue( 0 )
+    {
+    }
+
+    void Add( VmbUint64_t nValue = 1 )
+    {
+        m_nValue.fetch_add( nValue, std::memory_order_relaxed );
+    }
+
+    VmbUint64_t GetValue() const
+    {
+        return m_nValue.load( std::memory_order_relaxed );
+    }
+
+  private:
+    std::atomic<VmbUint64_t> m_nValue;
+
+    // No copies
+    MetricCounter( const MetricCounter& );
+    MetricCounter& operator=( const MetricCounter& );
+};
+
+//
+// A value that goes up and down, lock-free
+//
+class MetricGauge
+{
+  public:
+    MetricGauge()
+        : m_nValue( 0 )
+    {
+    }
+
+    void Set( VmbInt64_t nValue )
+    {
+        m_nValue.store( nValue, std::memory_order_relaxed );
+    }
+
+    void Add( VmbInt64_t nValue )
+    {
+        m_nValue.fetch_add( nValue, std::memory_order_relaxed );
+    }
+
+    VmbInt64_t GetValue() const
+    {
+        return m_nValue.load( std::memory_order_relaxed );
+    }
+
+  private:
+    std::atomic<VmbInt64_t> m_nValue;
+
+    // No copies
+    MetricGauge( const MetricGauge& );
+    MetricGauge& operator=( const MetricGauge& );
+};
+
+//
+// One value of a metric at the time it was read
+//
+struct MetricSample
+{
+    std::string     strName;                // The name of the sample, e.g. the family name with _bucket
+    std::string     strLabels;              // The labels without braces, e.g. camera="DEV_1",le="0.001"
+    double          dValue;
+};
+
+//
+// The samples of all metrics of one name
+//
+struct MetricFamily
+{
+    std::string                 strName;
+    std::string                 strHelp;
+    MetricType                  eType;
+    std::vector<MetricSample>   samples;
+};
+
+typedef std::vector<MetricFamily> MetricFamilyVector;
+
+//
+// Keeps the metrics of the process. Metrics are registered once and then updated lock-free
+// through the reference the registry hands out, which stays valid as long as the registry.
+// The latencies of the pipeline stages (LatencyMonitor) are added as histograms when read.
+//
+class MetricsRegistry
+{
+  public:
+    MetricsRegistry();
+
+    //
+    // Gets the registry the pipeline feeds
+    //
+    static MetricsRegistry& GetDefault();
+
+    //
+    // Gets a metric, registering it on the first call for its name and labels
+    //
+    // Parameters:
+    //  [in]    rName               The name, e.g. vimba_frames_acquired_total
+    //  [in]    rHelp               What it counts, only the first registration of a name sets it
+    //  [in]    rLabels             The labels without braces (see MakeMetricLabel), may be empty
+    //
+    MetricCounter&  GetCounter( const std::string &rName, const std::string &rHelp, const std::string &rLabels = std::string() );
+    MetricGauge&    GetGauge( const std::string &rName, const std::string &rHelp, const std::string &rLabels = std::string() );
+
+    //
+    // Reads all metrics, grouped by name in the order they were registered
+    //
+    // Parameters:
+    //  [out]   rFamilies           The metrics
+    //
+    void            GetFamilies( MetricFamilyVector &rFamilies ) const;
+
+    //
+    // Gets all metrics in the Prometheus text format
+    //
+    std::string     FormatText() const;
+
+    //
+    // Writes all metrics in the Prometheus text format, e.g. for the textfile collector of node_exporter.
+    // The file is written next to the destination and then renamed, so readers never see half of it.
+    //
+    // Parameters:
+    //  [in]    rFileName           The path of the file
+    //
+    // Returns:
+    //  An API status code
+    //
+    VmbErrorType    WriteTextFile( const std::string &rFileName ) const;
+
+  private:
+    struct Metric
+    {
+        std::string     strName;
+        std::string     strHelp;
+        std::string     strLabels;
+        MetricType      eType;
+        MetricCounter   counter;
+        MetricGauge     gauge;
+    };
+
+    //
+    // Gets the metric of a name and labels, registering it if needed
+    //
+    Metric&         GetMetric( const std::string &rName, const std::string &rHelp, const std::string &rLabels, MetricType eType );
+
+    // The metrics in the order of registration, they never move
+    std::vector<std::unique_ptr<Metric> >   m_metrics;
+    mutable std::mutex                      m_mutex;
+
+    // No copies
+    MetricsRegistry( const MetricsRegistry& );
+    MetricsRegistry& operator=( const MetricsRegistry& );
+};
+
+//
+// Makes a label for a metric, escaping the value as Prometheus needs it
+//
+// Parameters:
+//  [in]    pName               The name of the label
+//  [in]    rValue              The value
+//
+// Returns:
+//  The label, e.g. camera="DEV_1"
+//
+std::string MakeMetricLabel( const char *pName, const std::string &rValue );
+
+//
+// The metrics of the write path, registered in the default registry
+//
+struct WriteMetrics
+{
+    MetricCounter*  pBytesConverted;        // Image bytes converted to another pixel format for saving (WriteBitmapFile)
+    MetricCounter*  pBytesWritten;          // Bytes of image and recording files written
+    MetricCounter*  pFramesNotSaved;        // Frames the image writer dropped because its queue was full
+    MetricGauge*    pWriterQueueDepth;      // Frames waiting in the queues of all image writers
+
+    //
+    // Gets the metrics, registering them on the first call
+    //
+    static const WriteMetrics& GetDefault();
+};
+
+//
+// Feeds the metrics of one camera from its frame callback, registered in the default registry.
+// Dropped frames are the gaps in the frame IDs.
+//
+class CameraMetrics
+{
+  public:
+    //
+    // Parameters:
+    //  [in]    rCameraID           The ID of the camera, used as the camera label
+    //
+    explicit CameraMetrics( const std::string &rCameraID );
+
+    //
+    // Counts a frame, only to be called by one thread at a time in the order of the frames
+    //
+    // Parameters:
+    //  [in]    rFrame              The frame the camera delivered
+    //
+    void            RecordFrame( const ImageFrame &rFrame );
+
+  private:
+    MetricCounter&  m_rFramesAcquired;
+    MetricCounter&  m_rFramesIncomplete;
+    MetricCounter&  m_rFramesDropped;
+    MetricCounter&  m_rBytesAcquired;
+    VmbUint64_t     m_nNextFrameID;
+    bool            m_bHasFrame;
+
+    // No copies
+    CameraMetrics( const CameraMetrics& );
+    CameraMetrics& operator=( const CameraMetrics& );
+};
+
+typedef std::shared_ptr<CameraMetrics> CameraMetricsPtr;
+
+}}} // namespace AVT::VmbAPI::Examples
+
+#endif
@@ -0,0 +1,331 @@
+/*=============================================================================
+  Copyright (C) 2013 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        MonoImage.cpp
+
+  Description: Host side handling of mono images deeper than 8 bit: unpacking to
+               16 bit, window/level mapping to 8 bit for display and 16 bit files.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include "MonoImage.h"
+#include "MetricsRegistry.h"
+#include "PixelSwizzle.h"
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+// A multiple of 4 pixels, so every chunk of a packed image starts on a byte
+enum { CHUNK_PIXEL_COUNT = 4096, };
+
+namespace {
+
+// How the pixels of a mono format lie in memory
+enum MonoStorage
+{
+    StorageByte,                            // One byte per pixel
+    StorageWord,                            // One little endian 16 bit word per pixel, the value in the low bits
+    StoragePacked,                          // A stream of bits, see MonoPacking
+};
+
+//
+// Gets how the pixels of a mono format lie in memory
+//
+// Parameters:
+//  [in]    ePixelFormat        The pixel format
+//  [out]   rnBitDepth          The number of significant bits
+//  [out]   reStorage           The kind of storage
+//  [out]   rePacking           The layout of packed formats
+//
+// Returns:
+//  False if the format is not mono
+//
+bool GetMonoLayout( VmbPixelFormatType ePixelFormat, VmbUint32_t &rnBitDepth, MonoStorage &reStorage, MonoPacking &rePacking )
+{
+    rePacking = PackingCount;
+    switch ( ePixelFormat )
+    {
+    case VmbPixelFormatMono8:           rnBitDepth = 8;     reStorage = StorageByte;                                        return true;
+    case VmbPixelFormatMono10:          rnBitDepth = 10;    reStorage = StorageWord;                                        return true;
+    case VmbPixelFormatMono12:          rnBitDepth = 12;    reStorage = StorageWord;                                        return true;
+    case VmbPixelFormatMono14:          rnBitDepth = 14;    reStorage = StorageWord;                                        return true;
+    case VmbPixelFormatMono16:          rnBitDepth = 16;    reStorage = StorageWord;                                        return true;
+    case VmbPixelFormatMono10p:         rnBitDepth = 10;    reStorage = StoragePacked;  rePacking = PackingMono10p;         return true;
+    case VmbPixelFormatMono12p:         rnBitDepth = 12;    reStorage = StoragePacked;  rePacking = PackingMono12p;         return true;
+    case VmbPixelFormatMono12Packed:    rnBitDepth = 12;    reStorage = StoragePacked;  rePacking = PackingMono12Packed;    return true;
+    default:                                                                                                                return false;
+    }
+}
+
+//
+// Hands the pixels of a mono image to a function in chunks of 16 bit values.
+// Unpacked 16 bit images are handed over in one piece without a copy.
+//
+// Parameters:
+//  [in]    rFrame              The image, any mono format
+//  [in]    function            Gets ( const VmbUint16_t *pPixels, VmbUint32_t nFirst, VmbUint32_t nCount ), returns false to stop
+//
+// Returns:
+//  An API status code, VmbErrorOther if the function stopped
+//
+template <typename Function>
+VmbErrorType ForEachMonoChunk( const ImageFrame &rFrame, Function function )
+{
+    VmbUint32_t nBitDepth;
+    MonoStorage eStorage;
+    MonoPacking ePacking;
+    if (    NULL == rFrame.pImage
+         || !GetMonoLayout( rFrame.ePixelFormat, nBitDepth, eStorage, ePacking )
+         || rFrame.nImageSize < GetImageSize( rFrame.nWidth, rFrame.nHeight, rFrame.ePixelFormat ))
+    {
+        return VmbErrorBadParameter;
+    }
+
+    const VmbUint32_t nPixelCount = rFrame.nWidth * rFrame.nHeight;
+    if ( StorageWord == eStorage )
+    {
+        // Frame buffers are aligned, the pixels can be used in place
+        return function( reinterpret_cast<const VmbUint16_t*>( rFrame.pImage ), 0, nPixelCount ) ? VmbErrorSuccess : VmbErrorOther;
+    }
+
+    VmbUint16_t chunk[CHUNK_PIXEL_COUNT];
+    for ( VmbUint32_t nFirst = 0; nFirst < nPixelCount; nFirst += CHUNK_PIXEL_COUNT )
+    {
+        const VmbUint32_t nCount = std::min<VmbUint32_t>( nPixelCount - nFirst, CHUNK_PIXEL_COUNT );
+        if ( StorageByte == eStorage )
+        {
+            for ( VmbUint32_t i = 0; i < nCount; ++i )
+            {
+                chunk[i] = rFrame.pImage[nFirst + i];
+            }
+        }
+        else
+        {
+            AVTUnpackMono( ePacking, rFrame.pImage + static_cast<VmbUint64_t>( nFirst ) * GetBitsPerPixel( rFrame.ePixelFormat ) / 8, chunk, nCount );
+        }
+        if ( !function( chunk, nFirst, nCount ))
+        {
+            return VmbErrorOther;
+        }
+    }
+    return VmbErrorSuccess;
+}
+
+} // namespace
+
+//
+// Gets the number of significant bits of a mono pixel format
+//
+// Parameters:
+//  [in]    ePixelFormat        The pixel format to look at
+//
+// Returns:
+//  8 to 16, 0 for formats that are not mono
+//
+VmbUint32_t GetMonoBitDepth( VmbPixelFormatType ePixelFormat )
+{
+    VmbUint32_t nBitDepth;
+    MonoStorage eStorage;
+    MonoPacking ePacking;
+    return GetMonoLayout( ePixelFormat, nBitDepth, eStorage, ePacking ) ? nBitDepth : 0;
+}
+
+//
+// Gets the window that shows the whole range of a mono pixel format
+//
+// Parameters:
+//  [in]    ePixelFormat        The pixel format of the images
+//
+// Returns:
+//  The window
+//
+DisplayWindow GetFullRangeWindow( VmbPixelFormatType ePixelFormat )
+{
+    const VmbUint32_t nBitDepth = GetMonoBitDepth( ePixelFormat );
+
+    DisplayWindow window;
+    if ( 0 != nBitDepth )
+    {
+        window.nHigh = static_cast<VmbUint16_t>(( 1UL << nBitDepth ) - 1 );
+    }
+    return window;
+}
+
+//
+// Gets the window of the given level (center) and width, clipped to 16 bit
+//
+// Parameters:
+//  [in]    nLevel              The value in the middle of the window
+//  [in]    nWidth              The number of values the window spans, 0 for a threshold at nLevel
+//
+// Returns:
+//  The window
+//
+DisplayWindow GetLevelWidthWindow( VmbUint32_t nLevel, VmbUint32_t nWidth )
+{
+    const VmbInt64_t nLow   = static_cast<VmbInt64_t>( nLevel ) - nWidth / 2;
+    const VmbInt64_t nHigh  = nLow + nWidth;
+
+    DisplayWindow window;
+    window.nLow     = static_cast<VmbUint16_t>( nLow < 0 ? 0 : ( nLow > 0xFFFF ? 0xFFFF : nLow ));
+    window.nHigh    = static_cast<VmbUint16_t>( nHigh < 0 ? 0 : ( nHigh > 0xFFFF ? 0xFFFF : nHigh ));
+    return window;
+}
+
+//
+// Unpacks a mono image to one 16 bit value per pixel, the value in the low bits
+//
+// Parameters:
+//  [in]    rFrame              The image, any mono format
+//  [out]   pDestination        The unpacked pixels, nWidth * nHeight values
+//
+// Returns:
+//  An API status code
+//
+VmbErrorType UnpackMonoImage( const ImageFrame &rFrame, VmbUint16_t *pDestination )
+{
+    VmbUint32_t nBitDepth;
+    MonoStorage eStorage;
+    MonoPacking ePacking;
+    if (    NULL == pDestination
+         || NULL == rFrame.pImage
+         || !GetMonoLayout( rFrame.ePixelFormat, nBitDepth, eStorage, ePacking )
+         || rFrame.nImageSize < GetImageSize( rFrame.nWidth, rFrame.nHeight, rFrame.ePixelFormat ))
+    {
+        return VmbErrorBadParameter;
+    }
+
+    // Unpacked straight into the destination, the chunks of ForEachMonoChunk would be an extra copy
+    const VmbUint32_t nPixelCount = rFrame.nWidth * rFrame.nHeight;
+    switch ( eStorage )
+    {
+    case StorageByte:
+        for ( VmbUint32_t i = 0; i < nPixelCount; ++i )
+        {
+            pDestination[i] = rFrame.pImage[i];
+        }
+        break;
+    case StorageWord:
+        memcpy( pDestination, rFrame.pImage, nPixelCount * sizeof( VmbUint16_t ));
+        break;
+    case StoragePacked:
+        AVTUnpackMono( ePacking, rFrame.pImage, pDestination, nPixelCount );
+        break;
+    }
+    return VmbErrorSuccess;
+}
+
+//
+// Maps a mono image to 8 bit for display
+//
+// Parameters:
+//  [in]    rFrame              The image, any mono format
+//  [in]    rWindow             The values to spread over 8 bit
+//  [out]   pDestination        The Mono8 image, nWidth * nHeight bytes
+//
+// Returns:
+//  An API status code
+//
+VmbErrorType ConvertMonoToMono8( const ImageFrame &rFrame, const DisplayWindow &rWindow, VmbUchar_t *pDestination )
+{
+    if ( NULL == pDestination )
+    {
+        return VmbErrorBadParameter;
+    }
+    const auto mapChunk = [&]( const VmbUint16_t *pPixels, VmbUint32_t nFirst, VmbUint32_t nCount ) -> bool
+    {
+        AVTWindowLevel( pPixels, pDestination + nFirst, nCount, rWindow.nLow, rWindow.nHigh );
+        return true;
+    };
+    return ForEachMonoChunk( rFrame, mapChunk );
+}
+
+//
+// Writes a mono image with all of its bits to a binary PGM file (16 bit for more than 8 bit)
+//
+// Parameters:
+//  [in]    rFrame              The image, any mono format
+//  [in]    pFileName           The destination (complete path) of the file
+//
+// Returns:
+//  An API status code
+//
+VmbErrorType WritePgmFile( const ImageFrame &rFrame, const char *pFileName )
+{
+    const VmbUint32_t nBitDepth = GetMonoBitDepth( rFrame.ePixelFormat );
+    if (    0 == nBitDepth
+         || NULL == rFrame.pImage
+         || NULL == pFileName
+         || rFrame.nImageSize < GetImageSize( rFrame.nWidth, rFrame.nHeight, rFrame.ePixelFormat ))
+    {
+        return VmbErrorBadParameter;
+    }
+
+    FILE *file = fopen( pFileName, "wb" );
+    if ( NULL == file )
+    {
+        return VmbErrorOther;
+    }
+    // The maximum value tells readers the bit depth, the values are stored as they are
+    bool bResult = 0 < fprintf( file, "P5\n%u %u\n%lu\n", rFrame.nWidth, rFrame.nHeight, ( 1UL << nBitDepth ) - 1 );
+    VmbUchar_t bytes[CHUNK_PIXEL_COUNT * 2];
+    const auto writeChunk = [&]( const VmbUint16_t *pPixels, VmbUint32_t /*nFirst*/, VmbUint32_t nCount ) -> bool
+    {
+        // PGM is big endian, 8 bit images have one byte per pixel
+        size_t nSize = 0;
+        for ( VmbUint32_t i = 0; i < nCount; ++i )
+        {
+            if ( 8 < nBitDepth )
+            {
+                bytes[nSize++] = static_cast<VmbUchar_t>( pPixels[i] >> 8 );
+            }
+            bytes[nSize++] = static_cast<VmbUchar_t>( pPixels[i] );
+            if (    sizeof( bytes ) == nSize
+                 || i + 1 == nCount )
+            {
+                if ( nSize != fwrite( bytes, 1, nSize, file ))
+                {
+                    return false;
+                }
+                nSize = 0;
+            }
+        }
+        return true;
+    };
+    bResult = bResult && VmbErrorSuccess == ForEachMonoChunk( rFrame, writeChunk );
+    const long nFileSize = ftell( file );
+    bResult = ( 0 == fclose( file )) && bResult;
+    if (    !bResult
+         || 0 > nFileSize )
+    {
+        return VmbErrorOther;
+    }
+    WriteMetrics::GetDefault().pBytesWritten->Add( static_cast<VmbUint64_t>( nFileSize ));
+    return VmbErrorSuccess;
+}
+
+}}} // namespace AVT::VmbAPI::Examples
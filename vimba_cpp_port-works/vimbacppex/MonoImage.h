@@ -0,0 +1,129 @@
+/*=============================================================================
+  Copyright (C) 2013 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        MonoImage.h
+
+  Description: Host side handling of mono images deeper than 8 bit: unpacking to
+               16 bit, window/level mapping to 8 bit for display and 16 bit files.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#ifndef AVT_VMBAPI_EXAMPLES_MONOIMAGE
+#define AVT_VMBAPI_EXAMPLES_MONOIMAGE
+
+#include "VimbaCPP/Include/VimbaCPP.h"
+
+#include "ImageFrame.h"
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+//
+// The range of 16 bit values that is spread over the 8 bit of a display.
+// Values up to nLow are black, values from nHigh on are white.
+//
+struct DisplayWindow
+{
+    VmbUint16_t nLow;                       // The lower end of the window
+    VmbUint16_t nHigh;                      // The upper end of the window, equal to nLow for a threshold
+
+    DisplayWindow()
+        : nLow( 0 )
+        , nHigh( 0xFFFF )
+    {
+    }
+};
+
+//
+// Gets the number of significant bits of a mono pixel format
+//
+// Parameters:
+//  [in]    ePixelFormat        The pixel format to look at
+//
+// Returns:
+//  8 to 16, 0 for formats that are not mono
+//
+VmbUint32_t GetMonoBitDepth( VmbPixelFormatType ePixelFormat );
+
+//
+// Gets the window that shows the whole range of a mono pixel format
+//
+// Parameters:
+//  [in]    ePixelFormat        The pixel format of the images
+//
+// Returns:
+//  The window
+//
+DisplayWindow GetFullRangeWindow( VmbPixelFormatType ePixelFormat );
+
+//
+// Gets the window of the given level (center) and width, clipped to 16 bit
+//
+// Parameters:
+//  [in]    nLevel              The value in the middle of the window
+//  [in]    nWidth              The number of values the window spans, 0 for a threshold at nLevel
+//
+// Returns:
+//  The window
+//
+DisplayWindow GetLevelWidthWindow( VmbUint32_t nLevel, VmbUint32_t nWidth );
+
+//
+// Unpacks a mono image to one 16 bit value per pixel, the value in the low bits
+//
+// Parameters:
+//  [in]    rFrame              The image, any mono format
+//  [out]   pDestination        The unpacked pixels, nWidth * nHeight values
+//
+// Returns:
+//  An API status code
+//
+VmbErrorType UnpackMonoImage( const ImageFrame &rFrame, VmbUint16_t *pDestination );
+
+//
+// Maps a mono image to 8 bit for display
+//
+// Parameters:
+//  [in]    rFrame              The image, any mono format
+//  [in]    rWindow             The values to spread over 8 bit
+//  [out]   pDestination        The Mono8 image, nWidth * nHeight bytes
+//
+// Returns:
+//  An API status code
+//
+VmbErrorType ConvertMonoToMono8( const ImageFrame &rFrame, const DisplayWindow &rWindow, VmbUchar_t *pDestination );
+
+//
+// Writes a mono image with all of its bits to a binary PGM file (16 bit for more than 8 bit)
+//
+// Parameters:
+//  [in]    rFrame              The image, any mono format
+//  [in]    pFileName           The destination (complete path) of the file
+//
+// Returns:
+//  An API status code
+//
+VmbErrorType WritePgmFile( const ImageFrame &rFrame, const char *pFileName );
+
+}}} // namespace AVT::VmbAPI::Examples
+
+#endif
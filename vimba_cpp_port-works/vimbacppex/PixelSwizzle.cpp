@@ -0,0 +1,746 @@
+/*=============================================================================
+  Copyright (C) 2013 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        PixelSwizzle.cpp
+
+  Description: Vectorized RGB to BGR conversion, unpacking of 10 and 12 bit mono
+               pixels and window/level mapping of 16 bit to 8 bit pixels
+               (SSSE3, AVX2, NEON) with scalar references, chosen at runtime by
+               the features of the CPU.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#include <string.h>
+
+#if defined( _M_IX86 ) || defined( _M_X64 ) || defined( __i386__ ) || defined( __x86_64__ )
+#define AVT_SWIZZLE_X86
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#include <immintrin.h>
+#endif
+
+#if defined( __ARM_NEON ) || defined( __ARM_NEON__ ) || defined( _M_ARM64 )
+#define AVT_SWIZZLE_NEON
+#include <arm_neon.h>
+#endif
+
+// MSVC compiles any intrinsic, GCC and Clang need to be told per function
+#if defined( AVT_SWIZZLE_X86 ) && !defined( _MSC_VER )
+#define AVT_TARGET( x ) __attribute__(( target( x )))
+#else
+#define AVT_TARGET( x )
+#endif
+
+#include "PixelSwizzle.h"
+
+//
+// The reference: one pixel at a time
+//
+static void AVTSwapRGBScalar( const unsigned char* pSource, unsigned char* pDestination, unsigned long nPixels )
+{
+    unsigned long   px;                             // A single pixel for storing transformed color information
+    unsigned long   x;                              // The horizontal position within our row
+
+    for (   x = 0;
+            x < nPixels;
+            ++x,
+            pSource += 3,
+            pDestination += 3 )
+    {
+        px = 0;
+        // Create a 4 Byte structure to store ARGB (we don't use A)
+        px = px | (pSource[0] << 16) | (pSource[1] << 8) | pSource[2];
+        // Due to endianess ARGB is stored as BGRA 
+        // and we only have to write the first three Bytes
+        memcpy( pDestination, &px, 3 );
+    }
+}
+
+//
+// The references for unpacking. The LSB first layouts are a stream of bits, every pixel
+// lies within the two bytes at its first bit.
+//
+static void AVTUnpackMono10pScalar( const unsigned char* pSource, unsigned short* pDestination, unsigned long nPixels )
+{
+    unsigned long   nBit;                           // The first bit of the current pixel
+    unsigned long   x;                              // The position within our pixels
+
+    for ( x = 0, nBit = 0; x < nPixels; ++x, nBit += 10 )
+    {
+        pDestination[x] = (unsigned short)((( pSource[nBit >> 3] | ( pSource[( nBit >> 3 ) + 1] << 8 )) >> ( nBit & 7 )) & 0x3FF );
+    }
+}
+
+static void AVTUnpackMono12pScalar( const unsigned char* pSource, unsigned short* pDestination, unsigned long nPixels )
+{
+    unsigned long   x;                              // The position within our pixels
+
+    for ( x = 0; x + 2 <= nPixels; x += 2, pSource += 3 )
+    {
+        pDestination[x]     = (unsigned short)( pSource[0] | (( pSource[1] & 0x0F ) << 8 ));
+        pDestination[x + 1] = (unsigned short)(( pSource[1] >> 4 ) | ( pSource[2] << 4 ));
+    }
+    if ( x < nPixels )
+    {
+        pDestination[x]     = (unsigned short)( pSource[0] | (( pSource[1] & 0x0F ) << 8 ));
+    }
+}
+
+static void AVTUnpackMono12PackedScalar( const unsigned char* pSource, unsigned short* pDestination, unsigned long nPixels )
+{
+    unsigned long   x;                              // The position within our pixels
+
+    for ( x = 0; x + 2 <= nPixels; x += 2, pSource += 3 )
+    {
+        pDestination[x]     = (unsigned short)(( pSource[0] << 4 ) | ( pSource[1] & 0x0F ));
+        pDestination[x + 1] = (unsigned short)(( pSource[2] << 4 ) | ( pSource[1] >> 4 ));
+    }
+    if ( x < nPixels )
+    {
+        pDestination[x]     = (unsigned short)(( pSource[0] << 4 ) | ( pSource[1] & 0x0F ));
+    }
+}
+
+//
+// Window/level is (min( max( value - low, 0 ), width ) << shift) * scale >> 16. The shift moves the
+// width into the upper half of 16 bits so the scale fits into 16 bits as well, and the vector
+// kernels get away with a 16 bit high multiply. Every kernel uses the same arithmetic.
+//
+typedef struct
+{
+    unsigned short  nLow;                           // Subtracted from every value
+    unsigned short  nWidth;                         // The largest value after subtracting nLow
+    unsigned short  nShift;                         // Moves nWidth to at least 0x8000
+    unsigned short  nScale;                         // Maps nWidth << nShift to 255
+} AVTWindowLevelParams;
+
+static AVTWindowLevelParams AVTGetWindowLevelParams( unsigned short nLow, unsigned short nHigh )
+{
+    AVTWindowLevelParams    params;                 // The result
+
+    params.nLow     = nLow;
+    params.nWidth   = nHigh > nLow ? (unsigned short)( nHigh - nLow ) : 1;
+    params.nShift   = 0;
+    while ( 0 == ( ( params.nWidth << params.nShift ) & 0x8000 ))
+    {
+        ++params.nShift;
+    }
+    // Rounded up so the end of the window reaches 255, it never overshoots
+    params.nScale   = (unsigned short)( 255UL * 65536UL / ( (unsigned long)params.nWidth << params.nShift ) + 1 );
+    return params;
+}
+
+static void AVTWindowLevelScalar( const unsigned short* pSource, unsigned char* pDestination, unsigned long nPixels,
+                                  unsigned short nLow, unsigned short nHigh )
+{
+    const AVTWindowLevelParams  params = AVTGetWindowLevelParams( nLow, nHigh );
+    unsigned long               nValue;             // The current pixel within the window
+    unsigned long               x;                  // The position within our pixels
+
+    for ( x = 0; x < nPixels; ++x )
+    {
+        nValue = pSource[x] > params.nLow ? pSource[x] - params.nLow : 0;
+        nValue = nValue < params.nWidth ? nValue : params.nWidth;
+        pDestination[x] = (unsigned char)((( nValue << params.nShift ) * params.nScale ) >> 16 );
+    }
+}
+
+#ifdef AVT_SWIZZLE_X86
+
+//
+// 16 pixels are 48 bytes in three registers. Every output register takes most bytes
+// from the input register at the same position and one byte from a neighbor.
+//
+#define AVT_SWIZZLE_MASKS                                                                               \
+    const __m128i mask00 = _mm_setr_epi8(  2,  1,  0,  5,  4,  3,  8,  7,  6, 11, 10,  9, 14, 13, 12, -1 ); \
+    const __m128i mask01 = _mm_setr_epi8( -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,  1 ); \
+    const __m128i mask10 = _mm_setr_epi8( -1, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 ); \
+    const __m128i mask11 = _mm_setr_epi8(  0, -1,  4,  3,  2,  7,  6,  5, 10,  9,  8, 13, 12, 11, -1, 15 ); \
+    const __m128i mask12 = _mm_setr_epi8( -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,  0, -1 ); \
+    const __m128i mask21 = _mm_setr_epi8( 14, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 ); \
+    const __m128i mask22 = _mm_setr_epi8( -1,  3,  2,  1,  6,  5,  4,  9,  8,  7, 12, 11, 10, 15, 14, 13 );
+
+AVT_TARGET( "ssse3" )
+static void AVTSwapRGBSSSE3( const unsigned char* pSource, unsigned char* pDestination, unsigned long nPixels )
+{
+    AVT_SWIZZLE_MASKS
+    __m128i         a, b, c;                        // The 48 input bytes
+    unsigned long   x;                              // The horizontal position within our row
+
+    for ( x = 0; x + 16 <= nPixels; x += 16, pSource += 48, pDestination += 48 )
+    {
+        a = _mm_loadu_si128( (const __m128i*)( pSource ));
+        b = _mm_loadu_si128( (const __m128i*)( pSource + 16 ));
+        c = _mm_loadu_si128( (const __m128i*)( pSource + 32 ));
+        _mm_storeu_si128( (__m128i*)( pDestination ),      _mm_or_si128( _mm_shuffle_epi8( a, mask00 ), _mm_shuffle_epi8( b, mask01 )));
+        _mm_storeu_si128( (__m128i*)( pDestination + 16 ), _mm_or_si128( _mm_or_si128( _mm_shuffle_epi8( a, mask10 ), _mm_shuffle_epi8( b, mask11 )), _mm_shuffle_epi8( c, mask12 )));
+        _mm_storeu_si128( (__m128i*)( pDestination + 32 ), _mm_or_si128( _mm_shuffle_epi8( b, mask21 ), _mm_shuffle_epi8( c, mask22 )));
+    }
+    AVTSwapRGBScalar( pSource, pDestination, nPixels - x );
+}
+
+//
+// The same shuffles on two blocks of 16 pixels at once, one block per 128 bit lane
+//
+AVT_TARGET( "avx2" )
+static void AVTSwapRGBAVX2( const unsigned char* pSource, unsigned char* pDestination, unsigned long nPixels )
+{
+    AVT_SWIZZLE_MASKS
+    const __m256i   mask00x2 = _mm256_broadcastsi128_si256( mask00 );
+    const __m256i   mask01x2 = _mm256_broadcastsi128_si256( mask01 );
+    const __m256i   mask10x2 = _mm256_broadcastsi128_si256( mask10 );
+    const __m256i   mask11x2 = _mm256_broadcastsi128_si256( mask11 );
+    const __m256i   mask12x2 = _mm256_broadcastsi128_si256( mask12 );
+    const __m256i   mask21x2 = _mm256_broadcastsi128_si256( mask21 );
+    const __m256i   mask22x2 = _mm256_broadcastsi128_si256( mask22 );
+    __m256i         a, b, c;                        // The 96 input bytes, block one in the low lanes
+    __m256i         o0, o1, o2;                     // The 96 output bytes
+    unsigned long   x;                              // The horizontal position within our row
+
+    for ( x = 0; x + 32 <= nPixels; x += 32, pSource += 96, pDestination += 96 )
+    {
+        a = _mm256_inserti128_si256( _mm256_castsi128_si256( _mm_loadu_si128( (const __m128i*)( pSource      ))), _mm_loadu_si128( (const __m128i*)( pSource + 48 )), 1 );
+        b = _mm256_inserti128_si256( _mm256_castsi128_si256( _mm_loadu_si128( (const __m128i*)( pSource + 16 ))), _mm_loadu_si128( (const __m128i*)( pSource + 64 )), 1 );
+        c = _mm256_inserti128_si256( _mm256_castsi128_si256( _mm_loadu_si128( (const __m128i*)( pSource + 32 ))), _mm_loadu_si128( (const __m128i*)( pSource + 80 )), 1 );
+        o0 = _mm256_or_si256( _mm256_shuffle_epi8( a, mask00x2 ), _mm256_shuffle_epi8( b, mask01x2 ));
+        o1 = _mm256_or_si256( _mm256_or_si256( _mm256_shuffle_epi8( a, mask10x2 ), _mm256_shuffle_epi8( b, mask11x2 )), _mm256_shuffle_epi8( c, mask12x2 ));
+        o2 = _mm256_or_si256( _mm256_shuffle_epi8( b, mask21x2 ), _mm256_shuffle_epi8( c, mask22x2 ));
+        _mm_storeu_si128( (__m128i*)( pDestination      ), _mm256_castsi256_si128( o0 ));
+        _mm_storeu_si128( (__m128i*)( pDestination + 16 ), _mm256_castsi256_si128( o1 ));
+        _mm_storeu_si128( (__m128i*)( pDestination + 32 ), _mm256_castsi256_si128( o2 ));
+        _mm_storeu_si128( (__m128i*)( pDestination + 48 ), _mm256_extracti128_si256( o0, 1 ));
+        _mm_storeu_si128( (__m128i*)( pDestination + 64 ), _mm256_extracti128_si256( o1, 1 ));
+        _mm_storeu_si128( (__m128i*)( pDestination + 80 ), _mm256_extracti128_si256( o2, 1 ));
+    }
+    // Less than 32 pixels left
+    AVTSwapRGBSSSE3( pSource, pDestination, nPixels - x );
+}
+
+//
+// Unpacking puts the two bytes that hold a pixel into its 16 bit lane with a shuffle.
+// Multiplying by a power of two per lane moves the top bit of the pixel to the top of
+// the lane, an equal right shift of all lanes then drops the bits of the neighbors.
+//
+#define AVT_UNPACK_10P_MASKS                                                                            \
+    const __m128i shuffle10p        = _mm_setr_epi8(  0,  1,  1,  2,  2,  3,  3,  4,  5,  6,  6,  7,  7,  8,  8,  9 ); \
+    const __m128i multiplier10p     = _mm_setr_epi16( 64, 16, 4, 1, 64, 16, 4, 1 );
+#define AVT_UNPACK_12P_MASKS                                                                            \
+    const __m128i shuffle12p        = _mm_setr_epi8(  0,  1,  1,  2,  3,  4,  4,  5,  6,  7,  7,  8,  9, 10, 10, 11 ); \
+    const __m128i multiplier12p     = _mm_setr_epi16( 16, 1, 16, 1, 16, 1, 16, 1 );
+#define AVT_UNPACK_12PACKED_MASKS                                                                       \
+    const __m128i shuffle12Packed   = _mm_setr_epi8(  1,  0,  1,  2,  4,  3,  4,  5,  7,  6,  7,  8, 10,  9, 10, 11 ); \
+    const __m128i high12Packed      = _mm_setr_epi16( 0x0FF0, 0x0FFF, 0x0FF0, 0x0FFF, 0x0FF0, 0x0FFF, 0x0FF0, 0x0FFF ); \
+    const __m128i low12Packed       = _mm_setr_epi16( 0x000F, 0x0000, 0x000F, 0x0000, 0x000F, 0x0000, 0x000F, 0x0000 );
+
+// The loops load 16 bytes for 8 pixels, they stop early enough to never read past the image
+AVT_TARGET( "ssse3" )
+static void AVTUnpackMono10pSSSE3( const unsigned char* pSource, unsigned short* pDestination, unsigned long nPixels )
+{
+    AVT_UNPACK_10P_MASKS
+    __m128i         words;                          // 8 pixels with neighboring bits
+    unsigned long   x;                              // The position within our pixels
+
+    for ( x = 0; x + 16 <= nPixels; x += 8, pSource += 10, pDestination += 8 )
+    {
+        words = _mm_shuffle_epi8( _mm_loadu_si128( (const __m128i*)( pSource )), shuffle10p );
+        _mm_storeu_si128( (__m128i*)( pDestination ), _mm_srli_epi16( _mm_mullo_epi16( words, multiplier10p ), 6 ));
+    }
+    AVTUnpackMono10pScalar( pSource, pDestination, nPixels - x );
+}
+
+AVT_TARGET( "ssse3" )
+static void AVTUnpackMono12pSSSE3( const unsigned char* pSource, unsigned short* pDestination, unsigned long nPixels )
+{
+    AVT_UNPACK_12P_MASKS
+    __m128i         words;                          // 8 pixels with neighboring bits
+    unsigned long   x;                              // The position within our pixels
+
+    for ( x = 0; x + 16 <= nPixels; x += 8, pSource += 12, pDestination += 8 )
+    {
+        words = _mm_shuffle_epi8( _mm_loadu_si128( (const __m128i*)( pSource )), shuffle12p );
+        _mm_storeu_si128( (__m128i*)( pDestination ), _mm_srli_epi16( _mm_mullo_epi16( words, multiplier12p ), 4 ));
+    }
+    AVTUnpackMono12pScalar( pSource, pDestination, nPixels - x );
+}
+
+//
+// The even pixels of Mono12Packed have their high byte first, their two parts are masked out separately
+//
+AVT_TARGET( "ssse3" )
+static void AVTUnpackMono12PackedSSSE3( const unsigned char* pSource, unsigned short* pDestination, unsigned long nPixels )
+{
+    AVT_UNPACK_12PACKED_MASKS
+    __m128i         words;                          // 8 pixels with neighboring bits
+    unsigned long   x;                              // The position within our pixels
+
+    for ( x = 0; x + 16 <= nPixels; x += 8, pSource += 12, pDestination += 8 )
+    {
+        words = _mm_shuffle_epi8( _mm_loadu_si128( (const __m128i*)( pSource )), shuffle12Packed );
+        _mm_storeu_si128( (__m128i*)( pDestination ), _mm_or_si128( _mm_and_si128( _mm_srli_epi16( words, 4 ), high12Packed ),
+                                                                    _mm_and_si128( words, low12Packed )));
+    }
+    AVTUnpackMono12PackedScalar( pSource, pDestination, nPixels - x );
+}
+
+//
+// The same shuffles on two blocks of 8 pixels at once, one block per 128 bit lane
+//
+#define AVT_UNPACK_LOAD_X2( pBlock, nBlockSize ) \
+    _mm256_inserti128_si256( _mm256_castsi128_si256( _mm_loadu_si128( (const __m128i*)( pBlock ))), _mm_loadu_si128( (const __m128i*)( pBlock + nBlockSize )), 1 )
+
+AVT_TARGET( "avx2" )
+static void AVTUnpackMono10pAVX2( const unsigned char* pSource, unsigned short* pDestination, unsigned long nPixels )
+{
+    AVT_UNPACK_10P_MASKS
+    const __m256i   shuffle10px2    = _mm256_broadcastsi128_si256( shuffle10p );
+    const __m256i   multiplier10px2 = _mm256_broadcastsi128_si256( multiplier10p );
+    __m256i         words;                          // 16 pixels with neighboring bits
+    unsigned long   x;                              // The position within our pixels
+
+    for ( x = 0; x + 24 <= nPixels; x += 16, pSource += 20, pDestination += 16 )
+    {
+        words = _mm256_shuffle_epi8( AVT_UNPACK_LOAD_X2( pSource, 10 ), shuffle10px2 );
+        _mm256_storeu_si256( (__m256i*)( pDestination ), _mm256_srli_epi16( _mm256_mullo_epi16( words, multiplier10px2 ), 6 ));
+    }
+    AVTUnpackMono10pSSSE3( pSource, pDestination, nPixels - x );
+}
+
+AVT_TARGET( "avx2" )
+static void AVTUnpackMono12pAVX2( const unsigned char* pSource, unsigned short* pDestination, unsigned long nPixels )
+{
+    AVT_UNPACK_12P_MASKS
+    const __m256i   shuffle12px2    = _mm256_broadcastsi128_si256( shuffle12p );
+    const __m256i   multiplier12px2 = _mm256_broadcastsi128_si256( multiplier12p );
+    __m256i         words;                          // 16 pixels with neighboring bits
+    unsigned long   x;                              // The position within our pixels
+
+    for ( x = 0; x + 24 <= nPixels; x += 16, pSource += 24, pDestination += 16 )
+    {
+        words = _mm256_shuffle_epi8( AVT_UNPACK_LOAD_X2( pSource, 12 ), shuffle12px2 );
+        _mm256_storeu_si256( (__m256i*)( pDestination ), _mm256_srli_epi16( _mm256_mullo_epi16( words, multiplier12px2 ), 4 ));
+    }
+    AVTUnpackMono12pSSSE3( pSource, pDestination, nPixels - x );
+}
+
+AVT_TARGET( "avx2" )
+static void AVTUnpackMono12PackedAVX2( const unsigned char* pSource, unsigned short* pDestination, unsigned long nPixels )
+{
+    AVT_UNPACK_12PACKED_MASKS
+    const __m256i   shuffle12Packedx2   = _mm256_broadcastsi128_si256( shuffle12Packed );
+    const __m256i   high12Packedx2      = _mm256_broadcastsi128_si256( high12Packed );
+    const __m256i   low12Packedx2       = _mm256_broadcastsi128_si256( low12Packed );
+    __m256i         words;                          // 16 pixels with neighboring bits
+    unsigned long   x;                              // The position within our pixels
+
+    for ( x = 0; x + 24 <= nPixels; x += 16, pSource += 24, pDestination += 16 )
+    {
+        words = _mm256_shuffle_epi8( AVT_UNPACK_LOAD_X2( pSource, 12 ), shuffle12Packedx2 );
+        _mm256_storeu_si256( (__m256i*)( pDestination ), _mm256_or_si256( _mm256_and_si256( _mm256_srli_epi16( words, 4 ), high12Packedx2 ),
+                                                                          _mm256_and_si256( words, low12Packedx2 )));
+    }
+    AVTUnpackMono12PackedSSSE3( pSource, pDestination, nPixels - x );
+}
+
+//
+// SSE2 has no unsigned 16 bit minimum, a - saturated( a - b ) is one
+//
+AVT_TARGET( "ssse3" )
+static void AVTWindowLevelSSSE3( const unsigned short* pSource, unsigned char* pDestination, unsigned long nPixels,
+                                 unsigned short nLow, unsigned short nHigh )
+{
+    const AVTWindowLevelParams  params  = AVTGetWindowLevelParams( nLow, nHigh );
+    const __m128i               low     = _mm_set1_epi16( (short)params.nLow );
+    const __m128i               width   = _mm_set1_epi16( (short)params.nWidth );
+    const __m128i               scale   = _mm_set1_epi16( (short)params.nScale );
+    const __m128i               shift   = _mm_cvtsi32_si128( params.nShift );
+    __m128i                     a, b;               // 16 pixels
+    unsigned long               x;                  // The position within our pixels
+
+    for ( x = 0; x + 16 <= nPixels; x += 16, pSource += 16, pDestination += 16 )
+    {
+        a = _mm_subs_epu16( _mm_loadu_si128( (const __m128i*)( pSource )), low );
+        b = _mm_subs_epu16( _mm_loadu_si128( (const __m128i*)( pSource + 8 )), low );
+        a = _mm_sub_epi16( a, _mm_subs_epu16( a, width ));
+        b = _mm_sub_epi16( b, _mm_subs_epu16( b, width ));
+        a = _mm_mulhi_epu16( _mm_sll_epi16( a, shift ), scale );
+        b = _mm_mulhi_epu16( _mm_sll_epi16( b, shift ), scale );
+        _mm_storeu_si128( (__m128i*)( pDestination ), _mm_packus_epi16( a, b ));
+    }
+    AVTWindowLevelScalar( pSource, pDestination, nPixels - x, nLow, nHigh );
+}
+
+AVT_TARGET( "avx2" )
+static void AVTWindowLevelAVX2( const unsigned short* pSource, unsigned char* pDestination, unsigned long nPixels,
+                                unsigned short nLow, unsigned short nHigh )
+{
+    const AVTWindowLevelParams  params  = AVTGetWindowLevelParams( nLow, nHigh );
+    const __m256i               low     = _mm256_set1_epi16( (short)params.nLow );
+    const __m256i               width   = _mm256_set1_epi16( (short)params.nWidth );
+    const __m256i               scale   = _mm256_set1_epi16( (short)params.nScale );
+    const __m128i               shift   = _mm_cvtsi32_si128( params.nShift );
+    __m256i                     a, b;               // 32 pixels
+    unsigned long               x;                  // The position within our pixels
+
+    for ( x = 0; x + 32 <= nPixels; x += 32, pSource += 32, pDestination += 32 )
+    {
+        a = _mm256_min_epu16( _mm256_subs_epu16( _mm256_loadu_si256( (const __m256i*)( pSource )), low ), width );
+        b = _mm256_min_epu16( _mm256_subs_epu16( _mm256_loadu_si256( (const __m256i*)( pSource + 16 )), low ), width );
+        a = _mm256_mulhi_epu16( _mm256_sll_epi16( a, shift ), scale );
+        b = _mm256_mulhi_epu16( _mm256_sll_epi16( b, shift ), scale );
+        // Packing works per 128 bit lane, the permute puts the quarters back in order
+        _mm256_storeu_si256( (__m256i*)( pDestination ), _mm256_permute4x64_epi64( _mm256_packus_epi16( a, b ), 0xD8 ));
+    }
+    AVTWindowLevelSSSE3( pSource, pDestination, nPixels - x, nLow, nHigh );
+}
+
+//
+// Reads the CPU features
+//
+static void AVTCpuid( int nLeaf, int info[4] )
+{
+#ifdef _MSC_VER
+    __cpuidex( info, nLeaf, 0 );
+#else
+    unsigned int a = 0, b = 0, c = 0, d = 0;
+    if ( (unsigned int)nLeaf <= __get_cpuid_max( 0, NULL ))
+    {
+        __cpuid_count( nLeaf, 0, a, b, c, d );
+    }
+    info[0] = (int)a;
+    info[1] = (int)b;
+    info[2] = (int)c;
+    info[3] = (int)d;
+#endif
+}
+
+static int AVTHasSSSE3()
+{
+    int info[4];
+    AVTCpuid( 1, info );
+    return 0 != ( info[2] & ( 1 << 9 ));
+}
+
+static int AVTHasAVX2()
+{
+    int                 info[4];
+    unsigned long long  xcr0;
+
+    AVTCpuid( 1, info );
+    // The OS has to save the AVX registers (OSXSAVE and AVX bits)
+    if ( ( 3 << 27 ) != ( info[2] & ( 3 << 27 )))
+    {
+        return 0;
+    }
+#ifdef _MSC_VER
+    xcr0 = _xgetbv( 0 );
+#else
+    {
+        unsigned int eax, edx;
+        __asm__ __volatile__( "xgetbv" : "=a"( eax ), "=d"( edx ) : "c"( 0 ));
+        xcr0 = ( (unsigned long long)edx << 32 ) | eax;
+    }
+#endif
+    if ( 6 != ( xcr0 & 6 ))
+    {
+        return 0;
+    }
+    AVTCpuid( 7, info );
+    return 0 != ( info[1] & ( 1 << 5 ));
+}
+
+#endif // AVT_SWIZZLE_X86
+
+#ifdef AVT_SWIZZLE_NEON
+
+//
+// NEON loads and stores 16 pixels deinterleaved, so swapping is just exchanging two registers
+//
+static void AVTSwapRGBNEON( const unsigned char* pSource, unsigned char* pDestination, unsigned long nPixels )
+{
+    uint8x16x3_t    pixels;                         // 16 pixels, one register per channel
+    uint8x16_t      channel;                        // For swapping
+    unsigned long   x;                              // The horizontal position within our row
+
+    for ( x = 0; x + 16 <= nPixels; x += 16, pSource += 48, pDestination += 48 )
+    {
+        pixels          = vld3q_u8( pSource );
+        channel         = pixels.val[0];
+        pixels.val[0]   = pixels.val[2];
+        pixels.val[2]   = channel;
+        vst3q_u8( pDestination, pixels );
+    }
+    AVTSwapRGBScalar( pSource, pDestination, nPixels - x );
+}
+
+//
+// NEON loads 32 pixels deinterleaved into the first, middle and last bytes of their pairs
+// and stores the pairs interleaved again
+//
+static void AVTUnpackMono12pNEON( const unsigned char* pSource, unsigned short* pDestination, unsigned long nPixels )
+{
+    uint8x16x3_t    bytes;                          // 16 pairs of pixels, one register per byte of a pair
+    uint16x8x2_t    pixels;                         // 8 pairs of pixels, one register per pixel of a pair
+    unsigned long   x;                              // The position within our pixels
+
+    for ( x = 0; x + 32 <= nPixels; x += 32, pSource += 48, pDestination += 32 )
+    {
+        bytes = vld3q_u8( pSource );
+        pixels.val[0] = vorrq_u16( vmovl_u8( vget_low_u8( bytes.val[0] )), vshll_n_u8( vand_u8( vget_low_u8( bytes.val[1] ), vdup_n_u8( 0x0F )), 8 ));
+        pixels.val[1] = vorrq_u16( vmovl_u8( vshr_n_u8( vget_low_u8( bytes.val[1] ), 4 )), vshll_n_u8( vget_low_u8( bytes.val[2] ), 4 ));
+        vst2q_u16( pDestination, pixels );
+        pixels.val[0] = vorrq_u16( vmovl_u8( vget_high_u8( bytes.val[0] )), vshll_n_u8( vand_u8( vget_high_u8( bytes.val[1] ), vdup_n_u8( 0x0F )), 8 ));
+        pixels.val[1] = vorrq_u16( vmovl_u8( vshr_n_u8( vget_high_u8( bytes.val[1] ), 4 )), vshll_n_u8( vget_high_u8( bytes.val[2] ), 4 ));
+        vst2q_u16( pDestination + 16, pixels );
+    }
+    AVTUnpackMono12pScalar( pSource, pDestination, nPixels - x );
+}
+
+static void AVTUnpackMono12PackedNEON( const unsigned char* pSource, unsigned short* pDestination, unsigned long nPixels )
+{
+    uint8x16x3_t    bytes;                          // 16 pairs of pixels, one register per byte of a pair
+    uint16x8x2_t    pixels;                         // 8 pairs of pixels, one register per pixel of a pair
+    unsigned long   x;                              // The position within our pixels
+
+    for ( x = 0; x + 32 <= nPixels; x += 32, pSource += 48, pDestination += 32 )
+    {
+        bytes = vld3q_u8( pSource );
+        pixels.val[0] = vorrq_u16( vshll_n_u8( vget_low_u8( bytes.val[0] ), 4 ), vmovl_u8( vand_u8( vget_low_u8( bytes.val[1] ), vdup_n_u8( 0x0F ))));
+        pixels.val[1] = vorrq_u16( vshll_n_u8( vget_low_u8( bytes.val[2] ), 4 ), vmovl_u8( vshr_n_u8( vget_low_u8( bytes.val[1] ), 4 )));
+        vst2q_u16( pDestination, pixels );
+        pixels.val[0] = vorrq_u16( vshll_n_u8( vget_high_u8( bytes.val[0] ), 4 ), vmovl_u8( vand_u8( vget_high_u8( bytes.val[1] ), vdup_n_u8( 0x0F ))));
+        pixels.val[1] = vorrq_u16( vshll_n_u8( vget_high_u8( bytes.val[2] ), 4 ), vmovl_u8( vshr_n_u8( vget_high_u8( bytes.val[1] ), 4 )));
+        vst2q_u16( pDestination + 16, pixels );
+    }
+    AVTUnpackMono12PackedScalar( pSource, pDestination, nPixels - x );
+}
+
+static void AVTWindowLevelNEON( const unsigned short* pSource, unsigned char* pDestination, unsigned long nPixels,
+                                unsigned short nLow, unsigned short nHigh )
+{
+    const AVTWindowLevelParams  params  = AVTGetWindowLevelParams( nLow, nHigh );
+    const uint16x8_t            low     = vdupq_n_u16( params.nLow );
+    const uint16x8_t            width   = vdupq_n_u16( params.nWidth );
+    const uint16x4_t            scale   = vdup_n_u16( params.nScale );
+    const int16x8_t             shift   = vdupq_n_s16( (short)params.nShift );
+    uint16x8_t                  a;                  // 8 pixels
+    unsigned long               x;                  // The position within our pixels
+
+    for ( x = 0; x + 8 <= nPixels; x += 8, pSource += 8, pDestination += 8 )
+    {
+        a = vshlq_u16( vminq_u16( vqsubq_u16( vld1q_u16( pSource ), low ), width ), shift );
+        a = vcombine_u16( vshrn_n_u32( vmull_u16( vget_low_u16( a ), scale ), 16 ), vshrn_n_u32( vmull_u16( vget_high_u16( a ), scale ), 16 ));
+        vst1_u8( pDestination, vmovn_u16( a ));
+    }
+    AVTWindowLevelScalar( pSource, pDestination, nPixels - x, nLow, nHigh );
+}
+
+#endif // AVT_SWIZZLE_NEON
+
+//
+// Gets a certain kernel, e.g. to compare it against the scalar reference
+//
+// Parameters:
+//  [in]    eKernel         The kernel
+//
+// Returns:
+//  The kernel, NULL if it was not built or the CPU does not support it
+//
+AVTSwapRGBFunc AVTGetSwapRGBKernel( SwizzleKernel eKernel )
+{
+    switch ( eKernel )
+    {
+    case SwizzleKernelScalar:
+        return AVTSwapRGBScalar;
+#ifdef AVT_SWIZZLE_X86
+    case SwizzleKernelSSSE3:
+        return AVTHasSSSE3() ? AVTSwapRGBSSSE3 : NULL;
+    case SwizzleKernelAVX2:
+        // The AVX2 kernel hands its tail to the SSSE3 kernel
+        return ( AVTHasAVX2() && AVTHasSSSE3() ) ? AVTSwapRGBAVX2 : NULL;
+#endif
+#ifdef AVT_SWIZZLE_NEON
+    case SwizzleKernelNEON:
+        return AVTSwapRGBNEON;
+#endif
+    default:
+        return NULL;
+    }
+}
+
+//
+// Gets the kernel AVTSwapRGB uses
+//
+SwizzleKernel AVTGetBestSwizzleKernel()
+{
+    // Detected once, the CPU does not change
+    static const SwizzleKernel eBest = NULL != AVTGetSwapRGBKernel( SwizzleKernelAVX2 )  ? SwizzleKernelAVX2
+                                     : NULL != AVTGetSwapRGBKernel( SwizzleKernelSSSE3 ) ? SwizzleKernelSSSE3
+                                     : NULL != AVTGetSwapRGBKernel( SwizzleKernelNEON )  ? SwizzleKernelNEON
+                                     : SwizzleKernelScalar;
+    return eBest;
+}
+
+//
+// Swaps the first and third channel of nPixels 3 byte pixels with the fastest kernel this CPU supports
+//
+// Parameters:
+//  [in]    pSource         The pixels to convert
+//  [out]   pDestination    The converted pixels, must not overlap pSource
+//  [in]    nPixels         The number of pixels
+//
+void AVTSwapRGB( const unsigned char* pSource, unsigned char* pDestination, unsigned long nPixels )
+{
+    static const AVTSwapRGBFunc pSwap = AVTGetSwapRGBKernel( AVTGetBestSwizzleKernel() );
+    pSwap( pSource, pDestination, nPixels );
+}
+
+//
+// Gets the name of a kernel
+//
+const char* AVTGetSwizzleKernelName( SwizzleKernel eKernel )
+{
+    switch ( eKernel )
+    {
+    case SwizzleKernelScalar:   return "Scalar";
+    case SwizzleKernelSSSE3:    return "SSSE3";
+    case SwizzleKernelAVX2:     return "AVX2";
+    case SwizzleKernelNEON:     return "NEON";
+    default:                    return "Unknown";
+    }
+}
+
+//
+// Gets a certain unpack kernel, e.g. to compare it against the scalar reference
+//
+// Parameters:
+//  [in]    ePacking        The layout the kernel unpacks
+//  [in]    eKernel         The kernel
+//
+// Returns:
+//  The kernel, NULL if it was not built or the CPU does not support it
+//
+AVTUnpackMonoFunc AVTGetUnpackMonoKernel( MonoPacking ePacking, SwizzleKernel eKernel )
+{
+    static const AVTUnpackMonoFunc scalarKernels[PackingCount] = { AVTUnpackMono10pScalar, AVTUnpackMono12pScalar, AVTUnpackMono12PackedScalar };
+#ifdef AVT_SWIZZLE_X86
+    static const AVTUnpackMonoFunc ssse3Kernels[PackingCount] = { AVTUnpackMono10pSSSE3, AVTUnpackMono12pSSSE3, AVTUnpackMono12PackedSSSE3 };
+    static const AVTUnpackMonoFunc avx2Kernels[PackingCount] = { AVTUnpackMono10pAVX2, AVTUnpackMono12pAVX2, AVTUnpackMono12PackedAVX2 };
+#endif
+#ifdef AVT_SWIZZLE_NEON
+    // Five byte groups do not fit the structure loads, Mono10p stays scalar
+    static const AVTUnpackMonoFunc neonKernels[PackingCount] = { AVTUnpackMono10pScalar, AVTUnpackMono12pNEON, AVTUnpackMono12PackedNEON };
+#endif
+
+    if (    ePacking < 0
+         || ePacking >= PackingCount )
+    {
+        return NULL;
+    }
+    switch ( eKernel )
+    {
+    case SwizzleKernelScalar:
+        return scalarKernels[ePacking];
+#ifdef AVT_SWIZZLE_X86
+    case SwizzleKernelSSSE3:
+        return AVTHasSSSE3() ? ssse3Kernels[ePacking] : NULL;
+    case SwizzleKernelAVX2:
+        // The AVX2 kernels hand their tail to the SSSE3 kernels
+        return ( AVTHasAVX2() && AVTHasSSSE3() ) ? avx2Kernels[ePacking] : NULL;
+#endif
+#ifdef AVT_SWIZZLE_NEON
+    case SwizzleKernelNEON:
+        return neonKernels[ePacking];
+#endif
+    default:
+        return NULL;
+    }
+}
+
+//
+// Unpacks nPixels packed mono pixels with the fastest kernel this CPU supports
+//
+// Parameters:
+//  [in]    ePacking        The layout of pSource
+//  [in]    pSource         The packed pixels, starting at a pixel that begins on a byte
+//  [out]   pDestination    The unpacked pixels
+//  [in]    nPixels         The number of pixels
+//
+void AVTUnpackMono( MonoPacking ePacking, const unsigned char* pSource, unsigned short* pDestination, unsigned long nPixels )
+{
+    static const AVTUnpackMonoFunc pUnpack[PackingCount] = {    AVTGetUnpackMonoKernel( PackingMono10p, AVTGetBestSwizzleKernel() ),
+                                                                AVTGetUnpackMonoKernel( PackingMono12p, AVTGetBestSwizzleKernel() ),
+                                                                AVTGetUnpackMonoKernel( PackingMono12Packed, AVTGetBestSwizzleKernel() ) };
+    if (    ePacking >= 0
+         && ePacking < PackingCount )
+    {
+        pUnpack[ePacking]( pSource, pDestination, nPixels );
+    }
+}
+
+//
+// Gets a certain window/level kernel, e.g. to compare it against the scalar reference
+//
+// Parameters:
+//  [in]    eKernel         The kernel
+//
+// Returns:
+//  The kernel, NULL if it was not built or the CPU does not support it
+//
+AVTWindowLevelFunc AVTGetWindowLevelKernel( SwizzleKernel eKernel )
+{
+    switch ( eKernel )
+    {
+    case SwizzleKernelScalar:
+        return AVTWindowLevelScalar;
+#ifdef AVT_SWIZZLE_X86
+    case SwizzleKernelSSSE3:
+        return AVTHasSSSE3() ? AVTWindowLevelSSSE3 : NULL;
+    case SwizzleKernelAVX2:
+        return ( AVTHasAVX2() && AVTHasSSSE3() ) ? AVTWindowLevelAVX2 : NULL;
+#endif
+#ifdef AVT_SWIZZLE_NEON
+    case SwizzleKernelNEON:
+        return AVTWindowLevelNEON;
+#endif
+    default:
+        return NULL;
+    }
+}
+
+//
+// Maps nPixels 16 bit pixels to 8 bit with the fastest kernel this CPU supports
+//
+// Parameters:
+//  [in]    pSource         The pixels to map
+//  [out]   pDestination    The mapped pixels
+//  [in]    nPixels         The number of pixels
+//  [in]    nLow            The lower end of the window
+//  [in]    nHigh           The upper end of the window, a window of zero width is a threshold
+//
+void AVTWindowLevel( const unsigned short* pSource, unsigned char* pDestination, unsigned long nPixels,
+                     unsigned short nLow, unsigned short nHigh )
+{
+    static const AVTWindowLevelFunc pWindowLevel = AVTGetWindowLevelKernel( AVTGetBestSwizzleKernel() );
+    pWindowLevel( pSource, pDestination, nPixels, nLow, nHigh );
+}
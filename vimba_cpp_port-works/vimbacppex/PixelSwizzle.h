@@ -0,0 +1,164 @@
+/*=============================================================================
+  Copyright (C) 2013 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        PixelSwizzle.h
+
+  Description: Vectorized RGB to BGR conversion, unpacking of 10 and 12 bit mono
+               pixels and window/level mapping of 16 bit to 8 bit pixels
+               (SSSE3, AVX2, NEON) with scalar references, chosen at runtime by
+               the features of the CPU.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#ifndef AVT_PIXELSWIZZLE_H
+#define AVT_PIXELSWIZZLE_H
+
+typedef enum
+{
+    SwizzleKernelScalar = 0,
+    SwizzleKernelSSSE3  = 1,
+    SwizzleKernelAVX2   = 2,
+    SwizzleKernelNEON   = 3,
+    SwizzleKernelCount  = 4
+} SwizzleKernel;
+
+//
+// Swaps the first and third channel of nPixels 3 byte pixels (RGB <-> BGR)
+//
+// Parameters:
+//  [in]    pSource         The pixels to convert
+//  [out]   pDestination    The converted pixels, must not overlap pSource
+//  [in]    nPixels         The number of pixels
+//
+typedef void (*AVTSwapRGBFunc)( const unsigned char* pSource, unsigned char* pDestination, unsigned long nPixels );
+
+//
+// Swaps the first and third channel of nPixels 3 byte pixels with the fastest kernel this CPU supports
+//
+// Parameters:
+//  [in]    pSource         The pixels to convert
+//  [out]   pDestination    The converted pixels, must not overlap pSource
+//  [in]    nPixels         The number of pixels
+//
+void AVTSwapRGB( const unsigned char* pSource, unsigned char* pDestination, unsigned long nPixels );
+
+//
+// Gets a certain kernel, e.g. to compare it against the scalar reference
+//
+// Parameters:
+//  [in]    eKernel         The kernel
+//
+// Returns:
+//  The kernel, NULL if it was not built or the CPU does not support it
+//
+AVTSwapRGBFunc AVTGetSwapRGBKernel( SwizzleKernel eKernel );
+
+//
+// Gets the kernel AVTSwapRGB uses
+//
+SwizzleKernel AVTGetBestSwizzleKernel();
+
+//
+// Gets the name of a kernel
+//
+const char* AVTGetSwizzleKernelName( SwizzleKernel eKernel );
+
+// The packed mono layouts, all of them continue across rows
+typedef enum
+{
+    PackingMono10p          = 0,    // 4 pixels in 5 bytes, least significant bits first (PFNC)
+    PackingMono12p          = 1,    // 2 pixels in 3 bytes, least significant bits first (PFNC)
+    PackingMono12Packed     = 2,    // 2 pixels in 3 bytes, the high bits of each pixel in a byte of its own (GigE Vision)
+    PackingCount            = 3
+} MonoPacking;
+
+//
+// Unpacks nPixels packed mono pixels into 16 bit pixels with the value in the low bits
+//
+// Parameters:
+//  [in]    pSource         The packed pixels, starting at a pixel that begins on a byte
+//  [out]   pDestination    The unpacked pixels
+//  [in]    nPixels         The number of pixels
+//
+typedef void (*AVTUnpackMonoFunc)( const unsigned char* pSource, unsigned short* pDestination, unsigned long nPixels );
+
+//
+// Unpacks nPixels packed mono pixels with the fastest kernel this CPU supports
+//
+// Parameters:
+//  [in]    ePacking        The layout of pSource
+//  [in]    pSource         The packed pixels, starting at a pixel that begins on a byte
+//  [out]   pDestination    The unpacked pixels
+//  [in]    nPixels         The number of pixels
+//
+void AVTUnpackMono( MonoPacking ePacking, const unsigned char* pSource, unsigned short* pDestination, unsigned long nPixels );
+
+//
+// Gets a certain unpack kernel, e.g. to compare it against the scalar reference
+//
+// Parameters:
+//  [in]    ePacking        The layout the kernel unpacks
+//  [in]    eKernel         The kernel
+//
+// Returns:
+//  The kernel, NULL if it was not built or the CPU does not support it
+//
+AVTUnpackMonoFunc AVTGetUnpackMonoKernel( MonoPacking ePacking, SwizzleKernel eKernel );
+
+//
+// Maps nPixels 16 bit pixels to 8 bit. Values up to nLow become 0, values from nHigh on
+// become 255, the values in between are scaled linearly.
+//
+// Parameters:
+//  [in]    pSource         The pixels to map
+//  [out]   pDestination    The mapped pixels
+//  [in]    nPixels         The number of pixels
+//  [in]    nLow            The lower end of the window
+//  [in]    nHigh           The upper end of the window, a window of zero width is a threshold
+//
+typedef void (*AVTWindowLevelFunc)( const unsigned short* pSource, unsigned char* pDestination, unsigned long nPixels,
+                                    unsigned short nLow, unsigned short nHigh );
+
+//
+// Maps nPixels 16 bit pixels to 8 bit with the fastest kernel this CPU supports
+//
+// Parameters:
+//  [in]    pSource         The pixels to map
+//  [out]   pDestination    The mapped pixels
+//  [in]    nPixels         The number of pixels
+//  [in]    nLow            The lower end of the window
+//  [in]    nHigh           The upper end of the window, a window of zero width is a threshold
+//
+void AVTWindowLevel( const unsigned short* pSource, unsigned char* pDestination, unsigned long nPixels,
+                     unsigned short nLow, unsigned short nHigh );
+
+//
+// Gets a certain window/level kernel, e.g. to compare it against the scalar reference
+//
+// Parameters:
+//  [in]    eKernel         The kernel
+//
+// Returns:
+//  The kernel, NULL if it was not built or the CPU does not support it
+//
+AVTWindowLevelFunc AVTGetWindowLevelKernel( SwizzleKernel eKernel );
+
+#endif
@@ -0,0 +1,573 @@
+/*=============================================================================
+  Copyright (C) 2013 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        RecordingFile.cpp
+
+  Description: A recording that appends many frames to one file, with an index at
+               the end for random access, and a reader that maps it into memory.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "RecordingFile.h"
+#include "ImageWriter.h"
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+//
+// Moves the file position, 64 bit safe
+//
+static bool SeekFile( FILE *pFile, VmbUint64_t nOffset )
+{
+#ifdef _WIN32
+    return 0 == _fseeki64( pFile, static_cast<__int64>( nOffset ), SEEK_SET );
+#else
+    return 0 == fseeko( pFile, static_cast<off_t>( nOffset ), SEEK_SET );
+#endif
+}
+
+//
+// Writes the index and the trailer at the current file position
+//
+// Parameters:
+//  [in]    pFile               The recording, positioned at the end of the frames
+//  [in]    nIndexOffset        The current file position
+//  [in]    rIndex              The offset of every frame header
+//
+// Returns:
+//  An API status code
+//
+static VmbErrorType WriteIndex( FILE *pFile, VmbUint64_t nIndexOffset, const std::vector<VmbUint64_t> &rIndex )
+{
+    RecordingTrailer trailer;
+    InitRecordingTrailer( nIndexOffset, rIndex.size(), trailer );
+    if (    rIndex.size() != fwrite( rIndex.data(), sizeof( VmbUint64_t ), rIndex.size(), pFile )
+         || 1 != fwrite( &trailer, sizeof( trailer ), 1, pFile ))
+    {
+        return VmbErrorOther;
+    }
+    return VmbErrorSuccess;
+}
+
+//
+// Writes the index of a recording whose frames were written by other means (e.g. unbuffered)
+// and cuts off whatever follows it, like padding or preallocated space
+//
+// Parameters:
+//  [in]    rFileName           The path of the recording
+//  [in]    nDataSize           The size of file header and frames
+//  [in]    rIndex              The offset of every frame header
+//
+// Returns:
+//  An API status code
+//
+VmbErrorType FinishRecordingFile( const std::string &rFileName, VmbUint64_t nDataSize, const std::vector<VmbUint64_t> &rIndex )
+{
+    FILE *pFile = fopen( rFileName.c_str(), "r+b" );
+    if ( NULL == pFile )
+    {
+        return VmbErrorNotFound;
+    }
+    VmbErrorType res = SeekFile( pFile, nDataSize ) ? WriteIndex( pFile, nDataSize, rIndex ) : VmbErrorOther;
+    if (    VmbErrorSuccess == res
+         && 0 != fflush( pFile ))
+    {
+        res = VmbErrorOther;
+    }
+    if ( VmbErrorSuccess == res )
+    {
+        const VmbUint64_t nFileSize = nDataSize + rIndex.size() * sizeof( VmbUint64_t ) + sizeof( RecordingTrailer );
+#ifdef _WIN32
+        if ( 0 != _chsize_s( _fileno( pFile ), static_cast<__int64>( nFileSize )))
+#else
+        if ( 0 != ftruncate( fileno( pFile ), static_cast<off_t>( nFileSize )))
+#endif
+        {
+            res = VmbErrorOther;
+        }
+    }
+    if ( 0 != fclose( pFile ))
+    {
+        res = VmbErrorOther;
+    }
+    return res;
+}
+
+RecordingWriter::RecordingWriter()
+    : m_pFile( NULL )
+    , m_nOffset( 0 )
+{
+}
+
+RecordingWriter::~RecordingWriter()
+{
+    Close();
+}
+
+//
+// Creates a recording file, an existing file gets overwritten
+//
+// Parameters:
+//  [in]    rFileName           The path of the recording
+//
+// Returns:
+//  An API status code
+//
+VmbErrorType RecordingWriter::Open( const std::string &rFileName )
+{
+    std::lock_guard<std::mutex> lock( m_mutex );
+    if ( NULL != m_pFile )
+    {
+        return VmbErrorInvalidCall;
+    }
+    m_pFile = fopen( rFileName.c_str(), "wb" );
+    if ( NULL == m_pFile )
+    {
+        return VmbErrorOther;
+    }
+
+    RecordingFileHeader header;
+    InitRecordingFileHeader( header );
+    if ( 1 != fwrite( &header, sizeof( header ), 1, m_pFile ))
+    {
+        fclose( m_pFile );
+        m_pFile = NULL;
+        return VmbErrorOther;
+    }
+    m_nOffset = sizeof( header );
+    m_index.clear();
+    return VmbErrorSuccess;
+}
+
+//
+// Appends a frame to the recording (any thread)
+//
+// Parameters:
+//  [in]    rFrame              The frame to append
+//
+// Returns:
+//  An API status code
+//
+VmbErrorType RecordingWriter::Append( const ImageFrame &rFrame )
+{
+    static const VmbUchar_t padding[RECORDING_ALIGNMENT] = { 0 };
+
+    if ( NULL == rFrame.pImage )
+    {
+        return VmbErrorBadParameter;
+    }
+    std::lock_guard<std::mutex> lock( m_mutex );
+    if ( NULL == m_pFile )
+    {
+        return VmbErrorInvalidCall;
+    }
+
+    RecordingFrameHeader header;
+    InitRecordingFrameHeader( rFrame, header );
+
+    const VmbUint64_t nRecordSize = GetRecordingRecordSize( rFrame.nImageSize );
+    const size_t nPaddingSize = static_cast<size_t>( nRecordSize - sizeof( header ) - rFrame.nImageSize );
+    if (    1 != fwrite( &header, sizeof( header ), 1, m_pFile )
+         || rFrame.nImageSize != fwrite( rFrame.pImage, 1, rFrame.nImageSize, m_pFile )
+         || nPaddingSize != fwrite( padding, 1, nPaddingSize, m_pFile ))
+    {
+        // Let the next frame or the index overwrite the partial frame
+        SeekFile( m_pFile, m_nOffset );
+        return VmbErrorOther;
+    }
+    m_index.push_back( m_nOffset );
+    m_nOffset += nRecordSize;
+    return VmbErrorSuccess;
+}
+
+//
+// Writes the index and closes the file
+//
+// Returns:
+//  An API status code
+//
+VmbErrorType RecordingWriter::Close()
+{
+    std::lock_guard<std::mutex> lock( m_mutex );
+    if ( NULL == m_pFile )
+    {
+        return VmbErrorSuccess;
+    }
+
+    VmbErrorType res = WriteIndex( m_pFile, m_nOffset, m_index );
+    if ( 0 != fclose( m_pFile ))
+    {
+        res = VmbErrorOther;
+    }
+    m_pFile = NULL;
+    return res;
+}
+
+//
+// Gets the number of frames appended since Open
+//
+VmbUint64_t RecordingWriter::GetFrameCount() const
+{
+    std::lock_guard<std::mutex> lock( m_mutex );
+    return m_index.size();
+}
+
+//
+// A read only mapping of a whole file. Frames of the reader share it, so it lives as long as the
+// reader or any of its frames.
+//
+struct RecordingReader::Mapping
+{
+    const VmbUchar_t*   pData;
+    VmbUint64_t         nSize;
+#ifdef _WIN32
+    HANDLE              hFile;
+    HANDLE              hMapping;
+#endif
+
+    Mapping()
+        : pData( NULL )
+        , nSize( 0 )
+#ifdef _WIN32
+        , hFile( INVALID_HANDLE_VALUE )
+        , hMapping( NULL )
+#endif
+    {
+    }
+
+    ~Mapping()
+    {
+#ifdef _WIN32
+        if ( NULL != pData )
+        {
+            UnmapViewOfFile( pData );
+        }
+        if ( NULL != hMapping )
+        {
+            CloseHandle( hMapping );
+        }
+        if ( INVALID_HANDLE_VALUE != hFile )
+        {
+            CloseHandle( hFile );
+        }
+#else
+        if ( NULL != pData )
+        {
+            munmap( const_cast<VmbUchar_t*>( pData ), static_cast<size_t>( nSize ));
+        }
+#endif
+    }
+
+    VmbErrorType Open( const std::string &rFileName )
+    {
+#ifdef _WIN32
+        hFile = CreateFileA( rFileName.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL );
+        if ( INVALID_HANDLE_VALUE == hFile )
+        {
+            return VmbErrorNotFound;
+        }
+        LARGE_INTEGER size;
+        if ( !GetFileSizeEx( hFile, &size ))
+        {
+            return VmbErrorOther;
+        }
+        nSize = static_cast<VmbUint64_t>( size.QuadPart );
+        if ( 0 == nSize )
+        {
+            return VmbErrorInvalidValue;
+        }
+        hMapping = CreateFileMappingA( hFile, NULL, PAGE_READONLY, 0, 0, NULL );
+        if ( NULL == hMapping )
+        {
+            return VmbErrorResources;
+        }
+        pData = static_cast<const VmbUchar_t*>( MapViewOfFile( hMapping, FILE_MAP_READ, 0, 0, 0 ));
+#else
+        const int file = open( rFileName.c_str(), O_RDONLY );
+        if ( 0 > file )
+        {
+            return VmbErrorNotFound;
+        }
+        struct stat status;
+        if ( 0 != fstat( file, &status ))
+        {
+            close( file );
+            return VmbErrorOther;
+        }
+        nSize = static_cast<VmbUint64_t>( status.st_size );
+        if ( 0 == nSize )
+        {
+            close( file );
+            return VmbErrorInvalidValue;
+        }
+        void *pMapped = mmap( NULL, static_cast<size_t>( nSize ), PROT_READ, MAP_SHARED, file, 0 );
+        // The mapping stays valid without the descriptor
+        close( file );
+        pData = MAP_FAILED != pMapped ? static_cast<const VmbUchar_t*>( pMapped ) : NULL;
+#endif
+        return NULL != pData ? VmbErrorSuccess : VmbErrorResources;
+    }
+};
+
+RecordingReader::RecordingReader()
+{
+}
+
+RecordingReader::~RecordingReader()
+{
+    Close();
+}
+
+//
+// Maps a recording and reads its index
+//
+// Parameters:
+//  [in]    rFileName           The path of the recording
+//
+// Returns:
+//  An API status code
+//
+VmbErrorType RecordingReader::Open( const std::string &rFileName )
+{
+    Close();
+
+    std::shared_ptr<Mapping> pMapping( new Mapping() );
+    VmbErrorType res = pMapping->Open( rFileName );
+    if ( VmbErrorSuccess != res )
+    {
+        return res;
+    }
+
+    RecordingFileHeader header;
+    if ( pMapping->nSize < sizeof( header ))
+    {
+        return VmbErrorInvalidValue;
+    }
+    memcpy( &header, pMapping->pData, sizeof( header ));
+    if (    0 != memcmp( header.szMagic, RECORDING_MAGIC, RECORDING_MAGIC_SIZE )
+         || RECORDING_VERSION != header.nVersion
+         || sizeof( RecordingFrameHeader ) != header.nFrameHeaderSize )
+    {
+        return VmbErrorInvalidValue;
+    }
+
+    m_pMapping = pMapping;
+    res = ReadIndex();
+    if ( VmbErrorSuccess != res )
+    {
+        Close();
+    }
+    return res;
+}
+
+//
+// Unmaps the recording. Frames handed out before stay valid until they are released.
+//
+void RecordingReader::Close()
+{
+    m_pMapping.reset();
+    m_index.clear();
+}
+
+//
+// Gets the number of frames in the recording
+//
+VmbUint64_t RecordingReader::GetFrameCount() const
+{
+    return m_index.size();
+}
+
+//
+// Gets a frame without copying its image. The image points into the mapping, which the
+// frame keeps alive through pOwner.
+//
+// Parameters:
+//  [in]    nIndex              The position of the frame in the recording
+//  [out]   rFrame              The frame
+//
+// Returns:
+//  An API status code
+//
+VmbErrorType RecordingReader::GetFrame( VmbUint64_t nIndex, ImageFrame &rFrame ) const
+{
+    if ( nIndex >= m_index.size() )
+    {
+        return VmbErrorBadParameter;
+    }
+    const VmbUint64_t nOffset = m_index[static_cast<size_t>( nIndex )];
+    RecordingFrameHeader header;
+    memcpy( &header, m_pMapping->pData + nOffset, sizeof( header ));
+
+    rFrame.pImage           = m_pMapping->pData + nOffset + sizeof( header );
+    rFrame.nImageSize       = header.nImageSize;
+    rFrame.nWidth           = header.nWidth;
+    rFrame.nHeight          = header.nHeight;
+    rFrame.ePixelFormat     = static_cast<VmbPixelFormatType>( header.ePixelFormat );
+    rFrame.nFrameID         = header.nFrameID;
+    rFrame.nTimestamp       = header.nTimestamp;
+    rFrame.eReceiveStatus   = static_cast<VmbFrameStatusType>( header.eReceiveStatus );
+    SP_RESET( rFrame.pFrame );
+    rFrame.pOwner           = m_pMapping;
+    return VmbErrorSuccess;
+}
+
+//
+// Reads the index at the end of the file. Falls back to walking the frames if there is none.
+//
+// Returns:
+//  An API status code
+//
+VmbErrorType RecordingReader::ReadIndex()
+{
+    const VmbUchar_t *pData = m_pMapping->pData;
+    const VmbUint64_t nSize = m_pMapping->nSize;
+
+    RecordingTrailer trailer;
+    if ( nSize < sizeof( RecordingFileHeader ) + sizeof( trailer ))
+    {
+        return ScanFrames();
+    }
+    memcpy( &trailer, pData + nSize - sizeof( trailer ), sizeof( trailer ));
+    if (    0 != memcmp( trailer.szMagic, RECORDING_INDEX_MAGIC, RECORDING_MAGIC_SIZE )
+         || trailer.nIndexOffset > nSize
+         || trailer.nIndexOffset < sizeof( RecordingFileHeader )
+         || (    0 != trailer.nFrameCount
+              && trailer.nIndexOffset < sizeof( RecordingFileHeader ) + sizeof( RecordingFrameHeader ))
+         || trailer.nFrameCount > ( nSize - trailer.nIndexOffset ) / sizeof( VmbUint64_t )
+         || trailer.nIndexOffset + trailer.nFrameCount * sizeof( VmbUint64_t ) + sizeof( trailer ) != nSize )
+    {
+        // Not closed properly, or the trailer is corrupt
+        return ScanFrames();
+    }
+
+    m_index.resize( static_cast<size_t>( trailer.nFrameCount ));
+    if ( !m_index.empty() )
+    {
+        memcpy( m_index.data(), pData + trailer.nIndexOffset, m_index.size() * sizeof( VmbUint64_t ));
+    }
+    // Do not trust the index blindly, GetFrame relies on it.
+    // The offsets are compared without adding to them, so huge ones cannot wrap around.
+    for (   std::vector<VmbUint64_t>::const_iterator iter = m_index.begin();
+            m_index.end() != iter;
+            ++iter )
+    {
+        RecordingFrameHeader header;
+        if (    *iter < sizeof( RecordingFileHeader )
+             || *iter > trailer.nIndexOffset - sizeof( header ))
+        {
+            return VmbErrorInvalidValue;
+        }
+        memcpy( &header, pData + *iter, sizeof( header ));
+        if (    RECORDING_FRAME_MAGIC != header.nMagic
+             || GetRecordingRecordSize( header.nImageSize ) > trailer.nIndexOffset - *iter )
+        {
+            return VmbErrorInvalidValue;
+        }
+    }
+    return VmbErrorSuccess;
+}
+
+//
+// Finds the frames by walking from one frame header to the next, stops at the first incomplete frame
+//
+// Returns:
+//  An API status code
+//
+VmbErrorType RecordingReader::ScanFrames()
+{
+    const VmbUchar_t *pData = m_pMapping->pData;
+    const VmbUint64_t nSize = m_pMapping->nSize;
+
+    m_index.clear();
+    VmbUint64_t nOffset = sizeof( RecordingFileHeader );
+    while ( nSize - nOffset >= sizeof( RecordingFrameHeader ))
+    {
+        RecordingFrameHeader header;
+        memcpy( &header, pData + nOffset, sizeof( header ));
+        const VmbUint64_t nRecordSize = GetRecordingRecordSize( header.nImageSize );
+        if (    RECORDING_FRAME_MAGIC != header.nMagic
+             || nRecordSize > nSize - nOffset )
+        {
+            break;
+        }
+        m_index.push_back( nOffset );
+        nOffset += nRecordSize;
+    }
+    return VmbErrorSuccess;
+}
+
+//
+// Writes frames of a recording to bitmap files named <prefix><index>.bmp
+//
+// Parameters:
+//  [in]    rReader             The opened recording
+//  [in]    nFirst              The index of the first frame to export
+//  [in]    nCount              The number of frames to export at most
+//  [in]    nStep               Exports every nStep-th frame
+//  [in]    rFilePrefix         The path and start of the file names
+//  [out]   rnExported          The number of bitmaps written
+//
+// Returns:
+//  An API status code
+//
+VmbErrorType ExportRecordingToBitmaps(  const RecordingReader &rReader, VmbUint64_t nFirst, VmbUint64_t nCount, VmbUint64_t nStep,
+                                        const std::string &rFilePrefix, VmbUint64_t &rnExported )
+{
+    rnExported = 0;
+    if ( 0 == nStep )
+    {
+        return VmbErrorBadParameter;
+    }
+    for (   VmbUint64_t i = nFirst;
+            i < rReader.GetFrameCount() && rnExported < nCount;
+            i += nStep )
+    {
+        ImageFrame frame;
+        VmbErrorType res = rReader.GetFrame( i, frame );
+        if ( VmbErrorSuccess == res )
+        {
+            char szNumber[32];
+            snprintf( szNumber, sizeof( szNumber ), "%08llu.bmp", static_cast<unsigned long long>( i ));
+            res = WriteBitmapFile( frame, ( rFilePrefix + szNumber ).c_str() );
+        }
+        if ( VmbErrorSuccess != res )
+        {
+            return res;
+        }
+        ++rnExported;
+    }
+    return VmbErrorSuccess;
+}
+
+}}} // namespace AVT::VmbAPI::Examples
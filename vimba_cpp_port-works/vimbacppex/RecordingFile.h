@@ -0,0 +1,284 @@
+/*=============================================================================
+  Copyright (C) 2013 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        RecordingFile.h
+
+  Description: A recording that appends many frames to one file, with an index at
+               the end for random access, and a reader that maps it into memory.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#ifndef AVT_VMBAPI_EXAMPLES_RECORDINGFILE
+#define AVT_VMBAPI_EXAMPLES_RECORDINGFILE
+
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "VimbaCPP/Include/VimbaCPP.h"
+
+#include "ImageFrame.h"
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+enum { RECORDING_VERSION = 1, };
+enum { RECORDING_ALIGNMENT = 16, };
+enum { RECORDING_MAGIC_SIZE = 8, };
+enum { RECORDING_FRAME_MAGIC = 0x4D415246, };                          // "FRAM"
+
+static const char RECORDING_MAGIC[RECORDING_MAGIC_SIZE]          = { 'A', 'V', 'T', 'R', 'E', 'C', '1', '\n' };
+static const char RECORDING_INDEX_MAGIC[RECORDING_MAGIC_SIZE] = { 'A', 'V', 'T', 'I', 'D', 'X', '1', '\n' };
+
+//
+// The parts of a recording file, see RecordingWriter for the layout
+//
+struct RecordingFileHeader
+{
+    char            szMagic[RECORDING_MAGIC_SIZE];
+    VmbUint32_t     nVersion;
+    VmbUint32_t     nFrameHeaderSize;
+};
+
+struct RecordingFrameHeader
+{
+    VmbUint32_t     nMagic;
+    VmbUint32_t     nImageSize;
+    VmbUint64_t     nTimestamp;
+    VmbUint64_t     nFrameID;
+    VmbUint32_t     nWidth;
+    VmbUint32_t     nHeight;
+    VmbUint32_t     ePixelFormat;
+    VmbUint32_t     eReceiveStatus;
+    VmbUint64_t     nReserved;
+};
+
+struct RecordingTrailer
+{
+    VmbUint64_t     nIndexOffset;
+    VmbUint64_t     nFrameCount;
+    char            szMagic[RECORDING_MAGIC_SIZE];
+};
+
+//
+// Gets the size of a frame in the file, header and padding included
+//
+inline VmbUint64_t GetRecordingRecordSize( VmbUint64_t nImageSize )
+{
+    const VmbUint64_t nSize = sizeof( RecordingFrameHeader ) + nImageSize;
+    return ( nSize + RECORDING_ALIGNMENT - 1 ) / RECORDING_ALIGNMENT * RECORDING_ALIGNMENT;
+}
+
+inline void InitRecordingFileHeader( RecordingFileHeader &rHeader )
+{
+    memcpy( rHeader.szMagic, RECORDING_MAGIC, RECORDING_MAGIC_SIZE );
+    rHeader.nVersion            = RECORDING_VERSION;
+    rHeader.nFrameHeaderSize    = sizeof( RecordingFrameHeader );
+}
+
+inline void InitRecordingFrameHeader( const ImageFrame &rFrame, RecordingFrameHeader &rHeader )
+{
+    rHeader.nMagic              = RECORDING_FRAME_MAGIC;
+    rHeader.nImageSize          = rFrame.nImageSize;
+    rHeader.nTimestamp          = rFrame.nTimestamp;
+    rHeader.nFrameID            = rFrame.nFrameID;
+    rHeader.nWidth              = rFrame.nWidth;
+    rHeader.nHeight             = rFrame.nHeight;
+    rHeader.ePixelFormat        = static_cast<VmbUint32_t>( rFrame.ePixelFormat );
+    rHeader.eReceiveStatus      = static_cast<VmbUint32_t>( rFrame.eReceiveStatus );
+    rHeader.nReserved           = 0;
+}
+
+inline void InitRecordingTrailer( VmbUint64_t nIndexOffset, VmbUint64_t nFrameCount, RecordingTrailer &rTrailer )
+{
+    rTrailer.nIndexOffset       = nIndexOffset;
+    rTrailer.nFrameCount        = nFrameCount;
+    memcpy( rTrailer.szMagic, RECORDING_INDEX_MAGIC, RECORDING_MAGIC_SIZE );
+}
+
+//
+// Appends frames to a recording file.
+//
+// Layout (little endian):
+//  File header     "AVTREC1\n", version, size of a frame header
+//  Frames          A frame header (timestamp, frame ID, width, height, pixel format, size, status)
+//                  followed by the image data, padded so every image starts RECORDING_ALIGNMENT aligned
+//  Index           The offset of every frame header
+//  Trailer         Offset of the index, number of frames, "AVTIDX1\n"
+//
+// A recording that was not closed (e.g. after a crash) has no index. The reader then finds
+// the frames by walking the frame headers.
+//
+class RecordingWriter
+{
+  public:
+    RecordingWriter();
+
+    //
+    // Closes the recording
+    //
+    ~RecordingWriter();
+
+    //
+    // Creates a recording file, an existing file gets overwritten
+    //
+    // Parameters:
+    //  [in]    rFileName           The path of the recording
+    //
+    // Returns:
+    //  An API status code
+    //
+    VmbErrorType    Open( const std::string &rFileName );
+
+    //
+    // Appends a frame to the recording (any thread)
+    //
+    // Parameters:
+    //  [in]    rFrame              The frame to append
+    //
+    // Returns:
+    //  An API status code
+    //
+    VmbErrorType    Append( const ImageFrame &rFrame );
+
+    //
+    // Writes the index and closes the file
+    //
+    // Returns:
+    //  An API status code
+    //
+    VmbErrorType    Close();
+
+    //
+    // Gets the number of frames appended since Open
+    //
+    VmbUint64_t     GetFrameCount() const;
+
+  private:
+    FILE*                       m_pFile;
+    VmbUint64_t                 m_nOffset;              // The size of the file so far
+    std::vector<VmbUint64_t>    m_index;                // The offset of every frame header
+    mutable std::mutex          m_mutex;
+
+    // No copies
+    RecordingWriter( const RecordingWriter& );
+    RecordingWriter& operator=( const RecordingWriter& );
+};
+
+//
+// Reads a recording through a read only memory mapping of the file
+//
+class RecordingReader
+{
+  public:
+    RecordingReader();
+
+    //
+    // Closes the recording
+    //
+    ~RecordingReader();
+
+    //
+    // Maps a recording and reads its index
+    //
+    // Parameters:
+    //  [in]    rFileName           The path of the recording
+    //
+    // Returns:
+    //  An API status code
+    //
+    VmbErrorType    Open( const std::string &rFileName );
+
+    //
+    // Unmaps the recording. Frames handed out before stay valid until they are released.
+    //
+    void            Close();
+
+    //
+    // Gets the number of frames in the recording
+    //
+    VmbUint64_t     GetFrameCount() const;
+
+    //
+    // Gets a frame without copying its image. The image points into the mapping, which the
+    // frame keeps alive through pOwner.
+    //
+    // Parameters:
+    //  [in]    nIndex              The position of the frame in the recording
+    //  [out]   rFrame              The frame
+    //
+    // Returns:
+    //  An API status code
+    //
+    VmbErrorType    GetFrame( VmbUint64_t nIndex, ImageFrame &rFrame ) const;
+
+  private:
+    struct Mapping;
+
+    VmbErrorType    ReadIndex();
+    VmbErrorType    ScanFrames();
+
+    std::shared_ptr<Mapping>    m_pMapping;
+    std::vector<VmbUint64_t>    m_index;                // The offset of every frame header
+
+    // No copies
+    RecordingReader( const RecordingReader& );
+    RecordingReader& operator=( const RecordingReader& );
+};
+
+//
+// Writes the index of a recording whose frames were written by other means (e.g. unbuffered)
+// and cuts off whatever follows it, like padding or preallocated space
+//
+// Parameters:
+//  [in]    rFileName           The path of the recording
+//  [in]    nDataSize           The size of file header and frames
+//  [in]    rIndex              The offset of every frame header
+//
+// Returns:
+//  An API status code
+//
+VmbErrorType FinishRecordingFile( const std::string &rFileName, VmbUint64_t nDataSize, const std::vector<VmbUint64_t> &rIndex );
+
+//
+// Writes frames of a recording to bitmap files named <prefix><index>.bmp
+//
+// Parameters:
+//  [in]    rReader             The opened recording
+//  [in]    nFirst              The index of the first frame to export
+//  [in]    nCount              The number of frames to export at most
+//  [in]    nStep               Exports every nStep-th frame
+//  [in]    rFilePrefix         The path and start of the file names
+//  [out]   rnExported          The number of bitmaps written
+//
+// Returns:
+//  An API status code
+//
+VmbErrorType ExportRecordingToBitmaps(  const RecordingReader &rReader, VmbUint64_t nFirst, VmbUint64_t nCount, VmbUint64_t nStep,
+                                        const std::string &rFilePrefix, VmbUint64_t &rnExported );
+
+}}} // namespace AVT::VmbAPI::Examples
+
+#endif
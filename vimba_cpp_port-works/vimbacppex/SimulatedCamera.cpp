@@ -0,0 +1,660 @@
+/*=============================================================================
+  Copyright (C) 2013 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        SimulatedCamera.cpp
+
+  Description: Cameras that work without any hardware attached. The synthetic
+               camera renders deterministic test images, the replay camera
+               streams images that were recorded to files before.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include <chrono>
+
+#include "SimulatedCamera.h"
+#include "LatencyMonitor.h"
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+enum { DEFAULT_PACKET_SIZE  = 1500, };
+enum { JUMBO_PACKET_SIZE    = 8228, };
+
+namespace {
+
+//
+// Reads a little endian value from a byte buffer
+//
+VmbUint32_t ReadLE( const VmbUchar_t *pData, VmbUint32_t nBytes )
+{
+    VmbUint32_t nValue = 0;
+    for ( VmbUint32_t i = 0; i < nBytes; ++i )
+    {
+        nValue |= static_cast<VmbUint32_t>( pData[i] ) << ( 8 * i );
+    }
+    return nValue;
+}
+
+//
+// Reads a whole file into memory
+//
+bool ReadFile( const std::string &rStrFileName, std::vector<VmbUchar_t> &rData )
+{
+    FILE *file = fopen( rStrFileName.c_str(), "rb" );
+    if ( NULL == file )
+    {
+        return false;
+    }
+    bool bResult = false;
+    if ( 0 == fseek( file, 0, SEEK_END ))
+    {
+        long nSize = ftell( file );
+        if (    0 < nSize
+             && 0 == fseek( file, 0, SEEK_SET ))
+        {
+            rData.resize( nSize );
+            bResult = ( rData.size() == fread( &rData[0], 1, rData.size(), file ));
+        }
+    }
+    fclose( file );
+    return bResult;
+}
+
+//
+// Turns an uncompressed 8 bit or 24 bit Windows bitmap into top down, unpadded Mono8 or Rgb8 image data
+//
+// Parameters:
+//  [in]    rFile               The content of the bitmap file
+//  [out]   rImage              The image data
+//  [out]   rnWidth             The width of the image
+//  [out]   rnHeight            The height of the image
+//  [out]   rePixelFormat       Mono8 or Rgb8
+//
+// Returns:
+//  false if the file is no bitmap this function understands
+//
+bool DecodeBitmap( const std::vector<VmbUchar_t> &rFile, std::vector<VmbUchar_t> &rImage,
+                   VmbUint32_t &rnWidth, VmbUint32_t &rnHeight, VmbPixelFormatType &rePixelFormat )
+{
+    if (    rFile.size() < 54
+         || 'B' != rFile[0]
+         || 'M' != rFile[1] )
+    {
+        return false;
+    }
+    const VmbUint32_t   nOffset         = ReadLE( &rFile[10], 4 );
+    const VmbInt32_t    nWidth          = static_cast<VmbInt32_t>( ReadLE( &rFile[18], 4 ));
+    const VmbInt32_t    nHeight         = static_cast<VmbInt32_t>( ReadLE( &rFile[22], 4 ));
+    const VmbUint32_t   nBitsPerPixel   = ReadLE( &rFile[28], 2 );
+    const VmbUint32_t   nCompression    = ReadLE( &rFile[30], 4 );
+    if (    0 >= nWidth
+         || 0 == nHeight
+         || 0 != nCompression
+         || ( 8 != nBitsPerPixel && 24 != nBitsPerPixel ))
+    {
+        return false;
+    }
+
+    // Negative heights mark top down images
+    const bool          bTopDown        = nHeight < 0;
+    rnWidth                             = static_cast<VmbUint32_t>( nWidth );
+    rnHeight                            = static_cast<VmbUint32_t>( bTopDown ? -nHeight : nHeight );
+    rePixelFormat                       = ( 8 == nBitsPerPixel ) ? VmbPixelFormatMono8 : VmbPixelFormatRgb8;
+    const VmbUint32_t   nRowSize        = rnWidth * nBitsPerPixel / 8;
+    const VmbUint32_t   nStride         = ( nRowSize + 3 ) & ~3u;
+    if ( rFile.size() < nOffset + static_cast<VmbUint64_t>( nStride ) * rnHeight )
+    {
+        return false;
+    }
+
+    rImage.resize( static_cast<size_t>( nRowSize ) * rnHeight );
+    for ( VmbUint32_t y = 0; y < rnHeight; ++y )
+    {
+        const VmbUint32_t nSrcRow = bTopDown ? y : rnHeight - 1 - y;
+        memcpy( &rImage[static_cast<size_t>( y ) * nRowSize], &rFile[nOffset + static_cast<size_t>( nSrcRow ) * nStride], nRowSize );
+    }
+    // A Windows bitmap is BGR
+    if ( 24 == nBitsPerPixel )
+    {
+        for ( size_t i = 0; i < rImage.size(); i += 3 )
+        {
+            const VmbUchar_t nBlue = rImage[i];
+            rImage[i] = rImage[i + 2];
+            rImage[i + 2] = nBlue;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+SimulatedCamera::SimulatedCamera( const std::string &rStrID, VmbUint32_t nWidth, VmbUint32_t nHeight, VmbPixelFormatType ePixelFormat, double dFrameRate )
+    : m_strID( rStrID )
+{
+    //                                          nValue          dValue      float   writable    locked
+    const Feature width                     = { nWidth,         0.0,        false,  true,       true    };
+    const Feature height                    = { nHeight,        0.0,        false,  true,       true    };
+    const Feature pixelFormat               = { ePixelFormat,   0.0,        false,  true,       true    };
+    const Feature payloadSize               = { 0,              0.0,        false,  false,      false   };
+    const Feature packetSize                = { DEFAULT_PACKET_SIZE, 0.0,   false,  true,       true    };
+    const Feature frameRate                 = { 0,              dFrameRate, true,   true,       true    };
+    const Feature exposureTime              = { 0,              10000.0,    true,   true,       false   };
+    const Feature gain                      = { 0,              0.0,        true,   true,       false   };
+    m_features["Width"]                     = width;
+    m_features["Height"]                    = height;
+    m_features["PixelFormat"]               = pixelFormat;
+    m_features["PayloadSize"]               = payloadSize;
+    m_features["GVSPPacketSize"]            = packetSize;
+    m_features["AcquisitionFrameRate"]      = frameRate;
+    m_features["ExposureTime"]              = exposureTime;
+    m_features["Gain"]                      = gain;
+    UpdatePayloadSize();
+}
+
+const std::string& SimulatedCamera::GetID() const
+{
+    return m_strID;
+}
+
+VmbErrorType SimulatedCamera::Close()
+{
+    if ( IsStreaming() )
+    {
+        return StopStreaming();
+    }
+    return VmbErrorSuccess;
+}
+
+VmbErrorType SimulatedCamera::SetFeatureValue( const char *pName, VmbInt64_t nValue )
+{
+    std::map<std::string, Feature>::iterator iter = m_features.find( pName );
+    if ( m_features.end() == iter )
+    {
+        return VmbErrorNotFound;
+    }
+    if ( iter->second.bIsFloat )
+    {
+        return VmbErrorWrongType;
+    }
+    if (    !iter->second.bIsWritable
+         || ( iter->second.bIsLockedWhileStreaming && IsStreaming() ))
+    {
+        return VmbErrorInvalidAccess;
+    }
+    VmbErrorType res = ValidateFeatureValue( iter->first, nValue );
+    if ( VmbErrorSuccess == res )
+    {
+        iter->second.nValue = nValue;
+        UpdatePayloadSize();
+    }
+    return res;
+}
+
+VmbErrorType SimulatedCamera::GetFeatureValue( const char *pName, VmbInt64_t &rnValue )
+{
+    std::map<std::string, Feature>::const_iterator iter = m_features.find( pName );
+    if ( m_features.end() == iter )
+    {
+        return VmbErrorNotFound;
+    }
+    if ( iter->second.bIsFloat )
+    {
+        return VmbErrorWrongType;
+    }
+    rnValue = iter->second.nValue;
+    return VmbErrorSuccess;
+}
+
+VmbErrorType SimulatedCamera::SetFeatureValue( const char *pName, double dValue )
+{
+    std::map<std::string, Feature>::iterator iter = m_features.find( pName );
+    if ( m_features.end() == iter )
+    {
+        return VmbErrorNotFound;
+    }
+    if ( !iter->second.bIsFloat )
+    {
+        return VmbErrorWrongType;
+    }
+    if (    !iter->second.bIsWritable
+         || ( iter->second.bIsLockedWhileStreaming && IsStreaming() ))
+    {
+        return VmbErrorInvalidAccess;
+    }
+    if ( dValue < 0.0 )
+    {
+        return VmbErrorInvalidValue;
+    }
+    iter->second.dValue = dValue;
+    return VmbErrorSuccess;
+}
+
+VmbErrorType SimulatedCamera::GetFeatureValue( const char *pName, double &rdValue )
+{
+    std::map<std::string, Feature>::const_iterator iter = m_features.find( pName );
+    if ( m_features.end() == iter )
+    {
+        return VmbErrorNotFound;
+    }
+    if ( !iter->second.bIsFloat )
+    {
+        return VmbErrorWrongType;
+    }
+    rdValue = iter->second.dValue;
+    return VmbErrorSuccess;
+}
+
+VmbErrorType SimulatedCamera::RunFeatureCommand( const char *pName )
+{
+    if ( 0 == strcmp( pName, "GVSPAdjustPacketSize" ))
+    {
+        // Every simulated link supports jumbo frames
+        m_features["GVSPPacketSize"].nValue = JUMBO_PACKET_SIZE;
+        return VmbErrorSuccess;
+    }
+    if (    0 == strcmp( pName, "AcquisitionStart" )
+         || 0 == strcmp( pName, "AcquisitionStop" ))
+    {
+        return VmbErrorSuccess;
+    }
+    return VmbErrorNotFound;
+}
+
+VmbErrorType SimulatedCamera::IsFeatureCommandDone( const char *pName, bool &rbIsDone )
+{
+    if (    0 == strcmp( pName, "GVSPAdjustPacketSize" )
+         || 0 == strcmp( pName, "AcquisitionStart" )
+         || 0 == strcmp( pName, "AcquisitionStop" ))
+    {
+        // Simulated commands finish immediately
+        rbIsDone = true;
+        return VmbErrorSuccess;
+    }
+    return VmbErrorNotFound;
+}
+
+//
+// The simulated features live in a map by name anyway, so the handle accessors just look them up by name
+//
+VmbErrorType SimulatedCamera::SetFeatureValue( CameraFeature eFeature, VmbInt64_t nValue )
+{
+    return SetFeatureValue( GetCameraFeatureName( eFeature ), nValue );
+}
+
+VmbErrorType SimulatedCamera::GetFeatureValue( CameraFeature eFeature, VmbInt64_t &rnValue )
+{
+    return GetFeatureValue( GetCameraFeatureName( eFeature ), rnValue );
+}
+
+VmbErrorType SimulatedCamera::SetFeatureValue( CameraFeature eFeature, double dValue )
+{
+    return SetFeatureValue( GetCameraFeatureName( eFeature ), dValue );
+}
+
+VmbErrorType SimulatedCamera::GetFeatureValue( CameraFeature eFeature, double &rdValue )
+{
+    return GetFeatureValue( GetCameraFeatureName( eFeature ), rdValue );
+}
+
+VmbErrorType SimulatedCamera::RunFeatureCommand( CameraFeature eFeature )
+{
+    return RunFeatureCommand( GetCameraFeatureName( eFeature ));
+}
+
+VmbErrorType SimulatedCamera::IsFeatureCommandDone( CameraFeature eFeature, bool &rbIsDone )
+{
+    return IsFeatureCommandDone( GetCameraFeatureName( eFeature ), rbIsDone );
+}
+
+VmbErrorType SimulatedCamera::ValidateFeatureValue( const std::string &rStrName, VmbInt64_t nValue ) const
+{
+    if (    ( "Width" == rStrName || "Height" == rStrName || "GVSPPacketSize" == rStrName )
+         && ( nValue <= 0 || nValue > 0xFFFF ))
+    {
+        return VmbErrorInvalidValue;
+    }
+    return VmbErrorSuccess;
+}
+
+void SimulatedCamera::StoreFeatureValue( const char *pName, VmbInt64_t nValue )
+{
+    m_features[pName].nValue = nValue;
+    UpdatePayloadSize();
+}
+
+VmbUint32_t SimulatedCamera::GetWidth() const
+{
+    return static_cast<VmbUint32_t>( m_features.find( "Width" )->second.nValue );
+}
+
+VmbUint32_t SimulatedCamera::GetHeight() const
+{
+    return static_cast<VmbUint32_t>( m_features.find( "Height" )->second.nValue );
+}
+
+VmbPixelFormatType SimulatedCamera::GetPixelFormat() const
+{
+    return static_cast<VmbPixelFormatType>( m_features.find( "PixelFormat" )->second.nValue );
+}
+
+double SimulatedCamera::GetFrameRate() const
+{
+    return m_features.find( "AcquisitionFrameRate" )->second.dValue;
+}
+
+void SimulatedCamera::UpdatePayloadSize()
+{
+    m_features["PayloadSize"].nValue = GetImageSize( GetWidth(), GetHeight(), GetPixelFormat() );
+}
+
+SyntheticCamera::SyntheticCamera( const SyntheticCameraConfig &rConfig )
+    : SimulatedCamera( rConfig.strID, rConfig.nWidth, rConfig.nHeight, rConfig.ePixelFormat, rConfig.dFrameRate )
+    , m_config( rConfig )
+    , m_nNextFrameID( 0 )
+{
+}
+
+SyntheticCamera::~SyntheticCamera()
+{
+    Close();
+}
+
+//
+// Renders the next image of the deterministic sequence
+//
+VmbErrorType SyntheticCamera::AcquireSingleImage( ImageFrame &rFrame, VmbUint32_t /*nTimeout*/ )
+{
+    if ( IsStreaming() )
+    {
+        return VmbErrorInvalidCall;
+    }
+    SyntheticFrameSource source( GetWidth(), GetHeight(), GetPixelFormat(), 0.0 );
+    // The buffer goes back to the pool once the caller drops the frame
+    BufferPtr pBuffer = BufferPool::GetDefault().Acquire( GetWidth(), GetHeight(), GetPixelFormat() );
+    if ( !pBuffer )
+    {
+        return VmbErrorResources;
+    }
+    source.Render( pBuffer.get(), m_nNextFrameID );
+
+    rFrame.pImage           = pBuffer.get();
+    rFrame.nImageSize       = GetImageSize( GetWidth(), GetHeight(), GetPixelFormat() );
+    rFrame.nWidth           = GetWidth();
+    rFrame.nHeight          = GetHeight();
+    rFrame.ePixelFormat     = GetPixelFormat();
+    rFrame.nFrameID         = m_nNextFrameID++;
+    rFrame.nTimestamp       = std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now().time_since_epoch() ).count();
+    rFrame.eReceiveStatus   = VmbFrameStatusComplete;
+    rFrame.pOwner           = pBuffer;
+    SP_RESET( rFrame.pFrame );
+
+    return VmbErrorSuccess;
+}
+
+//
+// Renders images into a ring of nFrameCount buffers on a separate thread
+//
+VmbErrorType SyntheticCamera::StartStreaming( const FrameCallback &rCallback, VmbUint32_t nFrameCount )
+{
+    if ( IsStreaming() )
+    {
+        return VmbErrorInvalidCall;
+    }
+    m_pSource.reset( new SyntheticFrameSource( GetWidth(), GetHeight(), GetPixelFormat(), GetFrameRate(), m_config.nJitterUS, m_config.nSeed ));
+    VmbErrorType res = m_pSource->Start( rCallback, nFrameCount );
+    if ( VmbErrorSuccess != res )
+    {
+        m_pSource.reset();
+    }
+    return res;
+}
+
+VmbErrorType SyntheticCamera::StopStreaming()
+{
+    if ( !IsStreaming() )
+    {
+        return VmbErrorInvalidCall;
+    }
+    m_pSource->Stop();
+    m_nNextFrameID += m_pSource->GetFrameCount();
+    m_pSource.reset();
+    return VmbErrorSuccess;
+}
+
+VmbErrorType SyntheticCamera::ValidateFeatureValue( const std::string &rStrName, VmbInt64_t nValue ) const
+{
+    if ( "PixelFormat" == rStrName )
+    {
+        // The renderer only produces whole byte formats
+        switch ( nValue )
+        {
+        case VmbPixelFormatMono8:
+        case VmbPixelFormatMono10:
+        case VmbPixelFormatMono12:
+        case VmbPixelFormatMono14:
+        case VmbPixelFormatMono16:
+        case VmbPixelFormatBayerRG8:
+        case VmbPixelFormatBayerGR8:
+        case VmbPixelFormatBayerBG8:
+        case VmbPixelFormatBayerGB8:
+        case VmbPixelFormatRgb8:
+        case VmbPixelFormatBgr8:
+            return VmbErrorSuccess;
+        default:
+            return VmbErrorInvalidValue;
+        }
+    }
+    return SimulatedCamera::ValidateFeatureValue( rStrName, nValue );
+}
+
+bool SyntheticCamera::IsStreaming() const
+{
+    return NULL != m_pSource.get();
+}
+
+ReplayCamera::ReplayCamera( const ReplayCameraConfig &rConfig )
+    : SimulatedCamera( rConfig.strID, rConfig.nWidth, rConfig.nHeight, rConfig.ePixelFormat, rConfig.dFrameRate )
+    , m_config( rConfig )
+    , m_nNextFrameID( 0 )
+    , m_bRunning( false )
+{
+}
+
+ReplayCamera::~ReplayCamera()
+{
+    Close();
+}
+
+//
+// Reads all image files into memory so replay speed does not depend on the disk
+//
+// Returns:
+//  An API status code
+//
+VmbErrorType ReplayCamera::Load()
+{
+    if ( m_config.files.empty() )
+    {
+        return VmbErrorNotFound;
+    }
+
+    m_images.clear();
+    std::vector<VmbUchar_t> file;
+    for (   std::vector<std::string>::const_iterator iter = m_config.files.begin();
+            m_config.files.end() != iter;
+            ++iter )
+    {
+        if ( !ReadFile( *iter, file ))
+        {
+            return VmbErrorNotFound;
+        }
+
+        ImageBufferPtr pImage( new std::vector<VmbUchar_t>() );
+        VmbUint32_t nWidth = m_config.nWidth;
+        VmbUint32_t nHeight = m_config.nHeight;
+        VmbPixelFormatType ePixelFormat = m_config.ePixelFormat;
+        if ( !DecodeBitmap( file, *pImage, nWidth, nHeight, ePixelFormat ))
+        {
+            // Raw images need to match the configured geometry exactly
+            if (    0 == m_config.nWidth
+                 || 0 == m_config.nHeight
+                 || file.size() != GetImageSize( nWidth, nHeight, ePixelFormat ))
+            {
+                return VmbErrorInvalidValue;
+            }
+            pImage->swap( file );
+        }
+
+        // All files of a replay share one geometry
+        if ( m_images.empty() )
+        {
+            StoreFeatureValue( "Width", nWidth );
+            StoreFeatureValue( "Height", nHeight );
+            StoreFeatureValue( "PixelFormat", ePixelFormat );
+        }
+        else if (    nWidth != GetWidth()
+                  || nHeight != GetHeight()
+                  || ePixelFormat != GetPixelFormat() )
+        {
+            return VmbErrorInvalidValue;
+        }
+        m_images.push_back( pImage );
+    }
+
+    return VmbErrorSuccess;
+}
+
+//
+// Delivers the next image file
+//
+VmbErrorType ReplayCamera::AcquireSingleImage( ImageFrame &rFrame, VmbUint32_t /*nTimeout*/ )
+{
+    if ( IsStreaming() )
+    {
+        return VmbErrorInvalidCall;
+    }
+    if (    m_images.empty()
+         || ( !m_config.bLoop && m_nNextFrameID >= m_images.size() ))
+    {
+        return VmbErrorNotFound;
+    }
+    GetImage( m_nNextFrameID++, rFrame );
+    rFrame.pOwner = m_images[rFrame.nFrameID % m_images.size()];
+    return VmbErrorSuccess;
+}
+
+//
+// Delivers the image files on a separate thread.
+// The images are handed out straight from memory, so nFrameCount is not used.
+//
+VmbErrorType ReplayCamera::StartStreaming( const FrameCallback &rCallback, VmbUint32_t /*nFrameCount*/ )
+{
+    if ( m_thread.joinable() )
+    {
+        return VmbErrorInvalidCall;
+    }
+    if ( m_images.empty() )
+    {
+        return VmbErrorNotFound;
+    }
+    m_nNextFrameID = 0;
+    m_bRunning = true;
+    m_thread = std::thread( &ReplayCamera::Run, this, rCallback );
+    return VmbErrorSuccess;
+}
+
+VmbErrorType ReplayCamera::StopStreaming()
+{
+    if ( !m_thread.joinable() )
+    {
+        return VmbErrorInvalidCall;
+    }
+    m_bRunning = false;
+    m_thread.join();
+    return VmbErrorSuccess;
+}
+
+VmbErrorType ReplayCamera::ValidateFeatureValue( const std::string &rStrName, VmbInt64_t nValue ) const
+{
+    // The geometry is given by the files
+    if (    ( "Width" == rStrName && nValue != GetWidth() )
+         || ( "Height" == rStrName && nValue != GetHeight() )
+         || ( "PixelFormat" == rStrName && nValue != GetPixelFormat() ))
+    {
+        return VmbErrorInvalidValue;
+    }
+    return SimulatedCamera::ValidateFeatureValue( rStrName, nValue );
+}
+
+bool ReplayCamera::IsStreaming() const
+{
+    return m_thread.joinable();
+}
+
+void ReplayCamera::Run( FrameCallback callback )
+{
+    typedef std::chrono::steady_clock Clock;
+
+    const double dFrameRate = GetFrameRate();
+    const Clock::duration tPeriod = ( dFrameRate > 0.0 )
+        ? std::chrono::duration_cast<Clock::duration>( std::chrono::duration<double>( 1.0 / dFrameRate ))
+        : Clock::duration::zero();
+    Clock::time_point tNext = Clock::now();
+
+    for (   ;
+            m_bRunning && ( m_config.bLoop || m_nNextFrameID < m_images.size() );
+            ++m_nNextFrameID )
+    {
+        if ( Clock::duration::zero() != tPeriod )
+        {
+            tNext += tPeriod;
+            std::this_thread::sleep_until( tNext );
+        }
+
+        ImageFrame image;
+        GetImage( m_nNextFrameID, image );
+        image.nReceiveTime = GetLatencyClock();
+        if ( callback )
+        {
+            callback( image );
+        }
+    }
+    m_bRunning = false;
+}
+
+void ReplayCamera::GetImage( VmbUint64_t nFrameID, ImageFrame &rFrame ) const
+{
+    const std::vector<VmbUchar_t> &rImage = *m_images[nFrameID % m_images.size()];
+    rFrame.pImage           = &rImage[0];
+    rFrame.nImageSize       = static_cast<VmbUint32_t>( rImage.size() );
+    rFrame.nWidth           = GetWidth();
+    rFrame.nHeight          = GetHeight();
+    rFrame.ePixelFormat     = GetPixelFormat();
+    rFrame.nFrameID         = nFrameID;
+    rFrame.nTimestamp       = std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now().time_since_epoch() ).count();
+    rFrame.eReceiveStatus   = VmbFrameStatusComplete;
+}
+
+}}} // namespace AVT::VmbAPI::Examples
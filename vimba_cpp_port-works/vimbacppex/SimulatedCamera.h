@@ -0,0 +1,238 @@
+/*=============================================================================
+  Copyright (C) 2013 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        SimulatedCamera.h
+
+  Description: Cameras that work without any hardware attached. The synthetic
+               camera renders deterministic test images, the replay camera
+               streams images that were recorded to files before.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#ifndef AVT_VMBAPI_EXAMPLES_SIMULATEDCAMERA
+#define AVT_VMBAPI_EXAMPLES_SIMULATEDCAMERA
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "VimbaCPP/Include/VimbaCPP.h"
+
+#include "CameraBackend.h"
+#include "SyntheticFrameSource.h"
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+//
+// The settings of a synthetic camera
+//
+struct SyntheticCameraConfig
+{
+    std::string         strID;              // The ID the camera is listed and opened with
+    VmbUint32_t         nWidth;             // The initial width of the images
+    VmbUint32_t         nHeight;            // The initial height of the images
+    VmbPixelFormatType  ePixelFormat;       // The initial pixel format of the images
+    double              dFrameRate;         // The initial frame rate, 0 streams as fast as possible
+    VmbUint32_t         nJitterUS;          // The maximum deviation of a frame from its nominal time in microseconds
+    VmbUint32_t         nSeed;              // The seed of the jitter sequence
+
+    SyntheticCameraConfig()
+        : strID( "Synthetic0" )
+        , nWidth( 640 )
+        , nHeight( 480 )
+        , ePixelFormat( VmbPixelFormatMono8 )
+        , dFrameRate( 30.0 )
+        , nJitterUS( 0 )
+        , nSeed( 0 )
+    {
+    }
+};
+
+//
+// The settings of a replay camera
+//
+struct ReplayCameraConfig
+{
+    std::string                 strID;      // The ID the camera is listed and opened with
+    std::vector<std::string>    files;      // The image files to replay (8 or 24 bit Windows bitmaps or raw images)
+    double                      dFrameRate; // The frame rate to replay with, 0 streams as fast as possible
+    bool                        bLoop;      // Starts over after the last file instead of stopping
+    VmbUint32_t                 nWidth;     // The width of raw image files
+    VmbUint32_t                 nHeight;    // The height of raw image files
+    VmbPixelFormatType          ePixelFormat; // The pixel format of raw image files
+
+    ReplayCameraConfig()
+        : strID( "Replay0" )
+        , dFrameRate( 30.0 )
+        , bLoop( true )
+        , nWidth( 0 )
+        , nHeight( 0 )
+        , ePixelFormat( VmbPixelFormatMono8 )
+    {
+    }
+};
+
+//
+// The feature handling shared by all simulated cameras.
+// Knows the integer features Width, Height, PixelFormat, PayloadSize and GVSPPacketSize,
+// the float features AcquisitionFrameRate, ExposureTime and Gain
+// and the commands GVSPAdjustPacketSize, AcquisitionStart and AcquisitionStop.
+//
+class SimulatedCamera : public ICamera
+{
+  public:
+    //
+    // Parameters:
+    //  [in]    rStrID              The ID the camera was opened with
+    //  [in]    nWidth              The initial width of the images
+    //  [in]    nHeight             The initial height of the images
+    //  [in]    ePixelFormat        The initial pixel format of the images
+    //  [in]    dFrameRate          The initial frame rate
+    //
+    SimulatedCamera( const std::string &rStrID, VmbUint32_t nWidth, VmbUint32_t nHeight, VmbPixelFormatType ePixelFormat, double dFrameRate );
+
+    virtual const std::string&  GetID() const;
+    virtual VmbErrorType    Close();
+
+    virtual VmbErrorType    SetFeatureValue( const char *pName, VmbInt64_t nValue );
+    virtual VmbErrorType    GetFeatureValue( const char *pName, VmbInt64_t &rnValue );
+    virtual VmbErrorType    SetFeatureValue( const char *pName, double dValue );
+    virtual VmbErrorType    GetFeatureValue( const char *pName, double &rdValue );
+    virtual VmbErrorType    RunFeatureCommand( const char *pName );
+    virtual VmbErrorType    IsFeatureCommandDone( const char *pName, bool &rbIsDone );
+    virtual VmbErrorType    SetFeatureValue( CameraFeature eFeature, VmbInt64_t nValue );
+    virtual VmbErrorType    GetFeatureValue( CameraFeature eFeature, VmbInt64_t &rnValue );
+    virtual VmbErrorType    SetFeatureValue( CameraFeature eFeature, double dValue );
+    virtual VmbErrorType    GetFeatureValue( CameraFeature eFeature, double &rdValue );
+    virtual VmbErrorType    RunFeatureCommand( CameraFeature eFeature );
+    virtual VmbErrorType    IsFeatureCommandDone( CameraFeature eFeature, bool &rbIsDone );
+
+  protected:
+    struct Feature
+    {
+        VmbInt64_t      nValue;
+        double          dValue;
+        bool            bIsFloat;
+        bool            bIsWritable;
+        bool            bIsLockedWhileStreaming;
+    };
+
+    //
+    // Checks whether a new value is acceptable for an integer feature
+    //
+    virtual VmbErrorType    ValidateFeatureValue( const std::string &rStrName, VmbInt64_t nValue ) const;
+
+    //
+    // Tells whether a continuous acquisition is running
+    //
+    virtual bool            IsStreaming() const = 0;
+
+    void            StoreFeatureValue( const char *pName, VmbInt64_t nValue );
+    VmbUint32_t     GetWidth() const;
+    VmbUint32_t     GetHeight() const;
+    VmbPixelFormatType GetPixelFormat() const;
+    double          GetFrameRate() const;
+
+  private:
+    void            UpdatePayloadSize();
+
+    const std::string                   m_strID;
+    std::map<std::string, Feature>      m_features;
+};
+
+class SyntheticCamera : public SimulatedCamera
+{
+  public:
+    explicit SyntheticCamera( const SyntheticCameraConfig &rConfig );
+    ~SyntheticCamera();
+
+    //
+    // Renders the next image of the deterministic sequence
+    //
+    virtual VmbErrorType    AcquireSingleImage( ImageFrame &rFrame, VmbUint32_t nTimeout );
+
+    //
+    // Renders images into a ring of nFrameCount buffers on a separate thread
+    //
+    virtual VmbErrorType    StartStreaming( const FrameCallback &rCallback, VmbUint32_t nFrameCount );
+    virtual VmbErrorType    StopStreaming();
+
+  protected:
+    virtual VmbErrorType    ValidateFeatureValue( const std::string &rStrName, VmbInt64_t nValue ) const;
+    virtual bool            IsStreaming() const;
+
+  private:
+    const SyntheticCameraConfig             m_config;
+    VmbUint64_t                             m_nNextFrameID;
+    std::unique_ptr<SyntheticFrameSource>   m_pSource;
+};
+
+class ReplayCamera : public SimulatedCamera
+{
+  public:
+    explicit ReplayCamera( const ReplayCameraConfig &rConfig );
+    ~ReplayCamera();
+
+    //
+    // Reads all image files into memory so replay speed does not depend on the disk
+    //
+    // Returns:
+    //  An API status code
+    //
+    VmbErrorType            Load();
+
+    //
+    // Delivers the next image file
+    //
+    virtual VmbErrorType    AcquireSingleImage( ImageFrame &rFrame, VmbUint32_t nTimeout );
+
+    //
+    // Delivers the image files on a separate thread.
+    // The images are handed out straight from memory, so nFrameCount is not used.
+    //
+    virtual VmbErrorType    StartStreaming( const FrameCallback &rCallback, VmbUint32_t nFrameCount );
+    virtual VmbErrorType    StopStreaming();
+
+  protected:
+    virtual VmbErrorType    ValidateFeatureValue( const std::string &rStrName, VmbInt64_t nValue ) const;
+    virtual bool            IsStreaming() const;
+
+  private:
+    typedef std::shared_ptr< std::vector<VmbUchar_t> > ImageBufferPtr;
+
+    void                    Run( FrameCallback callback );
+    void                    GetImage( VmbUint64_t nFrameID, ImageFrame &rFrame ) const;
+
+    const ReplayCameraConfig        m_config;
+    std::vector<ImageBufferPtr>     m_images;
+    VmbUint64_t                     m_nNextFrameID;
+    std::thread                     m_thread;
+    std::atomic<bool>               m_bRunning;
+};
+
+}}} // namespace AVT::VmbAPI::Examples
+
+#endif
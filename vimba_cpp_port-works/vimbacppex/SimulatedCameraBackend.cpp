@@ -0,0 +1,234 @@
+/*=============================================================================
+  Copyright (C) 2013 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        SimulatedCameraBackend.cpp
+
+  Description: A camera backend that lists synthetic and replay cameras so
+               the acquisition and conversion paths can be run and measured
+               without hardware or the Vimba transport layers.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#include "SimulatedCameraBackend.h"
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+namespace {
+
+CameraInfo GetCameraInfo( const SyntheticCameraConfig &rConfig )
+{
+    CameraInfo info;
+    info.strID              = rConfig.strID;
+    info.strName            = "Synthetic camera";
+    info.strModel           = "Synthetic";
+    info.strSerialNumber    = rConfig.strID;
+    return info;
+}
+
+CameraInfo GetCameraInfo( const ReplayCameraConfig &rConfig )
+{
+    CameraInfo info;
+    info.strID              = rConfig.strID;
+    info.strName            = "Replay camera";
+    info.strModel           = "Replay";
+    info.strSerialNumber    = rConfig.strID;
+    return info;
+}
+
+} // namespace
+
+SimulatedCameraBackend::SimulatedCameraBackend()
+    : m_bIsStarted( false )
+{
+}
+
+void SimulatedCameraBackend::AddSyntheticCamera( const SyntheticCameraConfig &rConfig )
+{
+    {
+        std::lock_guard<std::mutex> lock( m_camerasMutex );
+        m_syntheticCameras.push_back( rConfig );
+    }
+    NotifyCameraListChanged( GetCameraInfo( rConfig ), CameraPluggedIn );
+}
+
+void SimulatedCameraBackend::AddReplayCamera( const ReplayCameraConfig &rConfig )
+{
+    {
+        std::lock_guard<std::mutex> lock( m_camerasMutex );
+        m_replayCameras.push_back( rConfig );
+    }
+    NotifyCameraListChanged( GetCameraInfo( rConfig ), CameraPluggedIn );
+}
+
+//
+// Removes a camera as if it was unplugged. Sessions open on it keep working.
+//
+// Parameters:
+//  [in]    rStrCameraID        The ID of the camera
+//
+// Returns:
+//  VmbErrorNotFound if there is no such camera
+//
+VmbErrorType SimulatedCameraBackend::RemoveCamera( const std::string &rStrCameraID )
+{
+    CameraInfo info;
+    {
+        std::lock_guard<std::mutex> lock( m_camerasMutex );
+        std::vector<SyntheticCameraConfig>::iterator iterSynthetic = m_syntheticCameras.begin();
+        while (    m_syntheticCameras.end() != iterSynthetic
+                && rStrCameraID != iterSynthetic->strID )
+        {
+            ++iterSynthetic;
+        }
+        std::vector<ReplayCameraConfig>::iterator iterReplay = m_replayCameras.begin();
+        while (    m_replayCameras.end() != iterReplay
+                && rStrCameraID != iterReplay->strID )
+        {
+            ++iterReplay;
+        }
+
+        if ( m_syntheticCameras.end() != iterSynthetic )
+        {
+            info = GetCameraInfo( *iterSynthetic );
+            m_syntheticCameras.erase( iterSynthetic );
+        }
+        else if ( m_replayCameras.end() != iterReplay )
+        {
+            info = GetCameraInfo( *iterReplay );
+            m_replayCameras.erase( iterReplay );
+        }
+        else
+        {
+            return VmbErrorNotFound;
+        }
+    }
+    NotifyCameraListChanged( info, CameraPluggedOut );
+    return VmbErrorSuccess;
+}
+
+VmbErrorType SimulatedCameraBackend::Startup( StartupPhaseVector &/*rPhases*/ )
+{
+    // Nothing to load, so there are no phases to report
+    std::lock_guard<std::mutex> lock( m_camerasMutex );
+    m_bIsStarted = true;
+    return VmbErrorSuccess;
+}
+
+void SimulatedCameraBackend::Shutdown()
+{
+    std::lock_guard<std::mutex> lock( m_camerasMutex );
+    m_bIsStarted = false;
+}
+
+VmbErrorType SimulatedCameraBackend::GetCameras( CameraInfoVector &rCameras )
+{
+    std::lock_guard<std::mutex> lock( m_camerasMutex );
+    if ( !m_bIsStarted )
+    {
+        return VmbErrorApiNotStarted;
+    }
+
+    rCameras.clear();
+    for (   std::vector<SyntheticCameraConfig>::const_iterator iter = m_syntheticCameras.begin();
+            m_syntheticCameras.end() != iter;
+            ++iter )
+    {
+        rCameras.push_back( GetCameraInfo( *iter ));
+    }
+    for (   std::vector<ReplayCameraConfig>::const_iterator iter = m_replayCameras.begin();
+            m_replayCameras.end() != iter;
+            ++iter )
+    {
+        rCameras.push_back( GetCameraInfo( *iter ));
+    }
+    return VmbErrorSuccess;
+}
+
+VmbErrorType SimulatedCameraBackend::SetCameraListCallback( const CameraListCallback &rCallback )
+{
+    std::lock_guard<std::mutex> lock( m_camerasMutex );
+    m_cameraListCallback = rCallback;
+    return VmbErrorSuccess;
+}
+
+VmbErrorType SimulatedCameraBackend::OpenCamera( const std::string &rStrCameraID, ICameraPtr &rpCamera )
+{
+    std::unique_lock<std::mutex> lock( m_camerasMutex );
+    if ( !m_bIsStarted )
+    {
+        return VmbErrorApiNotStarted;
+    }
+
+    for (   std::vector<SyntheticCameraConfig>::const_iterator iter = m_syntheticCameras.begin();
+            m_syntheticCameras.end() != iter;
+            ++iter )
+    {
+        if ( rStrCameraID == iter->strID )
+        {
+            rpCamera.reset( new SyntheticCamera( *iter ));
+            return VmbErrorSuccess;
+        }
+    }
+    for (   std::vector<ReplayCameraConfig>::const_iterator iter = m_replayCameras.begin();
+            m_replayCameras.end() != iter;
+            ++iter )
+    {
+        if ( rStrCameraID == iter->strID )
+        {
+            // Loading the recording may take a while, others do not have to wait for it
+            std::shared_ptr<ReplayCamera> pCamera( new ReplayCamera( *iter ));
+            lock.unlock();
+            VmbErrorType res = pCamera->Load();
+            if ( VmbErrorSuccess == res )
+            {
+                rpCamera = pCamera;
+            }
+            return res;
+        }
+    }
+    return VmbErrorNotFound;
+}
+
+void SimulatedCameraBackend::NotifyCameraListChanged( const CameraInfo &rInfo, CameraListChange eChange )
+{
+    CameraListCallback callback;
+    {
+        std::lock_guard<std::mutex> lock( m_camerasMutex );
+        if ( m_bIsStarted )
+        {
+            callback = m_cameraListCallback;
+        }
+    }
+    // Called without the lock so the callback may list the cameras
+    if ( callback )
+    {
+        callback( rInfo, eChange );
+    }
+}
+
+std::string SimulatedCameraBackend::GetVersion() const
+{
+    return "Simulated camera backend";
+}
+
+}}} // namespace AVT::VmbAPI::Examples
@@ -0,0 +1,94 @@
+/*=============================================================================
+  Copyright (C) 2013 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        SimulatedCameraBackend.h
+
+  Description: A camera backend that lists synthetic and replay cameras so
+               the acquisition and conversion paths can be run and measured
+               without hardware or the Vimba transport layers.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#ifndef AVT_VMBAPI_EXAMPLES_SIMULATEDCAMERABACKEND
+#define AVT_VMBAPI_EXAMPLES_SIMULATEDCAMERABACKEND
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "VimbaCPP/Include/VimbaCPP.h"
+
+#include "CameraBackend.h"
+#include "SimulatedCamera.h"
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+class SimulatedCameraBackend : public ICameraBackend
+{
+  public:
+    SimulatedCameraBackend();
+
+    //
+    // Adds a camera to the list of cameras this backend knows
+    //
+    // Parameters:
+    //  [in]    rConfig             The settings of the camera
+    //
+    void                    AddSyntheticCamera( const SyntheticCameraConfig &rConfig );
+    void                    AddReplayCamera( const ReplayCameraConfig &rConfig );
+
+    //
+    // Removes a camera as if it was unplugged. Sessions open on it keep working.
+    //
+    // Parameters:
+    //  [in]    rStrCameraID        The ID of the camera
+    //
+    // Returns:
+    //  VmbErrorNotFound if there is no such camera
+    //
+    VmbErrorType            RemoveCamera( const std::string &rStrCameraID );
+
+    virtual VmbErrorType    Startup( StartupPhaseVector &rPhases );
+    virtual void            Shutdown();
+    virtual VmbErrorType    GetCameras( CameraInfoVector &rCameras );
+    virtual VmbErrorType    SetCameraListCallback( const CameraListCallback &rCallback );
+    virtual VmbErrorType    OpenCamera( const std::string &rStrCameraID, ICameraPtr &rpCamera );
+    virtual std::string     GetVersion() const;
+
+  private:
+    //
+    // Reports a change of the camera list if the backend runs and somebody listens
+    //
+    void                    NotifyCameraListChanged( const CameraInfo &rInfo, CameraListChange eChange );
+
+    bool                                m_bIsStarted;
+    // Cameras can be added and removed while others list and open them
+    std::vector<SyntheticCameraConfig>  m_syntheticCameras;
+    std::vector<ReplayCameraConfig>     m_replayCameras;
+    CameraListCallback                  m_cameraListCallback;
+    mutable std::mutex                  m_camerasMutex;
+};
+
+}}} // namespace AVT::VmbAPI::Examples
+
+#endif
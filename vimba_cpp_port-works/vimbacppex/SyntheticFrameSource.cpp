@@ -0,0 +1,228 @@
+/*=============================================================================
+  Copyright (C) 2013 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        SyntheticFrameSource.cpp
+
+  Description: A frame source that renders deterministic test images on its
+               own thread so the continuous acquisition path can be exercised
+               without a camera attached.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#include <chrono>
+#include <random>
+
+#include "SyntheticFrameSource.h"
+#include "BayerImage.h"
+#include "LatencyMonitor.h"
+#include "MonoImage.h"
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+SyntheticFrameSource::SyntheticFrameSource( VmbUint32_t nWidth, VmbUint32_t nHeight, VmbPixelFormatType ePixelFormat, double dFrameRate,
+                                            VmbUint32_t nJitterUS, VmbUint32_t nSeed )
+    : m_nWidth( nWidth )
+    , m_nHeight( nHeight )
+    , m_ePixelFormat( ePixelFormat )
+    , m_dFrameRate( dFrameRate )
+    , m_nJitterUS( nJitterUS )
+    , m_nSeed( nSeed )
+    , m_bRunning( false )
+    , m_nFrameCount( 0 )
+{
+}
+
+SyntheticFrameSource::~SyntheticFrameSource()
+{
+    Stop();
+}
+
+//
+// Allocates a ring of frame buffers and starts rendering into it
+//
+// Parameters:
+//  [in]    rCallback           The function that gets every completed frame
+//  [in]    nFrameCount         The number of buffers in the ring
+//
+// Returns:
+//  An API status code
+//
+VmbErrorType SyntheticFrameSource::Start( const FrameCallback &rCallback, VmbUint32_t nFrameCount )
+{
+    if ( m_bRunning )
+    {
+        return VmbErrorInvalidCall;
+    }
+    // Only whole byte formats can be rendered
+    if (    0 == m_nWidth
+         || 0 == m_nHeight
+         || 0 == nFrameCount
+         || 0 == GetBitsPerPixel( m_ePixelFormat )
+         || 0 != GetBitsPerPixel( m_ePixelFormat ) % 8 )
+    {
+        return VmbErrorBadParameter;
+    }
+
+    // All memory is taken up front, rendering itself never allocates.
+    // The pool gives back the ring of the last start, so restarting does not allocate either.
+    m_buffers.clear();
+    for ( VmbUint32_t i = 0; i < nFrameCount; ++i )
+    {
+        BufferPtr pBuffer = BufferPool::GetDefault().Acquire( m_nWidth, m_nHeight, m_ePixelFormat );
+        if ( !pBuffer )
+        {
+            m_buffers.clear();
+            return VmbErrorResources;
+        }
+        m_buffers.push_back( pBuffer );
+    }
+    m_nFrameCount = 0;
+    m_bRunning = true;
+    m_thread = std::thread( &SyntheticFrameSource::Run, this, rCallback );
+
+    return VmbErrorSuccess;
+}
+
+//
+// Stops rendering and waits for the last callback to return
+//
+void SyntheticFrameSource::Stop()
+{
+    m_bRunning = false;
+    if ( m_thread.joinable() )
+    {
+        m_thread.join();
+    }
+}
+
+//
+// Gets the number of frames delivered since the last start
+//
+VmbUint64_t SyntheticFrameSource::GetFrameCount() const
+{
+    return m_nFrameCount;
+}
+
+void SyntheticFrameSource::Run( FrameCallback callback )
+{
+    typedef std::chrono::steady_clock Clock;
+
+    const Clock::time_point tStart = Clock::now();
+    Clock::time_point tNext = tStart;
+    const Clock::duration tPeriod = ( m_dFrameRate > 0.0 )
+        ? std::chrono::duration_cast<Clock::duration>( std::chrono::duration<double>( 1.0 / m_dFrameRate ))
+        : Clock::duration::zero();
+    std::mt19937 random( m_nSeed );
+    std::uniform_int_distribution<int> jitter( -static_cast<int>( m_nJitterUS ), static_cast<int>( m_nJitterUS ));
+
+    for ( VmbUint64_t nFrameID = 0; m_bRunning; ++nFrameID )
+    {
+        const BufferPtr &pBuffer = m_buffers[nFrameID % m_buffers.size()];
+        Render( pBuffer.get(), nFrameID );
+
+        // Pace the frames like a free running camera would, the jitter does not accumulate
+        if ( Clock::duration::zero() != tPeriod )
+        {
+            tNext += tPeriod;
+            std::this_thread::sleep_until( tNext + std::chrono::microseconds( jitter( random )));
+        }
+
+        ImageFrame image;
+        image.pImage            = pBuffer.get();
+        image.nImageSize        = GetImageSize( m_nWidth, m_nHeight, m_ePixelFormat );
+        image.nWidth            = m_nWidth;
+        image.nHeight           = m_nHeight;
+        image.ePixelFormat      = m_ePixelFormat;
+        image.nFrameID          = nFrameID;
+        image.nTimestamp        = std::chrono::duration_cast<std::chrono::nanoseconds>( Clock::now() - tStart ).count();
+        image.eReceiveStatus    = VmbFrameStatusComplete;
+        image.nReceiveTime      = GetLatencyClock();
+
+        if ( callback )
+        {
+            callback( image );
+        }
+        ++m_nFrameCount;
+    }
+}
+
+//
+// Renders the image with the given ID. The same ID always gives the same image.
+// The image is a diagonal ramp per channel that moves by one pixel per frame.
+//
+// Parameters:
+//  [out]   pBuffer             The buffer to render into, GetImageSize() bytes
+//  [in]    nFrameID            The ID of the frame
+//
+void SyntheticFrameSource::Render( VmbUchar_t *pBuffer, VmbUint64_t nFrameID ) const
+{
+    const VmbUint32_t nChannels = GetBitsPerPixel( m_ePixelFormat ) / 8;
+    const VmbUint32_t nShift = static_cast<VmbUint32_t>( nFrameID );
+    const VmbUint32_t nBitDepth = GetMonoBitDepth( m_ePixelFormat );
+
+    if ( 8 < nBitDepth )
+    {
+        // Deeper mono is one little endian word per pixel, the ramp wraps at the bit depth
+        const VmbUint32_t nMask = ( 1UL << nBitDepth ) - 1;
+        for ( VmbUint32_t y = 0; y < m_nHeight; ++y )
+        {
+            for ( VmbUint32_t x = 0; x < m_nWidth; ++x )
+            {
+                const VmbUint32_t nValue = ( x + y + nShift ) & nMask;
+                *pBuffer++ = static_cast<VmbUchar_t>( nValue );
+                *pBuffer++ = static_cast<VmbUchar_t>( nValue >> 8 );
+            }
+        }
+        return;
+    }
+
+    BayerPattern ePattern;
+    if ( GetBayerPattern( m_ePixelFormat, ePattern ))
+    {
+        // The RGB image seen through the color filter of every pixel
+        for ( VmbUint32_t y = 0; y < m_nHeight; ++y )
+        {
+            const VmbUint32_t nColorPhase = ( ePattern & 1 ) ^ ( y & 1 );
+            const VmbUint32_t nColor = ((( ePattern >> 1 ) ^ y ) & 1 ) ? 2 : 0;
+            for ( VmbUint32_t x = 0; x < m_nWidth; ++x, ++pBuffer )
+            {
+                const VmbUint32_t c = (( x & 1 ) == nColorPhase ) ? nColor : 1;
+                *pBuffer = static_cast<VmbUchar_t>( x * ( c + 1 ) + y + nShift );
+            }
+        }
+        return;
+    }
+
+    for ( VmbUint32_t y = 0; y < m_nHeight; ++y )
+    {
+        for ( VmbUint32_t x = 0; x < m_nWidth; ++x )
+        {
+            for ( VmbUint32_t c = 0; c < nChannels; ++c, ++pBuffer )
+            {
+                *pBuffer = static_cast<VmbUchar_t>( x * ( c + 1 ) + y + nShift );
+            }
+        }
+    }
+}
+
+}}} // namespace AVT::VmbAPI::Examples
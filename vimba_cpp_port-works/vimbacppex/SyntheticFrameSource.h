@@ -0,0 +1,111 @@
+/*=============================================================================
+  Copyright (C) 2013 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        SyntheticFrameSource.h
+
+  Description: A frame source that renders deterministic test images on its
+               own thread so the continuous acquisition path can be exercised
+               without a camera attached.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#ifndef AVT_VMBAPI_EXAMPLES_SYNTHETICFRAMESOURCE
+#define AVT_VMBAPI_EXAMPLES_SYNTHETICFRAMESOURCE
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "VimbaCPP/Include/VimbaCPP.h"
+
+#include "BufferPool.h"
+#include "ImageFrame.h"
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+class SyntheticFrameSource
+{
+  public:
+    //
+    // Parameters:
+    //  [in]    nWidth              The width of the rendered images
+    //  [in]    nHeight             The height of the rendered images
+    //  [in]    ePixelFormat        The pixel format of the rendered images
+    //  [in]    dFrameRate          Frames per second, 0 renders as fast as possible
+    //  [in]    nJitterUS           The maximum deviation of a frame from its nominal time in microseconds
+    //  [in]    nSeed               The seed of the jitter sequence, equal seeds give equal sequences
+    //
+    SyntheticFrameSource( VmbUint32_t nWidth, VmbUint32_t nHeight, VmbPixelFormatType ePixelFormat, double dFrameRate,
+                          VmbUint32_t nJitterUS = 0, VmbUint32_t nSeed = 0 );
+    ~SyntheticFrameSource();
+
+    //
+    // Allocates a ring of frame buffers and starts rendering into it
+    //
+    // Parameters:
+    //  [in]    rCallback           The function that gets every completed frame
+    //  [in]    nFrameCount         The number of buffers in the ring
+    //
+    // Returns:
+    //  An API status code
+    //
+    VmbErrorType    Start( const FrameCallback &rCallback, VmbUint32_t nFrameCount );
+
+    //
+    // Stops rendering and waits for the last callback to return
+    //
+    void            Stop();
+
+    //
+    // Gets the number of frames delivered since the last start
+    //
+    VmbUint64_t     GetFrameCount() const;
+
+    //
+    // Renders the image with the given ID. The same ID always gives the same image.
+    //
+    // Parameters:
+    //  [out]   pBuffer             The buffer to render into, GetImageSize() bytes
+    //  [in]    nFrameID            The ID of the frame
+    //
+    void            Render( VmbUchar_t *pBuffer, VmbUint64_t nFrameID ) const;
+
+  private:
+    void            Run( FrameCallback callback );
+
+    const VmbUint32_t                       m_nWidth;
+    const VmbUint32_t                       m_nHeight;
+    const VmbPixelFormatType                m_ePixelFormat;
+    const double                            m_dFrameRate;
+    const VmbUint32_t                       m_nJitterUS;
+    const VmbUint32_t                       m_nSeed;
+    // The ring of buffers frames are rendered into, from the default buffer pool
+    std::vector<BufferPtr>                  m_buffers;
+    std::thread                             m_thread;
+    std::atomic<bool>                       m_bRunning;
+    std::atomic<VmbUint64_t>                m_nFrameCount;
+};
+
+}}} // namespace AVT::VmbAPI::Examples
+
+#endif
@@ -0,0 +1,684 @@
+/*=============================================================================
+  Copyright (C) 2013 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        VimbaCameraBackend.cpp
+
+  Description: The camera backend that talks to real cameras through the
+               VimbaCPP API.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#include <chrono>
+#include <cstdlib>
+#include <sstream>
+
+#include "VimbaCameraBackend.h"
+#include "FrameObserver.h"
+#include "Common/StreamSystemInfo.h"
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+namespace {
+
+// The variable the GenTL consumer looks up the transport layers in
+#if defined( _WIN64 ) || defined( __LP64__ )
+const char *const GENTL_PATH_VARIABLE = "GENICAM_GENTL64_PATH";
+#else
+const char *const GENTL_PATH_VARIABLE = "GENICAM_GENTL32_PATH";
+#endif
+
+#ifdef _WIN32
+const char GENTL_PATH_SEPARATOR = ';';
+#else
+const char GENTL_PATH_SEPARATOR = ':';
+#endif
+
+//
+// Sets or removes a variable of the process environment
+//
+void PutEnvironmentVariable( const char *pName, const std::string &rStrValue, bool bIsSet )
+{
+#ifdef _WIN32
+    // An empty value removes the variable
+    _putenv_s( pName, bIsSet ? rStrValue.c_str() : "" );
+#else
+    if ( bIsSet )
+    {
+        setenv( pName, rStrValue.c_str(), 1 );
+    }
+    else
+    {
+        unsetenv( pName );
+    }
+#endif
+}
+
+//
+// Keeps the entries of a transport layer search path whose directory contains one of the given names
+//
+std::string FilterTransportLayerPath( const std::string &rStrPath, const std::vector<std::string> &rNames )
+{
+    std::string strFiltered;
+    std::string::size_type nStart = 0;
+    while ( nStart <= rStrPath.size() )
+    {
+        std::string::size_type nEnd = rStrPath.find( GENTL_PATH_SEPARATOR, nStart );
+        if ( std::string::npos == nEnd )
+        {
+            nEnd = rStrPath.size();
+        }
+        const std::string strEntry = rStrPath.substr( nStart, nEnd - nStart );
+        for (   std::vector<std::string>::const_iterator iter = rNames.begin();
+                rNames.end() != iter;
+                ++iter )
+        {
+            if (    !strEntry.empty()
+                 && std::string::npos != strEntry.find( *iter ))
+            {
+                if ( !strFiltered.empty() )
+                {
+                    strFiltered += GENTL_PATH_SEPARATOR;
+                }
+                strFiltered += strEntry;
+                break;
+            }
+        }
+        nStart = nEnd + 1;
+    }
+    return strFiltered;
+}
+
+//
+// Gets the description of a camera
+//
+CameraInfo GetCameraInfo( const CameraPtr &pCamera )
+{
+    CameraInfo info;
+    SP_ACCESS( pCamera )->GetID( info.strID );
+    SP_ACCESS( pCamera )->GetName( info.strName );
+    SP_ACCESS( pCamera )->GetModel( info.strModel );
+    SP_ACCESS( pCamera )->GetSerialNumber( info.strSerialNumber );
+    return info;
+}
+
+//
+// Hands the camera list events of Vimba to a callback
+//
+class CameraListObserver : public ICameraListObserver
+{
+  public:
+    explicit CameraListObserver( const CameraListCallback &rCallback )
+        : m_callback( rCallback )
+    {
+    }
+
+    virtual void CameraListChanged( CameraPtr pCamera, UpdateTriggerType eReason )
+    {
+        CameraListChange eChange = CameraChanged;
+        switch ( eReason )
+        {
+        case UpdateTriggerPluggedIn:
+            eChange = CameraPluggedIn;
+            break;
+        case UpdateTriggerPluggedOut:
+            eChange = CameraPluggedOut;
+            break;
+        default:
+            break;
+        }
+        m_callback( GetCameraInfo( pCamera ), eChange );
+    }
+
+  private:
+    CameraListCallback m_callback;
+};
+
+//
+// Gets the microseconds passed since the given time
+//
+VmbUint32_t GetElapsedUS( std::chrono::steady_clock::time_point tStart )
+{
+    return static_cast<VmbUint32_t>( std::chrono::duration_cast<std::chrono::microseconds>( std::chrono::steady_clock::now() - tStart ).count() );
+}
+
+} // namespace
+
+VimbaCamera::VimbaCamera( const std::string &rStrCameraID, const CameraPtr &pCamera )
+    : m_strID( rStrCameraID )
+    , m_pCamera( pCamera )
+{
+    // Resolve the known features once so later accesses do not need to look them up by name
+    for ( int i = 0; i < FeatureCount; ++i )
+    {
+        SP_ACCESS( m_pCamera )->GetFeatureByName( GetCameraFeatureName( static_cast<CameraFeature>( i )), m_features[i] );
+    }
+}
+
+VimbaCamera::~VimbaCamera()
+{
+    Close();
+}
+
+const std::string& VimbaCamera::GetID() const
+{
+    return m_strID;
+}
+
+VmbErrorType VimbaCamera::Close()
+{
+    if ( SP_ISNULL( m_pCamera ))
+    {
+        return VmbErrorSuccess;
+    }
+    if ( !SP_ISNULL( m_pFrameObserver ))
+    {
+        StopStreaming();
+    }
+    // Feature handles are not valid any more once the camera is closed
+    for ( int i = 0; i < FeatureCount; ++i )
+    {
+        SP_RESET( m_features[i] );
+    }
+    VmbErrorType res = SP_ACCESS( m_pCamera )->Close();
+    SP_RESET( m_pCamera );
+    return res;
+}
+
+VmbErrorType VimbaCamera::SetFeatureValue( const char *pName, VmbInt64_t nValue )
+{
+    FeaturePtr pFeature;
+    VmbErrorType res = GetFeature( pName, pFeature );
+    if ( VmbErrorSuccess == res )
+    {
+        res = SP_ACCESS( pFeature )->SetValue( nValue );
+    }
+    return res;
+}
+
+VmbErrorType VimbaCamera::GetFeatureValue( const char *pName, VmbInt64_t &rnValue )
+{
+    FeaturePtr pFeature;
+    VmbErrorType res = GetFeature( pName, pFeature );
+    if ( VmbErrorSuccess == res )
+    {
+        res = SP_ACCESS( pFeature )->GetValue( rnValue );
+    }
+    return res;
+}
+
+VmbErrorType VimbaCamera::SetFeatureValue( const char *pName, double dValue )
+{
+    FeaturePtr pFeature;
+    VmbErrorType res = GetFeature( pName, pFeature );
+    if ( VmbErrorSuccess == res )
+    {
+        res = SP_ACCESS( pFeature )->SetValue( dValue );
+    }
+    return res;
+}
+
+VmbErrorType VimbaCamera::GetFeatureValue( const char *pName, double &rdValue )
+{
+    FeaturePtr pFeature;
+    VmbErrorType res = GetFeature( pName, pFeature );
+    if ( VmbErrorSuccess == res )
+    {
+        res = SP_ACCESS( pFeature )->GetValue( rdValue );
+    }
+    return res;
+}
+
+VmbErrorType VimbaCamera::RunFeatureCommand( const char *pName )
+{
+    FeaturePtr pFeature;
+    VmbErrorType res = GetFeature( pName, pFeature );
+    if ( VmbErrorSuccess == res )
+    {
+        res = SP_ACCESS( pFeature )->RunCommand();
+    }
+    return res;
+}
+
+VmbErrorType VimbaCamera::IsFeatureCommandDone( const char *pName, bool &rbIsDone )
+{
+    FeaturePtr pFeature;
+    VmbErrorType res = GetFeature( pName, pFeature );
+    if ( VmbErrorSuccess == res )
+    {
+        res = SP_ACCESS( pFeature )->IsCommandDone( rbIsDone );
+    }
+    return res;
+}
+
+VmbErrorType VimbaCamera::SetFeatureValue( CameraFeature eFeature, VmbInt64_t nValue )
+{
+    FeaturePtr pFeature;
+    VmbErrorType res = GetFeature( eFeature, pFeature );
+    if ( VmbErrorSuccess == res )
+    {
+        res = SP_ACCESS( pFeature )->SetValue( nValue );
+    }
+    return res;
+}
+
+VmbErrorType VimbaCamera::GetFeatureValue( CameraFeature eFeature, VmbInt64_t &rnValue )
+{
+    FeaturePtr pFeature;
+    VmbErrorType res = GetFeature( eFeature, pFeature );
+    if ( VmbErrorSuccess == res )
+    {
+        res = SP_ACCESS( pFeature )->GetValue( rnValue );
+    }
+    return res;
+}
+
+VmbErrorType VimbaCamera::SetFeatureValue( CameraFeature eFeature, double dValue )
+{
+    FeaturePtr pFeature;
+    VmbErrorType res = GetFeature( eFeature, pFeature );
+    if ( VmbErrorSuccess == res )
+    {
+        res = SP_ACCESS( pFeature )->SetValue( dValue );
+    }
+    return res;
+}
+
+VmbErrorType VimbaCamera::GetFeatureValue( CameraFeature eFeature, double &rdValue )
+{
+    FeaturePtr pFeature;
+    VmbErrorType res = GetFeature( eFeature, pFeature );
+    if ( VmbErrorSuccess == res )
+    {
+        res = SP_ACCESS( pFeature )->GetValue( rdValue );
+    }
+    return res;
+}
+
+VmbErrorType VimbaCamera::RunFeatureCommand( CameraFeature eFeature )
+{
+    FeaturePtr pFeature;
+    VmbErrorType res = GetFeature( eFeature, pFeature );
+    if ( VmbErrorSuccess == res )
+    {
+        res = SP_ACCESS( pFeature )->RunCommand();
+    }
+    return res;
+}
+
+VmbErrorType VimbaCamera::IsFeatureCommandDone( CameraFeature eFeature, bool &rbIsDone )
+{
+    FeaturePtr pFeature;
+    VmbErrorType res = GetFeature( eFeature, pFeature );
+    if ( VmbErrorSuccess == res )
+    {
+        res = SP_ACCESS( pFeature )->IsCommandDone( rbIsDone );
+    }
+    return res;
+}
+
+//
+// Gets a feature, from the resolved handles if it is one of the known features
+//
+// Parameters:
+//  [in]    pName               The name of the feature
+//  [out]   rpFeature           The feature
+//
+// Returns:
+//  An API status code
+//
+VmbErrorType VimbaCamera::GetFeature( const char *pName, FeaturePtr &rpFeature )
+{
+    if ( SP_ISNULL( m_pCamera ))
+    {
+        return VmbErrorDeviceNotOpen;
+    }
+    CameraFeature eFeature;
+    if ( FindCameraFeature( pName, eFeature ))
+    {
+        return GetFeature( eFeature, rpFeature );
+    }
+    return SP_ACCESS( m_pCamera )->GetFeatureByName( pName, rpFeature );
+}
+
+//
+// Gets a resolved feature handle
+//
+// Parameters:
+//  [in]    eFeature            The feature
+//  [out]   rpFeature           The feature handle
+//
+// Returns:
+//  An API status code
+//
+VmbErrorType VimbaCamera::GetFeature( CameraFeature eFeature, FeaturePtr &rpFeature ) const
+{
+    if ( SP_ISNULL( m_pCamera ))
+    {
+        return VmbErrorDeviceNotOpen;
+    }
+    if ( SP_ISNULL( m_features[eFeature] ))
+    {
+        return VmbErrorNotFound;
+    }
+    rpFeature = m_features[eFeature];
+    return VmbErrorSuccess;
+}
+
+VmbErrorType VimbaCamera::AcquireSingleImage( ImageFrame &rFrame, VmbUint32_t nTimeout )
+{
+    if ( SP_ISNULL( m_pCamera ))
+    {
+        return VmbErrorDeviceNotOpen;
+    }
+    FramePtr pFrame;
+    VmbErrorType res = SP_ACCESS( m_pCamera )->AcquireSingleImage( pFrame, nTimeout );
+    if ( VmbErrorSuccess == res )
+    {
+        GetImageFrame( pFrame, rFrame );
+    }
+    return res;
+}
+
+//
+// Announces and queues a ring of frames and starts the acquisition
+// Every completed frame is handed to the given callback and requeued afterwards
+//
+// Parameters:
+//  [in]    rCallback           The function that gets every completed frame (called from the API's thread)
+//  [in]    nFrameCount         The number of frames in the ring
+//
+// Returns:
+//  An API status code
+//
+VmbErrorType VimbaCamera::StartStreaming( const FrameCallback &rCallback, VmbUint32_t nFrameCount )
+{
+    if ( SP_ISNULL( m_pCamera ))
+    {
+        return VmbErrorDeviceNotOpen;
+    }
+    if ( !SP_ISNULL( m_pFrameObserver ))
+    {
+        return VmbErrorInvalidCall;
+    }
+    if ( 0 == nFrameCount )
+    {
+        return VmbErrorBadParameter;
+    }
+
+    // Evaluate frame size
+    VmbInt64_t nPayloadSize = 0;
+    VmbErrorType res = GetFeatureValue( FeaturePayloadSize, nPayloadSize );
+
+    if ( VmbErrorSuccess == res )
+    {
+        SP_SET( m_pFrameObserver, new FrameObserver( m_pCamera, rCallback ));
+
+        // Announce a ring of frames on pooled buffers, so restarting does not allocate image memory again
+        m_frames.resize( nFrameCount );
+        for (   FramePtrVector::iterator iter = m_frames.begin();
+                m_frames.end() != iter && VmbErrorSuccess == res;
+                ++iter )
+        {
+            BufferPtr pBuffer = BufferPool::GetDefault().Acquire( static_cast<size_t>( nPayloadSize ));
+            if ( !pBuffer )
+            {
+                res = VmbErrorResources;
+                break;
+            }
+            m_frameBuffers.push_back( pBuffer );
+            SP_SET( (*iter), new Frame( pBuffer.get(), nPayloadSize ));
+            res = SP_ACCESS( (*iter) )->RegisterObserver( m_pFrameObserver );
+            if ( VmbErrorSuccess == res )
+            {
+                res = SP_ACCESS( m_pCamera )->AnnounceFrame( *iter );
+            }
+        }
+    }
+
+    // Start the capture engine and hand it all frames
+    bool bIsCapturing = false;
+    if ( VmbErrorSuccess == res )
+    {
+        res = SP_ACCESS( m_pCamera )->StartCapture();
+        bIsCapturing = VmbErrorSuccess == res;
+    }
+    for (   FramePtrVector::iterator iter = m_frames.begin();
+            m_frames.end() != iter && VmbErrorSuccess == res;
+            ++iter )
+    {
+        res = SP_ACCESS( m_pCamera )->QueueFrame( *iter );
+    }
+
+    // Start the acquisition engine (camera)
+    if ( VmbErrorSuccess == res )
+    {
+        res = RunFeatureCommand( FeatureAcquisitionStart );
+    }
+
+    // Undo only what was done, the camera never started acquiring
+    if ( VmbErrorSuccess != res )
+    {
+        if ( bIsCapturing )
+        {
+            SP_ACCESS( m_pCamera )->EndCapture();
+            SP_ACCESS( m_pCamera )->FlushQueue();
+        }
+        if ( !SP_ISNULL( m_pFrameObserver ))
+        {
+            RevokeFrames();
+        }
+    }
+
+    return res;
+}
+
+//
+// Stops the acquisition and revokes all frames
+//
+// Returns:
+//  An API status code
+//
+VmbErrorType VimbaCamera::StopStreaming()
+{
+    if (    SP_ISNULL( m_pCamera )
+         || SP_ISNULL( m_pFrameObserver ))
+    {
+        return VmbErrorInvalidCall;
+    }
+
+    // Stop the acquisition engine (camera)
+    VmbErrorType res = RunFeatureCommand( FeatureAcquisitionStop );
+
+    // Stop the capture engine (API) and free all frames
+    SP_ACCESS( m_pCamera )->EndCapture();
+    SP_ACCESS( m_pCamera )->FlushQueue();
+    RevokeFrames();
+
+    return res;
+}
+
+//
+// Revokes the announced frames and frees them and their observer
+//
+void VimbaCamera::RevokeFrames()
+{
+    SP_ACCESS( m_pCamera )->RevokeAllFrames();
+    for (   FramePtrVector::iterator iter = m_frames.begin();
+            m_frames.end() != iter;
+            ++iter )
+    {
+        if ( !SP_ISNULL( (*iter) ))
+        {
+            SP_ACCESS( (*iter) )->UnregisterObserver();
+        }
+    }
+    m_frames.clear();
+    // The API does not use the buffers any more once the frames are revoked
+    m_frameBuffers.clear();
+    SP_RESET( m_pFrameObserver );
+}
+
+VimbaCameraBackend::VimbaCameraBackend()
+    // Get a reference to the Vimba singleton
+    : m_system ( VimbaSystem::GetInstance() )
+{
+}
+
+//
+// Restricts the transport layers loaded at startup to the ones whose path contains one of the given names.
+// An empty list loads all of them. Takes effect at the next startup.
+//
+// Parameters:
+//  [in]    rNames              The names, e.g. "VimbaGigETL" or "VimbaUSBTL"
+//
+void VimbaCameraBackend::SetTransportLayers( const std::vector<std::string> &rNames )
+{
+    m_transportLayers = rNames;
+}
+
+//
+// Starts the Vimba API, loads the transport layers and enumerates their interfaces
+//
+// Parameters:
+//  [out]   rPhases             Gets the steps of the startup and how long they took appended
+//
+// Returns:
+//  An API status code
+//
+VmbErrorType VimbaCameraBackend::Startup( StartupPhaseVector &rPhases )
+{
+    // Vimba loads every transport layer it finds at startup and cannot load one later.
+    // Loading only the wanted ones is done by narrowing their search path for the duration of the call.
+    const char *pPath = getenv( GENTL_PATH_VARIABLE );
+    const bool bHasPath = NULL != pPath;
+    const std::string strPath = bHasPath ? pPath : "";
+    const bool bIsFiltered = !m_transportLayers.empty();
+    if ( bIsFiltered )
+    {
+        PutEnvironmentVariable( GENTL_PATH_VARIABLE, FilterTransportLayerPath( strPath, m_transportLayers ), true );
+    }
+
+    std::chrono::steady_clock::time_point tStart = std::chrono::steady_clock::now();
+    VmbErrorType res = m_system.Startup();
+    StartupPhase phase;
+    phase.strName = bIsFiltered ? "Load selected transport layers" : "Load transport layers";
+    phase.nDurationUS = GetElapsedUS( tStart );
+    rPhases.push_back( phase );
+
+    if ( bIsFiltered )
+    {
+        PutEnvironmentVariable( GENTL_PATH_VARIABLE, strPath, bHasPath );
+    }
+
+    if ( VmbErrorSuccess == res )
+    {
+        // The transport layers discover their interfaces here, the cameras behind them come with the first listing
+        tStart = std::chrono::steady_clock::now();
+        InterfacePtrVector interfaces;
+        m_system.GetInterfaces( interfaces );
+        phase.strName = "Enumerate interfaces";
+        phase.nDurationUS = GetElapsedUS( tStart );
+        rPhases.push_back( phase );
+    }
+
+    return res;
+}
+
+//
+// Shuts down the API
+//
+void VimbaCameraBackend::Shutdown()
+{
+    // Release Vimba, it forgets its observers with it
+    m_system.Shutdown();
+    SP_RESET( m_pCameraListObserver );
+}
+
+VmbErrorType VimbaCameraBackend::GetCameras( CameraInfoVector &rCameras )
+{
+    CameraPtrVector cameras;
+    // Get all known cameras
+    VmbErrorType res = m_system.GetCameras( cameras );
+    if ( VmbErrorSuccess == res )
+    {
+        rCameras.clear();
+        rCameras.reserve( cameras.size() );
+        for (   CameraPtrVector::const_iterator iter = cameras.begin();
+                cameras.end() != iter;
+                ++iter )
+        {
+            rCameras.push_back( GetCameraInfo( *iter ));
+        }
+    }
+    return res;
+}
+
+//
+// Reports the cameras Vimba sees plugged in, unplugged or opened by another application
+//
+// Parameters:
+//  [in]    rCallback           Gets every change (called from a thread of Vimba), empty to stop reporting
+//
+// Returns:
+//  An API status code
+//
+VmbErrorType VimbaCameraBackend::SetCameraListCallback( const CameraListCallback &rCallback )
+{
+    VmbErrorType res = VmbErrorSuccess;
+    if ( !SP_ISNULL( m_pCameraListObserver ))
+    {
+        res = m_system.UnregisterCameraListObserver( m_pCameraListObserver );
+        SP_RESET( m_pCameraListObserver );
+    }
+    if ( rCallback )
+    {
+        SP_SET( m_pCameraListObserver, new CameraListObserver( rCallback ));
+        res = m_system.RegisterCameraListObserver( m_pCameraListObserver );
+        if ( VmbErrorSuccess != res )
+        {
+            SP_RESET( m_pCameraListObserver );
+        }
+    }
+    return res;
+}
+
+VmbErrorType VimbaCameraBackend::OpenCamera( const std::string &rStrCameraID, ICameraPtr &rpCamera )
+{
+    // Open the desired camera by its ID
+    CameraPtr pCamera;
+    VmbErrorType res = m_system.OpenCameraByID( rStrCameraID.c_str(), VmbAccessModeFull, pCamera );
+    if ( VmbErrorSuccess == res )
+    {
+        rpCamera.reset( new VimbaCamera( rStrCameraID, pCamera ));
+    }
+    return res;
+}
+
+std::string VimbaCameraBackend::GetVersion() const
+{
+    std::ostringstream os;
+    os<<m_system;
+    return os.str();
+}
+
+}}} // namespace AVT::VmbAPI::Examples
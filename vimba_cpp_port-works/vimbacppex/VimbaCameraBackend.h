@@ -0,0 +1,157 @@
+/*=============================================================================
+  Copyright (C) 2013 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        VimbaCameraBackend.h
+
+  Description: The camera backend that talks to real cameras through the
+               VimbaCPP API.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#ifndef AVT_VMBAPI_EXAMPLES_VIMBACAMERABACKEND
+#define AVT_VMBAPI_EXAMPLES_VIMBACAMERABACKEND
+
+#include <string>
+#include <vector>
+
+#include "VimbaCPP/Include/VimbaCPP.h"
+
+#include "BufferPool.h"
+#include "CameraBackend.h"
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+class VimbaCamera : public ICamera
+{
+  public:
+    //
+    // Parameters:
+    //  [in]    rStrCameraID        The ID the camera was opened with
+    //  [in]    pCamera             The opened Vimba camera
+    //
+    VimbaCamera( const std::string &rStrCameraID, const CameraPtr &pCamera );
+    ~VimbaCamera();
+
+    virtual const std::string&  GetID() const;
+    virtual VmbErrorType    Close();
+
+    virtual VmbErrorType    SetFeatureValue( const char *pName, VmbInt64_t nValue );
+    virtual VmbErrorType    GetFeatureValue( const char *pName, VmbInt64_t &rnValue );
+    virtual VmbErrorType    SetFeatureValue( const char *pName, double dValue );
+    virtual VmbErrorType    GetFeatureValue( const char *pName, double &rdValue );
+    virtual VmbErrorType    RunFeatureCommand( const char *pName );
+    virtual VmbErrorType    IsFeatureCommandDone( const char *pName, bool &rbIsDone );
+    virtual VmbErrorType    SetFeatureValue( CameraFeature eFeature, VmbInt64_t nValue );
+    virtual VmbErrorType    GetFeatureValue( CameraFeature eFeature, VmbInt64_t &rnValue );
+    virtual VmbErrorType    SetFeatureValue( CameraFeature eFeature, double dValue );
+    virtual VmbErrorType    GetFeatureValue( CameraFeature eFeature, double &rdValue );
+    virtual VmbErrorType    RunFeatureCommand( CameraFeature eFeature );
+    virtual VmbErrorType    IsFeatureCommandDone( CameraFeature eFeature, bool &rbIsDone );
+
+    virtual VmbErrorType    AcquireSingleImage( ImageFrame &rFrame, VmbUint32_t nTimeout );
+
+    //
+    // Announces and queues a ring of frames and starts the acquisition
+    // Every completed frame is handed to the given callback and requeued afterwards
+    //
+    virtual VmbErrorType    StartStreaming( const FrameCallback &rCallback, VmbUint32_t nFrameCount );
+
+    //
+    // Stops the acquisition and revokes all frames
+    //
+    virtual VmbErrorType    StopStreaming();
+
+  private:
+    //
+    // Gets a feature, from the resolved handles if it is one of the known features
+    //
+    VmbErrorType        GetFeature( const char *pName, FeaturePtr &rpFeature );
+
+    //
+    // Gets a resolved feature handle
+    //
+    VmbErrorType        GetFeature( CameraFeature eFeature, FeaturePtr &rpFeature ) const;
+
+    //
+    // Revokes the announced frames and frees them and their observer
+    //
+    void                RevokeFrames();
+
+    const std::string   m_strID;
+    // The opened Vimba camera
+    CameraPtr           m_pCamera;
+    // The known features, resolved once when the camera was opened (empty if the camera does not have it)
+    FeaturePtr          m_features[FeatureCount];
+    // Every camera has its own frame observer
+    IFrameObserverPtr   m_pFrameObserver;
+    // The ring of frames announced to the camera while streaming
+    FramePtrVector      m_frames;
+    // The memory of the frames, from the default buffer pool
+    std::vector<BufferPtr> m_frameBuffers;
+};
+
+class VimbaCameraBackend : public ICameraBackend
+{
+  public:
+    VimbaCameraBackend();
+
+    //
+    // Restricts the transport layers loaded at startup to the ones whose path contains one of the given names.
+    // An empty list loads all of them. Takes effect at the next startup.
+    //
+    // Parameters:
+    //  [in]    rNames              The names, e.g. "VimbaGigETL" or "VimbaUSBTL"
+    //
+    void                    SetTransportLayers( const std::vector<std::string> &rNames );
+
+    //
+    // Starts the Vimba API, loads the transport layers and enumerates their interfaces
+    //
+    virtual VmbErrorType    Startup( StartupPhaseVector &rPhases );
+
+    //
+    // Shuts down the API
+    //
+    virtual void            Shutdown();
+
+    virtual VmbErrorType    GetCameras( CameraInfoVector &rCameras );
+
+    //
+    // Reports the cameras Vimba sees plugged in, unplugged or opened by another application
+    //
+    virtual VmbErrorType    SetCameraListCallback( const CameraListCallback &rCallback );
+    virtual VmbErrorType    OpenCamera( const std::string &rStrCameraID, ICameraPtr &rpCamera );
+    virtual std::string     GetVersion() const;
+
+  private:
+    // A reference to our Vimba singleton
+    VimbaSystem &m_system;
+    // The transport layers to load, all if empty
+    std::vector<std::string> m_transportLayers;
+    // Forwards the camera list events of Vimba while a callback is set
+    ICameraListObserverPtr m_pCameraListObserver;
+};
+
+}}} // namespace AVT::VmbAPI::Examples
+
+#endif
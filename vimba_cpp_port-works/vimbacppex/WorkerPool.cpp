@@ -0,0 +1,199 @@
+/*=============================================================================
+  Copyright (C) 2013 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        WorkerPool.cpp
+
+  Description: A fixed set of threads that runs submitted tasks, used to spread
+               work over cameras or image stripes.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#include <algorithm>
+#include <atomic>
+
+#include "WorkerPool.h"
+#include "Bitmap.h"
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+//
+// Starts the threads
+//
+// Parameters:
+//  [in]    nThreadCount        The number of threads, 0 uses one per hardware thread
+//
+WorkerPool::WorkerPool( VmbUint32_t nThreadCount )
+    : m_bStop( false )
+{
+    if ( 0 == nThreadCount )
+    {
+        nThreadCount = ( std::max )( std::thread::hardware_concurrency(), 1u );
+    }
+    m_threads.reserve( nThreadCount );
+    for ( VmbUint32_t i = 0; i < nThreadCount; ++i )
+    {
+        m_threads.push_back( std::thread( &WorkerPool::Run, this ));
+    }
+}
+
+//
+// Runs the tasks still queued and joins the threads
+//
+WorkerPool::~WorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        m_bStop = true;
+    }
+    m_condition.notify_all();
+    for (   std::vector<std::thread>::iterator iter = m_threads.begin();
+            m_threads.end() != iter;
+            ++iter )
+    {
+        iter->join();
+    }
+}
+
+//
+// Gets the number of threads
+//
+VmbUint32_t WorkerPool::GetThreadCount() const
+{
+    return static_cast<VmbUint32_t>( m_threads.size() );
+}
+
+//
+// Queues a task to run on one of the threads
+//
+// Parameters:
+//  [in]    rTask               The task to run
+//
+void WorkerPool::Submit( const Task &rTask )
+{
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        m_tasks.push_back( rTask );
+    }
+    m_condition.notify_one();
+}
+
+//
+// Runs rTask( 0 ) to rTask( nCount - 1 ) on the threads and waits until all have finished.
+// The calling thread helps, so this does not deadlock if called from one of the threads.
+//
+// Parameters:
+//  [in]    nCount              The number of indices
+//  [in]    rTask               The task to run for every index
+//
+void WorkerPool::ParallelFor( VmbUint32_t nCount, const IndexedTask &rTask )
+{
+    if ( 0 == nCount )
+    {
+        return;
+    }
+
+    // Every helper takes the next free index until none is left
+    struct Batch
+    {
+        std::atomic<VmbUint32_t>    nNext;
+        VmbUint32_t                 nDone;
+        std::mutex                  mutex;
+        std::condition_variable     condition;
+    };
+    std::shared_ptr<Batch> pBatch( new Batch() );
+    pBatch->nNext = 0;
+    pBatch->nDone = 0;
+
+    const IndexedTask &rBatchTask = rTask;
+    Task helper = [pBatch, nCount, &rBatchTask]()
+    {
+        VmbUint32_t nDone = 0;
+        for (   VmbUint32_t i = pBatch->nNext++;
+                i < nCount;
+                i = pBatch->nNext++ )
+        {
+            rBatchTask( i );
+            ++nDone;
+        }
+        if ( 0 != nDone )
+        {
+            std::lock_guard<std::mutex> lock( pBatch->mutex );
+            pBatch->nDone += nDone;
+            if ( nCount == pBatch->nDone )
+            {
+                pBatch->condition.notify_all();
+            }
+        }
+    };
+
+    // The calling thread is one of the helpers
+    const VmbUint32_t nHelpers = ( std::min )( nCount - 1, GetThreadCount() );
+    for ( VmbUint32_t i = 0; i < nHelpers; ++i )
+    {
+        Submit( helper );
+    }
+    helper();
+
+    // Helpers that start late find no index left and do not touch rTask any more
+    std::unique_lock<std::mutex> lock( pBatch->mutex );
+    pBatch->condition.wait( lock, [pBatch, nCount]() { return nCount == pBatch->nDone; } );
+}
+
+void WorkerPool::Run()
+{
+    for ( ;; )
+    {
+        Task task;
+        {
+            std::unique_lock<std::mutex> lock( m_mutex );
+            m_condition.wait( lock, [this]() { return m_bStop || !m_tasks.empty(); } );
+            if ( m_tasks.empty() )
+            {
+                // Stopped and nothing left to do
+                return;
+            }
+            task = m_tasks.front();
+            m_tasks.pop_front();
+        }
+        task();
+    }
+}
+
+static void RunBitmapStripes( unsigned long nCount, AVTBitmapTaskFunc pTask, void *pTaskContext, void *pContext )
+{
+    static_cast<WorkerPool*>( pContext )->ParallelFor(  static_cast<VmbUint32_t>( nCount ),
+                                                        [pTask, pTaskContext]( VmbUint32_t nIndex ) { pTask( nIndex, pTaskContext ); } );
+}
+
+//
+// Makes AVTCreateBitmap convert large images in stripes on this pool
+//
+// Parameters:
+//  [in]    nMinStripeSize      The least bytes of image data per stripe, 0 for the default
+//
+void WorkerPool::UseForBitmaps( VmbUint32_t nMinStripeSize )
+{
+    AVTSetBitmapParallelFor( RunBitmapStripes, this, nMinStripeSize );
+}
+
+}}} // namespace AVT::VmbAPI::Examples
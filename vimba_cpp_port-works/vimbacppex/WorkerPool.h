@@ -0,0 +1,113 @@
+/*=============================================================================
+  Copyright (C) 2013 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        WorkerPool.h
+
+  Description: A fixed set of threads that runs submitted tasks, used to spread
+               work over cameras or image stripes.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#ifndef AVT_VMBAPI_EXAMPLES_WORKERPOOL
+#define AVT_VMBAPI_EXAMPLES_WORKERPOOL
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "VimbaCPP/Include/VimbaCPP.h"
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+class WorkerPool
+{
+  public:
+    typedef std::function<void()>               Task;
+    typedef std::function<void( VmbUint32_t )>  IndexedTask;
+
+    //
+    // Starts the threads
+    //
+    // Parameters:
+    //  [in]    nThreadCount        The number of threads, 0 uses one per hardware thread
+    //
+    explicit WorkerPool( VmbUint32_t nThreadCount = 0 );
+
+    //
+    // Runs the tasks still queued and joins the threads
+    //
+    ~WorkerPool();
+
+    //
+    // Gets the number of threads
+    //
+    VmbUint32_t     GetThreadCount() const;
+
+    //
+    // Queues a task to run on one of the threads
+    //
+    // Parameters:
+    //  [in]    rTask               The task to run
+    //
+    void            Submit( const Task &rTask );
+
+    //
+    // Runs rTask( 0 ) to rTask( nCount - 1 ) on the threads and waits until all have finished.
+    // The calling thread helps, so this does not deadlock if called from one of the threads.
+    //
+    // Parameters:
+    //  [in]    nCount              The number of indices
+    //  [in]    rTask               The task to run for every index
+    //
+    void            ParallelFor( VmbUint32_t nCount, const IndexedTask &rTask );
+
+    //
+    // Makes AVTCreateBitmap convert large images in stripes on this pool
+    //
+    // Parameters:
+    //  [in]    nMinStripeSize      The least bytes of image data per stripe, 0 for the default
+    //
+    void            UseForBitmaps( VmbUint32_t nMinStripeSize = 0 );
+
+  private:
+    void            Run();
+
+    std::vector<std::thread>    m_threads;
+    std::deque<Task>            m_tasks;
+    std::mutex                  m_mutex;
+    std::condition_variable     m_condition;
+    bool                        m_bStop;
+
+    // No copies
+    WorkerPool( const WorkerPool& );
+    WorkerPool& operator=( const WorkerPool& );
+};
+typedef std::shared_ptr<WorkerPool> WorkerPoolPtr;
+
+}}} // namespace AVT::VmbAPI::Examples
+
+#endif